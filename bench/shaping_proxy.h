@@ -0,0 +1,223 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 用户态链路整形代理：类似 tc netem + tbf，为回环连接增加单向时延并限制带宽
+
+#pragma once
+
+#include "stub_server.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace RemoteDebug {
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+struct LinkProfile {
+    std::string               name;
+    std::chrono::microseconds latency{ 0 };    // 单向时延，往返时延为两倍
+    uint64_t                  bandwidth{ 0 };  // 每个方向的带宽（字节/秒），0 表示不限速
+};
+
+/**
+ * @brief 单方向的整形管道
+ * @details 读线程为每块数据记录到达时间后入队，写线程在“到达时间 + 时延”之后、
+ *          并且令牌桶允许时写出。队列长度限制为约一个带宽时延积，
+ *          超出后读线程停止读取，由 TCP 把背压传回发送方
+ */
+class ShapedPipe {
+public:
+    ShapedPipe(int from_fd, int to_fd, const LinkProfile &profile) : m_from(from_fd), m_to(to_fd), m_profile(profile)
+    {
+        m_capacity = 256 * 1024;
+        if (profile.bandwidth) {
+            m_capacity += static_cast<size_t>(profile.bandwidth * static_cast<uint64_t>(profile.latency.count()) / 1000000);
+        }
+    }
+
+    // 从服务端流向客户端的数据可在写出前改写（用于 FTP PASV 应答）
+    void set_rewriter(std::function<std::string(const std::string &)> rewriter) { m_rewriter = std::move(rewriter); }
+
+    void start()
+    {
+        m_reader = std::thread([this] { read_loop(); });
+        m_writer = std::thread([this] { write_loop(); });
+    }
+
+    void join()
+    {
+        m_reader.join();
+        m_writer.join();
+    }
+
+private:
+    struct Packet {
+        std::string       data;
+        Clock::time_point arrival;
+        bool              eof;
+    };
+
+    void read_loop()
+    {
+        char buffer[16 * 1024];
+        while (true) {
+            ssize_t n = recv(m_from, buffer, sizeof(buffer), 0);
+            Packet packet{ n > 0 ? std::string(buffer, static_cast<size_t>(n)) : std::string(), Clock::now(), n <= 0 };
+            if (!packet.eof && m_rewriter) {
+                packet.data = m_rewriter(packet.data);
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_not_full.wait(lock, [this] { return m_queued < m_capacity || m_closed; });
+            if (m_closed) {
+                return;
+            }
+            m_queued += packet.data.size();
+            m_queue.push_back(std::move(packet));
+            m_not_empty.notify_one();
+            if (n <= 0) {
+                return;
+            }
+        }
+    }
+
+    void write_loop()
+    {
+        Clock::time_point link_free = Clock::now();
+        while (true) {
+            Packet packet;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_not_empty.wait(lock, [this] { return !m_queue.empty(); });
+                packet = std::move(m_queue.front());
+                m_queue.pop_front();
+                m_queued -= packet.data.size();
+                m_not_full.notify_one();
+            }
+            if (packet.eof) {
+                shutdown(m_to, SHUT_WR);
+                return;
+            }
+
+            // 传播时延 + 串行化时延（令牌桶按字节数推迟链路空闲时间）
+            Clock::time_point send_at = std::max(packet.arrival + m_profile.latency, link_free);
+            std::this_thread::sleep_until(send_at);
+            if (m_profile.bandwidth) {
+                link_free = std::max(send_at, link_free) +
+                            std::chrono::microseconds(packet.data.size() * 1000000 / m_profile.bandwidth);
+            }
+
+            if (send(m_to, packet.data.data(), packet.data.size(), MSG_NOSIGNAL) !=
+                static_cast<ssize_t>(packet.data.size())) {
+                // 对端已关闭：停止读取并丢弃剩余数据
+                shutdown(m_from, SHUT_RD);
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_closed = true;
+                m_not_full.notify_one();
+                return;
+            }
+        }
+    }
+
+    int                                              m_from;
+    int                                              m_to;
+    LinkProfile                                      m_profile;
+    size_t                                           m_capacity;
+    std::function<std::string(const std::string &)>  m_rewriter;
+    std::thread                                      m_reader;
+    std::thread                                      m_writer;
+    std::mutex                                       m_mutex;
+    std::condition_variable                          m_not_empty;
+    std::condition_variable                          m_not_full;
+    std::deque<Packet>                               m_queue;
+    size_t                                           m_queued{ 0 };
+    bool                                             m_closed{ false };
+};
+
+/**
+ * @brief 整形代理：监听回环端口，将每个连接转发到目标端口并双向整形
+ * @details ftp_aware 时改写 227 应答中的数据端口，为数据连接再建立一个同样整形的代理，
+ *          否则 FTP 数据连接会绕过代理直连服务端
+ */
+class ShapingProxy : public test::StubServer {
+public:
+    ShapingProxy(uint16_t target_port, LinkProfile profile, bool ftp_aware = false)
+        : m_target_port(target_port), m_profile(std::move(profile)), m_ftp_aware(ftp_aware) {}
+    ~ShapingProxy() override
+    {
+        stop();
+        std::lock_guard<std::mutex> lock(m_children_mutex);
+        m_children.clear();
+    }
+
+protected:
+    void serve(int client_fd) override
+    {
+        int server_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(test::loopback_ip);
+        addr.sin_port = htons(m_target_port);
+        if (connect(server_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+            close(server_fd);
+            return;
+        }
+        int one = 1;
+        setsockopt(server_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        ShapedPipe upstream(client_fd, server_fd, m_profile);
+        ShapedPipe downstream(server_fd, client_fd, m_profile);
+        if (m_ftp_aware) {
+            downstream.set_rewriter([this](const std::string &data) { return rewrite_pasv(data); });
+        }
+        upstream.start();
+        downstream.start();
+        upstream.join();
+        downstream.join();
+        close(server_fd);
+    }
+
+private:
+    // 227 Entering Passive Mode (127,0,0,1,p1,p2) -> 指向新建的数据连接代理
+    std::string rewrite_pasv(const std::string &data)
+    {
+        size_t pos = data.find("227 ");
+        size_t open = data.find('(', pos);
+        size_t close_pos = data.find(')', open);
+        unsigned h[4] = {};
+        unsigned p[2] = {};
+        if (pos == std::string::npos || open == std::string::npos || close_pos == std::string::npos ||
+            std::sscanf(data.c_str() + open, "(%u,%u,%u,%u,%u,%u)", &h[0], &h[1], &h[2], &h[3], &p[0], &p[1]) != 6) {
+            return data;
+        }
+
+        auto child = std::make_unique<ShapingProxy>(static_cast<uint16_t>((p[0] << 8) | p[1]), m_profile);
+        if (!child->start()) {
+            return data;
+        }
+        uint16_t port = child->port();
+        {
+            std::lock_guard<std::mutex> lock(m_children_mutex);
+            m_children.push_back(std::move(child));
+        }
+        return data.substr(0, open) + "(127,0,0,1," + std::to_string(port >> 8) + "," + std::to_string(port & 0xFF) +
+               ")" + data.substr(close_pos + 1);
+    }
+
+    uint16_t                                   m_target_port;
+    LinkProfile                                m_profile;
+    bool                                       m_ftp_aware;
+    std::mutex                                 m_children_mutex;
+    std::vector<std::unique_ptr<ShapingProxy>> m_children;
+};
+
+}; // namespace bench
+}; // namespace RemoteDebug
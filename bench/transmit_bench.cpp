@@ -0,0 +1,366 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 传输后端吞吐基准：在回环地址上启动替身服务器，经整形代理模拟不同链路，输出 JSON 结果
+
+#include "shaping_proxy.h"
+#include "stub_server.h"
+#include "transmit/ftp_transmit.h"
+#include "transmit/net_util.h"
+#include "transmit/telnet_transmit.h"
+#ifdef REMOTEDEBUG_HAVE_LIBSSH2
+#include "transmit/ssh_transmit.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace RemoteDebug;
+
+namespace {
+
+constexpr const char *bench_username = "bench";
+constexpr const char *bench_password = "bench";
+
+struct Options {
+    std::vector<size_t>             sizes{ 64 * 1024, 1024 * 1024, 4 * 1024 * 1024 };
+    std::vector<std::string>        backends{ "ftp", "telnet", "ssh" };
+    std::vector<bench::LinkProfile> profiles;
+    int                             repeat{ 3 };
+};
+
+// 一个后端在某个链路配置下的被测对象
+struct Target {
+    std::string                                       backend;
+    TRANSMIT_TYPE                                     type;
+    uint16_t                                          port;
+    std::string                                       username;
+    std::string                                       password;
+    std::function<std::unique_ptr<RemoteTransmit>()>  create;
+};
+
+struct Sample {
+    double wall_ms{ 0 };
+    double cpu_ms{ 0 };
+    bool   ok{ false };
+};
+
+double thread_cpu_ms()
+{
+    rusage usage{};
+    getrusage(RUSAGE_THREAD, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+           static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+}
+
+double median(std::vector<double> values)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+size_t parse_size(const std::string &text)
+{
+    char *end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    switch (end && *end ? *end : ' ') {
+    case 'k': case 'K': value *= 1024; break;
+    case 'm': case 'M': value *= 1024 * 1024; break;
+    case 'g': case 'G': value *= 1024 * 1024 * 1024; break;
+    default: break;
+    }
+    return static_cast<size_t>(value);
+}
+
+std::vector<std::string> split(const std::string &text, char separator)
+{
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, separator)) {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+// 链路配置格式：name:单向时延毫秒:带宽Mbit（0 表示不限速）
+bool parse_profile(const std::string &text, bench::LinkProfile &profile)
+{
+    auto parts = split(text, ':');
+    if (parts.size() != 3) {
+        return false;
+    }
+    profile.name = parts[0];
+    profile.latency = std::chrono::microseconds(static_cast<int64_t>(std::strtod(parts[1].c_str(), nullptr) * 1000));
+    profile.bandwidth = static_cast<uint64_t>(std::strtod(parts[2].c_str(), nullptr) * 1000000 / 8);
+    return true;
+}
+
+void usage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [--sizes 64K,1M,4M] [--backends ftp,telnet,ssh] [--repeat N]\n"
+              << "       [--profile name:latency_ms:bandwidth_mbit]...\n"
+              << "Default profiles: loopback:0:0 lan:0.5:100\n"
+              << "SSH runs against a temporary sshd when REMOTEDEBUG_BENCH_SSH_USER/PASSWORD are set" << std::endl;
+}
+
+std::string json_escape(const std::string &text)
+{
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+std::string write_random_file(const std::string &dir, size_t size)
+{
+    std::string path = dir + "/payload_" + std::to_string(size);
+    std::mt19937_64 rng(size);
+    std::string data(size, '\0');
+    for (size_t i = 0; i + 8 <= size; i += 8) {
+        uint64_t v = rng();
+        std::memcpy(&data[i], &v, 8);
+    }
+    std::ofstream(path, std::ios::binary) << data;
+    return path;
+}
+
+off_t file_size(const std::string &path)
+{
+    struct stat st{};
+    return stat(path.c_str(), &st) == 0 ? st.st_size : -1;
+}
+
+/**
+ * @brief 在临时目录中启动 sshd（仅密码认证，不使用 PAM）
+ * @details 密码认证依赖本机账户，因此需要通过环境变量提供一个本地账户
+ */
+class SshdInstance {
+public:
+    ~SshdInstance()
+    {
+        if (m_pid > 0) {
+            kill(m_pid, SIGTERM);
+            waitpid(m_pid, nullptr, 0);
+        }
+    }
+
+    bool start(const std::string &dir)
+    {
+        const char *sshd = "/usr/sbin/sshd";
+        if (access(sshd, X_OK) != 0 || std::system(("ssh-keygen -q -t ed25519 -N '' -f " + dir +
+                                                    "/host_key >/dev/null 2>&1").c_str()) != 0) {
+            return false;
+        }
+
+        int fd = test::listen_loopback(m_port);
+        close(fd);
+        const std::string config = dir + "/sshd_config";
+        std::ofstream(config) << "Port " << m_port << "\nListenAddress 127.0.0.1\nHostKey " << dir
+                              << "/host_key\nPidFile " << dir << "/sshd.pid\nUsePAM no\n"
+                              << "PasswordAuthentication yes\nStrictModes no\n";
+
+        m_pid = fork();
+        if (m_pid == 0) {
+            execl(sshd, sshd, "-D", "-e", "-f", config.c_str(), static_cast<char *>(nullptr));
+            _exit(127);
+        }
+
+        // 等待端口可连接
+        for (int i = 0; i < 50; ++i) {
+            int probe = tcp_connect(test::loopback_ip, m_port, 100);
+            if (probe >= 0) {
+                close(probe);
+                return true;
+            }
+            usleep(100 * 1000);
+        }
+        return false;
+    }
+
+    uint16_t port() const { return m_port; }
+
+private:
+    pid_t    m_pid{ -1 };
+    uint16_t m_port{ 0 };
+};
+
+Sample run_once(const Target &target, uint16_t port, const std::string &file, const std::string &remote)
+{
+    Device_info device{ target.type, test::loopback_ip, port, file, target.username, target.password, remote };
+    std::remove(remote.c_str());
+
+    // 每次新建后端，耗时包含建连与登录
+    auto backend = target.create();
+    Sample sample;
+    double cpu_start = thread_cpu_ms();
+    auto start = std::chrono::steady_clock::now();
+    int ret = backend->transmit(device);
+    sample.wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    sample.cpu_ms = thread_cpu_ms() - cpu_start;
+    sample.ok = ret == 0 && file_size(remote) == file_size(file);
+    return sample;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        std::string value = argv[++i];
+        if (arg == "--sizes") {
+            options.sizes.clear();
+            for (const auto &size : split(value, ',')) {
+                options.sizes.push_back(parse_size(size));
+            }
+        } else if (arg == "--backends") {
+            options.backends = split(value, ',');
+        } else if (arg == "--repeat") {
+            options.repeat = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--profile") {
+            bench::LinkProfile profile;
+            if (!parse_profile(value, profile)) {
+                usage(argv[0]);
+                return 2;
+            }
+            options.profiles.push_back(profile);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (options.profiles.empty()) {
+        bench::LinkProfile profile;
+        parse_profile("loopback:0:0", profile);
+        options.profiles.push_back(profile);
+        parse_profile("lan:0.5:100", profile);
+        options.profiles.push_back(profile);
+    }
+
+    char root_template[] = "/tmp/transmit_bench_XXXXXX";
+    const std::string root = mkdtemp(root_template);
+    const std::string device_root = root + "/device";
+    mkdir(device_root.c_str(), 0755);
+
+    std::vector<std::string> payloads;
+    for (size_t size : options.sizes) {
+        payloads.push_back(write_random_file(root, size));
+    }
+    const std::string empty_payload = write_random_file(root, 0);
+
+    // 替身服务器与被测对象；FTP 替身按文件名保存到 device_root，与其他后端的远端路径一致
+    test::FtpStubServer ftp_server(device_root);
+    test::TelnetStubServer telnet_server(bench_username, bench_password);
+    SshdInstance sshd;
+    std::vector<Target> targets;
+    std::vector<std::string> skipped;
+    for (const auto &backend : options.backends) {
+        if (backend == "ftp" && ftp_server.start()) {
+            targets.push_back({ backend, TRANSMIT_TYPE::FTP, ftp_server.port(), bench_username, bench_password,
+                                [] { return std::make_unique<FtpTransmit>(); } });
+        } else if (backend == "telnet" && telnet_server.start()) {
+            targets.push_back({ backend, TRANSMIT_TYPE::TELNET, telnet_server.port(), bench_username, bench_password,
+                                [] { return std::make_unique<TelnetTransmit>(); } });
+        } else if (backend == "ssh") {
+#ifdef REMOTEDEBUG_HAVE_LIBSSH2
+            const char *user = std::getenv("REMOTEDEBUG_BENCH_SSH_USER");
+            const char *password = std::getenv("REMOTEDEBUG_BENCH_SSH_PASSWORD");
+            if (user && password && sshd.start(root)) {
+                targets.push_back({ backend, TRANSMIT_TYPE::SSH, sshd.port(), user, password,
+                                    [] { return std::make_unique<SshTransmit>(); } });
+                continue;
+            }
+#endif
+            skipped.push_back(backend);
+        } else {
+            skipped.push_back(backend);
+        }
+    }
+
+    std::ostringstream json;
+    json << "{\n  \"repeat\": " << options.repeat << ",\n  \"skipped\": [";
+    for (size_t i = 0; i < skipped.size(); ++i) {
+        json << (i ? ", " : "") << "\"" << json_escape(skipped[i]) << "\"";
+    }
+    json << "],\n  \"results\": [";
+
+    bool first = true;
+    for (const auto &profile : options.profiles) {
+        for (const auto &target : targets) {
+            bench::ShapingProxy proxy(target.port, profile, target.backend == "ftp");
+            if (!proxy.start()) {
+                std::cerr << "Failed to start shaping proxy" << std::endl;
+                continue;
+            }
+
+            // 握手开销：传输空文件的耗时（建连、登录与协议往返）
+            std::vector<double> handshake;
+            for (int r = 0; r < options.repeat; ++r) {
+                Sample sample = run_once(target, proxy.port(), empty_payload, device_root + "/bench_empty");
+                if (sample.ok) {
+                    handshake.push_back(sample.wall_ms);
+                }
+            }
+
+            for (size_t s = 0; s < options.sizes.size(); ++s) {
+                std::vector<double> wall;
+                std::vector<double> cpu;
+                int failures = 0;
+                for (int r = 0; r < options.repeat; ++r) {
+                    Sample sample = run_once(target, proxy.port(), payloads[s], device_root + "/bench_file");
+                    if (!sample.ok) {
+                        ++failures;
+                        continue;
+                    }
+                    wall.push_back(sample.wall_ms);
+                    cpu.push_back(sample.cpu_ms);
+                }
+
+                const double mb = static_cast<double>(options.sizes[s]) / (1024.0 * 1024.0);
+                const double wall_ms = median(wall);
+                json << (first ? "" : ",") << "\n    {\"backend\": \"" << target.backend << "\", \"profile\": \""
+                     << json_escape(profile.name) << "\", \"latency_ms\": "
+                     << static_cast<double>(profile.latency.count()) / 1000.0 << ", \"bandwidth_mbit\": "
+                     << static_cast<double>(profile.bandwidth) * 8 / 1000000.0 << ", \"size\": " << options.sizes[s]
+                     << ", \"runs\": " << wall.size() << ", \"failures\": " << failures
+                     << ", \"wall_ms\": " << wall_ms << ", \"throughput_mb_s\": " << (wall_ms > 0 ? mb * 1000.0 / wall_ms : 0)
+                     << ", \"handshake_ms\": " << median(handshake)
+                     << ", \"cpu_ms_per_mb\": " << (mb > 0 ? median(cpu) / mb : 0) << "}";
+                first = false;
+            }
+        }
+    }
+    json << "\n  ]\n}\n";
+    std::cout << json.str();
+
+    ftp_server.stop();
+    telnet_server.stop();
+    std::system(("rm -rf " + root).c_str());
+    return 0;
+}
@@ -0,0 +1,27 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 补丁包：补丁库导出补丁表，进程内代理加载补丁库后按表安装全部补丁
+
+#pragma once
+
+extern "C" {
+
+struct RemoteDebugPatch {
+    const char *target;      // 被替换的函数符号
+    const char *replacement; // 补丁库中的替换函数符号
+};
+
+} // extern "C"
+
+// 补丁表的导出符号名，表以 { nullptr, nullptr } 结尾
+#define REMOTEDEBUG_PATCH_TABLE_SYMBOL "remotedebug_patch_table"
+
+/**
+ * @brief 在补丁库中定义补丁表
+ * @details 用法：
+ *          REMOTEDEBUG_PATCH_TABLE = {
+ *              { "old_function", "new_function" },
+ *              { nullptr, nullptr },
+ *          };
+ */
+#define REMOTEDEBUG_PATCH_TABLE \
+    extern "C" __attribute__((visibility("default"))) const RemoteDebugPatch remotedebug_patch_table[]
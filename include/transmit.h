@@ -3,11 +3,13 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 namespace RemoteDebug {
 
-constexpr char *remote_file_path = "/tmp/remote_debug_file"; // 远端文件路径
+constexpr const char *remote_file_path = "/tmp/remote_debug_file"; // 远端文件路径
+constexpr const char *remote_tool_path = "/tmp/RemoteDebug";       // 远端热补丁工具路径
 
 enum class TRANSMIT_TYPE {
     FTP,
@@ -18,16 +20,24 @@ enum class TRANSMIT_TYPE {
 
 struct Device_info {
     TRANSMIT_TYPE     trans_type;         // 设备传输类型
-    uint32_t          ip{ UINT32_MAX };   // 设备IP地址
+    uint32_t          ip{ UINT32_MAX };   // 设备IP地址（主机字节序）
     uint32_t          port{ UINT32_MAX }; // 端口号
-    const std::string file_name;
+    const std::string file_name;          // 本地待发送文件
     const std::string m_username; // FTP用户名
     const std::string m_password; // FTP密码
+    const std::string remote_path{ remote_file_path }; // 远端文件路径
 };
 
 class RemoteTransmit {
-    public:
-    int transmit(Device_info) = 0; // 传输文件到远端
+public:
+    virtual ~RemoteTransmit() = default;
+    virtual int transmit(const Device_info &device_info) = 0; // 传输文件到远端，成功返回0
+
+    /**
+     * @brief 在远端执行命令并收集标准输出
+     * @return 返回命令退出码，传输方式不支持执行命令时返回-1
+     */
+    virtual int execute(const Device_info &, const std::string &, std::string &) { return -1; }
 };
 
 }; // namespace RemoteDebug
@@ -0,0 +1,218 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 非加密哈希函数：用于增量传输块校验、文件完整性比对
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#endif
+
+namespace RemoteDebug {
+
+namespace detail {
+
+constexpr uint64_t xxh_prime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t xxh_prime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t xxh_prime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t xxh_prime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t xxh_prime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl64(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t read_u64(const uint8_t *ptr)
+{
+    uint64_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+inline uint32_t read_u32(const uint8_t *ptr)
+{
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+inline uint64_t xxh64_round(uint64_t acc, uint64_t input)
+{
+    acc += input * xxh_prime2;
+    acc = rotl64(acc, 31);
+    return acc * xxh_prime1;
+}
+
+inline uint64_t xxh64_merge(uint64_t acc, uint64_t value)
+{
+    acc ^= xxh64_round(0, value);
+    return acc * xxh_prime1 + xxh_prime4;
+}
+
+constexpr uint32_t crc32c_polynomial = 0x82F63B78; // Castagnoli，按位反转
+
+// slicing-by-8 查找表，编译时生成
+struct Crc32cTables {
+    uint32_t table[8][256]{};
+
+    constexpr Crc32cTables()
+    {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (crc32c_polynomial & (0u - (crc & 1)));
+            }
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (size_t k = 1; k < 8; ++k) {
+                table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+inline constexpr Crc32cTables crc32c_tables{};
+
+inline uint32_t crc32c_software(uint32_t crc, const uint8_t *ptr, size_t size)
+{
+    const auto &t = crc32c_tables.table;
+    for (; size >= 8; ptr += 8, size -= 8) {
+        const uint64_t v = read_u64(ptr) ^ crc;
+        crc = t[7][v & 0xFF] ^ t[6][(v >> 8) & 0xFF] ^ t[5][(v >> 16) & 0xFF] ^ t[4][(v >> 24) & 0xFF] ^
+              t[3][(v >> 32) & 0xFF] ^ t[2][(v >> 40) & 0xFF] ^ t[1][(v >> 48) & 0xFF] ^ t[0][v >> 56];
+    }
+    for (; size > 0; --size) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *ptr++) & 0xFF];
+    }
+    return crc;
+}
+
+#if defined(__x86_64__)
+// SSE4.2 的 crc32 指令每次处理 8 字节
+__attribute__((target("sse4.2"))) inline uint32_t crc32c_hardware(uint32_t crc, const uint8_t *ptr, size_t size)
+{
+    uint64_t value = crc;
+    for (; size >= 8; ptr += 8, size -= 8) {
+        value = _mm_crc32_u64(value, read_u64(ptr));
+    }
+    crc = static_cast<uint32_t>(value);
+    for (; size > 0; --size) {
+        crc = _mm_crc32_u8(crc, *ptr++);
+    }
+    return crc;
+}
+
+inline bool crc32c_hardware_supported()
+{
+    return __builtin_cpu_supports("sse4.2");
+}
+#elif defined(__aarch64__)
+// ARMv8 CRC 扩展
+__attribute__((target("+crc"))) inline uint32_t crc32c_hardware(uint32_t crc, const uint8_t *ptr, size_t size)
+{
+    for (; size >= 8; ptr += 8, size -= 8) {
+        crc = __crc32cd(crc, read_u64(ptr));
+    }
+    for (; size > 0; --size) {
+        crc = __crc32cb(crc, *ptr++);
+    }
+    return crc;
+}
+
+inline bool crc32c_hardware_supported()
+{
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+}
+#else
+inline uint32_t crc32c_hardware(uint32_t crc, const uint8_t *ptr, size_t size)
+{
+    return crc32c_software(crc, ptr, size);
+}
+
+inline bool crc32c_hardware_supported()
+{
+    return false;
+}
+#endif
+
+} // namespace detail
+
+/**
+ * @brief XXH64 哈希（小端主机）
+ */
+inline uint64_t xxh64(const void *data, size_t size, uint64_t seed = 0)
+{
+    using namespace detail;
+    const uint8_t *ptr = static_cast<const uint8_t *>(data);
+    const uint8_t *end = ptr + size;
+    uint64_t hash;
+
+    if (size >= 32) {
+        uint64_t v1 = seed + xxh_prime1 + xxh_prime2;
+        uint64_t v2 = seed + xxh_prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - xxh_prime1;
+        const uint8_t *limit = end - 32;
+        do {
+            v1 = xxh64_round(v1, read_u64(ptr));
+            v2 = xxh64_round(v2, read_u64(ptr + 8));
+            v3 = xxh64_round(v3, read_u64(ptr + 16));
+            v4 = xxh64_round(v4, read_u64(ptr + 24));
+            ptr += 32;
+        } while (ptr <= limit);
+
+        hash = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        hash = xxh64_merge(hash, v1);
+        hash = xxh64_merge(hash, v2);
+        hash = xxh64_merge(hash, v3);
+        hash = xxh64_merge(hash, v4);
+    } else {
+        hash = seed + xxh_prime5;
+    }
+
+    hash += static_cast<uint64_t>(size);
+    for (; ptr + 8 <= end; ptr += 8) {
+        hash ^= xxh64_round(0, read_u64(ptr));
+        hash = rotl64(hash, 27) * xxh_prime1 + xxh_prime4;
+    }
+    if (ptr + 4 <= end) {
+        hash ^= static_cast<uint64_t>(read_u32(ptr)) * xxh_prime1;
+        hash = rotl64(hash, 23) * xxh_prime2 + xxh_prime3;
+        ptr += 4;
+    }
+    for (; ptr < end; ++ptr) {
+        hash ^= (*ptr) * xxh_prime5;
+        hash = rotl64(hash, 11) * xxh_prime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= xxh_prime2;
+    hash ^= hash >> 29;
+    hash *= xxh_prime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+/**
+ * @brief CRC32C（Castagnoli）
+ * @details CPU 支持时使用 SSE4.2 或 ARMv8 CRC 指令，否则查表计算，两者结果相同
+ * @param[in] crc 前一段数据的结果，用于分段计算
+ */
+inline uint32_t crc32c(const void *data, size_t size, uint32_t crc = 0)
+{
+    static const bool hardware = detail::crc32c_hardware_supported();
+    const auto *ptr = static_cast<const uint8_t *>(data);
+    crc = ~crc;
+    crc = hardware ? detail::crc32c_hardware(crc, ptr, size) : detail::crc32c_software(crc, ptr, size);
+    return ~crc;
+}
+
+}; // namespace RemoteDebug
@@ -0,0 +1,129 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "command_ring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace RemoteDebug {
+
+std::string command_ring_name(pid_t pid)
+{
+    return "/remotedebug_agent." + std::to_string(pid);
+}
+
+void ring_wait(std::atomic<uint32_t> &word, uint32_t expected, int timeout_ms)
+{
+    timespec timeout{ timeout_ms / 1000, (timeout_ms % 1000) * 1000000L };
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected, timeout_ms < 0 ? nullptr : &timeout,
+            nullptr, 0);
+}
+
+void ring_wake(std::atomic<uint32_t> &word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+}
+
+void ring_complete(CommandSlot &slot, const std::string &reply)
+{
+    size_t size = std::min(reply.size(), command_text_size - 1);
+    memcpy(slot.reply, reply.data(), size);
+    slot.reply[size] = '\0';
+    uint32_t expected = static_cast<uint32_t>(SLOT_STATE::PROCESSING);
+    if (!slot.state.compare_exchange_strong(expected, static_cast<uint32_t>(SLOT_STATE::DONE),
+                                            std::memory_order_acq_rel)) {
+        slot.state.store(static_cast<uint32_t>(SLOT_STATE::FREE), std::memory_order_release);
+        return;
+    }
+    ring_wake(slot.state);
+}
+
+int ring_request(pid_t pid, const std::string &request, std::string &reply, int timeout_ms)
+{
+    if (request.size() >= command_text_size) {
+        std::cerr << "Request is too long" << std::endl;
+        return -1;
+    }
+
+    std::string name = command_ring_name(pid);
+    int fd = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "No in-process agent in process " << pid << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+    struct stat st{};
+    void *mapped = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(CommandRing)) {
+        mapped = mmap(nullptr, sizeof(CommandRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Failed to map " << name << std::endl;
+        return -1;
+    }
+
+    auto *ring = static_cast<CommandRing *>(mapped);
+    int ret = -1;
+    CommandSlot *slot = nullptr;
+    if (ring->magic != command_ring_magic || ring->version != command_ring_version || ring->pid != pid) {
+        std::cerr << name << " is not a compatible command ring" << std::endl;
+    } else {
+        for (auto &candidate : ring->slots) {
+            uint32_t expected = static_cast<uint32_t>(SLOT_STATE::FREE);
+            if (candidate.state.compare_exchange_strong(expected, static_cast<uint32_t>(SLOT_STATE::WRITING))) {
+                slot = &candidate;
+                break;
+            }
+        }
+        if (!slot) {
+            std::cerr << "Command ring of process " << pid << " is full" << std::endl;
+        }
+    }
+
+    if (slot) {
+        memcpy(slot->request, request.c_str(), request.size() + 1);
+        slot->state.store(static_cast<uint32_t>(SLOT_STATE::READY), std::memory_order_release);
+        ring->doorbell.fetch_add(1, std::memory_order_release);
+        ring_wake(ring->doorbell);
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (true) {
+            uint32_t state = slot->state.load(std::memory_order_acquire);
+            if (state == static_cast<uint32_t>(SLOT_STATE::DONE)) {
+                reply.assign(slot->reply, strnlen(slot->reply, command_text_size));
+                slot->state.store(static_cast<uint32_t>(SLOT_STATE::FREE), std::memory_order_release);
+                ret = 0;
+                break;
+            }
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (left.count() <= 0) {
+                // 代理尚未取走的请求直接撤回，已在处理中的标记为放弃，由代理完成后释放
+                uint32_t expected = static_cast<uint32_t>(SLOT_STATE::READY);
+                if (!slot->state.compare_exchange_strong(expected, static_cast<uint32_t>(SLOT_STATE::FREE))) {
+                    expected = static_cast<uint32_t>(SLOT_STATE::PROCESSING);
+                    const auto abandoned = static_cast<uint32_t>(SLOT_STATE::ABANDONED);
+                    if (!slot->state.compare_exchange_strong(expected, abandoned)) {
+                        continue; // 恰好处理完成，下一轮读取回复
+                    }
+                }
+                std::cerr << "Timed out waiting for in-process agent of process " << pid << std::endl;
+                break;
+            }
+            ring_wait(slot->state, state, static_cast<int>(left.count()));
+        }
+    }
+
+    munmap(mapped, sizeof(CommandRing));
+    return ret;
+}
+
+}; // namespace RemoteDebug
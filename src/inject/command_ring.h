@@ -0,0 +1,84 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 进程内补丁代理的共享内存命令环：主机工具写入请求并敲门，代理线程处理后写回结果
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+
+namespace RemoteDebug {
+
+constexpr uint32_t command_ring_magic = 0x52444341; // "RDCA"
+constexpr uint32_t command_ring_version = 1;
+constexpr size_t   command_ring_slots = 8;
+constexpr size_t   command_text_size = 1024;
+constexpr int      command_ring_timeout_ms = 30000;
+
+enum class SLOT_STATE : uint32_t {
+    FREE,       // 空闲，客户端可通过 CAS 占用
+    WRITING,    // 客户端正在写入请求
+    READY,      // 请求已提交，等待代理处理
+    PROCESSING, // 代理正在处理
+    DONE,       // 回复已写入，由客户端读取后释放
+    ABANDONED,  // 客户端在处理中超时离开，代理处理完成后直接释放
+};
+
+struct CommandSlot {
+    std::atomic<uint32_t> state;
+    uint32_t              reserved;
+    char                  request[command_text_size];
+    char                  reply[command_text_size];
+};
+
+/**
+ * @brief 共享内存中的命令环，由进程内代理创建
+ * @details 客户端提交请求后递增 doorbell 并唤醒在其上等待的代理线程，
+ *          代理写回回复后唤醒在 slot.state 上等待的客户端。
+ *          两者都使用共享（非 PRIVATE）futex，不需要信号，也不会打断应用线程
+ */
+struct CommandRing {
+    uint32_t              magic;
+    uint32_t              version;
+    int32_t               pid;
+    std::atomic<uint32_t> doorbell;
+    CommandSlot           slots[command_ring_slots];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared memory atomics must be lock free");
+
+/**
+ * @brief 目标进程命令环的共享内存名称
+ */
+std::string command_ring_name(pid_t pid);
+
+/**
+ * @brief 在 futex 上等待值不再等于 expected
+ * @param[in] timeout_ms 超时时间，小于0表示一直等待
+ */
+void ring_wait(std::atomic<uint32_t> &word, uint32_t expected, int timeout_ms);
+
+/**
+ * @brief 唤醒在 futex 上等待的全部线程（可跨进程）
+ */
+void ring_wake(std::atomic<uint32_t> &word);
+
+/**
+ * @brief 代理处理完一个请求后写回回复
+ * @details 客户端已超时离开（ABANDONED）时直接释放槽位，否则置为 DONE 并唤醒客户端
+ */
+void ring_complete(CommandSlot &slot, const std::string &reply);
+
+/**
+ * @brief 向目标进程中的进程内代理发送一个请求并等待回复
+ * @param[in] pid 加载了 libremotedebug_agent.so 的进程
+ * @param[in] request 请求，格式与常驻补丁代理相同但不含 pid
+ * @param[out] reply 回复
+ * @return 成功收到回复返回0，代理不存在或超时返回-1
+ */
+int ring_request(pid_t pid, const std::string &request, std::string &reply,
+        int timeout_ms = command_ring_timeout_ms);
+
+}; // namespace RemoteDebug
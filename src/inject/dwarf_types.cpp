@@ -0,0 +1,815 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "dwarf_types.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <elf.h>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <link.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RemoteDebug {
+
+namespace {
+
+// DWARF 标签
+constexpr uint64_t tag_array_type = 0x01;
+constexpr uint64_t tag_class_type = 0x02;
+constexpr uint64_t tag_enumeration_type = 0x04;
+constexpr uint64_t tag_lexical_block = 0x0b;
+constexpr uint64_t tag_member = 0x0d;
+constexpr uint64_t tag_pointer_type = 0x0f;
+constexpr uint64_t tag_reference_type = 0x10;
+constexpr uint64_t tag_structure_type = 0x13;
+constexpr uint64_t tag_typedef = 0x16;
+constexpr uint64_t tag_union_type = 0x17;
+constexpr uint64_t tag_inlined_subroutine = 0x1d;
+constexpr uint64_t tag_base_type = 0x24;
+constexpr uint64_t tag_const_type = 0x26;
+constexpr uint64_t tag_subprogram = 0x2e;
+constexpr uint64_t tag_variable = 0x34;
+constexpr uint64_t tag_volatile_type = 0x35;
+constexpr uint64_t tag_restrict_type = 0x37;
+constexpr uint64_t tag_namespace = 0x39;
+constexpr uint64_t tag_rvalue_reference_type = 0x42;
+constexpr uint64_t tag_atomic_type = 0x47;
+
+// DWARF 属性
+constexpr uint64_t at_name = 0x03;
+constexpr uint64_t at_byte_size = 0x0b;
+constexpr uint64_t at_declaration = 0x3c;
+constexpr uint64_t at_encoding = 0x3e;
+constexpr uint64_t at_specification = 0x47;
+constexpr uint64_t at_type = 0x49;
+constexpr uint64_t at_linkage_name = 0x6e;
+constexpr uint64_t at_str_offsets_base = 0x72;
+constexpr uint64_t at_mips_linkage_name = 0x2007;
+
+// DWARF 基本类型编码
+constexpr uint8_t ate_address = 0x01;
+constexpr uint8_t ate_boolean = 0x02;
+constexpr uint8_t ate_float = 0x04;
+constexpr uint8_t ate_signed = 0x05;
+constexpr uint8_t ate_signed_char = 0x06;
+constexpr uint8_t ate_unsigned = 0x07;
+constexpr uint8_t ate_unsigned_char = 0x08;
+constexpr uint8_t ate_utf = 0x10;
+
+// DWARF 5 单元类型
+constexpr uint8_t ut_type = 0x02;
+constexpr uint8_t ut_skeleton = 0x04;
+constexpr uint8_t ut_split_compile = 0x05;
+constexpr uint8_t ut_split_type = 0x06;
+
+constexpr int max_type_hops = 32; // typedef/const 链的最大长度，防止损坏的数据造成死循环
+
+/**
+ * @brief 小端字节流读取，越界后置 bad 并返回 0
+ */
+struct Cursor {
+    const uint8_t *data{ nullptr };
+    size_t         size{ 0 };
+    size_t         pos{ 0 };
+    bool           bad{ false };
+
+    bool available(size_t n)
+    {
+        if (bad || n > size - pos) {
+            bad = true;
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t fixed(size_t n)
+    {
+        uint64_t value = 0;
+        if (available(n)) {
+            memcpy(&value, data + pos, n);
+            pos += n;
+        }
+        return value;
+    }
+
+    uint64_t uleb()
+    {
+        uint64_t value = 0;
+        for (unsigned shift = 0; available(1); shift += 7) {
+            uint8_t byte = data[pos++];
+            if (shift < 64) {
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            }
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        return 0;
+    }
+
+    int64_t sleb()
+    {
+        uint64_t value = 0;
+        unsigned shift = 0;
+        uint8_t byte = 0;
+        do {
+            if (!available(1)) {
+                return 0;
+            }
+            byte = data[pos++];
+            if (shift < 64) {
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            }
+            shift += 7;
+        } while (byte & 0x80);
+        if (shift < 64 && (byte & 0x40)) {
+            value |= ~0ULL << shift;
+        }
+        return static_cast<int64_t>(value);
+    }
+
+    const char *cstr()
+    {
+        if (bad || pos >= size) {
+            bad = true;
+            return "";
+        }
+        const void *end = memchr(data + pos, '\0', size - pos);
+        if (!end) {
+            bad = true;
+            return "";
+        }
+        const char *text = reinterpret_cast<const char *>(data + pos);
+        pos = static_cast<size_t>(static_cast<const uint8_t *>(end) - data) + 1;
+        return text;
+    }
+
+    void skip(uint64_t n)
+    {
+        if (available(static_cast<size_t>(n))) {
+            pos += static_cast<size_t>(n);
+        }
+    }
+};
+
+struct Section {
+    const uint8_t *data{ nullptr };
+    size_t         size{ 0 };
+};
+
+struct AttrSpec {
+    uint64_t name;
+    uint64_t form;
+    int64_t  implicit_const;
+};
+
+struct Abbrev {
+    uint64_t              tag{ 0 };
+    bool                  children{ false };
+    std::vector<AttrSpec> attrs;
+};
+
+struct Unit {
+    uint64_t offset{ 0 };
+    uint8_t  offset_size{ 4 };
+    uint8_t  address_size{ 8 };
+    uint16_t version{ 0 };
+    uint64_t str_offsets_base{ 0 };
+};
+
+// 属性值：数值、引用（.debug_info 内的绝对偏移）或几种字符串形式
+struct Value {
+    enum KIND : uint8_t { NONE, NUMBER, REF, STRING, STRP, LINE_STRP, STRX };
+    KIND        kind{ NONE };
+    uint64_t    number{ 0 };
+    const char *string{ nullptr };
+};
+
+struct Scope {
+    std::string name;
+    bool        local;
+};
+
+struct VarDie {
+    std::string qualified;
+    std::string linkage;
+    uint64_t    type{ 0 };
+    uint64_t    specification{ 0 };
+    bool        declaration{ false };
+};
+
+bool is_type_tag(uint64_t tag)
+{
+    switch (tag) {
+    case tag_array_type:
+    case tag_class_type:
+    case tag_enumeration_type:
+    case tag_pointer_type:
+    case tag_reference_type:
+    case tag_structure_type:
+    case tag_typedef:
+    case tag_union_type:
+    case tag_base_type:
+    case tag_const_type:
+    case tag_volatile_type:
+    case tag_restrict_type:
+    case tag_rvalue_reference_type:
+    case tag_atomic_type:
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+/**
+ * @brief .debug_info 解析，结果写入 DwarfTypes
+ */
+class DwarfParser {
+public:
+    DwarfParser(DwarfTypes &types, Section info, Section abbrev, Section str, Section line_str, Section str_offsets)
+        : m_types(types), m_info(info), m_abbrev(abbrev), m_str(str), m_line_str(line_str), m_str_offsets(str_offsets)
+    {
+    }
+
+    int parse()
+    {
+        Cursor cursor{ m_info.data, m_info.size };
+        while (cursor.pos < m_info.size && !cursor.bad) {
+            Unit unit;
+            unit.offset = cursor.pos;
+            uint64_t length = cursor.fixed(4);
+            if (length == 0xFFFFFFFF) {
+                length = cursor.fixed(8);
+                unit.offset_size = 8;
+            }
+            if (cursor.bad || length > m_info.size - cursor.pos) {
+                return -1;
+            }
+            size_t end = cursor.pos + static_cast<size_t>(length);
+            unit.version = static_cast<uint16_t>(cursor.fixed(2));
+            if (unit.version >= 2 && unit.version <= 5 && parse_unit(cursor, unit, end) != 0) {
+                return -1;
+            }
+            cursor.pos = end;
+        }
+        finish();
+        return 0;
+    }
+
+private:
+    int parse_unit(Cursor cursor, Unit &unit, size_t end)
+    {
+        uint8_t unit_type = 0;
+        uint64_t abbrev_offset = 0;
+        if (unit.version >= 5) {
+            unit_type = static_cast<uint8_t>(cursor.fixed(1));
+            unit.address_size = static_cast<uint8_t>(cursor.fixed(1));
+            abbrev_offset = cursor.fixed(unit.offset_size);
+            if (unit_type == ut_skeleton || unit_type == ut_split_compile) {
+                cursor.skip(8);
+            } else if (unit_type == ut_type || unit_type == ut_split_type) {
+                cursor.skip(8 + unit.offset_size);
+            }
+        } else {
+            abbrev_offset = cursor.fixed(unit.offset_size);
+            unit.address_size = static_cast<uint8_t>(cursor.fixed(1));
+        }
+        const auto *abbrevs = abbrev_table(abbrev_offset);
+        if (cursor.bad || !abbrevs) {
+            return -1;
+        }
+
+        cursor.size = end;
+        std::vector<Scope> scopes;
+        while (cursor.pos < end) {
+            uint64_t offset = cursor.pos;
+            uint64_t code = cursor.uleb();
+            if (code == 0) {
+                if (!scopes.empty()) {
+                    scopes.pop_back();
+                }
+                continue;
+            }
+            auto it = abbrevs->find(code);
+            if (cursor.bad || it == abbrevs->end()) {
+                return -1;
+            }
+            const Abbrev &abbrev = it->second;
+
+            Value name;
+            Value linkage;
+            DwarfTypes::TypeDie die;
+            VarDie var;
+            die.tag = static_cast<uint16_t>(abbrev.tag);
+            for (const auto &attr : abbrev.attrs) {
+                Value value;
+                if (!read_value(cursor, attr.form, attr.implicit_const, unit, value)) {
+                    return -1;
+                }
+                switch (attr.name) {
+                case at_name: name = value; break;
+                case at_linkage_name:
+                case at_mips_linkage_name: linkage = value; break;
+                case at_type: die.type = value.kind == Value::REF ? value.number : 0; break;
+                case at_specification: var.specification = value.kind == Value::REF ? value.number : 0; break;
+                case at_byte_size: die.byte_size = value.number; break;
+                case at_encoding: die.encoding = static_cast<uint8_t>(value.number); break;
+                case at_declaration: var.declaration = value.number != 0; break;
+                case at_str_offsets_base: unit.str_offsets_base = value.number; break;
+                default: break;
+                }
+            }
+            if (cursor.bad) {
+                return -1;
+            }
+
+            const char *text = string(name, unit);
+            bool local = !scopes.empty() && scopes.back().local;
+            if (is_type_tag(abbrev.tag)) {
+                die.name = text ? text : "";
+                m_types.m_types.emplace(offset, std::move(die));
+            } else if (!local && (abbrev.tag == tag_variable || (abbrev.tag == tag_member && var.declaration))) {
+                // DWARF 4 的静态成员是带 DW_AT_declaration 的 DW_TAG_member，DWARF 5 改为 DW_TAG_variable
+                if (text) {
+                    var.qualified = qualify(scopes, text);
+                }
+                const char *mangled = string(linkage, unit);
+                var.linkage = mangled ? mangled : "";
+                var.type = die.type;
+                m_vars.emplace(offset, std::move(var));
+            }
+
+            if (abbrev.children) {
+                bool scope_local = local || abbrev.tag == tag_subprogram || abbrev.tag == tag_lexical_block ||
+                                   abbrev.tag == tag_inlined_subroutine;
+                std::string scope_name;
+                if (abbrev.tag == tag_namespace) {
+                    scope_name = text ? text : "(anonymous namespace)";
+                } else if ((abbrev.tag == tag_class_type || abbrev.tag == tag_structure_type ||
+                            abbrev.tag == tag_union_type) && text) {
+                    scope_name = text;
+                }
+                scopes.push_back({ std::move(scope_name), scope_local });
+            }
+        }
+        return 0;
+    }
+
+    // 变量定义从 DW_AT_specification 指向的声明继承名称与类型；定义优先于仅有声明的变量
+    void finish()
+    {
+        for (bool definitions : { true, false }) {
+            for (const auto &entry : m_vars) {
+                const VarDie &var = entry.second;
+                if (var.declaration == definitions) {
+                    continue;
+                }
+                const VarDie *decl = nullptr;
+                if (var.specification) {
+                    auto it = m_vars.find(var.specification);
+                    decl = it != m_vars.end() ? &it->second : nullptr;
+                }
+                const std::string &qualified = var.qualified.empty() && decl ? decl->qualified : var.qualified;
+                const std::string &linkage = var.linkage.empty() && decl ? decl->linkage : var.linkage;
+                uint64_t type = var.type == 0 && decl ? decl->type : var.type;
+                for (const std::string *key : { &qualified, &linkage }) {
+                    if (key->empty()) {
+                        continue;
+                    }
+                    if (definitions) {
+                        m_types.m_variables[*key] = type;
+                    } else {
+                        m_types.m_variables.emplace(*key, type);
+                    }
+                }
+            }
+        }
+    }
+
+    static std::string qualify(const std::vector<Scope> &scopes, const char *name)
+    {
+        std::string qualified;
+        for (const auto &scope : scopes) {
+            if (!scope.name.empty()) {
+                qualified += scope.name + "::";
+            }
+        }
+        return qualified + name;
+    }
+
+    const std::unordered_map<uint64_t, Abbrev> *abbrev_table(uint64_t offset)
+    {
+        auto cached = m_abbrevs.find(offset);
+        if (cached != m_abbrevs.end()) {
+            return &cached->second;
+        }
+        if (offset >= m_abbrev.size) {
+            return nullptr;
+        }
+
+        Cursor cursor{ m_abbrev.data, m_abbrev.size, static_cast<size_t>(offset) };
+        std::unordered_map<uint64_t, Abbrev> table;
+        while (!cursor.bad) {
+            uint64_t code = cursor.uleb();
+            if (code == 0) {
+                break;
+            }
+            Abbrev abbrev;
+            abbrev.tag = cursor.uleb();
+            abbrev.children = cursor.fixed(1) != 0;
+            while (!cursor.bad) {
+                AttrSpec attr{ cursor.uleb(), cursor.uleb(), 0 };
+                if (attr.name == 0 && attr.form == 0) {
+                    break;
+                }
+                if (attr.form == 0x21) { // DW_FORM_implicit_const
+                    attr.implicit_const = cursor.sleb();
+                }
+                abbrev.attrs.push_back(attr);
+            }
+            table.emplace(code, std::move(abbrev));
+        }
+        if (cursor.bad) {
+            return nullptr;
+        }
+        return &m_abbrevs.emplace(offset, std::move(table)).first->second;
+    }
+
+    static bool read_value(Cursor &cursor, uint64_t form, int64_t implicit_const, const Unit &unit, Value &value)
+    {
+        value.kind = Value::NUMBER;
+        switch (form) {
+        case 0x01: value.number = cursor.fixed(unit.address_size); break;           // addr
+        case 0x03: value.kind = Value::NONE; cursor.skip(cursor.fixed(2)); break;   // block2
+        case 0x04: value.kind = Value::NONE; cursor.skip(cursor.fixed(4)); break;   // block4
+        case 0x09:                                                                  // block
+        case 0x18: value.kind = Value::NONE; cursor.skip(cursor.uleb()); break;     // exprloc
+        case 0x0a: value.kind = Value::NONE; cursor.skip(cursor.fixed(1)); break;   // block1
+        case 0x0b:                                                                  // data1
+        case 0x0c:                                                                  // flag
+        case 0x29: value.number = cursor.fixed(1); break;                           // addrx1
+        case 0x05:                                                                  // data2
+        case 0x2a: value.number = cursor.fixed(2); break;                           // addrx2
+        case 0x2b: value.number = cursor.fixed(3); break;                           // addrx3
+        case 0x06:                                                                  // data4
+        case 0x2c: value.number = cursor.fixed(4); break;                           // addrx4
+        case 0x07: value.number = cursor.fixed(8); break;                           // data8
+        case 0x1e: value.kind = Value::NONE; cursor.skip(16); break;                // data16
+        case 0x08: value.kind = Value::STRING; value.string = cursor.cstr(); break;  // string
+        case 0x0d: value.number = static_cast<uint64_t>(cursor.sleb()); break;      // sdata
+        case 0x0f:                                                                  // udata
+        case 0x1b:                                                                  // addrx
+        case 0x22:                                                                  // loclistx
+        case 0x23:                                                                  // rnglistx
+        case 0x1f01: value.number = cursor.uleb(); break;                           // GNU_addr_index
+        case 0x17: value.number = cursor.fixed(unit.offset_size); break;            // sec_offset
+        case 0x0e: value.kind = Value::STRP; value.number = cursor.fixed(unit.offset_size); break;
+        case 0x1f: value.kind = Value::LINE_STRP; value.number = cursor.fixed(unit.offset_size); break;
+        case 0x1a:                                                                  // strx
+        case 0x1f02: value.kind = Value::STRX; value.number = cursor.uleb(); break; // GNU_str_index
+        case 0x25: value.kind = Value::STRX; value.number = cursor.fixed(1); break;
+        case 0x26: value.kind = Value::STRX; value.number = cursor.fixed(2); break;
+        case 0x27: value.kind = Value::STRX; value.number = cursor.fixed(3); break;
+        case 0x28: value.kind = Value::STRX; value.number = cursor.fixed(4); break;
+        case 0x11: value.kind = Value::REF; value.number = unit.offset + cursor.fixed(1); break;
+        case 0x12: value.kind = Value::REF; value.number = unit.offset + cursor.fixed(2); break;
+        case 0x13: value.kind = Value::REF; value.number = unit.offset + cursor.fixed(4); break;
+        case 0x14: value.kind = Value::REF; value.number = unit.offset + cursor.fixed(8); break;
+        case 0x15: value.kind = Value::REF; value.number = unit.offset + cursor.uleb(); break;
+        case 0x10:                                                                  // ref_addr
+            value.kind = Value::REF;
+            value.number = cursor.fixed(unit.version <= 2 ? unit.address_size : unit.offset_size);
+            break;
+        case 0x1d:                                                                  // strp_sup
+        case 0x1f20:                                                                // GNU_ref_alt
+        case 0x1f21: value.kind = Value::NONE; cursor.skip(unit.offset_size); break; // GNU_strp_alt
+        case 0x1c: value.kind = Value::NONE; cursor.skip(4); break;                 // ref_sup4
+        case 0x20:                                                                  // ref_sig8
+        case 0x24: value.kind = Value::NONE; cursor.skip(8); break;                 // ref_sup8
+        case 0x19: value.number = 1; break;                                         // flag_present
+        case 0x21: value.number = static_cast<uint64_t>(implicit_const); break;     // implicit_const
+        case 0x16: return read_value(cursor, cursor.uleb(), implicit_const, unit, value); // indirect
+        default:
+            return false;
+        }
+        return !cursor.bad;
+    }
+
+    const char *string(const Value &value, const Unit &unit) const
+    {
+        uint64_t offset = value.number;
+        const Section *section = &m_str;
+        switch (value.kind) {
+        case Value::STRING:
+            return value.string;
+        case Value::STRP:
+            break;
+        case Value::LINE_STRP:
+            section = &m_line_str;
+            break;
+        case Value::STRX: {
+            // 未设置 DW_AT_str_offsets_base 时（仅 CU 自身的属性）跳过 DWARF 5 的段头
+            uint64_t base = unit.str_offsets_base ? unit.str_offsets_base : (unit.offset_size == 8 ? 16 : 8);
+            Cursor cursor{ m_str_offsets.data, m_str_offsets.size };
+            cursor.skip(base + offset * unit.offset_size);
+            offset = cursor.fixed(unit.offset_size);
+            if (cursor.bad) {
+                return nullptr;
+            }
+            break;
+        }
+        default:
+            return nullptr;
+        }
+        if (offset >= section->size || !memchr(section->data + offset, '\0', section->size - offset)) {
+            return nullptr;
+        }
+        return reinterpret_cast<const char *>(section->data + offset);
+    }
+
+    DwarfTypes                                                        &m_types;
+    Section                                                            m_info;
+    Section                                                            m_abbrev;
+    Section                                                            m_str;
+    Section                                                            m_line_str;
+    Section                                                            m_str_offsets;
+    std::unordered_map<uint64_t, std::unordered_map<uint64_t, Abbrev>> m_abbrevs;
+    std::unordered_map<uint64_t, VarDie>                               m_vars;
+};
+
+int DwarfTypes::load(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Failed to open " << path << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ElfW(Ehdr))) {
+        close(fd);
+        std::cerr << path << " is not an ELF file" << std::endl;
+        return -1;
+    }
+    size_t image_size = static_cast<size_t>(st.st_size);
+    void *mapped = mmap(nullptr, image_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Failed to map " << path << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    const auto *image = static_cast<const uint8_t *>(mapped);
+    const auto *ehdr = reinterpret_cast<const ElfW(Ehdr) *>(image);
+    m_types.clear();
+    m_variables.clear();
+    m_debug_info = false;
+    int ret = 0;
+    if (memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 || ehdr->e_ident[EI_CLASS] != ELFCLASS64 ||
+        ehdr->e_ident[EI_DATA] != ELFDATA2LSB || ehdr->e_shoff + ehdr->e_shnum * sizeof(ElfW(Shdr)) > image_size ||
+        ehdr->e_shstrndx >= ehdr->e_shnum) {
+        std::cerr << path << " is not a 64-bit little-endian ELF file" << std::endl;
+        ret = -1;
+    } else {
+        const auto *shdrs = reinterpret_cast<const ElfW(Shdr) *>(image + ehdr->e_shoff);
+        const ElfW(Shdr) &names = shdrs[ehdr->e_shstrndx];
+        Section info, abbrev, str, line_str, str_offsets;
+        bool compressed = false;
+        for (size_t i = 0; i < ehdr->e_shnum && names.sh_offset + names.sh_size <= image_size; ++i) {
+            const ElfW(Shdr) &shdr = shdrs[i];
+            if (shdr.sh_type == SHT_NOBITS || shdr.sh_name >= names.sh_size ||
+                shdr.sh_offset + shdr.sh_size > image_size) {
+                continue;
+            }
+            std::string name(reinterpret_cast<const char *>(image + names.sh_offset + shdr.sh_name),
+                             strnlen(reinterpret_cast<const char *>(image + names.sh_offset + shdr.sh_name),
+                                     names.sh_size - shdr.sh_name));
+            Section section{ image + shdr.sh_offset, shdr.sh_size };
+            Section *target = name == ".debug_info"          ? &info
+                              : name == ".debug_abbrev"      ? &abbrev
+                              : name == ".debug_str"         ? &str
+                              : name == ".debug_line_str"    ? &line_str
+                              : name == ".debug_str_offsets" ? &str_offsets
+                                                             : nullptr;
+            if (target) {
+                *target = section;
+                compressed = compressed || (shdr.sh_flags & SHF_COMPRESSED);
+            }
+        }
+
+        if (compressed) {
+            std::cerr << path << ": compressed debug sections are not supported" << std::endl;
+        } else if (info.size && abbrev.size) {
+            m_debug_info = true;
+            if (DwarfParser(*this, info, abbrev, str, line_str, str_offsets).parse() != 0) {
+                std::cerr << path << ": malformed .debug_info" << std::endl;
+                ret = -1;
+            }
+        }
+    }
+
+    munmap(mapped, image_size);
+    return ret;
+}
+
+bool DwarfTypes::find(const std::string &name, VariableType &type) const
+{
+    auto it = m_variables.find(name);
+    if (it == m_variables.end()) {
+        return false;
+    }
+
+    type = VariableType();
+    uint64_t offset = it->second;
+    for (int hop = 0; offset != 0 && hop < max_type_hops; ++hop) {
+        auto die = m_types.find(offset);
+        if (die == m_types.end()) {
+            break;
+        }
+        const TypeDie &t = die->second;
+        if (type.name.empty()) {
+            type.name = t.name;
+        }
+        switch (t.tag) {
+        case tag_const_type:
+            type.is_const = true;
+            offset = t.type;
+            continue;
+        case tag_typedef:
+        case tag_volatile_type:
+        case tag_restrict_type:
+        case tag_atomic_type:
+            offset = t.type;
+            continue;
+        case tag_base_type:
+            type.size = t.byte_size;
+            switch (t.encoding) {
+            case ate_boolean: type.kind = VALUE_KIND::BOOL; break;
+            case ate_float: type.kind = VALUE_KIND::FLOAT; break;
+            case ate_signed:
+            case ate_signed_char: type.kind = VALUE_KIND::SIGNED; break;
+            case ate_address:
+            case ate_unsigned:
+            case ate_unsigned_char:
+            case ate_utf: type.kind = VALUE_KIND::UNSIGNED; break;
+            default: type.kind = VALUE_KIND::AGGREGATE; break;
+            }
+            return true;
+        case tag_enumeration_type:
+            type.kind = VALUE_KIND::ENUM;
+            type.size = t.byte_size;
+            return true;
+        case tag_pointer_type:
+        case tag_reference_type:
+        case tag_rvalue_reference_type:
+            type.kind = VALUE_KIND::POINTER;
+            type.size = t.byte_size ? t.byte_size : sizeof(void *);
+            if (type.name.empty()) {
+                type.name = "pointer";
+            }
+            return true;
+        default:
+            type.kind = VALUE_KIND::AGGREGATE;
+            type.size = t.byte_size;
+            return true;
+        }
+    }
+    return true;
+}
+
+int encode_value(const VariableType &type, const std::string &text, std::vector<uint8_t> &bytes, std::string &error)
+{
+    const size_t size = static_cast<size_t>(type.size);
+    bool integer = type.kind == VALUE_KIND::SIGNED || type.kind == VALUE_KIND::UNSIGNED ||
+                   type.kind == VALUE_KIND::ENUM || type.kind == VALUE_KIND::BOOL || type.kind == VALUE_KIND::UNKNOWN;
+    if (integer && size != 1 && size != 2 && size != 4 && size != 8) {
+        error = "unsupported " + std::to_string(size) + "-byte integer";
+        return -1;
+    }
+
+    uint64_t raw = 0;
+    const char *begin = text.c_str();
+    char *end = nullptr;
+    errno = 0;
+    switch (type.kind) {
+    case VALUE_KIND::BOOL:
+        if (text != "true" && text != "false" && text != "1" && text != "0") {
+            error = "expected true or false, got '" + text + "'";
+            return -1;
+        }
+        raw = text == "true" || text == "1";
+        break;
+    case VALUE_KIND::FLOAT:
+        bytes.assign(size, 0);
+        if (size == sizeof(float)) {
+            float value = std::strtof(begin, &end);
+            memcpy(bytes.data(), &value, sizeof(value));
+        } else if (size == sizeof(double)) {
+            double value = std::strtod(begin, &end);
+            memcpy(bytes.data(), &value, sizeof(value));
+        } else {
+            error = "unsupported " + std::to_string(size) + "-byte floating point";
+            return -1;
+        }
+        if (text.empty() || *end != '\0' || errno == ERANGE) {
+            error = "invalid floating point value '" + text + "'";
+            return -1;
+        }
+        return 0;
+    case VALUE_KIND::SIGNED:
+    case VALUE_KIND::ENUM:
+    case VALUE_KIND::UNSIGNED:
+    case VALUE_KIND::UNKNOWN: {
+        bool negative = text.find('-') == 0;
+        if (negative && type.kind == VALUE_KIND::UNSIGNED) {
+            error = "negative value for unsigned type";
+            return -1;
+        }
+        const unsigned bits = static_cast<unsigned>(size * 8);
+        if (negative) {
+            long long value = std::strtoll(begin, &end, 0);
+            long long min = bits == 64 ? std::numeric_limits<long long>::min() : -(1LL << (bits - 1));
+            if (value < min) {
+                errno = ERANGE;
+            }
+            raw = static_cast<uint64_t>(value);
+        } else {
+            unsigned long long value = std::strtoull(begin, &end, 0);
+            // 有符号类型的正数不能超过最大值，未知类型按无符号处理
+            unsigned limit_bits = type.kind == VALUE_KIND::SIGNED || type.kind == VALUE_KIND::ENUM ? bits - 1 : bits;
+            if (limit_bits < 64 && value >= (1ULL << limit_bits)) {
+                errno = ERANGE;
+            }
+            raw = value;
+        }
+        if (text.empty() || *end != '\0' || errno == ERANGE) {
+            error = "value '" + text + "' does not fit " + (type.name.empty() ? "the variable" : type.name);
+            return -1;
+        }
+        break;
+    }
+    default:
+        error = "cannot set " + std::string(type.kind == VALUE_KIND::POINTER ? "pointer" : "aggregate") + " variable";
+        return -1;
+    }
+
+    bytes.assign(size, 0);
+    memcpy(bytes.data(), &raw, size);
+    return 0;
+}
+
+std::string format_value(const VariableType &type, const uint8_t *bytes)
+{
+    const size_t size = static_cast<size_t>(type.size);
+    std::ostringstream oss;
+    uint64_t raw = 0;
+    if (size <= sizeof(raw)) {
+        memcpy(&raw, bytes, size);
+    }
+    switch (type.kind) {
+    case VALUE_KIND::SIGNED:
+    case VALUE_KIND::ENUM:
+        if (size < sizeof(raw) && size > 0 && (raw >> (size * 8 - 1)) & 1) {
+            raw |= ~0ULL << (size * 8);
+        }
+        oss << static_cast<int64_t>(raw);
+        break;
+    case VALUE_KIND::UNSIGNED:
+        oss << raw;
+        break;
+    case VALUE_KIND::BOOL:
+        oss << (raw ? "true" : "false");
+        break;
+    case VALUE_KIND::FLOAT:
+        if (size == sizeof(float)) {
+            float value;
+            memcpy(&value, bytes, sizeof(value));
+            oss << std::setprecision(std::numeric_limits<float>::max_digits10) << value;
+        } else if (size == sizeof(double)) {
+            double value;
+            memcpy(&value, bytes, sizeof(value));
+            oss << std::setprecision(std::numeric_limits<double>::max_digits10) << value;
+        } else {
+            oss << "<" << size << "-byte float>";
+        }
+        break;
+    default:
+        if (size > sizeof(raw)) {
+            oss << "<" << size << " bytes>";
+        } else {
+            oss << "0x" << std::hex << raw;
+        }
+        break;
+    }
+    return oss.str();
+}
+
+}; // namespace RemoteDebug
@@ -0,0 +1,84 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// DWARF 变量类型索引：从 .debug_info 中读取全局变量与静态成员的类型，用于数据补丁前检查大小与类型
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace RemoteDebug {
+
+enum class VALUE_KIND : uint8_t {
+    SIGNED,
+    UNSIGNED,
+    FLOAT,
+    BOOL,
+    ENUM,
+    POINTER,
+    AGGREGATE, // 结构体、联合体、数组
+    UNKNOWN,   // 没有调试信息，只知道符号大小
+};
+
+struct VariableType {
+    std::string name;                      // 类型名，如 "size_t"，取类型链上第一个有名字的类型
+    VALUE_KIND  kind{ VALUE_KIND::UNKNOWN };
+    uint64_t    size{ 0 };
+    bool        is_const{ false };
+};
+
+/**
+ * @brief 单个 ELF 文件的 DWARF 变量索引
+ * @details 支持 DWARF 2-5 的 .debug_info（不支持压缩的调试段与分离的调试文件）。
+ *          以限定名（"ns::Service::queue_depth"）和链接名（mangled）为键；
+ *          函数内的变量不建立索引
+ */
+class DwarfTypes {
+public:
+    /**
+     * @brief 读取 ELF 文件的调试信息，没有 .debug_info 时索引为空
+     * @return 成功返回0，文件无法读取或调试信息损坏返回-1
+     */
+    int load(const std::string &path);
+
+    /**
+     * @brief 按限定名或链接名查找变量类型
+     * @return 未找到返回 false
+     */
+    bool find(const std::string &name, VariableType &type) const;
+
+    bool has_debug_info() const { return m_debug_info; }
+    size_t size() const { return m_variables.size(); }
+
+private:
+    struct TypeDie {
+        uint16_t    tag{ 0 };
+        std::string name;
+        uint64_t    byte_size{ 0 };
+        uint64_t    type{ 0 };     // 引用的类型在 .debug_info 中的偏移，0 表示 void
+        uint8_t     encoding{ 0 };
+    };
+
+    friend class DwarfParser;
+
+    std::unordered_map<uint64_t, TypeDie>     m_types;
+    std::unordered_map<std::string, uint64_t> m_variables; // 变量名 -> 类型偏移
+    bool                                      m_debug_info{ false };
+};
+
+/**
+ * @brief 按变量类型将文本解析为内存中的字节（本机字节序）
+ * @param[out] bytes 与 type.size 等长
+ * @param[out] error 失败原因
+ * @return 成功返回0，类型不支持或数值越界返回-1
+ */
+int encode_value(const VariableType &type, const std::string &text, std::vector<uint8_t> &bytes, std::string &error);
+
+/**
+ * @brief 按变量类型格式化内存中的值
+ */
+std::string format_value(const VariableType &type, const uint8_t *bytes);
+
+}; // namespace RemoteDebug
@@ -0,0 +1,173 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "elf_symbols.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <iostream>
+#include <link.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RemoteDebug {
+
+namespace {
+
+#if defined(__x86_64__)
+constexpr uint16_t native_machine = EM_X86_64;
+#elif defined(__aarch64__)
+constexpr uint16_t native_machine = EM_AARCH64;
+#else
+constexpr uint16_t native_machine = EM_NONE;
+#endif
+
+constexpr uint64_t page_mask = ~static_cast<uint64_t>(0xFFF);
+
+// 读取一个符号表中已定义的符号
+void visit_table(const uint8_t *image, size_t image_size, size_t symtab_index,
+        const std::function<void(const char *, const ElfSymbol &)> &visit)
+{
+    const auto *ehdr = reinterpret_cast<const ElfW(Ehdr) *>(image);
+    const auto *shdrs = reinterpret_cast<const ElfW(Shdr) *>(image + ehdr->e_shoff);
+    const ElfW(Shdr) &symtab = shdrs[symtab_index];
+    if (symtab.sh_link >= ehdr->e_shnum || symtab.sh_entsize != sizeof(ElfW(Sym)) ||
+        symtab.sh_offset + symtab.sh_size > image_size) {
+        return;
+    }
+    const ElfW(Shdr) &strtab = shdrs[symtab.sh_link];
+    if (strtab.sh_offset + strtab.sh_size > image_size) {
+        return;
+    }
+
+    const auto *symbols = reinterpret_cast<const ElfW(Sym) *>(image + symtab.sh_offset);
+    const char *strings = reinterpret_cast<const char *>(image + strtab.sh_offset);
+    size_t count = symtab.sh_size / sizeof(ElfW(Sym));
+    for (size_t i = 1; i < count; ++i) {
+        const ElfW(Sym) &sym = symbols[i];
+        uint8_t type = ELF64_ST_TYPE(sym.st_info);
+        if (sym.st_shndx == SHN_UNDEF || sym.st_name >= strtab.sh_size || type == STT_SECTION || type == STT_FILE) {
+            continue;
+        }
+        const char *name = strings + sym.st_name;
+        if (*name == '\0' || memchr(name, '\0', strtab.sh_size - sym.st_name) == nullptr) {
+            continue;
+        }
+        visit(name, ElfSymbol{ sym.st_value, sym.st_size, type, static_cast<uint8_t>(ELF64_ST_BIND(sym.st_info)) });
+    }
+}
+
+} // namespace
+
+int read_elf_symbols(const std::string &path,
+        const std::function<void(const char *name, const ElfSymbol &symbol)> &visit, uint64_t &load_address)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Failed to open " << path << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ElfW(Ehdr))) {
+        close(fd);
+        std::cerr << path << " is not an ELF file" << std::endl;
+        return -1;
+    }
+    size_t image_size = static_cast<size_t>(st.st_size);
+    void *mapped = mmap(nullptr, image_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Failed to map " << path << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    const auto *image = static_cast<const uint8_t *>(mapped);
+    const auto *ehdr = reinterpret_cast<const ElfW(Ehdr) *>(image);
+    int ret = -1;
+    if (memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 || ehdr->e_ident[EI_CLASS] != ELFCLASS64 ||
+        ehdr->e_machine != native_machine) {
+        std::cerr << path << " is not a native 64-bit ELF file" << std::endl;
+    } else if (ehdr->e_phoff + ehdr->e_phnum * sizeof(ElfW(Phdr)) > image_size ||
+               ehdr->e_shoff + ehdr->e_shnum * sizeof(ElfW(Shdr)) > image_size) {
+        std::cerr << path << " has truncated headers" << std::endl;
+    } else {
+        bool have_load = false;
+        const auto *phdrs = reinterpret_cast<const ElfW(Phdr) *>(image + ehdr->e_phoff);
+        for (size_t i = 0; i < ehdr->e_phnum; ++i) {
+            if (phdrs[i].p_type != PT_LOAD) {
+                continue;
+            }
+            uint64_t address = (phdrs[i].p_vaddr - phdrs[i].p_offset) & page_mask;
+            if (!have_load || address < load_address) {
+                load_address = address;
+                have_load = true;
+            }
+        }
+
+        const auto *shdrs = reinterpret_cast<const ElfW(Shdr) *>(image + ehdr->e_shoff);
+        for (uint32_t wanted : { SHT_SYMTAB, SHT_DYNSYM }) {
+            for (size_t i = 0; i < ehdr->e_shnum; ++i) {
+                if (shdrs[i].sh_type == wanted) {
+                    visit_table(image, image_size, i, visit);
+                }
+            }
+        }
+        ret = 0;
+    }
+
+    munmap(mapped, image_size);
+    return ret;
+}
+
+int ElfSymbols::load(const std::string &path)
+{
+    // 先加载 .symtab 再加载 .dynsym，两者同名时保持一致
+    m_symbols.clear();
+    return read_elf_symbols(
+            path,
+            [this](const char *name, const ElfSymbol &symbol) {
+                auto result = m_symbols.emplace(name, symbol);
+                if (!result.second && result.first->second.bind == STB_LOCAL && symbol.bind != STB_LOCAL) {
+                    result.first->second = symbol;
+                }
+            },
+            m_load_address);
+}
+
+const ElfSymbol *ElfSymbols::find(const std::string &name) const
+{
+    auto it = m_symbols.find(name);
+    return it == m_symbols.end() ? nullptr : &it->second;
+}
+
+const ElfSymbol *ElfSymbols::find_object(const std::string &name, std::string *symbol_name) const
+{
+    auto it = m_symbols.find(name);
+    if (it == m_symbols.end() && name.find("::") != std::string::npos) {
+        // 只还原数据符号的名称，C++ 名称查找较少使用，不常驻还原后的索引
+        for (it = m_symbols.begin(); it != m_symbols.end(); ++it) {
+            if ((it->second.type != STT_OBJECT && it->second.type != STT_TLS) || it->first.compare(0, 2, "_Z") != 0) {
+                continue;
+            }
+            int status = 0;
+            char *demangled = abi::__cxa_demangle(it->first.c_str(), nullptr, nullptr, &status);
+            bool match = status == 0 && name == demangled;
+            std::free(demangled);
+            if (match) {
+                break;
+            }
+        }
+    }
+    if (it == m_symbols.end()) {
+        return nullptr;
+    }
+    if (symbol_name) {
+        *symbol_name = it->first;
+    }
+    return &it->second;
+}
+
+}; // namespace RemoteDebug
@@ -0,0 +1,67 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// ELF 符号表索引：解析 .symtab 与 .dynsym，按名称查找符号的链接地址
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+namespace RemoteDebug {
+
+struct ElfSymbol {
+    uint64_t value{ 0 }; // 链接地址，加上模块加载偏移即运行地址
+    uint64_t size{ 0 };
+    uint8_t  type{ 0 };  // STT_FUNC、STT_OBJECT 等
+    uint8_t  bind{ 0 };  // STB_GLOBAL、STB_WEAK、STB_LOCAL
+};
+
+/**
+ * @brief 逐个读取 ELF 文件中已定义的符号，先 .symtab 后 .dynsym，跳过节、文件符号与空名称
+ * @details 同名符号可能出现多次，由调用者决定保留哪一个；name 只在回调期间有效
+ * @param[out] load_address 第一个 PT_LOAD 段按页对齐的虚拟地址
+ * @return 成功返回0，不是本机架构的 64 位 ELF 或读取失败返回-1
+ */
+int read_elf_symbols(const std::string &path,
+        const std::function<void(const char *name, const ElfSymbol &symbol)> &visit, uint64_t &load_address);
+
+/**
+ * @brief 单个 ELF 文件的符号索引
+ * @details 只保留已定义的符号；同名符号优先保留全局符号，其次是最先出现的局部符号
+ */
+class ElfSymbols {
+public:
+    /**
+     * @brief 读取 ELF 文件并建立索引，只支持与本机架构相同的 64 位 ELF
+     * @return 成功返回0，失败返回-1
+     */
+    int load(const std::string &path);
+
+    /**
+     * @brief 按名称查找符号
+     * @return 未找到返回 nullptr
+     */
+    const ElfSymbol *find(const std::string &name) const;
+
+    /**
+     * @brief 按名称查找数据符号，名称可以是原始符号名或还原后的 C++ 名称（如 "ns::Service::queue_depth"）
+     * @param[out] symbol_name 找到时的原始符号名
+     * @return 未找到返回 nullptr
+     */
+    const ElfSymbol *find_object(const std::string &name, std::string *symbol_name = nullptr) const;
+
+    /**
+     * @brief 第一个 PT_LOAD 段按页对齐的虚拟地址，模块最低映射地址减去该值即加载偏移
+     */
+    uint64_t load_address() const { return m_load_address; }
+
+    size_t size() const { return m_symbols.size(); }
+
+private:
+    std::unordered_map<std::string, ElfSymbol> m_symbols;
+    uint64_t                                   m_load_address{ 0 };
+};
+
+}; // namespace RemoteDebug
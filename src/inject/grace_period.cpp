@@ -0,0 +1,254 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "grace_period.h"
+
+#include "process_maps.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <dirent.h>
+#include <iostream>
+#include <mutex>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <thread>
+#include <ucontext.h>
+#include <unistd.h>
+
+namespace RemoteDebug {
+
+namespace {
+
+constexpr size_t scan_chunk_words = 2048; // 信号处理函数每次读取 16KB 栈
+
+// 按起始地址排序的区间，index 为在调用者 ranges 中的位置
+struct SortedRange {
+    uintptr_t begin;
+    uintptr_t end;
+    size_t    index;
+};
+
+// 可读写的映射，线程栈位于其中
+struct StackRegion {
+    uintptr_t begin;
+    uintptr_t end;
+};
+
+/**
+ * @brief 扫描线程与信号处理函数共享的状态
+ * @details 一次只扫描一个线程：tid 非 0 时处理函数才检查，检查完成后置 done。
+ *          超时放弃时先清零 tid，再等待已进入的处理函数（active）退出，之后才能释放区间与映射数组
+ */
+struct ScanState {
+    std::atomic<pid_t>  tid{ 0 };
+    std::atomic<int>    active{ 0 };
+    std::atomic<bool>   done{ false };
+    const SortedRange  *ranges{ nullptr };
+    size_t              range_count{ 0 };
+    const StackRegion  *regions{ nullptr };
+    size_t              region_count{ 0 };
+    uint8_t            *hits{ nullptr };   // 与调用者 ranges 等长
+    uintptr_t           chunk[scan_chunk_words];
+};
+
+ScanState g_scan;
+
+int scan_signal()
+{
+    return SIGRTMAX - 2;
+}
+
+// 只使用异步信号安全的操作：查找与内存读写
+void mark(uintptr_t value)
+{
+    const SortedRange *end = g_scan.ranges + g_scan.range_count;
+    const SortedRange *it = std::upper_bound(g_scan.ranges, end, value,
+                                             [](uintptr_t v, const SortedRange &range) { return v < range.begin; });
+    if (it != g_scan.ranges && value < (it - 1)->end) {
+        g_scan.hits[(it - 1)->index] = 1;
+    }
+}
+
+// 经 process_vm_readv 读取栈，映射在扫描期间被其他线程解除时读取失败而不是触发 SIGSEGV
+void scan_stack(uintptr_t sp)
+{
+    const StackRegion *end = g_scan.regions + g_scan.region_count;
+    const StackRegion *region = std::upper_bound(g_scan.regions, end, sp,
+                                                 [](uintptr_t v, const StackRegion &r) { return v < r.begin; });
+    if (region == g_scan.regions || sp >= (region - 1)->end) {
+        return;
+    }
+    const uintptr_t limit = (region - 1)->end;
+    for (uintptr_t address = sp & ~static_cast<uintptr_t>(sizeof(uintptr_t) - 1); address < limit;) {
+        const size_t size = std::min<uintptr_t>(sizeof(g_scan.chunk), limit - address);
+        iovec local{ g_scan.chunk, size };
+        iovec remote{ reinterpret_cast<void *>(address), size };
+        const ssize_t read = process_vm_readv(getpid(), &local, 1, &remote, 1, 0);
+        if (read <= 0) {
+            return;
+        }
+        for (size_t i = 0; i < static_cast<size_t>(read) / sizeof(uintptr_t); ++i) {
+            mark(g_scan.chunk[i]);
+        }
+        address += static_cast<size_t>(read);
+    }
+}
+
+void scan_handler(int, siginfo_t *, void *context)
+{
+    g_scan.active.fetch_add(1);
+    const int saved_errno = errno;
+    if (g_scan.tid.load() == static_cast<pid_t>(syscall(SYS_gettid))) {
+        const auto *uc = static_cast<const ucontext_t *>(context);
+        uintptr_t sp = 0;
+#if defined(__x86_64__)
+        for (greg_t reg : uc->uc_mcontext.gregs) {
+            mark(static_cast<uintptr_t>(reg));
+        }
+        sp = static_cast<uintptr_t>(uc->uc_mcontext.gregs[REG_RSP]);
+#elif defined(__aarch64__)
+        // x30 为链接寄存器，叶子函数的返回地址只在其中
+        for (auto reg : uc->uc_mcontext.regs) {
+            mark(static_cast<uintptr_t>(reg));
+        }
+        mark(static_cast<uintptr_t>(uc->uc_mcontext.pc));
+        sp = static_cast<uintptr_t>(uc->uc_mcontext.sp);
+#endif
+        scan_stack(sp);
+        g_scan.done.store(true, std::memory_order_release);
+    }
+    errno = saved_errno;
+    g_scan.active.fetch_sub(1);
+}
+
+// 首次扫描时安装处理函数；信号已有应用的处理函数时不覆盖
+int install_handler()
+{
+    struct sigaction current{};
+    if (sigaction(scan_signal(), nullptr, &current) != 0) {
+        return -1;
+    }
+    if ((current.sa_flags & SA_SIGINFO) && current.sa_sigaction == scan_handler) {
+        return 0;
+    }
+    if (current.sa_handler != SIG_DFL) {
+        std::cerr << "Signal " << scan_signal() << " is used by the application" << std::endl;
+        return -1;
+    }
+    struct sigaction action{};
+    action.sa_sigaction = scan_handler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    return sigaction(scan_signal(), &action, nullptr);
+}
+
+std::vector<pid_t> list_threads()
+{
+    std::vector<pid_t> threads;
+    DIR *dir = opendir("/proc/self/task");
+    if (!dir) {
+        return threads;
+    }
+    const auto self = static_cast<pid_t>(syscall(SYS_gettid));
+    while (dirent *entry = readdir(dir)) {
+        const auto tid = static_cast<pid_t>(std::strtol(entry->d_name, nullptr, 10));
+        if (tid > 0 && tid != self) {
+            threads.push_back(tid);
+        }
+    }
+    closedir(dir);
+    return threads;
+}
+
+bool thread_alive(pid_t tid)
+{
+    return syscall(SYS_tgkill, getpid(), tid, 0) == 0 || errno != ESRCH;
+}
+
+// 向一个线程发送扫描信号并等待处理函数完成；线程已退出也视为完成
+bool scan_thread(pid_t tid)
+{
+    g_scan.done.store(false);
+    g_scan.tid.store(tid);
+    if (syscall(SYS_tgkill, getpid(), tid, scan_signal()) != 0) {
+        return errno == ESRCH;
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(grace_thread_timeout_ms);
+    while (!g_scan.done.load(std::memory_order_acquire)) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return !thread_alive(tid);
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+    }
+    return true;
+}
+
+} // namespace
+
+int scan_thread_references(const std::vector<CodeRange> &ranges, std::vector<bool> &referenced)
+{
+    referenced.assign(ranges.size(), true);
+#if !defined(__x86_64__) && !defined(__aarch64__)
+    std::cerr << "Thread scan is not supported on this architecture" << std::endl;
+    return -1;
+#else
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (ranges.empty()) {
+        return 0;
+    }
+    if (install_handler() != 0) {
+        return -1;
+    }
+
+    std::vector<MapEntry> maps;
+    if (read_process_maps(getpid(), maps) != 0) {
+        return -1;
+    }
+    std::vector<StackRegion> regions;
+    for (const auto &entry : maps) {
+        if (entry.perms.size() > 1 && entry.perms[0] == 'r' && entry.perms[1] == 'w') {
+            regions.push_back({ entry.start, entry.end });
+        }
+    }
+    std::vector<SortedRange> sorted;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        sorted.push_back({ ranges[i].begin, ranges[i].end, i });
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const SortedRange &a, const SortedRange &b) { return a.begin < b.begin; });
+    std::vector<uint8_t> hits(ranges.size(), 0);
+
+    g_scan.ranges = sorted.data();
+    g_scan.range_count = sorted.size();
+    g_scan.regions = regions.data();
+    g_scan.region_count = regions.size();
+    g_scan.hits = hits.data();
+
+    // 扫描开始后创建的线程从已恢复的入口开始执行，不会引用这些区间
+    bool complete = true;
+    for (pid_t tid : list_threads()) {
+        if (!scan_thread(tid)) {
+            complete = false;
+            break;
+        }
+    }
+    g_scan.tid.store(0);
+    while (g_scan.active.load() != 0) {
+        std::this_thread::yield();
+    }
+    if (!complete) {
+        return -1;
+    }
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        referenced[i] = hits[i] != 0;
+    }
+    return 0;
+#endif
+}
+
+}; // namespace RemoteDebug
@@ -0,0 +1,33 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 进程内代码回收的宽限期检测：在各线程上检查寄存器与栈，确认没有线程仍在使用待释放的跳转岛或补丁库
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace RemoteDebug {
+
+constexpr int grace_thread_timeout_ms = 100; // 线程未在此时间内响应扫描信号时本次扫描失败
+
+// 一段待释放的内存，[begin, end)
+struct CodeRange {
+    uintptr_t begin{ 0 };
+    uintptr_t end{ 0 };
+};
+
+/**
+ * @brief 检查本进程的其他线程是否仍引用若干内存区间
+ * @details 逐个向线程发送扫描信号（SIGRTMAX - 2），信号处理函数在该线程上检查被中断时的全部通用寄存器，
+ *          并保守扫描 [sp, 栈所在映射的末尾) 中的每个 8 字节字：PC 落在区间内表示正在执行其中的代码，
+ *          栈上的返回地址表示调用链中仍有未返回的帧，残留的旧值只会推迟释放。
+ *          调用前应已恢复函数入口与 GOT 表项，之后的调用不会再进入这些区间，因此一次扫描未发现引用即可释放。
+ *          存放在堆上的函数指针（如补丁库注册的回调）无法发现，补丁库不应保留这类引用。
+ *          处理函数带 SA_RESTART，但 epoll_wait 等不会自动重启的系统调用在被扫描时可能返回 EINTR。
+ *          同一时刻只能有一个调用者
+ * @param[out] referenced 与 ranges 等长，true 表示仍被引用；失败时全部为 true
+ * @return 成功返回0；扫描信号已被应用占用、线程屏蔽了信号或处于停止状态而超时、不支持的架构返回-1
+ */
+int scan_thread_references(const std::vector<CodeRange> &ranges, std::vector<bool> &referenced);
+
+}; // namespace RemoteDebug
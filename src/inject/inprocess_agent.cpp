@@ -0,0 +1,730 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// libremotedebug_agent.so：链接或 LD_PRELOAD 到业务进程后，在独立线程中接收命令环请求，
+// 直接在进程内 dlopen 补丁库并改写函数入口，不依赖 ptrace，也不暂停应用线程
+
+#include "command_ring.h"
+#include "elf_symbols.h"
+#include "grace_period.h"
+#include "patch.h"
+#include "patch_package.h"
+#include "probe_ring.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <iostream>
+#include <link.h>
+#include <map>
+#include <memory>
+#include <pthread.h>
+#include <sstream>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace RemoteDebug {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int idle_wait_ms = 1000;             // 无请求时定期检查退出标志
+constexpr int reclaim_interval_ms = 100;       // 有待回收的跳转岛或补丁库时的初始扫描间隔
+constexpr int max_reclaim_interval_ms = 10000; // 扫描失败或仍有引用时间隔逐次加倍，至多到此
+constexpr int max_scan_failures = 3;           // 连续失败此次数后停止自动扫描，直到显式 reclaim
+
+std::string hex(uintptr_t value)
+{
+    std::ostringstream oss;
+    oss << "0x" << std::hex << value;
+    return oss.str();
+}
+
+bool contains(const std::vector<CodeRange> &ranges, uintptr_t address)
+{
+    return std::any_of(ranges.begin(), ranges.end(),
+                       [address](const CodeRange &range) { return address >= range.begin && address < range.end; });
+}
+
+// 补丁库各 PT_LOAD 段的地址区间，代码与数据都可能被其他线程引用
+std::vector<CodeRange> library_ranges(void *handle)
+{
+    struct Search {
+        link_map              *map;
+        std::vector<CodeRange> ranges;
+    } search{ nullptr, {} };
+    if (dlinfo(handle, RTLD_DI_LINKMAP, &search.map) != 0 || !search.map) {
+        return {};
+    }
+    dl_iterate_phdr(
+            [](dl_phdr_info *info, size_t, void *data) {
+                auto *s = static_cast<Search *>(data);
+                if (info->dlpi_addr != s->map->l_addr || !info->dlpi_name ||
+                    strcmp(info->dlpi_name, s->map->l_name) != 0) {
+                    return 0;
+                }
+                for (ElfW(Half) i = 0; i < info->dlpi_phnum; ++i) {
+                    const ElfW(Phdr) &phdr = info->dlpi_phdr[i];
+                    if (phdr.p_type == PT_LOAD) {
+                        const uintptr_t begin = info->dlpi_addr + phdr.p_vaddr;
+                        s->ranges.push_back({ begin, begin + phdr.p_memsz });
+                    }
+                }
+                return 1;
+            },
+            &search);
+    return search.ranges;
+}
+
+/**
+ * @brief 进程内补丁代理
+ * @details 命令与常驻补丁代理一致，但不带 pid：
+ *            ping
+ *            load <library>
+ *            apply <target_symbol> <replacement_symbol>
+ *            redirect <target_symbol> <replacement_symbol>
+ *                                     改写各模块引用目标符号的 GOT 表项，不修改代码
+ *            revert <target_symbol>   同时撤销入口补丁与 GOT 重定向，跳转岛在宽限期后回收
+ *            package <library>        加载补丁库并安装其补丁表中的全部补丁
+ *            unload <library>         撤销跳到补丁库中的补丁与 GOT 重定向，宽限期后 dlclose
+ *            reclaim                  立即扫描一次，回收没有线程引用的跳转岛与补丁库，
+ *                                     并恢复因连续扫描失败而停止的自动扫描
+ *            probe <symbol> [<symbol>...]
+ *                                     安装入口/出口探针，各线程的调用记录写入共享内存，由 ProbeDrain 读取
+ *            unprobe                  同时停止全部探针的记录并恢复各函数入口
+ *            status
+ *            trace [on [<file>]|dump [<file>]|off]
+ *                                     各阶段耗时追踪，见 TraceSession
+ */
+class InProcessAgent {
+public:
+    ~InProcessAgent() { stop(); }
+
+    int start()
+    {
+        m_name = command_ring_name(getpid());
+        int fd = shm_open(m_name.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+        if (fd < 0 || ftruncate(fd, sizeof(CommandRing)) != 0) {
+            std::cerr << "remotedebug agent: failed to create " << m_name << ": " << strerror(errno) << std::endl;
+            if (fd >= 0) {
+                close(fd);
+            }
+            return -1;
+        }
+        void *mapped = mmap(nullptr, sizeof(CommandRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            shm_unlink(m_name.c_str());
+            return -1;
+        }
+
+        // 新建的共享内存全为 0，即全部槽位 FREE
+        m_ring = static_cast<CommandRing *>(mapped);
+        m_ring->version = command_ring_version;
+        m_ring->pid = getpid();
+        std::atomic_thread_fence(std::memory_order_release);
+        m_ring->magic = command_ring_magic;
+
+        m_thread = std::thread([this] { serve(); });
+        return 0;
+    }
+
+    void stop()
+    {
+        if (!m_ring) {
+            return;
+        }
+        m_stop = true;
+        m_ring->doorbell.fetch_add(1);
+        ring_wake(m_ring->doorbell);
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        if (m_probe_ring) {
+            m_probe_ring->enabled.store(0, std::memory_order_release);
+            probe_ring_unlink();
+        }
+        shm_unlink(m_name.c_str());
+        munmap(m_ring, sizeof(CommandRing));
+        m_ring = nullptr;
+    }
+
+private:
+    void serve()
+    {
+        pthread_setname_np(pthread_self(), "rd-agent");
+        while (!m_stop) {
+            uint32_t doorbell = m_ring->doorbell.load(std::memory_order_acquire);
+            for (auto &slot : m_ring->slots) {
+                uint32_t expected = static_cast<uint32_t>(SLOT_STATE::READY);
+                if (!slot.state.compare_exchange_strong(expected, static_cast<uint32_t>(SLOT_STATE::PROCESSING))) {
+                    continue;
+                }
+                const std::string request(slot.request, strnlen(slot.request, command_text_size));
+                ring_complete(slot, handle_request(request));
+            }
+            // 撤销与卸载不等待其他线程离开旧代码，由这里定期回收。每次扫描都会向全部线程发送信号，
+            // 仍有引用或扫描失败时退避，连续失败后不再自动扫描
+            const bool pending = retired_count() != 0 && m_scan_failures < max_scan_failures;
+            if (pending && Clock::now() >= m_next_reclaim) {
+                size_t islands = 0;
+                size_t libraries = 0;
+                if (reclaim(islands, libraries) != 0 && m_scan_failures == max_scan_failures) {
+                    std::cerr << "remotedebug agent: thread scan failed " << max_scan_failures
+                              << " times, automatic reclaim paused until 'reclaim'" << std::endl;
+                }
+            }
+            int wait_ms = idle_wait_ms;
+            if (retired_count() != 0 && m_scan_failures < max_scan_failures) {
+                const auto left =
+                        std::chrono::duration_cast<std::chrono::milliseconds>(m_next_reclaim - Clock::now()).count();
+                wait_ms = static_cast<int>(std::max<long long>(1, std::min<long long>(left, idle_wait_ms)));
+            }
+            ring_wait(m_ring->doorbell, doorbell, wait_ms);
+        }
+    }
+
+    std::string handle_request(const std::string &request)
+    {
+        std::istringstream iss(request);
+        std::string command;
+        iss >> command;
+        if (command == "trace") {
+            return m_trace.control(iss);
+        }
+        return m_trace.run(command, [&] { return execute(request); });
+    }
+
+    std::string execute(const std::string &request)
+    {
+        std::istringstream iss(request);
+        std::string command;
+        std::string arg1;
+        std::string arg2;
+        iss >> command >> arg1 >> arg2;
+        Clock::time_point start = Clock::now();
+        auto elapsed = [&start] {
+            return std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count()) +
+                   "us";
+        };
+
+        if (command == "ping") {
+            return "OK pong";
+        }
+        if (command == "status") {
+            std::string reply = "OK pid=" + std::to_string(getpid()) + " libraries=" +
+                                std::to_string(m_libraries.size()) + " patches=" + std::to_string(m_patches.size()) +
+                                " redirects=" + std::to_string(m_patcher.redirected().size()) +
+                                " probes=" + std::to_string(m_probes.size()) +
+                                " retired=" + std::to_string(retired_count()) +
+                                " scan_failures=" + std::to_string(m_scan_failures);
+            if (m_scan_failures >= max_scan_failures) {
+                reply += " reclaim=paused";
+            }
+            for (const auto &patch : m_patches) {
+                reply += " " + patch.first;
+            }
+            for (const auto &redirect : m_patcher.redirected()) {
+                reply += " " + redirect.symbol + "@got";
+            }
+            for (const auto &probe : m_probes) {
+                reply += " " + probe.first + "@probe";
+            }
+            for (const auto &library : m_retired_libraries) {
+                reply += " " + library.path + "@unloading";
+            }
+            return reply;
+        }
+        if (command == "load" && !arg1.empty()) {
+            void *handle = load(arg1);
+            return handle ? "OK " + hex(reinterpret_cast<uintptr_t>(handle)) + " " + elapsed() : "ERR " + m_error;
+        }
+        if (command == "apply" && !arg2.empty()) {
+            void *target = nullptr;
+            return apply(arg1, arg2, &target) == 0 ? "OK " + hex(reinterpret_cast<uintptr_t>(target)) + " " + elapsed()
+                                                   : "ERR " + m_error;
+        }
+        if (command == "redirect" && !arg2.empty()) {
+            size_t slots = 0;
+            return redirect(arg1, arg2, slots) == 0 ? "OK slots=" + std::to_string(slots) + " " + elapsed()
+                                                    : "ERR " + m_error;
+        }
+        if (command == "revert" && !arg1.empty()) {
+            return revert(arg1) == 0 ? "OK " + elapsed() : "ERR " + m_error;
+        }
+        if (command == "package" && !arg1.empty()) {
+            size_t applied = 0;
+            return apply_package(arg1, applied) == 0 ? "OK applied=" + std::to_string(applied) + " " + elapsed()
+                                                     : "ERR " + m_error;
+        }
+        if (command == "unload" && !arg1.empty()) {
+            size_t reverted = 0;
+            return unload(arg1, reverted) == 0 ? "OK reverted=" + std::to_string(reverted) + " " + elapsed()
+                                               : "ERR " + m_error;
+        }
+        if (command == "reclaim") {
+            size_t islands = 0;
+            size_t libraries = 0;
+            m_scan_failures = 0;
+            if (reclaim(islands, libraries) != 0) {
+                return "ERR thread scan failed";
+            }
+            return "OK islands=" + std::to_string(islands) + " libraries=" + std::to_string(libraries) +
+                   " pending=" + std::to_string(retired_count()) + " " + elapsed();
+        }
+        if (command == "probe" && !arg1.empty()) {
+            std::vector<std::string> symbols{ arg1 };
+            if (!arg2.empty()) {
+                symbols.push_back(arg2);
+            }
+            for (std::string symbol; iss >> symbol;) {
+                symbols.push_back(symbol);
+            }
+            return probe(symbols) == 0 ? "OK probes=" + std::to_string(m_probes.size()) + " " +
+                                                 probe_ring_name(getpid()) + " " + elapsed()
+                                       : "ERR " + m_error;
+        }
+        if (command == "unprobe") {
+            size_t removed = m_probes.size();
+            return unprobe() == 0 ? "OK removed=" + std::to_string(removed) + " " + elapsed() : "ERR " + m_error;
+        }
+        return "ERR invalid request: " + request;
+    }
+
+    int fail(const std::string &message)
+    {
+        m_error = message;
+        std::cerr << "remotedebug agent: " << message << std::endl;
+        return -1;
+    }
+
+    void *load(const std::string &path)
+    {
+        auto it = m_libraries.find(path);
+        if (it != m_libraries.end()) {
+            return it->second;
+        }
+        TraceSpan span("dlopen", "inprocess");
+        void *handle = dlopen(path.c_str(), RTLD_NOW);
+        if (!handle) {
+            const char *reason = dlerror();
+            fail("failed to load " + path + ": " + (reason ? reason : "unknown error"));
+            return nullptr;
+        }
+        m_libraries[path] = handle;
+        m_load_order.push_back(handle);
+        return handle;
+    }
+
+    /**
+     * @brief 查找符号：先查已加载的补丁库（新加载的优先），再查全局符号，
+     *        最后解析各模块的 .symtab，覆盖未导出到动态符号表的函数
+     */
+    void *resolve(const std::string &symbol)
+    {
+        TraceSpan span("symbol_resolve", "inprocess");
+        for (auto it = m_load_order.rbegin(); it != m_load_order.rend(); ++it) {
+            if (void *address = dlsym(*it, symbol.c_str())) {
+                return address;
+            }
+        }
+        if (void *address = dlsym(RTLD_DEFAULT, symbol.c_str())) {
+            return address;
+        }
+
+        struct Search {
+            InProcessAgent *agent;
+            const std::string *symbol;
+            void *address;
+        } search{ this, &symbol, nullptr };
+        dl_iterate_phdr(
+                [](dl_phdr_info *info, size_t, void *data) {
+                    auto *s = static_cast<Search *>(data);
+                    std::string path = info->dlpi_name && info->dlpi_name[0] ? info->dlpi_name : "/proc/self/exe";
+                    const ElfSymbols *symbols = s->agent->symbols(path);
+                    const ElfSymbol *found = symbols ? symbols->find(*s->symbol) : nullptr;
+                    if (found && found->value != 0) {
+                        s->address = reinterpret_cast<void *>(info->dlpi_addr + found->value);
+                        return 1;
+                    }
+                    return 0;
+                },
+                &search);
+        return search.address;
+    }
+
+    // 模块符号索引，首次使用时建立
+    const ElfSymbols *symbols(const std::string &path)
+    {
+        auto it = m_symbols.find(path);
+        if (it == m_symbols.end()) {
+            auto symbols = std::make_unique<ElfSymbols>();
+            if (path[0] != '/' || symbols->load(path) != 0) {
+                symbols.reset();
+            }
+            it = m_symbols.emplace(path, std::move(symbols)).first;
+        }
+        return it->second.get();
+    }
+
+    int apply(const std::string &target_symbol, const std::string &replacement_symbol, void **target_out)
+    {
+        void *replacement = resolve(replacement_symbol);
+        if (!replacement) {
+            return fail("symbol " + replacement_symbol + " not found");
+        }
+        auto it = m_patches.find(target_symbol);
+        void *target = it != m_patches.end() ? it->second : resolve(target_symbol);
+        if (!target) {
+            return fail("symbol " + target_symbol + " not found");
+        }
+        *target_out = target;
+
+        // FunctionPatcher 不支持改写已有跳转岛，先恢复原始入口再安装，旧跳转岛宽限期后回收
+        if (it != m_patches.end() && !retire(target)) {
+            return fail("failed to remove previous patch of " + target_symbol);
+        }
+        if (!m_patcher.install_patch(target, replacement)) {
+            m_patches.erase(target_symbol);
+            return fail("failed to patch " + target_symbol);
+        }
+        m_patches[target_symbol] = target;
+        return 0;
+    }
+
+    int redirect(const std::string &target_symbol, const std::string &replacement_symbol, size_t &slots)
+    {
+        void *replacement = resolve(replacement_symbol);
+        if (!replacement) {
+            return fail("symbol " + replacement_symbol + " not found");
+        }
+        if (!m_patcher.install_got_patch(target_symbol, replacement)) {
+            return fail("no GOT entry of " + target_symbol + " redirected");
+        }
+        for (const auto &entry : m_patcher.redirected()) {
+            if (entry.symbol == target_symbol) {
+                slots = entry.slots.size();
+            }
+        }
+        return 0;
+    }
+
+    int revert(const std::string &target_symbol)
+    {
+        const auto &redirects = m_patcher.redirected();
+        bool redirected = std::any_of(redirects.begin(), redirects.end(),
+                                      [&](const GotRedirect &entry) { return entry.symbol == target_symbol; });
+        if (redirected && !m_patcher.uninstall_got_patch(target_symbol)) {
+            return fail("failed to restore GOT entries of " + target_symbol);
+        }
+        auto it = m_patches.find(target_symbol);
+        if (it == m_patches.end()) {
+            return redirected ? 0 : fail(target_symbol + " is not patched");
+        }
+        if (!retire(it->second)) {
+            return fail("failed to restore " + target_symbol);
+        }
+        m_patches.erase(it);
+        return 0;
+    }
+
+    // 恢复函数入口，跳转岛留待回收
+    bool retire(void *target)
+    {
+        if (!m_patcher.retire_patch(target)) {
+            return false;
+        }
+        schedule_reclaim();
+        return true;
+    }
+
+    /**
+     * @brief 卸载补丁库：撤销目标或替换函数位于库中的补丁与 GOT 重定向，库留待回收
+     * @details 不等待正在执行库中代码的线程，reclaim 确认没有线程引用库的任何段、
+     *          也没有待回收的跳转岛跳向库之后才 dlclose
+     */
+    int unload(const std::string &path, size_t &reverted)
+    {
+        auto library = m_libraries.find(path);
+        if (library == m_libraries.end()) {
+            return fail(path + " is not loaded");
+        }
+        void *handle = library->second;
+        std::vector<CodeRange> ranges = library_ranges(handle);
+        if (ranges.empty()) {
+            return fail("failed to locate segments of " + path);
+        }
+        for (const auto &probe : m_probes) {
+            if (contains(ranges, reinterpret_cast<uintptr_t>(probe.second))) {
+                return fail(probe.first + " in " + path + " is probed");
+            }
+        }
+
+        std::vector<std::string> redirected;
+        for (const auto &entry : m_patcher.redirected()) {
+            if (contains(ranges, entry.patch_function)) {
+                redirected.push_back(entry.symbol);
+            }
+        }
+        for (const auto &symbol : redirected) {
+            if (!m_patcher.uninstall_got_patch(symbol)) {
+                return fail("failed to restore GOT entries of " + symbol);
+            }
+            ++reverted;
+        }
+        for (const auto &island : std::vector<JumpIsland>(m_patcher.installed())) {
+            if (!contains(ranges, island.patch_function) && !contains(ranges, island.original_function)) {
+                continue;
+            }
+            auto patch = std::find_if(m_patches.begin(), m_patches.end(), [&island](const auto &entry) {
+                return reinterpret_cast<uintptr_t>(entry.second) == island.original_function;
+            });
+            if (!retire(reinterpret_cast<void *>(island.original_function))) {
+                return fail("failed to restore " +
+                            (patch != m_patches.end() ? patch->first : hex(island.original_function)));
+            }
+            if (patch != m_patches.end()) {
+                m_patches.erase(patch);
+            }
+            ++reverted;
+        }
+
+        m_libraries.erase(library);
+        m_load_order.erase(std::remove(m_load_order.begin(), m_load_order.end(), handle), m_load_order.end());
+        m_retired_libraries.push_back({ path, handle, std::move(ranges) });
+        schedule_reclaim();
+        return 0;
+    }
+
+    size_t retired_count() const { return m_patcher.retired().size() + m_retired_libraries.size(); }
+
+    // 有新的待回收内容时从初始间隔开始扫描
+    void schedule_reclaim()
+    {
+        m_reclaim_interval_ms = reclaim_interval_ms;
+        m_next_reclaim = Clock::now() + std::chrono::milliseconds(m_reclaim_interval_ms);
+    }
+
+    /**
+     * @brief 一次扫描后安排下一次：全部回收后恢复初始间隔，扫描失败或仍有引用时间隔加倍，
+     *        扫描失败计入连续失败次数
+     */
+    void schedule_after_scan(bool failed)
+    {
+        m_scan_failures = failed ? m_scan_failures + 1 : 0;
+        m_reclaim_interval_ms = retired_count() == 0 ? reclaim_interval_ms
+                                                     : std::min(m_reclaim_interval_ms * 2, max_reclaim_interval_ms);
+        m_next_reclaim = Clock::now() + std::chrono::milliseconds(m_reclaim_interval_ms);
+    }
+
+    /**
+     * @brief 回收宽限期已过的跳转岛与补丁库
+     * @details 扫描各线程的寄存器与栈（见 scan_thread_references），未被引用的跳转岛直接释放；
+     *          补丁库在没有线程引用、也没有待回收的跳转岛跳向它时 dlclose。
+     *          同一个库已被重新加载时 dlclose 只减少引用计数，无需等待
+     * @return 扫描失败返回-1，待回收的内容保留到下次
+     */
+    int reclaim(size_t &islands, size_t &libraries)
+    {
+        const std::vector<JumpIsland> retired = m_patcher.retired();
+        std::vector<CodeRange> ranges;
+        for (const auto &island : retired) {
+            const auto begin = reinterpret_cast<uintptr_t>(island.allocated_memory);
+            ranges.push_back({ begin, begin + island.size });
+        }
+        for (const auto &library : m_retired_libraries) {
+            ranges.insert(ranges.end(), library.ranges.begin(), library.ranges.end());
+        }
+        if (ranges.empty()) {
+            return 0;
+        }
+        std::vector<bool> referenced;
+        {
+            TraceSpan span("grace_scan", "inprocess");
+            if (scan_thread_references(ranges, referenced) != 0) {
+                schedule_after_scan(true);
+                return -1;
+            }
+        }
+
+        islands = m_patcher.reclaim([&](const JumpIsland &island) {
+            for (size_t i = 0; i < retired.size(); ++i) {
+                if (retired[i].allocated_memory == island.allocated_memory) {
+                    return static_cast<bool>(referenced[i]);
+                }
+            }
+            return true;
+        });
+        const std::vector<JumpIsland> remaining = m_patcher.retired();
+        size_t next = retired.size();
+        for (auto it = m_retired_libraries.begin(); it != m_retired_libraries.end();) {
+            bool busy = std::any_of(referenced.begin() + static_cast<std::ptrdiff_t>(next),
+                                    referenced.begin() + static_cast<std::ptrdiff_t>(next + it->ranges.size()),
+                                    [](bool value) { return value; }) ||
+                        std::any_of(remaining.begin(), remaining.end(), [&it](const JumpIsland &island) {
+                            return contains(it->ranges, island.patch_function);
+                        });
+            next += it->ranges.size();
+            const bool reloaded = std::any_of(m_libraries.begin(), m_libraries.end(),
+                                              [&it](const auto &entry) { return entry.second == it->handle; });
+            if (busy && !reloaded) {
+                ++it;
+                continue;
+            }
+            TraceSpan span("dlclose", "inprocess");
+            dlclose(it->handle);
+            it = m_retired_libraries.erase(it);
+            ++libraries;
+        }
+        schedule_after_scan(false);
+        return 0;
+    }
+
+    // 函数在探针记录区中的编号，按名字复用
+    uint32_t probe_id(const std::string &symbol)
+    {
+        uint32_t count = m_probe_ring->functions.load(std::memory_order_acquire);
+        for (uint32_t id = 0; id < count; ++id) {
+            if (strncmp(m_probe_ring->names[id], symbol.c_str(), probe_name_size - 1) == 0) {
+                return id;
+            }
+        }
+        if (count == probe_max_functions) {
+            return UINT32_MAX;
+        }
+        strncpy(m_probe_ring->names[count], symbol.c_str(), probe_name_size - 1);
+        m_probe_ring->functions.store(count + 1, std::memory_order_release);
+        return count;
+    }
+
+    // 先解析全部符号再逐个安装，安装失败时已安装的探针保留，可用 unprobe 一并移除
+    int probe(const std::vector<std::string> &symbols)
+    {
+        std::vector<std::pair<std::string, void *>> targets;
+        for (const auto &symbol : symbols) {
+            if (m_probes.count(symbol)) {
+                return fail(symbol + " is already probed");
+            }
+            void *address = resolve(symbol);
+            if (!address) {
+                return fail("symbol " + symbol + " not found");
+            }
+            targets.emplace_back(symbol, address);
+        }
+        if (!m_probe_ring && !(m_probe_ring = probe_ring_create())) {
+            return fail("failed to create " + probe_ring_name(getpid()));
+        }
+
+        m_probe_ring->enabled.store(1, std::memory_order_release);
+        for (const auto &target : targets) {
+            uint32_t id = probe_id(target.first);
+            if (id == UINT32_MAX) {
+                return fail("too many probed functions");
+            }
+            if (!m_patcher.install_probe(target.second, id, probe_ring_hooks())) {
+                return fail("failed to probe " + target.first);
+            }
+            m_probes[target.first] = target.second;
+        }
+        return 0;
+    }
+
+    // 先清除 enabled，全部探针在同一时刻停止记录入口，再逐个恢复函数入口
+    int unprobe()
+    {
+        if (m_probes.empty()) {
+            return fail("no probes installed");
+        }
+        m_probe_ring->enabled.store(0, std::memory_order_release);
+        m_probes.clear();
+        schedule_reclaim();
+        return m_patcher.uninstall_probes() ? 0 : fail("failed to restore probed functions");
+    }
+
+    // 加载补丁库并安装补丁表中的全部补丁，任一失败则撤销本次已安装的补丁
+    int apply_package(const std::string &path, size_t &applied)
+    {
+        void *handle = load(path);
+        if (!handle) {
+            return -1;
+        }
+        const auto *table = static_cast<const RemoteDebugPatch *>(dlsym(handle, REMOTEDEBUG_PATCH_TABLE_SYMBOL));
+        if (!table) {
+            return fail(path + " has no " REMOTEDEBUG_PATCH_TABLE_SYMBOL);
+        }
+
+        std::vector<std::string> installed;
+        for (; table->target && table->replacement; ++table) {
+            void *target = nullptr;
+            if (apply(table->target, table->replacement, &target) != 0) {
+                std::string error = m_error;
+                for (const auto &symbol : installed) {
+                    revert(symbol);
+                }
+                m_error = error;
+                return -1;
+            }
+            installed.push_back(table->target);
+        }
+        applied = installed.size();
+        return 0;
+    }
+
+    // 已卸载、等待 dlclose 的补丁库
+    struct RetiredLibrary {
+        std::string            path;
+        void                  *handle;
+        std::vector<CodeRange> ranges;
+    };
+
+    std::string                                        m_name;
+    CommandRing                                       *m_ring{ nullptr };
+    std::atomic<bool>                                  m_stop{ false };
+    std::thread                                        m_thread;
+    FunctionPatcher                                    m_patcher;
+    std::map<std::string, void *>                      m_libraries;
+    std::vector<void *>                                m_load_order;
+    std::map<std::string, void *>                      m_patches; // 目标符号 -> 函数地址
+    std::map<std::string, void *>                      m_probes;  // 探测的符号 -> 函数地址
+    std::vector<RetiredLibrary>                        m_retired_libraries;
+    Clock::time_point                                  m_next_reclaim;
+    int                                                m_reclaim_interval_ms{ reclaim_interval_ms };
+    int                                                m_scan_failures{ 0 }; // 连续失败的扫描次数
+    ProbeRing                                         *m_probe_ring{ nullptr };
+    std::map<std::string, std::unique_ptr<ElfSymbols>> m_symbols;
+    std::string                                        m_error;
+    TraceSession                                       m_trace;
+};
+
+InProcessAgent *g_agent = nullptr;
+
+// 加载时启动代理线程；REMOTEDEBUG_AGENT=0 时不启动
+__attribute__((constructor)) void start_agent()
+{
+    const char *enabled = std::getenv("REMOTEDEBUG_AGENT");
+    if (enabled && std::strcmp(enabled, "0") == 0) {
+        return;
+    }
+    g_agent = new InProcessAgent();
+    if (g_agent->start() != 0) {
+        delete g_agent;
+        g_agent = nullptr;
+    }
+}
+
+__attribute__((destructor)) void stop_agent()
+{
+    delete g_agent;
+    g_agent = nullptr;
+}
+
+} // namespace
+
+}; // namespace RemoteDebug
@@ -0,0 +1,371 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "patch_agent.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+namespace RemoteDebug {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t max_request_size = 4096;
+constexpr size_t max_reported_diffs = 32;  // verify 回复中最多列出的差异区间
+
+int make_address(const std::string &path, sockaddr_un &addr)
+{
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Invalid agent socket path: " << path << std::endl;
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size());
+    return 0;
+}
+
+int send_line(int fd, const std::string &line)
+{
+    std::string data = line + "\n";
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return 0;
+}
+
+std::string hex(uintptr_t value)
+{
+    std::ostringstream oss;
+    oss << "0x" << std::hex << value;
+    return oss.str();
+}
+
+long elapsed_us(Clock::time_point start)
+{
+    return static_cast<long>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+}
+
+} // namespace
+
+int PatchAgent::run()
+{
+    sockaddr_un addr{};
+    if (make_address(m_socket_path, addr) != 0) {
+        return -1;
+    }
+
+    // 已有代理在监听时不抢占其 socket
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe >= 0 && connect(probe, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0) {
+        close(probe);
+        std::cerr << "Another agent is already listening on " << m_socket_path << std::endl;
+        return -1;
+    }
+    if (probe >= 0) {
+        close(probe);
+    }
+    unlink(m_socket_path.c_str());
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        chmod(m_socket_path.c_str(), S_IRUSR | S_IWUSR) != 0 || listen(listen_fd, 16) != 0) {
+        std::cerr << "Failed to listen on " << m_socket_path << ": " << strerror(errno) << std::endl;
+        if (listen_fd >= 0) {
+            close(listen_fd);
+        }
+        return -1;
+    }
+    std::cout << "Patch agent listening on " << m_socket_path << std::endl;
+
+    std::map<int, std::string> clients; // fd -> 未处理完的输入
+    Clock::time_point next_watch = Clock::now() + std::chrono::milliseconds(agent_watch_interval_ms);
+    while (!m_stop) {
+        std::vector<pollfd> fds{ { listen_fd, POLLIN, 0 } };
+        for (const auto &client : clients) {
+            fds.push_back({ client.first, POLLIN, 0 });
+        }
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next_watch - Clock::now()).count();
+        int n = poll(fds.data(), fds.size(), wait > 0 ? static_cast<int>(wait) : 0);
+        if (n < 0 && errno != EINTR) {
+            std::cerr << "poll failed: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        if (Clock::now() >= next_watch) {
+            watch_processes();
+            next_watch = Clock::now() + std::chrono::milliseconds(agent_watch_interval_ms);
+        }
+        if (n <= 0) {
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int client_fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client_fd >= 0) {
+                clients[client_fd];
+            }
+        }
+        for (size_t i = 1; i < fds.size(); ++i) {
+            if (!fds[i].revents) {
+                continue;
+            }
+            int fd = fds[i].fd;
+            std::string &input = clients[fd];
+            char buffer[1024];
+            ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+            bool closed = received <= 0;
+            if (!closed) {
+                input.append(buffer, static_cast<size_t>(received));
+            }
+
+            size_t pos;
+            while (!closed && (pos = input.find('\n')) != std::string::npos) {
+                std::string request = input.substr(0, pos);
+                input.erase(0, pos + 1);
+                closed = send_line(fd, handle_request(request)) != 0;
+            }
+            if (closed || input.size() > max_request_size) {
+                close(fd);
+                clients.erase(fd);
+            }
+        }
+    }
+
+    for (const auto &client : clients) {
+        close(client.first);
+    }
+    close(listen_fd);
+    unlink(m_socket_path.c_str());
+    return 0;
+}
+
+ProcessPatcher *PatchAgent::find_process(pid_t pid, std::string &error)
+{
+    auto it = m_processes.find(pid);
+    if (it != m_processes.end()) {
+        return it->second.get();
+    }
+    auto patcher = std::make_unique<ProcessPatcher>(pid, m_cache);
+    if (pid <= 0 || patcher->refresh() < 0) {
+        error = "process " + std::to_string(pid) + " not found";
+        return nullptr;
+    }
+    return m_processes.emplace(pid, std::move(patcher)).first->second.get();
+}
+
+void PatchAgent::watch_processes()
+{
+    for (auto it = m_processes.begin(); it != m_processes.end();) {
+        int ret = it->second->refresh();
+        if (ret < 0) {
+            std::cout << "Process " << it->first << " exited, dropping its state" << std::endl;
+            it = m_processes.erase(it);
+            continue;
+        }
+        if (ret > 0) {
+            std::cout << "Process " << it->first << " modules changed, " << it->second->modules().size()
+                      << " modules loaded" << std::endl;
+        }
+        ++it;
+    }
+    m_cache.prune();
+}
+
+std::string PatchAgent::handle_request(const std::string &request)
+{
+    std::istringstream iss(request);
+    std::string command;
+    iss >> command;
+    if (command == "trace") {
+        return m_trace.control(iss);
+    }
+
+    std::string reply = m_trace.run(command, [&] { return execute(request); });
+    if (PhaseTracer::instance().enabled()) {
+        std::cout << m_trace.last_summary() << std::endl;
+    }
+    return reply;
+}
+
+std::string PatchAgent::execute(const std::string &request)
+{
+    std::istringstream iss(request);
+    std::string command;
+    iss >> command;
+
+    if (command == "ping") {
+        return "OK pong";
+    }
+    if (command == "shutdown") {
+        stop();
+        return "OK bye";
+    }
+    if (command == "status" && iss.peek() == std::char_traits<char>::eof()) {
+        return "OK processes=" + std::to_string(m_processes.size()) + " symbol_indices=" +
+               std::to_string(m_cache.size());
+    }
+
+    long pid_value = 0;
+    if (!(iss >> pid_value)) {
+        return "ERR missing pid";
+    }
+    pid_t pid = static_cast<pid_t>(pid_value);
+    if (command == "detach") {
+        return m_processes.erase(pid) ? "OK" : "ERR process " + std::to_string(pid) + " not attached";
+    }
+
+    std::string error;
+    ProcessPatcher *patcher = find_process(pid, error);
+    if (!patcher) {
+        return "ERR " + error;
+    }
+
+    std::string arg1;
+    std::string arg2;
+    iss >> arg1 >> arg2;
+    Clock::time_point start = Clock::now();
+    if (command == "attach") {
+        size_t indexed = patcher->index_modules();
+        return "OK modules=" + std::to_string(patcher->modules().size()) + " indexed=" + std::to_string(indexed) +
+               " " + std::to_string(elapsed_us(start)) + "us";
+    }
+    if (command == "status") {
+        std::string reply = "OK pid=" + std::to_string(pid) + " modules=" + std::to_string(patcher->modules().size()) +
+                            " libraries=" + std::to_string(patcher->library_count()) +
+                            " arenas=" + std::to_string(patcher->arena_count()) +
+                            " patches=" + std::to_string(patcher->patches().size()) +
+                            " data=" + std::to_string(patcher->data_patches().size());
+        for (const auto &patch : patcher->patches()) {
+            reply += " " + patch.first;
+        }
+        for (const auto &patch : patcher->data_patches()) {
+            reply += " " + patch.first;
+        }
+        return reply;
+    }
+    if (command == "load" && !arg1.empty()) {
+        uintptr_t handle = 0;
+        if (patcher->load_library(arg1, handle) != 0) {
+            return "ERR " + patcher->error();
+        }
+        return "OK " + hex(handle) + " " + std::to_string(elapsed_us(start)) + "us";
+    }
+    if (command == "apply" && !arg2.empty()) {
+        uintptr_t address = 0;
+        if (patcher->apply(arg1, arg2, address) != 0) {
+            return "ERR " + patcher->error();
+        }
+        return "OK " + hex(address) + " " + std::to_string(elapsed_us(start)) + "us";
+    }
+    if (command == "get" && !arg1.empty()) {
+        VariableType type;
+        std::string value;
+        if (patcher->read_variable(arg1, type, value) != 0) {
+            return "ERR " + patcher->error();
+        }
+        return "OK " + value + " type=" + (type.name.empty() ? "?" : type.name) + " size=" + std::to_string(type.size);
+    }
+    if (command == "set" && !arg1.empty()) {
+        std::vector<std::string> items{ arg1 };
+        if (!arg2.empty()) {
+            items.push_back(arg2);
+        }
+        for (std::string item; iss >> item;) {
+            items.push_back(item);
+        }
+        std::vector<std::pair<std::string, std::string>> assignments;
+        for (const auto &item : items) {
+            size_t equal = item.find('=');
+            if (equal == 0 || equal == std::string::npos) {
+                return "ERR expected <variable>=<value>, got " + item;
+            }
+            assignments.emplace_back(item.substr(0, equal), item.substr(equal + 1));
+        }
+        std::string report;
+        if (patcher->write_variables(assignments, report) != 0) {
+            return "ERR " + patcher->error();
+        }
+        return "OK " + report + " " + std::to_string(elapsed_us(start)) + "us";
+    }
+    if (command == "verify") {
+        TextVerifyReport report;
+        if (patcher->verify(report) != 0) {
+            return "ERR " + patcher->error();
+        }
+        return "OK " + format_verify_report(report, max_reported_diffs) + " " + std::to_string(elapsed_us(start)) +
+               "us";
+    }
+    if (command == "revert" && patcher->data_patches().count(arg1)) {
+        if (patcher->revert_variable(arg1) != 0) {
+            return "ERR " + patcher->error();
+        }
+        return "OK " + std::to_string(elapsed_us(start)) + "us";
+    }
+    if (command == "revert" && !arg1.empty()) {
+        if (patcher->revert(arg1) != 0) {
+            return "ERR " + patcher->error();
+        }
+        return "OK " + std::to_string(elapsed_us(start)) + "us";
+    }
+    return "ERR invalid request: " + request;
+}
+
+int agent_request(const std::string &socket_path, const std::string &request, std::string &reply, int timeout_ms)
+{
+    sockaddr_un addr{};
+    if (make_address(socket_path, addr) != 0) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    timeval tv{ timeout_ms / 1000, (timeout_ms % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || send_line(fd, request) != 0) {
+        std::cerr << "Failed to reach agent at " << socket_path << ": " << strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+
+    reply.clear();
+    char c;
+    while (true) {
+        ssize_t n = recv(fd, &c, 1, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            close(fd);
+            return -1;
+        }
+        if (c == '\n') {
+            break;
+        }
+        reply.push_back(c);
+    }
+    close(fd);
+    return 0;
+}
+
+}; // namespace RemoteDebug
@@ -0,0 +1,80 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 设备侧常驻补丁代理：缓存各进程的符号索引与跳转岛，通过本地 Unix socket 接收补丁命令
+
+#pragma once
+
+#include "process_patcher.h"
+#include "trace.h"
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace RemoteDebug {
+
+constexpr const char *default_agent_socket = "/tmp/remote_debug_agent.sock";
+constexpr int         agent_watch_interval_ms = 200;  // 轮询模块加载/卸载的间隔
+constexpr int         agent_request_timeout_ms = 30000;
+
+/**
+ * @brief 常驻补丁代理
+ * @details 每行一个请求，每个请求回复一行 "OK ..." 或 "ERR <原因>"，同一连接可连续发送多个请求：
+ *            ping
+ *            attach <pid>                                  预读映射并建立符号索引
+ *            load <pid> <library>                          在目标进程中 dlopen 补丁库
+ *            apply <pid> <target_symbol> <replacement_symbol>
+ *            revert <pid> <target_symbol>                  同时用于恢复 set 改写的变量
+ *            get <pid> <variable>                          读取全局变量，回复值、DWARF 类型与大小
+ *            set <pid> <variable>=<value> [...]            按类型检查后暂停全部线程一次写入并读回校验
+ *            verify <pid>                                  校验代码段与 ELF 文件及已打补丁一致，回复差异区间
+ *            status [pid]
+ *            detach <pid>                                  丢弃该进程的缓存，已打的补丁保持不变
+ *            trace [on [<file>]|dump [<file>]|off]         各阶段耗时追踪，见 TraceSession
+ *            shutdown
+ *          代理定期重新读取各进程的内存映射，模块卸载后丢弃对应的索引与补丁，进程退出后丢弃全部状态
+ */
+class PatchAgent {
+public:
+    explicit PatchAgent(std::string socket_path = default_agent_socket) : m_socket_path(std::move(socket_path)) {}
+
+    /**
+     * @brief 监听 socket 并处理请求，直到 stop 或收到 shutdown
+     * @return 正常退出返回0，监听失败返回-1
+     */
+    int run();
+
+    /**
+     * @brief 请求退出事件循环，可在信号处理函数中调用
+     */
+    void stop() { m_stop = true; }
+
+    /**
+     * @brief 处理一行请求
+     * @return 回复（不含换行）
+     */
+    std::string handle_request(const std::string &request);
+
+private:
+    std::string execute(const std::string &request);
+    ProcessPatcher *find_process(pid_t pid, std::string &error);
+    void watch_processes();
+
+    std::string                                       m_socket_path;
+    std::atomic<bool>                                 m_stop{ false };
+    SymbolCache                                       m_cache;
+    std::map<pid_t, std::unique_ptr<ProcessPatcher>>  m_processes;
+    TraceSession                                      m_trace;
+};
+
+/**
+ * @brief 向代理发送一个请求并等待回复
+ * @param[in] socket_path 代理监听的 socket
+ * @param[in] request 请求（不含换行）
+ * @param[out] reply 回复（不含换行）
+ * @return 成功收到回复返回0，连接失败或超时返回-1
+ */
+int agent_request(const std::string &socket_path, const std::string &request, std::string &reply,
+        int timeout_ms = agent_request_timeout_ms);
+
+}; // namespace RemoteDebug
@@ -0,0 +1,356 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "probe_ring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iostream>
+#include <pthread.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifdef __x86_64__
+#include <x86intrin.h>
+#endif
+
+namespace RemoteDebug {
+
+namespace {
+
+// 探针回调的线程私有状态，与记录区中的线程环一一对应；返回地址栈不放入共享内存
+struct ProbeFrame {
+    uintptr_t return_address;
+    uint32_t  function;
+};
+
+struct ProbeThread {
+    uint32_t   tid;
+    uint32_t   index;
+    uint32_t   depth;
+    ProbeFrame frames[probe_stack_depth];
+};
+
+std::atomic<ProbeRing *> g_ring{ nullptr };
+ProbeThread              g_threads[probe_max_threads];
+ProbeThread              g_no_thread; // 线程环耗尽、正在占用线程环或正在记录时的占位，不记录
+
+// initial-exec 模型访问时不调用 __tls_get_addr，回调中不会分配内存
+__attribute__((tls_model("initial-exec"))) thread_local ProbeThread *t_thread = nullptr;
+
+uint64_t monotonic_ns()
+{
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+}
+
+inline uint64_t timestamp()
+{
+#ifdef __x86_64__
+    return __rdtsc();
+#else
+    return monotonic_ns();
+#endif
+}
+
+// 时间戳每毫秒的计数
+uint64_t calibrate_tsc_khz()
+{
+#ifdef __x86_64__
+    const uint64_t start_ns = monotonic_ns();
+    const uint64_t start_tsc = timestamp();
+    usleep(20000);
+    const uint64_t elapsed_ns = monotonic_ns() - start_ns;
+    const uint64_t elapsed_tsc = timestamp() - start_tsc;
+    return elapsed_ns ? static_cast<uint64_t>(static_cast<double>(elapsed_tsc) * 1e6 / static_cast<double>(elapsed_ns))
+                      : 1000000;
+#else
+    return 1000000;
+#endif
+}
+
+bool push(ProbeThreadRing &ring, const ProbeRecord &record)
+{
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= probe_ring_records) {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    ring.records[head & (probe_ring_records - 1)] = record;
+    ring.head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief 为当前线程占用一个线程环：空闲的、tid 相同的（原线程已退出）或 tgkill 探测到占用线程已退出的
+ */
+ProbeThread *claim(ProbeRing *ring)
+{
+    // 占用期间调用的函数若也被探测，直接跳过，不递归
+    t_thread = &g_no_thread;
+    const int saved_errno = errno;
+    const auto tid = static_cast<uint32_t>(syscall(SYS_gettid));
+    const auto pid = static_cast<long>(getpid());
+    for (uint32_t i = 0; i < probe_max_threads; ++i) {
+        std::atomic<uint32_t> &owner = ring->threads[i].owner;
+        uint32_t current = owner.load(std::memory_order_acquire);
+        bool exited = current != 0 && current != tid && syscall(SYS_tgkill, pid, current, 0) != 0 && errno == ESRCH;
+        if ((current == 0 || current == tid || exited) && owner.compare_exchange_strong(current, tid)) {
+            ProbeThread &thread = g_threads[i];
+            thread.tid = tid;
+            thread.index = i;
+            thread.depth = 0;
+            t_thread = &thread;
+            break;
+        }
+    }
+    if (t_thread == &g_no_thread) {
+        ring->lost_threads.fetch_add(1, std::memory_order_relaxed);
+    }
+    errno = saved_errno;
+    return t_thread;
+}
+
+/**
+ * @brief 记录期间将 t_thread 置为占位，同一线程上的信号处理函数再调用被探测函数时不记录，
+ *        不会与被打断的 push 同时写入线程环或返回地址栈
+ */
+class ReentryGuard {
+public:
+    explicit ReentryGuard(ProbeThread *thread) : m_thread(thread)
+    {
+        t_thread = &g_no_thread;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    }
+    ~ReentryGuard()
+    {
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        t_thread = m_thread;
+    }
+    ReentryGuard(const ReentryGuard &) = delete;
+    ReentryGuard &operator=(const ReentryGuard &) = delete;
+
+private:
+    ProbeThread *m_thread;
+};
+
+void probe_enter(uint32_t id, uintptr_t *return_slot, uintptr_t exit_stub)
+{
+    ProbeRing *ring = g_ring.load(std::memory_order_acquire);
+    if (!ring || !ring->enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    ProbeThread *thread = t_thread ? t_thread : claim(ring);
+    if (thread == &g_no_thread) {
+        return;
+    }
+    ReentryGuard guard(thread);
+    ProbeThreadRing &records = ring->threads[thread->index];
+    if (thread->depth == probe_stack_depth) {
+        records.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    // 入口记录写不进去时不改写返回地址，该次调用没有出口记录
+    if (!push(records, { thread->tid, id, timestamp() })) {
+        return;
+    }
+    thread->frames[thread->depth++] = { *return_slot, id };
+    *return_slot = exit_stub;
+}
+
+// 只有 probe_enter 改写过返回地址的调用才会到达这里，停止记录后仍为未返回的调用记录出口
+uintptr_t probe_exit()
+{
+    const uint64_t now = timestamp();
+    ProbeThread *thread = t_thread;
+    ReentryGuard guard(thread);
+    const ProbeFrame frame = thread->frames[--thread->depth];
+    // fork 出的子进程中 g_ring 为空，只返回原返回地址，不写入父进程的线程环
+    if (ProbeRing *ring = g_ring.load(std::memory_order_acquire)) {
+        push(ring->threads[thread->index], { thread->tid, frame.function | probe_exit_flag, now });
+    }
+    return frame.return_address;
+}
+
+// 子进程继承了共享映射与父进程的线程环占用，继续写入会破坏单生产者约定；子进程中停止记录
+void stop_in_child()
+{
+    g_ring.store(nullptr, std::memory_order_release);
+}
+
+} // namespace
+
+std::string probe_ring_name(pid_t pid)
+{
+    return "/remotedebug_probe." + std::to_string(pid);
+}
+
+ProbeRing *probe_ring_create()
+{
+    if (ProbeRing *ring = g_ring.load(std::memory_order_acquire)) {
+        return ring;
+    }
+
+    std::string name = probe_ring_name(getpid());
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0 || ftruncate(fd, sizeof(ProbeRing)) != 0) {
+        std::cerr << "Failed to create " << name << ": " << strerror(errno) << std::endl;
+        if (fd >= 0) {
+            close(fd);
+            shm_unlink(name.c_str());
+        }
+        return nullptr;
+    }
+    void *mapped = mmap(nullptr, sizeof(ProbeRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    // 新建的共享内存全为 0，即全部线程环空闲、未启用
+    auto *ring = static_cast<ProbeRing *>(mapped);
+    ring->version = probe_ring_version;
+    ring->pid = getpid();
+    ring->tsc_khz = calibrate_tsc_khz();
+    std::atomic_thread_fence(std::memory_order_release);
+    ring->magic = probe_ring_magic;
+    static const int registered = pthread_atfork(nullptr, nullptr, stop_in_child);
+    (void)registered;
+    g_ring.store(ring, std::memory_order_release);
+    return ring;
+}
+
+void probe_ring_unlink()
+{
+    if (g_ring.load(std::memory_order_acquire)) {
+        shm_unlink(probe_ring_name(getpid()).c_str());
+    }
+}
+
+const ProbeHooks &probe_ring_hooks()
+{
+    static const ProbeHooks hooks{ probe_enter, probe_exit };
+    return hooks;
+}
+
+ProbeDrain::~ProbeDrain()
+{
+    if (m_ring) {
+        munmap(m_ring, sizeof(ProbeRing));
+    }
+}
+
+int ProbeDrain::open(pid_t pid)
+{
+    std::string name = probe_ring_name(pid);
+    int fd = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "No probes in process " << pid << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+    struct stat st{};
+    void *mapped = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(ProbeRing)) {
+        mapped = mmap(nullptr, sizeof(ProbeRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Failed to map " << name << std::endl;
+        return -1;
+    }
+
+    auto *ring = static_cast<ProbeRing *>(mapped);
+    if (ring->magic != probe_ring_magic || ring->version != probe_ring_version || ring->pid != pid ||
+        ring->tsc_khz == 0) {
+        std::cerr << name << " is not a compatible probe ring" << std::endl;
+        munmap(mapped, sizeof(ProbeRing));
+        return -1;
+    }
+    if (m_ring) {
+        munmap(m_ring, sizeof(ProbeRing));
+    }
+    m_ring = ring;
+    return 0;
+}
+
+size_t ProbeDrain::drain()
+{
+    if (!m_ring) {
+        return 0;
+    }
+    const double ns_per_tick = 1e6 / static_cast<double>(m_ring->tsc_khz);
+    size_t count = 0;
+    for (auto &ring : m_ring->threads) {
+        uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        const uint64_t head = ring.head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail, ++count) {
+            const ProbeRecord record = ring.records[tail & (probe_ring_records - 1)];
+            const uint32_t function = record.function & ~probe_exit_flag;
+            std::vector<Frame> &stack = m_stacks[record.tid];
+            if (!(record.function & probe_exit_flag)) {
+                stack.push_back({ function, record.tsc });
+                continue;
+            }
+
+            // 丢弃的记录或复用 tid 的线程会使入口与出口错位，弹出到同一函数的入口为止
+            while (!stack.empty() && stack.back().function != function) {
+                stack.pop_back();
+            }
+            if (stack.empty() || function >= probe_max_functions) {
+                continue;
+            }
+            const auto ns = static_cast<uint64_t>(static_cast<double>(record.tsc - stack.back().tsc) * ns_per_tick);
+            stack.pop_back();
+
+            ProbeStats &stats = m_stats[function];
+            if (stats.name.empty()) {
+                stats.name.assign(m_ring->names[function], strnlen(m_ring->names[function], probe_name_size));
+            }
+            ++stats.calls;
+            stats.total_ns += ns;
+            stats.max_ns = std::max(stats.max_ns, ns);
+            if (stats.samples_ns.size() < probe_max_samples) {
+                stats.samples_ns.push_back(ns);
+            }
+        }
+        ring.tail.store(tail, std::memory_order_release);
+    }
+    m_records += count;
+    return count;
+}
+
+uint64_t ProbeDrain::dropped() const
+{
+    uint64_t total = 0;
+    for (size_t i = 0; m_ring && i < probe_max_threads; ++i) {
+        total += m_ring->threads[i].dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::string ProbeDrain::report()
+{
+    std::ostringstream oss;
+    oss << "probe records=" << m_records << " dropped=" << dropped() << "\n";
+    for (auto &entry : m_stats) {
+        ProbeStats &stats = entry.second;
+        std::vector<uint64_t> &samples = stats.samples_ns;
+        auto percentile = [&samples](size_t numerator) {
+            auto nth = samples.begin() + static_cast<std::ptrdiff_t>((samples.size() - 1) * numerator / 100);
+            std::nth_element(samples.begin(), nth, samples.end());
+            return *nth;
+        };
+        oss << stats.name << " calls=" << stats.calls << " avg=" << stats.total_ns / stats.calls
+            << "ns p50=" << percentile(50) << "ns p99=" << percentile(99) << "ns max=" << stats.max_ns << "ns\n";
+    }
+    return oss.str();
+}
+
+}; // namespace RemoteDebug
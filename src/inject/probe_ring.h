@@ -0,0 +1,146 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 函数探针的共享内存记录环：探测函数的入口/出口桩写入各线程自己的无锁环，主机工具不暂停目标进程直接读取
+
+#pragma once
+
+#include "patch.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+
+namespace RemoteDebug {
+
+constexpr uint32_t probe_ring_magic = 0x52445052; // "RDPR"
+constexpr uint32_t probe_ring_version = 1;
+constexpr size_t   probe_max_functions = 256;
+constexpr size_t   probe_name_size = 64;
+constexpr size_t   probe_max_threads = 128;
+constexpr size_t   probe_ring_records = 4096;   // 每个线程环的记录数，2 的幂
+constexpr size_t   probe_stack_depth = 64;      // 每个线程可嵌套的探测调用层数
+constexpr uint32_t probe_exit_flag = 0x80000000; // ProbeRecord::function 的最高位表示出口
+
+static_assert((probe_ring_records & (probe_ring_records - 1)) == 0, "ring size must be a power of two");
+
+struct ProbeRecord {
+    uint32_t tid;
+    uint32_t function; // 函数编号，出口记录带 probe_exit_flag
+    uint64_t tsc;
+};
+
+/**
+ * @brief 单个线程的记录环
+ * @details 单生产者单消费者：线程首次执行到探针时按 tid 占用，只有该线程写入记录并推进 head，
+ *          主机工具读取后推进 tail。环满时丢弃新记录并计入 dropped，入口记录被丢弃时该次调用不记录出口
+ */
+struct alignas(64) ProbeThreadRing {
+    std::atomic<uint32_t>              owner;   // 占用线程的 tid，0 表示空闲；线程退出后可被其他线程回收
+    std::atomic<uint64_t>              dropped;
+    alignas(64) std::atomic<uint64_t>  head;
+    alignas(64) std::atomic<uint64_t>  tail;
+    alignas(64) ProbeRecord            records[probe_ring_records];
+};
+
+/**
+ * @brief 共享内存中的探针记录区，由进程内代理首次安装探针时创建
+ * @details tsc 为时间戳计数器的值，tsc_khz 为每毫秒的计数，主机用于换算耗时。
+ *          enabled 清零后全部探针同时停止记录入口，之后再恢复各函数入口
+ */
+struct ProbeRing {
+    uint32_t              magic;
+    uint32_t              version;
+    int32_t               pid;
+    std::atomic<uint32_t> enabled;
+    uint64_t              tsc_khz;
+    std::atomic<uint32_t> functions;             // 已分配的函数编号数
+    std::atomic<uint32_t> lost_threads;          // 线程环耗尽时未能记录的线程数
+    char                  names[probe_max_functions][probe_name_size];
+    ProbeThreadRing       threads[probe_max_threads];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory atomics must be lock free");
+
+/**
+ * @brief 目标进程探针记录区的共享内存名称
+ */
+std::string probe_ring_name(pid_t pid);
+
+/**
+ * @brief 创建当前进程的探针记录区，并将其设为探针回调写入的位置
+ * @details 记录区创建后不再解除映射：退出中的线程与尚未返回的探测调用仍会写入。
+ *          fork 出的子进程不记录：子进程中的探针直接跳过，未返回的调用只恢复返回地址
+ * @return 成功返回记录区，失败返回 nullptr
+ */
+ProbeRing *probe_ring_create();
+
+/**
+ * @brief 删除当前进程的探针记录区名称，已映射的内存保持有效
+ */
+void probe_ring_unlink();
+
+/**
+ * @brief 写入当前进程探针记录区的回调，供 FunctionPatcher::install_probe 使用
+ */
+const ProbeHooks &probe_ring_hooks();
+
+// 单个函数的耗时统计
+struct ProbeStats {
+    std::string           name;
+    uint64_t              calls{ 0 };
+    uint64_t              total_ns{ 0 };
+    uint64_t              max_ns{ 0 };
+    std::vector<uint64_t> samples_ns; // 用于计算分位数，最多保留 probe_max_samples 个
+};
+
+constexpr size_t probe_max_samples = 1 << 20;
+
+/**
+ * @brief 主机侧读取目标进程的探针记录并按线程配对入口与出口
+ */
+class ProbeDrain {
+public:
+    ProbeDrain() = default;
+    ~ProbeDrain();
+    ProbeDrain(const ProbeDrain &) = delete;
+    ProbeDrain &operator=(const ProbeDrain &) = delete;
+
+    /**
+     * @brief 映射目标进程的探针记录区
+     * @return 成功返回0，目标进程未安装过探针返回-1
+     */
+    int open(pid_t pid);
+
+    /**
+     * @brief 读取各线程环中的新记录，不暂停目标进程
+     * @return 本次读取的记录数
+     */
+    size_t drain();
+
+    const std::map<uint32_t, ProbeStats> &stats() const { return m_stats; }
+
+    // 目标进程中因环满或嵌套过深丢弃的记录数
+    uint64_t dropped() const;
+
+    /**
+     * @brief 每个函数一行：调用次数、平均/P50/P99/最大耗时
+     */
+    std::string report();
+
+private:
+    struct Frame {
+        uint32_t function;
+        uint64_t tsc;
+    };
+
+    ProbeRing                                        *m_ring{ nullptr };
+    std::map<uint32_t, ProbeStats>                    m_stats;
+    std::unordered_map<uint32_t, std::vector<Frame>>  m_stacks; // tid -> 未返回的调用
+    uint64_t                                          m_records{ 0 };
+};
+
+}; // namespace RemoteDebug
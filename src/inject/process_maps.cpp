@@ -0,0 +1,119 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "process_maps.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
+namespace RemoteDebug {
+
+namespace {
+
+constexpr uintptr_t min_map_address = 0x10000;          // 默认 vm.mmap_min_addr
+constexpr uintptr_t max_user_address = 0x7FFFFFFFF000; // 48 位用户态地址空间上限
+constexpr uintptr_t guard_size = 0x1000;                // 与相邻映射之间保留一页
+
+uint64_t distance(uintptr_t a, uintptr_t b)
+{
+    return a > b ? a - b : b - a;
+}
+
+} // namespace
+
+int read_process_maps(pid_t pid, std::vector<MapEntry> &entries)
+{
+    std::ifstream maps("/proc/" + std::to_string(pid) + "/maps");
+    if (!maps) {
+        return -1;
+    }
+
+    entries.clear();
+    std::string line;
+    while (std::getline(maps, line)) {
+        MapEntry entry;
+        char perms[8] = {};
+        unsigned long long start = 0;
+        unsigned long long end = 0;
+        unsigned long long offset = 0;
+        unsigned long long inode = 0;
+        int path_pos = 0;
+        if (std::sscanf(line.c_str(), "%llx-%llx %7s %llx %*s %llu %n", &start, &end, perms, &offset, &inode,
+                        &path_pos) < 5) {
+            continue;
+        }
+        entry.start = static_cast<uintptr_t>(start);
+        entry.end = static_cast<uintptr_t>(end);
+        entry.offset = offset;
+        entry.inode = inode;
+        entry.perms = perms;
+        if (path_pos > 0 && static_cast<size_t>(path_pos) < line.size()) {
+            entry.path = line.substr(static_cast<size_t>(path_pos));
+        }
+        entries.push_back(std::move(entry));
+    }
+    return entries.empty() ? -1 : 0;
+}
+
+std::vector<ModuleInfo> collect_modules(const std::vector<MapEntry> &entries)
+{
+    std::vector<ModuleInfo> modules;
+    for (const auto &entry : entries) {
+        // 仅文件映射，排除 [heap]、[vdso] 等伪路径
+        if (entry.inode == 0 || entry.path.empty() || entry.path[0] != '/') {
+            continue;
+        }
+        auto it = std::find_if(modules.begin(), modules.end(), [&](const ModuleInfo &module) {
+            return module.inode == entry.inode && module.path == entry.path;
+        });
+        if (it == modules.end()) {
+            modules.push_back({ entry.path, entry.inode, entry.start, entry.end });
+        } else {
+            it->base = std::min(it->base, entry.start);
+            it->end = std::max(it->end, entry.end);
+        }
+    }
+
+    // 只保留含可执行段的模块，数据文件映射不参与符号解析
+    modules.erase(std::remove_if(modules.begin(), modules.end(),
+                                 [&](const ModuleInfo &module) {
+                                     return std::none_of(entries.begin(), entries.end(), [&](const MapEntry &entry) {
+                                         return entry.executable() && entry.inode == module.inode &&
+                                                entry.path == module.path;
+                                     });
+                                 }),
+                  modules.end());
+    std::sort(modules.begin(), modules.end(),
+              [](const ModuleInfo &a, const ModuleInfo &b) { return a.base < b.base; });
+    return modules;
+}
+
+int find_free_region(const std::vector<MapEntry> &entries, uintptr_t near, size_t size, uint64_t max_distance,
+        uintptr_t &address)
+{
+    bool found = false;
+    uint64_t best = 0;
+    uintptr_t gap_start = min_map_address;
+    for (size_t i = 0; i <= entries.size(); ++i) {
+        uintptr_t gap_end = i < entries.size() ? std::min(entries[i].start, max_user_address) : max_user_address;
+        if (gap_end > gap_start && gap_end - gap_start >= size + 2 * guard_size) {
+            uintptr_t low = gap_start + guard_size;
+            uintptr_t high = gap_end - guard_size - size;
+            uintptr_t candidate = std::min(std::max(near & ~(guard_size - 1), low), high);
+            uint64_t far_end = std::max(distance(candidate, near), distance(candidate + size, near));
+            if (far_end <= max_distance && (!found || far_end < best)) {
+                found = true;
+                best = far_end;
+                address = candidate;
+            }
+        }
+        if (i < entries.size()) {
+            gap_start = std::max(gap_start, entries[i].end);
+        }
+    }
+    return found ? 0 : -1;
+}
+
+}; // namespace RemoteDebug
@@ -0,0 +1,65 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 解析 /proc/<pid>/maps：定位目标进程中的模块与可用于跳转岛的空闲地址区间
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace RemoteDebug {
+
+struct MapEntry {
+    uintptr_t   start{ 0 };
+    uintptr_t   end{ 0 };
+    uint64_t    offset{ 0 };
+    uint64_t    inode{ 0 };
+    std::string perms; // 如 "r-xp"
+    std::string path;  // 匿名映射为空
+
+    bool executable() const { return perms.size() > 2 && perms[2] == 'x'; }
+};
+
+/**
+ * @brief 已加载的模块（可执行文件或共享库）
+ * @details base 为该文件最低的映射地址，与 ELF 第一个 PT_LOAD 的页对齐虚拟地址之差即加载偏移
+ */
+struct ModuleInfo {
+    std::string path;
+    uint64_t    inode{ 0 };
+    uintptr_t   base{ 0 };
+    uintptr_t   end{ 0 };
+
+    bool operator==(const ModuleInfo &other) const
+    {
+        return base == other.base && end == other.end && inode == other.inode && path == other.path;
+    }
+    bool operator!=(const ModuleInfo &other) const { return !(*this == other); }
+};
+
+/**
+ * @brief 读取进程的内存映射
+ * @return 成功返回0，进程不存在或无权限返回-1
+ */
+int read_process_maps(pid_t pid, std::vector<MapEntry> &entries);
+
+/**
+ * @brief 从映射中提取含可执行段的文件模块，按加载地址排序
+ */
+std::vector<ModuleInfo> collect_modules(const std::vector<MapEntry> &entries);
+
+/**
+ * @brief 在 near 附近查找未映射的区间
+ * @param[in] entries 进程映射（按地址排序）
+ * @param[in] near 目标地址
+ * @param[in] size 需要的区间大小（页对齐）
+ * @param[in] max_distance 区间任意一端与 near 的最大距离
+ * @param[out] address 找到的区间起始地址
+ * @return 找到返回0，否则返回-1
+ */
+int find_free_region(const std::vector<MapEntry> &entries, uintptr_t near, size_t size, uint64_t max_distance,
+        uintptr_t &address);
+
+}; // namespace RemoteDebug
@@ -0,0 +1,681 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "process_patcher.h"
+#include "patch_arch.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <dlfcn.h>
+#include <elf.h>
+#include <iomanip>
+#include <iterator>
+#include <iostream>
+#include <sstream>
+#include <sys/mman.h>
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+namespace RemoteDebug {
+
+namespace {
+
+constexpr int    libc_rtld_dlopen = static_cast<int>(0x80000000u); // __RTLD_DLOPEN，__libc_dlopen_mode 需要
+
+// 入口跳转与跳转岛的编码由编译时选择的体系结构后端提供
+using Arch = arch::Native;
+constexpr uint64_t max_branch_distance = Arch::entry_range;
+
+static_assert(Arch::literal_jump_size == island_slot_size, "island slot holds one literal jump");
+
+uint64_t distance(uintptr_t a, uintptr_t b)
+{
+    return a > b ? a - b : b - a;
+}
+
+std::string hex(uintptr_t value)
+{
+    std::ostringstream oss;
+    oss << "0x" << std::hex << value;
+    return oss.str();
+}
+
+// 作用域结束时恢复目标进程的全部线程
+class AttachGuard {
+public:
+    explicit AttachGuard(RemoteProcess &process) : m_process(process) {}
+    ~AttachGuard() { m_process.detach(); }
+    AttachGuard(const AttachGuard &) = delete;
+    AttachGuard &operator=(const AttachGuard &) = delete;
+
+private:
+    RemoteProcess &m_process;
+};
+
+} // namespace
+
+std::shared_ptr<const ElfSymbols> SymbolCache::get(pid_t pid, const ModuleInfo &module)
+{
+    auto key = std::make_pair(module.path, module.inode);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        return it->second;
+    }
+
+    TraceSpan span("symbol_index", "patcher", pid);
+    auto symbols = std::make_shared<ElfSymbols>();
+    if (symbols->load("/proc/" + std::to_string(pid) + "/root" + module.path) != 0) {
+        return nullptr;
+    }
+    m_entries.emplace(key, symbols);
+    return symbols;
+}
+
+std::shared_ptr<const DwarfTypes> SymbolCache::get_types(pid_t pid, const ModuleInfo &module)
+{
+    auto key = std::make_pair(module.path, module.inode);
+    auto it = m_types.find(key);
+    if (it != m_types.end()) {
+        return it->second;
+    }
+
+    TraceSpan span("dwarf_index", "patcher", pid);
+    auto types = std::make_shared<DwarfTypes>();
+    if (types->load("/proc/" + std::to_string(pid) + "/root" + module.path) != 0) {
+        return nullptr;
+    }
+    m_types.emplace(key, types);
+    return types;
+}
+
+std::shared_ptr<const TextImage> SymbolCache::get_text(pid_t pid, const ModuleInfo &module)
+{
+    auto key = std::make_pair(module.path, module.inode);
+    auto it = m_texts.find(key);
+    if (it != m_texts.end()) {
+        return it->second;
+    }
+
+    TraceSpan span("text_index", "patcher", pid);
+    auto text = std::make_shared<TextImage>();
+    if (text->load("/proc/" + std::to_string(pid) + "/root" + module.path) != 0) {
+        return nullptr;
+    }
+    m_texts.emplace(key, text);
+    return text;
+}
+
+void SymbolCache::prune()
+{
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        it = it->second.use_count() == 1 ? m_entries.erase(it) : std::next(it);
+    }
+    for (auto it = m_types.begin(); it != m_types.end();) {
+        it = it->second.use_count() == 1 ? m_types.erase(it) : std::next(it);
+    }
+    for (auto it = m_texts.begin(); it != m_texts.end();) {
+        it = it->second.use_count() == 1 ? m_texts.erase(it) : std::next(it);
+    }
+}
+
+int ProcessPatcher::fail(const std::string &message)
+{
+    m_error = message;
+    std::cerr << "[pid " << pid() << "] " << message << std::endl;
+    return -1;
+}
+
+int ProcessPatcher::refresh()
+{
+    TraceSpan span("maps_parse", "patcher", pid());
+    std::vector<MapEntry> maps;
+    if (read_process_maps(pid(), maps) != 0) {
+        return -1;
+    }
+    std::vector<ModuleInfo> modules = collect_modules(maps);
+    span.end();
+    m_maps.swap(maps);
+    if (modules == m_modules) {
+        return 0;
+    }
+
+    // 仍在的模块保留已建立的符号索引
+    std::vector<std::shared_ptr<const ElfSymbols>> symbols(modules.size());
+    std::vector<std::shared_ptr<const DwarfTypes>> types(modules.size());
+    std::vector<std::shared_ptr<const TextImage>> texts(modules.size());
+    for (size_t i = 0; i < modules.size(); ++i) {
+        auto it = std::find(m_modules.begin(), m_modules.end(), modules[i]);
+        if (it != m_modules.end()) {
+            symbols[i] = m_symbols[static_cast<size_t>(it - m_modules.begin())];
+            types[i] = m_types[static_cast<size_t>(it - m_modules.begin())];
+            texts[i] = m_texts[static_cast<size_t>(it - m_modules.begin())];
+        }
+    }
+
+    auto in_module = [&](uintptr_t address) {
+        return std::any_of(modules.begin(), modules.end(),
+                           [&](const ModuleInfo &module) { return address >= module.base && address < module.end; });
+    };
+    for (auto it = m_patches.begin(); it != m_patches.end();) {
+        if (in_module(it->second.address)) {
+            ++it;
+            continue;
+        }
+        std::cerr << "[pid " << pid() << "] module of " << it->first << " unloaded, dropping its patch" << std::endl;
+        release_island(it->second.island);
+        it = m_patches.erase(it);
+    }
+    for (auto it = m_data.begin(); it != m_data.end();) {
+        if (in_module(it->second.address)) {
+            ++it;
+            continue;
+        }
+        std::cerr << "[pid " << pid() << "] module of " << it->first << " unloaded, dropping its data patch" << std::endl;
+        it = m_data.erase(it);
+    }
+    m_arenas.erase(std::remove_if(m_arenas.begin(), m_arenas.end(),
+                                  [&](const IslandArena &arena) {
+                                      return std::none_of(m_maps.begin(), m_maps.end(), [&](const MapEntry &entry) {
+                                          return entry.start <= arena.base && arena.base < entry.end;
+                                      });
+                                  }),
+                   m_arenas.end());
+    for (auto it = m_libraries.begin(); it != m_libraries.end();) {
+        bool loaded = std::any_of(modules.begin(), modules.end(),
+                                  [&](const ModuleInfo &module) { return module.path == it->first; });
+        it = loaded ? std::next(it) : m_libraries.erase(it);
+    }
+
+    m_modules = std::move(modules);
+    m_symbols = std::move(symbols);
+    m_types = std::move(types);
+    m_texts = std::move(texts);
+    return 1;
+}
+
+size_t ProcessPatcher::index_modules()
+{
+    size_t indexed = 0;
+    for (size_t i = 0; i < m_modules.size(); ++i) {
+        if (!m_symbols[i]) {
+            m_symbols[i] = m_cache.get(pid(), m_modules[i]);
+        }
+        indexed += m_symbols[i] ? 1 : 0;
+    }
+    return indexed;
+}
+
+int ProcessPatcher::resolve_cached(const std::string &symbol, uintptr_t &address)
+{
+    for (size_t i = 0; i < m_modules.size(); ++i) {
+        if (!m_symbols[i]) {
+            m_symbols[i] = m_cache.get(pid(), m_modules[i]);
+            if (!m_symbols[i]) {
+                continue;
+            }
+        }
+        const ElfSymbol *found = m_symbols[i]->find(symbol);
+        if (found && found->value != 0) {
+            address = m_modules[i].base - m_symbols[i]->load_address() + found->value;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int ProcessPatcher::resolve(const std::string &symbol, uintptr_t &address)
+{
+    TraceSpan span("symbol_resolve", "patcher", pid());
+    if (resolve_cached(symbol, address) == 0) {
+        return 0;
+    }
+    // 缓存未命中时可能是刚加载的模块还未被轮询到
+    if (refresh() == 1 && resolve_cached(symbol, address) == 0) {
+        return 0;
+    }
+    return -1;
+}
+
+int ProcessPatcher::map_arena(uintptr_t near, uintptr_t &base)
+{
+    TraceSpan span("remote_alloc", "patcher", pid());
+    uintptr_t hint = 0;
+    uintptr_t mmap_function = 0;
+    if (find_free_region(m_maps, near, island_arena_size, max_branch_distance, hint) != 0) {
+        return fail("no free address range within branch distance of " + hex(near));
+    }
+    if (resolve_cached("mmap", mmap_function) != 0) {
+        return fail("mmap not found in target process");
+    }
+    if (m_process.attach() != 0) {
+        return fail("failed to attach");
+    }
+
+    // 跳转岛只需读和执行权限，内容通过 /proc/<pid>/mem 写入
+    RemoteCall call{ mmap_function,
+                     { hint, island_arena_size, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+                       ~0ULL, 0 },
+                     "" };
+    uint64_t result = 0;
+    if (m_process.call_function(call, result) != 0 || result == reinterpret_cast<uint64_t>(MAP_FAILED)) {
+        return fail("remote mmap failed");
+    }
+    if (distance(result, near) > max_branch_distance) {
+        return fail("island arena " + hex(result) + " is out of branch range");
+    }
+    base = result;
+    read_process_maps(pid(), m_maps);
+    return 0;
+}
+
+int ProcessPatcher::allocate_island(uintptr_t near, uintptr_t &island)
+{
+    for (auto &arena : m_arenas) {
+        if (distance(arena.base, near) > max_branch_distance ||
+            distance(arena.base + island_arena_size, near) > max_branch_distance) {
+            continue;
+        }
+        if (!arena.free_slots.empty()) {
+            island = arena.free_slots.back();
+            arena.free_slots.pop_back();
+            return 0;
+        }
+        if (arena.used + island_slot_size <= island_arena_size) {
+            island = arena.base + arena.used;
+            arena.used += island_slot_size;
+            return 0;
+        }
+    }
+
+    IslandArena arena;
+    if (map_arena(near, arena.base) != 0) {
+        return -1;
+    }
+    island = arena.base;
+    arena.used = island_slot_size;
+    m_arenas.push_back(arena);
+    return 0;
+}
+
+void ProcessPatcher::release_island(uintptr_t island)
+{
+    for (auto &arena : m_arenas) {
+        if (island >= arena.base && island < arena.base + island_arena_size) {
+            arena.free_slots.push_back(island);
+            return;
+        }
+    }
+}
+
+int ProcessPatcher::load_library(const std::string &path, uintptr_t &handle)
+{
+    if (path.empty() || path[0] != '/') {
+        return fail("library path must be absolute: " + path);
+    }
+    auto it = m_libraries.find(path);
+    if (it != m_libraries.end()) {
+        handle = it->second;
+        return 0;
+    }
+
+    int mode = RTLD_NOW;
+    uintptr_t dlopen_function = 0;
+    if (resolve_cached("dlopen", dlopen_function) != 0) {
+        // glibc 2.34 之前 dlopen 位于 libdl，未加载时使用 libc 内部入口
+        if (resolve_cached("__libc_dlopen_mode", dlopen_function) != 0) {
+            return fail("dlopen not found in target process");
+        }
+        mode |= libc_rtld_dlopen;
+    }
+
+    {
+        TraceSpan span("dlopen", "patcher", pid());
+        AttachGuard guard(m_process);
+        if (m_process.attach() != 0) {
+            return fail("failed to attach");
+        }
+        uint64_t result = 0;
+        // 其他线程可能持有 dlopen 需要的锁，调用期间让它们继续运行
+        RemoteCall call{ dlopen_function, { 0, static_cast<uint64_t>(mode) }, path, true };
+        if (m_process.call_function(call, result) != 0) {
+            return fail("remote dlopen failed");
+        }
+        if (result == 0) {
+            std::string reason = "dlopen returned NULL";
+            uintptr_t dlerror_function = 0;
+            uint64_t message = 0;
+            char buffer[256] = {};
+            if (resolve_cached("dlerror", dlerror_function) == 0 &&
+                m_process.call_function({ dlerror_function, {}, "", true }, message) == 0 && message != 0 &&
+                m_process.read_memory(message, buffer, sizeof(buffer) - 1) == 0) {
+                reason = buffer;
+            }
+            return fail("failed to load " + path + ": " + reason);
+        }
+        handle = result;
+    }
+
+    refresh();
+    m_libraries[path] = handle;
+    return 0;
+}
+
+int ProcessPatcher::apply(const std::string &target, const std::string &replacement, uintptr_t &address)
+{
+    if (!Arch::supported) {
+        return fail("remote patching is not supported on this architecture");
+    }
+    uintptr_t replacement_address = 0;
+    if (resolve(replacement, replacement_address) != 0) {
+        return fail("symbol " + replacement + " not found");
+    }
+
+    // 已打补丁：只改写跳转岛中的目标地址
+    auto it = m_patches.find(target);
+    if (it != m_patches.end()) {
+        AppliedPatch &patch = it->second;
+        address = patch.address;
+        if (patch.replacement == replacement_address) {
+            return 0;
+        }
+        AttachGuard guard(m_process);
+        uint64_t value = replacement_address;
+        if (m_process.attach() != 0 ||
+            m_process.write_memory(patch.island + Arch::literal_target_offset, &value, sizeof(value)) != 0) {
+            return fail("failed to retarget island of " + target);
+        }
+        patch.replacement = replacement_address;
+        return 0;
+    }
+
+    if (resolve(target, address) != 0) {
+        return fail("symbol " + target + " not found");
+    }
+    for (const auto &entry : m_patches) {
+        if (entry.second.address == address) {
+            return fail(target + " is already patched as " + entry.first);
+        }
+    }
+
+    AppliedPatch patch;
+    patch.target = target;
+    patch.address = address;
+    patch.replacement = replacement_address;
+    patch.original.resize(Arch::entry_jump_size);
+    if (m_process.read_memory(address, patch.original.data(), patch.original.size()) != 0) {
+        return fail("failed to read entry of " + target);
+    }
+
+    AttachGuard guard(m_process);
+    if (allocate_island(address, patch.island) != 0) {
+        return -1;
+    }
+
+    // 跳转岛未被引用，先写入；入口改写期间所有线程处于暂停状态
+    const auto slot = Arch::literal_jump(replacement_address);
+    const auto jump = Arch::entry_jump(address, patch.island);
+    if (m_process.write_memory(patch.island, slot.bytes, slot.size) != 0 || m_process.attach() != 0 ||
+        rewrite_entry(address, jump.bytes, jump.size) != 0) {
+        release_island(patch.island);
+        return fail("failed to patch entry of " + target);
+    }
+
+    m_patches.emplace(target, std::move(patch));
+    return 0;
+}
+
+int ProcessPatcher::revert(const std::string &target)
+{
+    auto it = m_patches.find(target);
+    if (it == m_patches.end()) {
+        return fail(target + " is not patched");
+    }
+
+    const AppliedPatch &patch = it->second;
+    {
+        AttachGuard guard(m_process);
+        // 入口恢复后停在跳转岛内的线程先执行到补丁函数，跳转岛才能复用
+        if (m_process.attach() != 0 || rewrite_entry(patch.address, patch.original.data(), patch.original.size()) != 0 ||
+            m_process.move_threads_out_of(patch.island - 1, patch.island + island_slot_size) != 0) {
+            return fail("failed to restore entry of " + target);
+        }
+    }
+
+    release_island(patch.island);
+    m_patches.erase(it);
+    return 0;
+}
+
+int ProcessPatcher::rewrite_entry(uintptr_t address, const uint8_t *code, size_t size)
+{
+    TraceSpan span("prologue_rewrite", "patcher", pid());
+    if (m_process.move_threads_out_of(address, address + size) != 0 || m_process.write_memory(address, code, size) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+int ProcessPatcher::resolve_variable(const std::string &variable, DataPatch &patch)
+{
+    TraceSpan span("symbol_resolve", "patcher", pid());
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        for (size_t i = 0; i < m_modules.size(); ++i) {
+            if (!m_symbols[i]) {
+                m_symbols[i] = m_cache.get(pid(), m_modules[i]);
+                if (!m_symbols[i]) {
+                    continue;
+                }
+            }
+            std::string symbol_name;
+            const ElfSymbol *found = m_symbols[i]->find_object(variable, &symbol_name);
+            if (!found || found->value == 0) {
+                continue;
+            }
+            if (found->type == STT_TLS) {
+                return fail(variable + " is thread-local");
+            }
+            if (found->type != STT_OBJECT) {
+                return fail(variable + " is not a variable");
+            }
+
+            patch.variable = variable;
+            patch.address = m_modules[i].base - m_symbols[i]->load_address() + found->value;
+            if (!m_types[i]) {
+                m_types[i] = m_cache.get_types(pid(), m_modules[i]);
+            }
+            const DwarfTypes *types = m_types[i].get();
+            VariableType &type = patch.type;
+            if (!types || !types->has_debug_info()) {
+                // 模块没有 .debug_info：只能按符号大小当作整数处理
+                type = VariableType();
+                type.size = found->size;
+                return 0;
+            }
+            if ((!types->find(variable, type) && !types->find(symbol_name, type)) ||
+                type.kind == VALUE_KIND::UNKNOWN) {
+                // 有调试信息却找不到类型时不能跳过类型检查，否则浮点数或结构体成员会按整数写入
+                return fail("no DWARF type for " + variable);
+            }
+            if (found->size != 0 && type.size != found->size) {
+                return fail(variable + " is " + std::to_string(found->size) + " bytes but DWARF type " + type.name +
+                            " is " + std::to_string(type.size) + " bytes (stale debug info?)");
+            }
+            return 0;
+        }
+        // 未找到时可能是刚加载的模块还未被轮询到
+        if (attempt == 0 && refresh() != 1) {
+            break;
+        }
+    }
+    return fail("variable " + variable + " not found");
+}
+
+int ProcessPatcher::read_variable(const std::string &variable, VariableType &type, std::string &value)
+{
+    DataPatch patch;
+    if (resolve_variable(variable, patch) != 0) {
+        return -1;
+    }
+    type = patch.type;
+    std::vector<uint8_t> bytes(std::min<uint64_t>(type.size, sizeof(uint64_t)));
+    if (type.size <= sizeof(uint64_t) && m_process.read_memory(patch.address, bytes.data(), bytes.size()) != 0) {
+        return fail("failed to read " + variable);
+    }
+    value = format_value(type, bytes.data());
+    return 0;
+}
+
+int ProcessPatcher::write_variables(const std::vector<std::pair<std::string, std::string>> &assignments,
+                                    std::string &report)
+{
+    std::vector<DataPatch> batch;
+    std::vector<std::vector<uint8_t>> values;
+    for (const auto &assignment : assignments) {
+        const std::string &variable = assignment.first;
+        if (std::any_of(batch.begin(), batch.end(), [&](const DataPatch &p) { return p.variable == variable; })) {
+            return fail(variable + " is assigned twice");
+        }
+        DataPatch patch;
+        if (resolve_variable(variable, patch) != 0) {
+            return -1;
+        }
+        if (patch.type.is_const) {
+            return fail(variable + " is const, its value may have been folded into code");
+        }
+        std::string error;
+        std::vector<uint8_t> bytes;
+        if (encode_value(patch.type, assignment.second, bytes, error) != 0) {
+            return fail(variable + ": " + error);
+        }
+        batch.push_back(std::move(patch));
+        values.push_back(std::move(bytes));
+    }
+
+    AttachGuard guard(m_process);
+    if (m_process.attach() != 0) {
+        return fail("failed to attach");
+    }
+    std::vector<std::vector<uint8_t>> previous(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        previous[i].resize(values[i].size());
+        if (m_process.read_memory(batch[i].address, previous[i].data(), previous[i].size()) != 0) {
+            return fail("failed to read " + batch[i].variable);
+        }
+    }
+    if (write_data(batch, values, previous) != 0) {
+        return -1;
+    }
+
+    report.clear();
+    for (size_t i = 0; i < batch.size(); ++i) {
+        report += (i ? " " : "") + batch[i].variable + "=" + format_value(batch[i].type, previous[i].data()) + "->" +
+                  format_value(batch[i].type, values[i].data());
+        auto result = m_data.emplace(batch[i].variable, batch[i]);
+        if (result.second) {
+            result.first->second.original = previous[i];
+        }
+    }
+    return 0;
+}
+
+int ProcessPatcher::revert_variable(const std::string &variable)
+{
+    auto it = m_data.find(variable);
+    if (it == m_data.end()) {
+        return fail(variable + " is not patched");
+    }
+
+    const DataPatch &patch = it->second;
+    AttachGuard guard(m_process);
+    std::vector<uint8_t> current(patch.original.size());
+    if (m_process.attach() != 0 || m_process.read_memory(patch.address, current.data(), current.size()) != 0 ||
+        write_data({ patch }, { patch.original }, { current }) != 0) {
+        return fail("failed to restore " + variable);
+    }
+    m_data.erase(it);
+    return 0;
+}
+
+int ProcessPatcher::verify(TextVerifyReport &report)
+{
+    report = TextVerifyReport();
+    if (refresh() < 0) {
+        return fail("process " + std::to_string(pid()) + " is gone");
+    }
+    TraceSpan span("text_verify", "patcher", pid());
+    auto read = [this](uintptr_t address, void *buffer, size_t size) {
+        return m_process.read_memory(address, buffer, size);
+    };
+
+    // 补丁清单：入口为跳到跳转岛的指令，跳转岛跳到补丁函数
+    std::vector<TextExpectation> expected;
+    for (const auto &entry : m_patches) {
+        const AppliedPatch &patch = entry.second;
+        const auto jump = Arch::entry_jump(patch.address, patch.island);
+        expected.push_back({ patch.address, { jump.bytes, jump.bytes + jump.size }, "patch:" + entry.first });
+
+        const auto slot = Arch::literal_jump(patch.replacement);
+        uint8_t live[Arch::literal_jump_size];
+        if (read(patch.island, live, sizeof(live)) != 0) {
+            report.skipped.push_back("[island]");
+            continue;
+        }
+        const TextExpectation island{ patch.island, { slot.bytes, slot.bytes + slot.size }, "island:" + entry.first };
+        append_diffs(live, slot.bytes, slot.size, patch.island, "[island]", 0, { island }, report.diffs);
+        report.bytes += sizeof(live);
+        ++report.patch_sites;
+    }
+    std::sort(expected.begin(), expected.end(),
+              [](const TextExpectation &a, const TextExpectation &b) { return a.address < b.address; });
+
+    for (size_t i = 0; i < m_modules.size(); ++i) {
+        const ModuleInfo &module = m_modules[i];
+        if (!m_texts[i]) {
+            m_texts[i] = m_cache.get_text(pid(), module);
+            if (!m_texts[i]) {
+                report.skipped.push_back(module.path);
+                continue;
+            }
+        }
+        std::vector<TextExpectation> sites;
+        std::copy_if(expected.begin(), expected.end(), std::back_inserter(sites), [&](const TextExpectation &site) {
+            return site.address >= module.base && site.address < module.end;
+        });
+        verify_module_text(*m_texts[i], module.path, module.base - m_texts[i]->load_address(), sites, read, report);
+    }
+    return 0;
+}
+
+int ProcessPatcher::write_data(const std::vector<DataPatch> &batch, const std::vector<std::vector<uint8_t>> &values,
+                               const std::vector<std::vector<uint8_t>> &previous)
+{
+    TraceSpan span("data_write", "patcher", pid());
+    size_t written = 0;
+    bool verified = true;
+    for (; written < batch.size(); ++written) {
+        if (m_process.write_memory(batch[written].address, values[written].data(), values[written].size()) != 0) {
+            verified = false;
+            break;
+        }
+    }
+    for (size_t i = 0; verified && i < batch.size(); ++i) {
+        std::vector<uint8_t> readback(values[i].size());
+        verified = m_process.read_memory(batch[i].address, readback.data(), readback.size()) == 0 &&
+                   readback == values[i];
+    }
+    if (verified) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < written; ++i) {
+        m_process.write_memory(batch[i].address, previous[i].data(), previous[i].size());
+    }
+    if (written < batch.size()) {
+        return fail("failed to write " + batch[written].variable + ", batch rolled back");
+    }
+    return fail("read-back did not match, batch rolled back");
+}
+
+}; // namespace RemoteDebug
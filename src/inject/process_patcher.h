@@ -0,0 +1,207 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 对单个目标进程打补丁：缓存模块符号与跳转岛内存，函数入口改写为跳转到补丁函数，全局变量按类型改写
+
+#pragma once
+
+#include "dwarf_types.h"
+#include "elf_symbols.h"
+#include "process_maps.h"
+#include "remote_process.h"
+#include "text_image.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace RemoteDebug {
+
+constexpr size_t island_arena_size = 64 * 1024; // 每块跳转岛内存的大小
+constexpr size_t island_slot_size = 16;         // 每个跳转岛占用的字节数
+
+/**
+ * @brief 模块符号索引缓存
+ * @details 以路径和 inode 为键，多个进程加载同一文件时共享同一份索引；
+ *          文件被替换后 inode 变化，自动建立新索引
+ */
+class SymbolCache {
+public:
+    /**
+     * @brief 获取模块的符号索引，首次访问时解析 ELF 文件
+     * @param[in] pid 模块所属进程，通过 /proc/<pid>/root 访问，兼容容器内进程
+     * @return 解析失败返回 nullptr
+     */
+    std::shared_ptr<const ElfSymbols> get(pid_t pid, const ModuleInfo &module);
+
+    /**
+     * @brief 获取模块的 DWARF 变量索引，首次访问时解析调试信息
+     * @return 解析失败返回 nullptr，没有调试信息时返回空索引
+     */
+    std::shared_ptr<const DwarfTypes> get_types(pid_t pid, const ModuleInfo &module);
+
+    /**
+     * @brief 获取模块可执行段的分块校验值，首次访问时读取 ELF 文件计算
+     * @return 读取失败返回 nullptr
+     */
+    std::shared_ptr<const TextImage> get_text(pid_t pid, const ModuleInfo &module);
+
+    /**
+     * @brief 释放已没有进程使用的索引
+     */
+    void prune();
+
+    size_t size() const { return m_entries.size(); }
+
+private:
+    std::map<std::pair<std::string, uint64_t>, std::shared_ptr<const ElfSymbols>> m_entries;
+    std::map<std::pair<std::string, uint64_t>, std::shared_ptr<const DwarfTypes>> m_types;
+    std::map<std::pair<std::string, uint64_t>, std::shared_ptr<const TextImage>>  m_texts;
+};
+
+struct AppliedPatch {
+    std::string          target;
+    uintptr_t            address{ 0 };     // 被改写的函数入口
+    uintptr_t            replacement{ 0 }; // 补丁函数
+    uintptr_t            island{ 0 };      // 跳转岛，入口跳转到这里再跳到补丁函数
+    std::vector<uint8_t> original;         // 被覆盖的入口指令
+};
+
+struct DataPatch {
+    std::string          variable;
+    uintptr_t            address{ 0 };
+    VariableType         type;             // 没有调试信息时 kind 为 UNKNOWN，size 取符号大小
+    std::vector<uint8_t> original;         // 第一次写入前的值
+};
+
+/**
+ * @brief 单个进程的补丁状态
+ * @details 模块列表与符号索引在 refresh 时更新，apply 时直接使用缓存；
+ *          跳转岛从靠近目标函数的预分配内存块中分配，入口只需一条相对跳转。
+ *          apply/revert 期间暂停全部线程，并保证没有线程停在被改写的指令中间
+ */
+class ProcessPatcher {
+public:
+    ProcessPatcher(pid_t pid, SymbolCache &cache) : m_process(pid), m_cache(cache) {}
+
+    pid_t pid() const { return m_process.pid(); }
+
+    /**
+     * @brief 重新读取内存映射，检测模块加载与卸载
+     * @details 卸载模块中的补丁与符号索引随之丢弃
+     * @return 模块未变化返回0，有变化返回1，进程已退出返回-1
+     */
+    int refresh();
+
+    /**
+     * @brief 在目标进程中 dlopen 补丁库，同一路径只加载一次
+     * @param[in] path 补丁库绝对路径（目标进程视角）
+     * @param[out] handle dlopen 返回的句柄
+     * @return 成功返回0，失败返回-1
+     */
+    int load_library(const std::string &path, uintptr_t &handle);
+
+    /**
+     * @brief 将 target 函数重定向到 replacement 函数
+     * @details 已打过补丁的函数只改写跳转岛中的目标地址
+     * @param[out] address target 函数地址
+     * @return 成功返回0，失败返回-1
+     */
+    int apply(const std::string &target, const std::string &replacement, uintptr_t &address);
+
+    /**
+     * @brief 恢复 target 函数的原始入口并回收跳转岛
+     * @return 成功返回0，失败返回-1
+     */
+    int revert(const std::string &target);
+
+    /**
+     * @brief 读取全局变量或类的静态成员
+     * @param[in] variable 符号名或还原后的 C++ 名称
+     * @param[out] type 变量类型
+     * @param[out] value 按类型格式化的当前值
+     * @return 成功返回0，失败返回-1
+     */
+    int read_variable(const std::string &variable, VariableType &type, std::string &value);
+
+    /**
+     * @brief 写入一批变量
+     * @details 先解析全部变量并按 DWARF 类型检查新值，再暂停全部线程一次写入并读回校验，
+     *          任一失败则恢复本批已写入的值；目标线程看到的要么全部是旧值，要么全部是新值
+     * @param[in] assignments 变量名与新值
+     * @param[out] report 每个变量 "name=旧值->新值"，以空格分隔
+     * @return 成功返回0，失败返回-1
+     */
+    int write_variables(const std::vector<std::pair<std::string, std::string>> &assignments, std::string &report);
+
+    /**
+     * @brief 将变量恢复为第一次写入前的值
+     * @return 成功返回0，失败返回-1
+     */
+    int revert_variable(const std::string &variable);
+
+    /**
+     * @brief 校验全部模块的代码段与磁盘上的 ELF 文件一致，补丁入口与跳转岛为补丁清单中期望的跳转
+     * @details 用 process_vm_readv 读取，不暂停目标进程；见 verify_module_text
+     * @param[out] report 校验的模块、字节数与差异区间
+     * @return 完成校验返回0（可能有差异），目标进程已退出返回-1
+     */
+    int verify(TextVerifyReport &report);
+
+    /**
+     * @brief 在已加载的模块中查找符号的运行地址，按加载地址顺序取第一个定义
+     * @return 成功返回0，未找到返回-1
+     */
+    int resolve(const std::string &symbol, uintptr_t &address);
+
+    /**
+     * @brief 预先建立全部模块的符号索引，之后的 apply 不再解析 ELF 文件
+     * @return 已建立索引的模块数
+     */
+    size_t index_modules();
+
+    const std::vector<ModuleInfo> &modules() const { return m_modules; }
+    const std::map<std::string, AppliedPatch> &patches() const { return m_patches; }
+    const std::map<std::string, DataPatch> &data_patches() const { return m_data; }
+    size_t arena_count() const { return m_arenas.size(); }
+    size_t library_count() const { return m_libraries.size(); }
+
+    // 最近一次失败的原因
+    const std::string &error() const { return m_error; }
+
+private:
+    struct IslandArena {
+        uintptr_t              base{ 0 };
+        size_t                 used{ 0 };
+        std::vector<uintptr_t> free_slots;
+    };
+
+    int fail(const std::string &message);
+    int resolve_cached(const std::string &symbol, uintptr_t &address);
+    int allocate_island(uintptr_t near, uintptr_t &island);
+    void release_island(uintptr_t island);
+    int map_arena(uintptr_t near, uintptr_t &base);
+    // 将线程移出入口后写入新的入口指令，调用前需已 attach
+    int rewrite_entry(uintptr_t address, const uint8_t *code, size_t size);
+    // 查找变量地址并确定类型；模块有调试信息但找不到变量类型、或类型大小与符号大小不一致时失败
+    int resolve_variable(const std::string &variable, DataPatch &patch);
+    // 写入一批值并读回校验，失败时恢复 previous，调用前需已 attach
+    int write_data(const std::vector<DataPatch> &batch, const std::vector<std::vector<uint8_t>> &values,
+                   const std::vector<std::vector<uint8_t>> &previous);
+
+    RemoteProcess                                    m_process;
+    SymbolCache                                     &m_cache;
+    std::vector<MapEntry>                            m_maps;
+    std::vector<ModuleInfo>                          m_modules;
+    std::vector<std::shared_ptr<const ElfSymbols>>   m_symbols; // 与 m_modules 一一对应，按需加载
+    std::vector<std::shared_ptr<const DwarfTypes>>   m_types;   // 与 m_modules 一一对应，数据补丁时加载
+    std::vector<std::shared_ptr<const TextImage>>    m_texts;   // 与 m_modules 一一对应，校验代码段时加载
+    std::vector<IslandArena>                         m_arenas;
+    std::map<std::string, AppliedPatch>              m_patches;
+    std::map<std::string, uintptr_t>                 m_libraries;
+    std::map<std::string, DataPatch>                 m_data;
+    std::string                                      m_error;
+};
+
+}; // namespace RemoteDebug
@@ -0,0 +1,518 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "remote_process.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <dirent.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sys/ptrace.h>
+#include <sys/uio.h>
+#include <sys/user.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace RemoteDebug {
+
+namespace {
+
+constexpr int        max_attach_rounds = 16;  // 逐轮暂停新出现的线程，直至线程列表稳定
+constexpr int        max_single_steps = 64;
+constexpr size_t     stack_reserve = 256;     // 跳过 x86-64 的 128 字节 red zone 并留出余量
+constexpr useconds_t min_call_poll_us = 20;   // 远程调用通常在百微秒内返回，等待间隔从此值起倍增
+constexpr useconds_t max_call_poll_us = 5000;
+
+#if defined(__x86_64__)
+using Registers = user_regs_struct;
+
+int get_registers(pid_t tid, Registers &regs)
+{
+    return ptrace(PTRACE_GETREGS, tid, nullptr, &regs) == 0 ? 0 : -1;
+}
+
+int set_registers(pid_t tid, const Registers &regs)
+{
+    return ptrace(PTRACE_SETREGS, tid, nullptr, &regs) == 0 ? 0 : -1;
+}
+
+uintptr_t program_counter(const Registers &regs)
+{
+    return regs.rip;
+}
+
+uintptr_t stack_pointer(const Registers &regs)
+{
+    return regs.rsp;
+}
+
+uint64_t return_value(const Registers &regs)
+{
+    return regs.rax;
+}
+
+/**
+ * @brief 设置调用寄存器：System V 参数寄存器，返回地址压栈
+ * @details orig_rax 置为 -1，避免线程暂停在系统调用中时内核按系统调用重启规则回退 rip
+ */
+int setup_call(RemoteProcess &process, Registers &regs, uintptr_t function, const std::vector<uint64_t> &args,
+        uintptr_t sp)
+{
+    unsigned long long *const params[] = { &regs.rdi, &regs.rsi, &regs.rdx, &regs.rcx, &regs.r8, &regs.r9 };
+    for (size_t i = 0; i < args.size(); ++i) {
+        *params[i] = args[i];
+    }
+    const uint64_t return_address = 0;
+    sp -= sizeof(return_address);
+    if (process.write_memory(sp, &return_address, sizeof(return_address)) != 0) {
+        return -1;
+    }
+    regs.rsp = sp;
+    regs.rip = function;
+    regs.rax = 0;
+    regs.orig_rax = ~0ULL;
+    return 0;
+}
+#elif defined(__aarch64__)
+struct Registers {
+    user_pt_regs gp;
+    int          syscall_no;
+};
+
+int get_registers(pid_t tid, Registers &regs)
+{
+    iovec gp{ &regs.gp, sizeof(regs.gp) };
+    iovec sc{ &regs.syscall_no, sizeof(regs.syscall_no) };
+    if (ptrace(PTRACE_GETREGSET, tid, NT_PRSTATUS, &gp) != 0 ||
+        ptrace(PTRACE_GETREGSET, tid, NT_ARM_SYSTEM_CALL, &sc) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+int set_registers(pid_t tid, const Registers &regs)
+{
+    iovec gp{ const_cast<user_pt_regs *>(&regs.gp), sizeof(regs.gp) };
+    iovec sc{ const_cast<int *>(&regs.syscall_no), sizeof(regs.syscall_no) };
+    if (ptrace(PTRACE_SETREGSET, tid, NT_PRSTATUS, &gp) != 0 ||
+        ptrace(PTRACE_SETREGSET, tid, NT_ARM_SYSTEM_CALL, &sc) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+uintptr_t program_counter(const Registers &regs)
+{
+    return regs.gp.pc;
+}
+
+uintptr_t stack_pointer(const Registers &regs)
+{
+    return regs.gp.sp;
+}
+
+uint64_t return_value(const Registers &regs)
+{
+    return regs.gp.regs[0];
+}
+
+// AAPCS64：x0-x5 传参，返回地址放在 x30
+int setup_call(RemoteProcess &, Registers &regs, uintptr_t function, const std::vector<uint64_t> &args, uintptr_t sp)
+{
+    for (size_t i = 0; i < args.size(); ++i) {
+        regs.gp.regs[i] = args[i];
+    }
+    regs.gp.regs[30] = 0;
+    regs.gp.sp = sp;
+    regs.gp.pc = function;
+    regs.syscall_no = -1;
+    return 0;
+}
+#endif
+
+} // namespace
+
+RemoteProcess::~RemoteProcess()
+{
+    detach();
+    if (m_mem_fd >= 0) {
+        close(m_mem_fd);
+    }
+}
+
+int RemoteProcess::stop_thread(pid_t tid, Thread &thread)
+{
+    if (ptrace(PTRACE_SEIZE, tid, nullptr, nullptr) != 0) {
+        return errno == ESRCH ? 1 : -1;
+    }
+    thread.tid = tid;
+    int ret = interrupt_thread(thread);
+    return ret < 0 && errno == ECHILD ? 1 : ret;
+}
+
+int RemoteProcess::interrupt_thread(Thread &thread)
+{
+    ptrace(PTRACE_INTERRUPT, thread.tid, nullptr, nullptr);
+    while (true) {
+        int status = 0;
+        if (waitpid(thread.tid, &status, __WALL) < 0) {
+            return -1;
+        }
+        if (WIFEXITED(status) || WIFSIGNALED(status)) {
+            return 1;
+        }
+        if (WIFSTOPPED(status)) {
+            // 线程可能先停在信号投递上，记录信号并在 detach 时补发
+            if ((status >> 16) != PTRACE_EVENT_STOP && thread.pending_signal == 0) {
+                thread.pending_signal = WSTOPSIG(status);
+            }
+            return 0;
+        }
+    }
+}
+
+void RemoteProcess::resume_others(pid_t caller)
+{
+    for (const auto &thread : m_threads) {
+        if (thread.tid != caller) {
+            ptrace(PTRACE_CONT, thread.tid, nullptr, nullptr);
+        }
+    }
+}
+
+// 远程调用期间其他线程收到的信号直接投递，避免持锁线程停在信号投递上
+void RemoteProcess::forward_signals(pid_t caller)
+{
+    for (auto it = m_threads.begin(); it != m_threads.end();) {
+        int status = 0;
+        pid_t ret = it->tid == caller ? 0 : waitpid(it->tid, &status, __WALL | WNOHANG);
+        if (ret < 0 || (ret > 0 && (WIFEXITED(status) || WIFSIGNALED(status)))) {
+            it = m_threads.erase(it);
+            continue;
+        }
+        if (ret > 0 && WIFSTOPPED(status)) {
+            int signal = WSTOPSIG(status);
+            if ((status >> 16) == PTRACE_EVENT_STOP || signal == SIGSTOP || signal == SIGTRAP) {
+                signal = 0;
+            }
+            ptrace(PTRACE_CONT, it->tid, nullptr, reinterpret_cast<void *>(static_cast<intptr_t>(signal)));
+        }
+        ++it;
+    }
+}
+
+void RemoteProcess::stop_others(pid_t caller)
+{
+    for (auto it = m_threads.begin(); it != m_threads.end();) {
+        if (it->tid != caller && interrupt_thread(*it) != 0) {
+            it = m_threads.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+int RemoteProcess::attach()
+{
+#if !defined(__x86_64__) && !defined(__aarch64__)
+    std::cerr << "Remote patching is not supported on this architecture" << std::endl;
+    return -1;
+#else
+    if (attached()) {
+        return 0;
+    }
+
+    TraceSpan span("attach", "ptrace", m_pid);
+    std::set<pid_t> seen;
+    std::string task_dir = "/proc/" + std::to_string(m_pid) + "/task";
+    for (int round = 0; round < max_attach_rounds; ++round) {
+        DIR *dir = opendir(task_dir.c_str());
+        if (!dir) {
+            std::cerr << "Failed to open " << task_dir << ": " << strerror(errno) << std::endl;
+            detach();
+            return -1;
+        }
+        std::vector<pid_t> tids;
+        while (dirent *entry = readdir(dir)) {
+            pid_t tid = static_cast<pid_t>(std::strtol(entry->d_name, nullptr, 10));
+            if (tid > 0 && seen.insert(tid).second) {
+                tids.push_back(tid);
+            }
+        }
+        closedir(dir);
+        if (tids.empty()) {
+            break;
+        }
+
+        for (pid_t tid : tids) {
+            Thread thread;
+            int ret = stop_thread(tid, thread);
+            if (ret < 0) {
+                std::cerr << "Failed to attach thread " << tid << ": " << strerror(errno) << std::endl;
+                detach();
+                return -1;
+            }
+            if (ret == 0) {
+                m_threads.push_back(thread);
+            }
+        }
+    }
+
+    if (m_threads.empty()) {
+        std::cerr << "Process " << m_pid << " has no live threads" << std::endl;
+        return -1;
+    }
+    span.end();
+    m_stopped_since = PhaseTracer::instance().enabled() ? PhaseTracer::now_ns() : 0;
+    return 0;
+#endif
+}
+
+void RemoteProcess::detach()
+{
+    if (m_threads.empty()) {
+        return;
+    }
+    {
+        TraceSpan span("detach", "ptrace", m_pid);
+        for (const auto &thread : m_threads) {
+            ptrace(PTRACE_DETACH, thread.tid, nullptr,
+                   reinterpret_cast<void *>(static_cast<intptr_t>(thread.pending_signal)));
+        }
+        m_threads.clear();
+    }
+
+    // 从全部线程暂停到全部恢复，即目标进程实际停顿的时间
+    if (m_stopped_since) {
+        PhaseTracer::instance().record("stopped", "ptrace", m_stopped_since, m_pid);
+        m_stopped_since = 0;
+    }
+}
+
+int RemoteProcess::open_mem()
+{
+    if (m_mem_fd < 0) {
+        std::string path = "/proc/" + std::to_string(m_pid) + "/mem";
+        m_mem_fd = open(path.c_str(), O_RDWR | O_CLOEXEC);
+        if (m_mem_fd < 0) {
+            std::cerr << "Failed to open " << path << ": " << strerror(errno) << std::endl;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int RemoteProcess::read_memory(uintptr_t address, void *buffer, size_t size)
+{
+    iovec local{ buffer, size };
+    iovec remote{ reinterpret_cast<void *>(address), size };
+    if (process_vm_readv(m_pid, &local, 1, &remote, 1, 0) == static_cast<ssize_t>(size)) {
+        return 0;
+    }
+
+    // 不可读的页（如 --x 映射）回退到 /proc/<pid>/mem
+    if (open_mem() != 0 ||
+        pread(m_mem_fd, buffer, size, static_cast<off_t>(address)) != static_cast<ssize_t>(size)) {
+        return -1;
+    }
+    return 0;
+}
+
+int RemoteProcess::write_memory(uintptr_t address, const void *data, size_t size)
+{
+    TraceSpan span("memory_write", "ptrace", m_pid);
+    if (open_mem() != 0) {
+        return -1;
+    }
+    const auto *ptr = static_cast<const uint8_t *>(data);
+    while (size > 0) {
+        ssize_t n = pwrite(m_mem_fd, ptr, size, static_cast<off_t>(address));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            std::cerr << "Failed to write process " << m_pid << " memory at 0x" << std::hex << address << std::dec
+                      << ": " << strerror(errno) << std::endl;
+            return -1;
+        }
+        ptr += n;
+        address += static_cast<size_t>(n);
+        size -= static_cast<size_t>(n);
+    }
+    return 0;
+}
+
+RemoteProcess::Thread *RemoteProcess::pick_call_thread()
+{
+    for (auto &thread : m_threads) {
+        std::ifstream file("/proc/" + std::to_string(m_pid) + "/task/" + std::to_string(thread.tid) + "/syscall");
+        long number = -1;
+        if (file >> number && number >= 0) {
+            return &thread;
+        }
+    }
+    auto it = std::find_if(m_threads.begin(), m_threads.end(), [this](const Thread &t) { return t.tid == m_pid; });
+    return it != m_threads.end() ? &*it : (m_threads.empty() ? nullptr : &m_threads.front());
+}
+
+int RemoteProcess::call_function(const RemoteCall &call, uint64_t &result)
+{
+#if !defined(__x86_64__) && !defined(__aarch64__)
+    (void)call;
+    (void)result;
+    return -1;
+#else
+    Thread *thread = pick_call_thread();
+    if (!thread || call.args.size() > 6 || (!call.stack_data.empty() && call.args.empty())) {
+        return -1;
+    }
+
+    Registers saved{};
+    if (get_registers(thread->tid, saved) != 0) {
+        std::cerr << "Failed to read registers of thread " << thread->tid << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    std::vector<uint64_t> args = call.args;
+    uintptr_t sp = (stack_pointer(saved) - stack_reserve) & ~static_cast<uintptr_t>(0xF);
+    if (!call.stack_data.empty()) {
+        sp = (sp - call.stack_data.size() - 1) & ~static_cast<uintptr_t>(0xF);
+        if (write_memory(sp, call.stack_data.c_str(), call.stack_data.size() + 1) != 0) {
+            return -1;
+        }
+        args[0] = sp;
+    }
+
+    Registers regs = saved;
+    const pid_t tid = thread->tid;
+    if (setup_call(*this, regs, call.function, args, sp) != 0 || set_registers(tid, regs) != 0) {
+        return -1;
+    }
+    if (call.run_others) {
+        resume_others(tid);
+    }
+
+    int ret = -1;
+    int signal = 0;
+    bool lost = false;
+    bool running = false;
+    useconds_t delay = min_call_poll_us;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(remote_call_timeout_ms);
+    while (true) {
+        int status = 0;
+        void *deliver = reinterpret_cast<void *>(static_cast<intptr_t>(signal));
+        if (!running && ptrace(PTRACE_CONT, tid, nullptr, deliver) != 0) {
+            std::cerr << "Lost thread " << tid << " during remote call: " << strerror(errno) << std::endl;
+            lost = true;
+            break;
+        }
+        running = true;
+        pid_t waited = waitpid(tid, &status, __WALL | WNOHANG);
+        if (waited < 0) {
+            std::cerr << "Lost thread " << tid << " during remote call: " << strerror(errno) << std::endl;
+            lost = true;
+            break;
+        }
+        if (waited == 0) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                // 被调函数可能在等待永远不会释放的锁：中断调用线程，随后恢复其寄存器
+                std::cerr << "Remote call in thread " << tid << " did not return within " << remote_call_timeout_ms
+                          << " ms" << std::endl;
+                auto it = std::find_if(m_threads.begin(), m_threads.end(),
+                                       [tid](const Thread &t) { return t.tid == tid; });
+                lost = interrupt_thread(*it) != 0;
+                break;
+            }
+            if (call.run_others) {
+                forward_signals(tid);
+            }
+            usleep(delay);
+            delay = std::min(delay * 2, max_call_poll_us);
+            continue;
+        }
+        running = false;
+        if (WIFEXITED(status) || WIFSIGNALED(status)) {
+            std::cerr << "Thread " << tid << " exited during remote call" << std::endl;
+            lost = true;
+            break;
+        }
+        if (!WIFSTOPPED(status)) {
+            running = true;
+            continue;
+        }
+        signal = WSTOPSIG(status);
+        if ((status >> 16) == PTRACE_EVENT_STOP || signal == SIGSTOP || signal == SIGTRAP) {
+            signal = 0;
+            continue;
+        }
+        if (signal == SIGSEGV) {
+            // 返回到地址 0 表示调用完成，其他位置的 SIGSEGV 是被调函数崩溃
+            Registers after{};
+            if (get_registers(tid, after) == 0 && program_counter(after) == 0) {
+                result = return_value(after);
+                ret = 0;
+            } else {
+                std::cerr << "Remote call faulted at 0x" << std::hex << program_counter(after) << std::dec << std::endl;
+            }
+            break;
+        }
+        // 其他信号照常投递给目标线程
+    }
+
+    if (call.run_others) {
+        stop_others(tid);
+    }
+    if (lost) {
+        m_threads.erase(std::remove_if(m_threads.begin(), m_threads.end(),
+                                       [tid](const Thread &t) { return t.tid == tid; }),
+                        m_threads.end());
+        return -1;
+    }
+    if (set_registers(tid, saved) != 0) {
+        std::cerr << "Failed to restore registers of thread " << tid << std::endl;
+        return -1;
+    }
+    return ret;
+#endif
+}
+
+int RemoteProcess::move_threads_out_of(uintptr_t begin, uintptr_t end)
+{
+#if !defined(__x86_64__) && !defined(__aarch64__)
+    (void)begin;
+    (void)end;
+    return -1;
+#else
+    for (auto &thread : m_threads) {
+        for (int step = 0;; ++step) {
+            Registers regs{};
+            if (get_registers(thread.tid, regs) != 0) {
+                return -1;
+            }
+            uintptr_t pc = program_counter(regs);
+            if (pc <= begin || pc >= end) {
+                break;
+            }
+            int status = 0;
+            if (step == max_single_steps || ptrace(PTRACE_SINGLESTEP, thread.tid, nullptr, nullptr) != 0 ||
+                waitpid(thread.tid, &status, __WALL) < 0 || !WIFSTOPPED(status)) {
+                std::cerr << "Thread " << thread.tid << " is stuck inside the patched range" << std::endl;
+                return -1;
+            }
+            if (WSTOPSIG(status) != SIGTRAP && (status >> 16) != PTRACE_EVENT_STOP && thread.pending_signal == 0) {
+                thread.pending_signal = WSTOPSIG(status);
+            }
+        }
+    }
+    return 0;
+#endif
+}
+
+}; // namespace RemoteDebug
@@ -0,0 +1,99 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 通过 ptrace 控制目标进程：暂停全部线程、读写内存、在目标线程上下文中调用函数
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace RemoteDebug {
+
+constexpr int remote_call_timeout_ms = 5000; // 远程调用超过此时间未返回则中断调用线程并放弃
+
+/**
+ * @brief 在目标进程中调用的函数及其参数
+ * @details stack_data 非空时先复制到目标线程栈上（以 '\0' 结尾），其地址替换 args[0]，
+ *          用于传递 dlopen 的路径等字符串参数。
+ *          run_others 为 true 时调用期间恢复其他线程：dlopen 等函数需要的 malloc 锁、dl_load_lock
+ *          可能正被某个暂停的线程持有，其他线程保持暂停会使调用永远无法返回
+ */
+struct RemoteCall {
+    uintptr_t             function{ 0 };
+    std::vector<uint64_t> args;        // 最多 6 个整数参数
+    std::string           stack_data;
+    bool                  run_others{ false };
+};
+
+/**
+ * @brief 目标进程句柄
+ * @details 内存读写不要求暂停进程：读使用 process_vm_readv，写通过 /proc/<pid>/mem，
+ *          可以直接写入只读的代码段。修改代码或调用函数前需 attach 暂停全部线程，
+ *          使用 PTRACE_SEIZE + PTRACE_INTERRUPT，不会像 PTRACE_ATTACH 一样给目标发送 SIGSTOP
+ */
+class RemoteProcess {
+public:
+    explicit RemoteProcess(pid_t pid) : m_pid(pid) {}
+    ~RemoteProcess();
+    RemoteProcess(const RemoteProcess &) = delete;
+    RemoteProcess &operator=(const RemoteProcess &) = delete;
+
+    pid_t pid() const { return m_pid; }
+    bool attached() const { return !m_threads.empty(); }
+
+    /**
+     * @brief 暂停目标进程的全部线程，期间新建的线程同样会被暂停
+     * @return 成功返回0，失败返回-1（已暂停的线程会被恢复）
+     */
+    int attach();
+
+    /**
+     * @brief 恢复全部线程，暂停期间截获的信号重新投递给原线程
+     */
+    void detach();
+
+    int read_memory(uintptr_t address, void *buffer, size_t size);
+    int write_memory(uintptr_t address, const void *data, size_t size);
+
+    /**
+     * @brief 在某个已暂停线程的上下文中调用函数，返回后恢复该线程的寄存器
+     * @details 优先选择阻塞在系统调用中的线程，减少打断持锁代码的可能。
+     *          返回地址设为 0，函数返回时触发 SIGSEGV 由 ptrace 截获。
+     *          remote_call_timeout_ms 内未返回时中断调用线程并恢复其寄存器，
+     *          被调函数已获取的锁无法释放，调用方应放弃对该进程的后续调用
+     * @param[in] call 调用的函数与参数
+     * @param[out] result 函数返回值
+     * @return 成功返回0，失败或超时返回-1，返回时全部线程处于暂停状态
+     */
+    int call_function(const RemoteCall &call, uint64_t &result);
+
+    /**
+     * @brief 确保没有线程的 PC 位于 (begin, end) 内，即将被改写的指令中间
+     * @details 位于区间内的线程单步执行直至离开；begin 本身是指令边界，不需要处理
+     * @return 成功返回0，失败返回-1
+     */
+    int move_threads_out_of(uintptr_t begin, uintptr_t end);
+
+private:
+    struct Thread {
+        pid_t tid{ 0 };
+        int   pending_signal{ 0 }; // 暂停时截获的信号，detach 时重新投递
+    };
+
+    int stop_thread(pid_t tid, Thread &thread);
+    int interrupt_thread(Thread &thread);
+    void resume_others(pid_t caller);
+    void forward_signals(pid_t caller);
+    void stop_others(pid_t caller);
+    int open_mem();
+    Thread *pick_call_thread();
+
+    pid_t               m_pid;
+    int                 m_mem_fd{ -1 };
+    std::vector<Thread> m_threads;
+    uint64_t            m_stopped_since{ 0 }; // 追踪开启时记录全部线程暂停的时刻
+};
+
+}; // namespace RemoteDebug
@@ -0,0 +1,747 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "symbol_index.h"
+
+#include "process_maps.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <iostream>
+#include <sstream>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RemoteDebug {
+
+/**
+ * @brief 索引文件头，各偏移相对文件开头
+ * @details 名称表与还原名称表之后各跟一个 uint64_t 数组，为每组在表中的偏移
+ */
+struct SymbolIndex::Header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_size;
+    uint64_t source_mtime_ns;
+    uint64_t load_address;
+    uint64_t count;
+    uint64_t names;
+    uint64_t name_buckets;
+    uint64_t demangled;
+    uint64_t demangled_buckets;
+    uint64_t symbols;
+    uint64_t addresses;
+    uint64_t address_count;
+    uint64_t size;
+};
+
+namespace {
+
+// 符号记录，大小超过 4GB 的符号记为 UINT32_MAX
+struct SymbolRecord {
+    uint64_t value;
+    uint32_t size;
+    uint8_t  type;
+    uint8_t  bind;
+    uint16_t reserved;
+};
+
+static_assert(sizeof(SymbolRecord) == 16, "SymbolRecord is stored in the index file as is");
+
+size_t bucket_count(size_t count)
+{
+    return (count + symbol_index_bucket - 1) / symbol_index_bucket;
+}
+
+void put_varint(std::vector<uint8_t> &out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// 读取不越过 end 的 varint，越界或超过 64 位时返回 false
+bool get_varint(const uint8_t *&p, const uint8_t *end, uint64_t &value)
+{
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && p < end; shift += 7) {
+        const uint8_t byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// [offset, offset + count * unit) 位于 size 字节内，且 offset 按 unit 对齐
+bool section_fits(uint64_t offset, uint64_t count, uint64_t unit, size_t size)
+{
+    return offset % unit == 0 && offset <= size && count <= (size - offset) / unit;
+}
+
+template <typename T>
+void append(std::vector<uint8_t> &out, const T *data, size_t count)
+{
+    const auto *bytes = reinterpret_cast<const uint8_t *>(data);
+    out.insert(out.end(), bytes, bytes + count * sizeof(T));
+}
+
+void align8(std::vector<uint8_t> &out)
+{
+    out.resize((out.size() + 7) & ~static_cast<size_t>(7));
+}
+
+/**
+ * @brief 分组前缀压缩：每组第一个字符串为 varint(长度) + 字节，
+ *        其余为 varint(与前一个的共同前缀长度) + varint(后缀长度) + 后缀
+ * @return 表在 out 中的偏移；各组偏移紧随其后（8 字节对齐），位置写入 buckets_offset
+ */
+uint64_t encode_table(const std::vector<std::string> &strings, std::vector<uint8_t> &out, uint64_t &buckets_offset)
+{
+    const uint64_t table = out.size();
+    std::vector<uint64_t> buckets;
+    for (size_t i = 0; i < strings.size(); ++i) {
+        const std::string &current = strings[i];
+        if (i % symbol_index_bucket == 0) {
+            buckets.push_back(out.size() - table);
+            put_varint(out, current.size());
+            out.insert(out.end(), current.begin(), current.end());
+            continue;
+        }
+        const std::string &previous = strings[i - 1];
+        size_t shared = 0;
+        while (shared < previous.size() && shared < current.size() && previous[shared] == current[shared]) {
+            ++shared;
+        }
+        put_varint(out, shared);
+        put_varint(out, current.size() - shared);
+        out.insert(out.end(), current.begin() + static_cast<std::ptrdiff_t>(shared), current.end());
+    }
+    align8(out);
+    buckets_offset = out.size();
+    append(out, buckets.data(), buckets.size());
+    return table;
+}
+
+/**
+ * @brief 顺序解码分组前缀压缩的表，用于前缀与子串查找
+ * @details 表紧接在组偏移数组之前结束，解码越界时游标变为无效
+ */
+class TableCursor {
+public:
+    TableCursor(const uint8_t *table, const uint64_t *buckets, size_t count, size_t index)
+        : m_table(table), m_end(reinterpret_cast<const uint8_t *>(buckets)), m_buckets(buckets), m_count(count),
+          m_index(index)
+    {
+        if (m_index < m_count) {
+            const size_t first = m_index - m_index % symbol_index_bucket;
+            m_next = m_table + m_buckets[first / symbol_index_bucket];
+            for (size_t i = first; i <= m_index && valid(); ++i) {
+                read(i);
+            }
+        }
+    }
+
+    bool valid() const { return m_index < m_count; }
+    size_t index() const { return m_index; }
+    const std::string &value() const { return m_value; }
+
+    void next()
+    {
+        if (++m_index < m_count) {
+            read(m_index);
+        }
+    }
+
+private:
+    void read(size_t i)
+    {
+        uint64_t shared = 0;
+        uint64_t length = 0;
+        if (i % symbol_index_bucket == 0) {
+            m_next = m_table + m_buckets[i / symbol_index_bucket];
+        } else if (!get_varint(m_next, m_end, shared) || shared > m_value.size()) {
+            m_index = m_count;
+            return;
+        }
+        if (!get_varint(m_next, m_end, length) || length > static_cast<uint64_t>(m_end - m_next)) {
+            m_index = m_count;
+            return;
+        }
+        m_value.resize(shared);
+        m_value.append(reinterpret_cast<const char *>(m_next), length);
+        m_next += length;
+    }
+
+    const uint8_t  *m_table;
+    const uint8_t  *m_end;
+    const uint64_t *m_buckets;
+    size_t          m_count;
+    size_t          m_index;
+    const uint8_t  *m_next{ nullptr };
+    std::string     m_value;
+};
+
+// 地址表中的符号：有大小的在前，同一地址全局符号在前
+bool address_order(const IndexEntry &a, const IndexEntry &b)
+{
+    auto rank = [](const ElfSymbol &symbol) { return (symbol.size == 0) * 2 + (symbol.bind == STB_LOCAL); };
+    if (a.symbol.value != b.symbol.value) {
+        return a.symbol.value < b.symbol.value;
+    }
+    return rank(a.symbol) < rank(b.symbol);
+}
+
+int collect_symbols(const std::string &elf_path, std::vector<IndexEntry> &entries, uint64_t &load_address)
+{
+    return read_elf_symbols(
+            elf_path, [&entries](const char *name, const ElfSymbol &symbol) { entries.push_back({ name, symbol }); },
+            load_address);
+}
+
+// 逐级创建目录，已存在时成功
+int make_directories(const std::string &path)
+{
+    for (size_t slash = path.find('/', 1);; slash = path.find('/', slash + 1)) {
+        const std::string prefix = path.substr(0, slash);
+        if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+            return -1;
+        }
+        if (slash == std::string::npos) {
+            return 0;
+        }
+    }
+}
+
+int write_file(const std::string &path, const std::vector<uint8_t> &image)
+{
+    const std::string temporary = path + ".tmp." + std::to_string(getpid());
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    size_t written = 0;
+    while (written < image.size()) {
+        const ssize_t n = write(fd, image.data() + written, image.size() - written);
+        if (n <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(n);
+    }
+    const bool ok = written == image.size() && ::close(fd) == 0;
+    if (!ok || rename(temporary.c_str(), path.c_str()) != 0) {
+        if (!ok && fd >= 0) {
+            ::close(fd);
+        }
+        unlink(temporary.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+} // namespace
+
+std::vector<uint8_t> encode_symbol_index(std::vector<IndexEntry> entries, uint64_t load_address,
+        const IndexStamp &stamp)
+{
+    // 同名符号保留全局符号，其次最先出现的
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const IndexEntry &a, const IndexEntry &b) { return a.name < b.name; });
+    std::vector<IndexEntry> unique;
+    unique.reserve(entries.size());
+    for (auto &entry : entries) {
+        if (!unique.empty() && unique.back().name == entry.name) {
+            if (unique.back().symbol.bind == STB_LOCAL && entry.symbol.bind != STB_LOCAL) {
+                unique.back().symbol = entry.symbol;
+            }
+            continue;
+        }
+        unique.push_back(std::move(entry));
+    }
+    entries.clear();
+    entries.shrink_to_fit();
+
+    SymbolIndex::Header header{};
+    header.magic = symbol_index_magic;
+    header.version = symbol_index_version;
+    header.source_size = stamp.size;
+    header.source_mtime_ns = stamp.mtime_ns;
+    header.load_address = load_address;
+    header.count = unique.size();
+
+    std::vector<uint8_t> out(sizeof(header));
+    std::vector<std::string> strings;
+    strings.reserve(unique.size());
+    for (const auto &entry : unique) {
+        strings.push_back(entry.name);
+    }
+    header.names = encode_table(strings, out, header.name_buckets);
+
+    // 复用同一个缓冲区还原名称，__cxa_demangle 按需扩大
+    size_t length = 256;
+    char *buffer = static_cast<char *>(std::malloc(length));
+    for (size_t i = 0; i < unique.size(); ++i) {
+        const std::string &name = unique[i].name;
+        int status = -1;
+        char *result = name.compare(0, 2, "_Z") == 0 ? abi::__cxa_demangle(name.c_str(), buffer, &length, &status)
+                                                     : nullptr;
+        if (status == 0 && result) {
+            buffer = result;
+            strings[i] = result;
+        } else {
+            strings[i] = name;
+        }
+    }
+    std::free(buffer);
+    header.demangled = encode_table(strings, out, header.demangled_buckets);
+    strings.clear();
+    strings.shrink_to_fit();
+
+    align8(out);
+    header.symbols = out.size();
+    for (const auto &entry : unique) {
+        const SymbolRecord record{ entry.symbol.value,
+                                   static_cast<uint32_t>(std::min<uint64_t>(entry.symbol.size, UINT32_MAX)),
+                                   entry.symbol.type, entry.symbol.bind, 0 };
+        append(out, &record, 1);
+    }
+
+    std::vector<size_t> order;
+    for (size_t i = 0; i < unique.size(); ++i) {
+        const uint8_t type = unique[i].symbol.type;
+        if ((type == STT_FUNC || type == STT_OBJECT || type == STT_GNU_IFUNC) && unique[i].symbol.value != 0) {
+            order.push_back(i);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&unique](size_t a, size_t b) { return address_order(unique[a], unique[b]); });
+    header.addresses = out.size();
+    header.address_count = order.size();
+    for (size_t i : order) {
+        const auto address = static_cast<uint32_t>(i);
+        append(out, &address, 1);
+    }
+
+    header.size = out.size();
+    memcpy(out.data(), &header, sizeof(header));
+    return out;
+}
+
+SymbolIndex::~SymbolIndex()
+{
+    close();
+}
+
+void SymbolIndex::close()
+{
+    if (m_mapped) {
+        munmap(const_cast<uint8_t *>(m_data), m_size);
+    }
+    m_memory.clear();
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+}
+
+IndexStamp SymbolIndex::stamp_of(const std::string &path)
+{
+    struct stat st{};
+    if (stat(path.c_str(), &st) != 0) {
+        return {};
+    }
+    return { static_cast<uint64_t>(st.st_size),
+             static_cast<uint64_t>(st.st_mtim.tv_sec) * 1000000000ull + static_cast<uint64_t>(st.st_mtim.tv_nsec) };
+}
+
+int SymbolIndex::build(const std::string &elf_path, const std::string &index_path)
+{
+    const IndexStamp stamp = stamp_of(elf_path);
+    std::vector<IndexEntry> entries;
+    uint64_t load_address = 0;
+    if (collect_symbols(elf_path, entries, load_address) != 0) {
+        return -1;
+    }
+    if (write_file(index_path, encode_symbol_index(std::move(entries), load_address, stamp)) != 0) {
+        std::cerr << "Failed to write " << index_path << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+int SymbolIndex::open(const std::string &index_path, const IndexStamp &expected)
+{
+    close();
+    int fd = ::open(index_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        ::close(fd);
+        return -1;
+    }
+    void *mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return -1;
+    }
+    // 查找只访问少量页，关闭预读
+    madvise(mapped, static_cast<size_t>(st.st_size), MADV_RANDOM);
+    m_data = static_cast<const uint8_t *>(mapped);
+    m_size = static_cast<size_t>(st.st_size);
+    m_mapped = true;
+
+    const Header *h = header();
+    if (IndexStamp{ h->source_size, h->source_mtime_ns } != expected || !validate()) {
+        close();
+        return -1;
+    }
+    return 0;
+}
+
+int SymbolIndex::assign(std::vector<uint8_t> image)
+{
+    close();
+    if (image.size() < sizeof(Header)) {
+        return -1;
+    }
+    m_memory = std::move(image);
+    m_data = m_memory.data();
+    m_size = m_memory.size();
+    if (!validate()) {
+        close();
+        return -1;
+    }
+    return 0;
+}
+
+bool SymbolIndex::validate() const
+{
+    const Header *h = header();
+    if (h->magic != symbol_index_magic || h->version != symbol_index_version || h->size != m_size ||
+        h->count > UINT32_MAX || !section_fits(h->symbols, h->count, sizeof(SymbolRecord), m_size) ||
+        !section_fits(h->addresses, h->address_count, sizeof(uint32_t), m_size)) {
+        return false;
+    }
+    // 每个组偏移须落在所属的表内，表在组偏移数组之前结束
+    const uint64_t buckets = bucket_count(h->count);
+    for (auto table : { std::make_pair(h->names, h->name_buckets),
+                        std::make_pair(h->demangled, h->demangled_buckets) }) {
+        if (table.first > table.second || !section_fits(table.second, buckets, sizeof(uint64_t), m_size)) {
+            return false;
+        }
+        const auto *offsets = reinterpret_cast<const uint64_t *>(m_data + table.second);
+        for (uint64_t i = 0; i < buckets; ++i) {
+            if (offsets[i] >= table.second - table.first) {
+                return false;
+            }
+        }
+    }
+    const auto *addresses = reinterpret_cast<const uint32_t *>(m_data + h->addresses);
+    for (uint64_t i = 0; i < h->address_count; ++i) {
+        if (addresses[i] >= h->count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string SymbolIndex::cache_path_for(const std::string &elf_path)
+{
+    std::string directory;
+    if (const char *dir = getenv("REMOTEDEBUG_CACHE_DIR")) {
+        directory = dir;
+    } else if (const char *xdg = getenv("XDG_CACHE_HOME")) {
+        directory = std::string(xdg) + "/remotedebug";
+    } else if (const char *home = getenv("HOME")) {
+        directory = std::string(home) + "/.cache/remotedebug";
+    }
+    if (directory.empty() || directory[0] != '/') {
+        return {};
+    }
+    std::string name = elf_path;
+    std::replace(name.begin(), name.end(), '/', '%');
+    return directory + "/" + name + symbol_index_suffix;
+}
+
+int SymbolIndex::open_for(const std::string &elf_path)
+{
+    const IndexStamp stamp = stamp_of(elf_path);
+    if (stamp.size == 0) {
+        std::cerr << "Failed to stat " << elf_path << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+    const std::string cache_path = cache_path_for(elf_path);
+    if (open(path_for(elf_path), stamp) == 0 || (!cache_path.empty() && open(cache_path, stamp) == 0)) {
+        return 0;
+    }
+
+    std::vector<IndexEntry> entries;
+    uint64_t load_address = 0;
+    if (collect_symbols(elf_path, entries, load_address) != 0) {
+        return -1;
+    }
+    std::vector<uint8_t> image = encode_symbol_index(std::move(entries), load_address, stamp);
+    if (!cache_path.empty() && make_directories(cache_path.substr(0, cache_path.rfind('/'))) == 0 &&
+        write_file(cache_path, image) == 0 && open(cache_path, stamp) == 0) {
+        return 0;
+    }
+    return assign(std::move(image));
+}
+
+size_t SymbolIndex::size() const
+{
+    return m_data ? header()->count : 0;
+}
+
+uint64_t SymbolIndex::load_address() const
+{
+    return m_data ? header()->load_address : 0;
+}
+
+std::string SymbolIndex::decode(uint64_t table, uint64_t buckets, size_t index) const
+{
+    TableCursor cursor(m_data + table, reinterpret_cast<const uint64_t *>(m_data + buckets), size(), index);
+    return cursor.valid() ? cursor.value() : std::string();
+}
+
+std::string SymbolIndex::name(size_t index) const
+{
+    return decode(header()->names, header()->name_buckets, index);
+}
+
+std::string SymbolIndex::demangled(size_t index) const
+{
+    return decode(header()->demangled, header()->demangled_buckets, index);
+}
+
+ElfSymbol SymbolIndex::symbol(size_t index) const
+{
+    const SymbolRecord &record = reinterpret_cast<const SymbolRecord *>(m_data + header()->symbols)[index];
+    ElfSymbol symbol;
+    symbol.value = record.value;
+    symbol.size = record.size;
+    symbol.type = record.type;
+    symbol.bind = record.bind;
+    return symbol;
+}
+
+size_t SymbolIndex::lower_bound(const std::string &key) const
+{
+    const size_t count = size();
+    if (count == 0) {
+        return 0;
+    }
+    const uint8_t *table = m_data + header()->names;
+    const auto *buckets = reinterpret_cast<const uint64_t *>(m_data + header()->name_buckets);
+    const auto *table_end = reinterpret_cast<const uint8_t *>(buckets);
+    auto head = [&](size_t bucket) {
+        const uint8_t *p = table + buckets[bucket];
+        uint64_t length = 0;
+        if (!get_varint(p, table_end, length) || length > static_cast<uint64_t>(table_end - p)) {
+            return std::string_view(); // 损坏的组首，查找结果无意义但不越界
+        }
+        return std::string_view(reinterpret_cast<const char *>(p), length);
+    };
+
+    // 第一个组首大于 key 的组，key 位于其前一组中
+    size_t low = 0;
+    size_t high = bucket_count(count);
+    while (low < high) {
+        const size_t middle = (low + high) / 2;
+        if (head(middle) <= key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low == 0) {
+        return 0;
+    }
+    const size_t end = std::min(count, low * symbol_index_bucket);
+    for (TableCursor cursor(table, buckets, count, (low - 1) * symbol_index_bucket); cursor.index() < end;
+         cursor.next()) {
+        if (cursor.value() >= key) {
+            return cursor.index();
+        }
+    }
+    return end;
+}
+
+ssize_t SymbolIndex::find(const std::string &name) const
+{
+    const size_t index = lower_bound(name);
+    return index < size() && this->name(index) == name ? static_cast<ssize_t>(index) : -1;
+}
+
+std::vector<size_t> SymbolIndex::find_prefix(const std::string &prefix, size_t limit) const
+{
+    std::vector<size_t> result;
+    if (!m_data) {
+        return result;
+    }
+    TableCursor cursor(m_data + header()->names, reinterpret_cast<const uint64_t *>(m_data + header()->name_buckets),
+                       size(), lower_bound(prefix));
+    for (; cursor.valid() && result.size() < limit && cursor.value().compare(0, prefix.size(), prefix) == 0;
+         cursor.next()) {
+        result.push_back(cursor.index());
+    }
+    return result;
+}
+
+std::vector<size_t> SymbolIndex::find_fuzzy(const std::string &text, size_t limit) const
+{
+    std::vector<size_t> result;
+    if (!m_data) {
+        return result;
+    }
+    TableCursor cursor(m_data + header()->demangled,
+                       reinterpret_cast<const uint64_t *>(m_data + header()->demangled_buckets), size(), 0);
+    for (; cursor.valid() && result.size() < limit; cursor.next()) {
+        if (cursor.value().find(text) != std::string::npos) {
+            result.push_back(cursor.index());
+        }
+    }
+    return result;
+}
+
+ssize_t SymbolIndex::find_address(uint64_t address, uint64_t &offset) const
+{
+    if (!m_data) {
+        return -1;
+    }
+    const auto *records = reinterpret_cast<const SymbolRecord *>(m_data + header()->symbols);
+    const auto *begin = reinterpret_cast<const uint32_t *>(m_data + header()->addresses);
+    const auto *end = begin + header()->address_count;
+    const auto *it = std::upper_bound(begin, end, address,
+                                      [records](uint64_t value, uint32_t i) { return value < records[i].value; });
+    if (it == begin) {
+        return -1;
+    }
+    // 同一地址的多个符号中取排在最前的
+    const uint64_t value = records[*(it - 1)].value;
+    it = std::lower_bound(begin, it, value, [records](uint32_t i, uint64_t v) { return records[i].value < v; });
+    offset = address - value;
+    if (offset != 0 && offset >= records[*it].size) {
+        return -1;
+    }
+    return static_cast<ssize_t>(*it);
+}
+
+int select_symbol(const SymbolIndex &index, const std::string &query, std::string &name,
+        std::vector<std::string> &candidates, size_t limit)
+{
+    candidates.clear();
+    if (index.find(query) >= 0) {
+        name = query;
+        return 0;
+    }
+    const std::vector<size_t> prefixed = index.find_prefix(query, limit + 1);
+    if (prefixed.size() == 1) {
+        name = index.name(prefixed[0]);
+        return 0;
+    }
+
+    // 子串匹配过多时不再区分，按候选列表提示
+    constexpr size_t fuzzy_limit = 1000;
+    const std::vector<size_t> matched = index.find_fuzzy(query, fuzzy_limit);
+    std::vector<size_t> whole;
+    for (size_t i : matched) {
+        const std::string text = index.demangled(i);
+        if (text.compare(0, query.size(), query) == 0 && (text.size() == query.size() || text[query.size()] == '(')) {
+            whole.push_back(i);
+        }
+    }
+    if (matched.size() == 1 || whole.size() == 1) {
+        name = index.name(matched.size() == 1 ? matched[0] : whole[0]);
+        return 0;
+    }
+    for (size_t i : matched.empty() ? prefixed : matched) {
+        if (candidates.size() == limit) {
+            break;
+        }
+        candidates.push_back(index.demangled(i));
+    }
+    return -1;
+}
+
+ProcessSymbolizer::ProcessSymbolizer(pid_t pid)
+{
+    std::vector<MapEntry> entries;
+    if (read_process_maps(pid, entries) != 0) {
+        return;
+    }
+    for (const auto &module : collect_modules(entries)) {
+        Module entry;
+        entry.path = module.path;
+        entry.base = module.base;
+        entry.end = module.end;
+        m_modules.push_back(std::move(entry));
+    }
+}
+
+std::string ProcessSymbolizer::describe(uintptr_t address)
+{
+    auto module = std::find_if(m_modules.begin(), m_modules.end(),
+                               [address](const Module &m) { return address >= m.base && address < m.end; });
+    if (module == m_modules.end()) {
+        return {};
+    }
+    if (!module->opened) {
+        module->opened = true;
+        module->index = std::make_unique<SymbolIndex>();
+        if (module->index->open_for(module->path) != 0) {
+            module->index.reset();
+        }
+    }
+    if (!module->index) {
+        return {};
+    }
+
+    const uintptr_t bias = module->base - module->index->load_address();
+    uint64_t offset = 0;
+    const ssize_t index = module->index->find_address(address - bias, offset);
+    if (index < 0) {
+        return {};
+    }
+    std::ostringstream oss;
+    oss << module->index->demangled(static_cast<size_t>(index)) << "+0x" << std::hex << offset;
+    return oss.str();
+}
+
+std::string ProcessSymbolizer::annotate(const std::string &text)
+{
+    std::string result;
+    for (size_t i = 0; i < text.size();) {
+        size_t end = i;
+        if (text.compare(i, 2, "0x") == 0 && (i == 0 || !isalnum(static_cast<unsigned char>(text[i - 1])))) {
+            end = i + 2;
+            while (end < text.size() && isxdigit(static_cast<unsigned char>(text[end]))) {
+                ++end;
+            }
+        }
+        if (end <= i + 2) {
+            result += text[i++];
+            continue;
+        }
+        result.append(text, i, end - i);
+        const std::string symbol = describe(std::strtoull(text.c_str() + i, nullptr, 16));
+        if (!symbol.empty()) {
+            result += "(" + symbol + ")";
+        }
+        i = end;
+    }
+    return result;
+}
+
+}; // namespace RemoteDebug
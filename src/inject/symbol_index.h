@@ -0,0 +1,188 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 紧凑符号索引：由 ELF 符号表生成、保存在缓存目录（或显式保存在可执行文件旁）并按需 mmap，
+// 支持精确、前缀、还原名称子串与地址查找
+
+#pragma once
+
+#include "elf_symbols.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace RemoteDebug {
+
+constexpr uint32_t    symbol_index_magic = 0x49534452; // "RDSI"
+constexpr uint32_t    symbol_index_version = 1;
+constexpr size_t      symbol_index_bucket = 16;        // 前缀压缩的分组大小，每组第一个名称完整保存
+constexpr const char *symbol_index_suffix = ".rdsym";
+
+// 生成索引使用的一个符号
+struct IndexEntry {
+    std::string name;
+    ElfSymbol   symbol;
+};
+
+// 源 ELF 文件的大小与修改时间，不一致时索引视为过期
+struct IndexStamp {
+    uint64_t size{ 0 };
+    uint64_t mtime_ns{ 0 };
+
+    bool operator==(const IndexStamp &other) const { return size == other.size && mtime_ns == other.mtime_ns; }
+    bool operator!=(const IndexStamp &other) const { return !(*this == other); }
+};
+
+/**
+ * @brief 将符号编码为索引文件内容
+ * @details 同名符号按 ElfSymbols 的规则保留一个：优先全局符号，其次最先出现的。
+ *          文件由以下几部分组成，查找时只访问用到的页：
+ *            名称表       按字节序排序，每 symbol_index_bucket 个一组，组内其余名称只保存与前一个不同的后缀
+ *            还原名称表   与名称表一一对应的 C++ 还原名称（其他名称保存原名），同样分组压缩，供子串查找顺序扫描
+ *            符号记录     按名称顺序的 16 字节记录（地址、32 位大小、类型与绑定）
+ *            地址表       函数与数据符号按地址排序的 32 位序号，同一地址有大小的、全局的符号在前
+ */
+std::vector<uint8_t> encode_symbol_index(std::vector<IndexEntry> entries, uint64_t load_address,
+        const IndexStamp &stamp);
+
+/**
+ * @brief 只读的符号索引，序号为符号在名称表中的位置
+ * @details 索引文件 mmap 后直接查找，不展开到内存：精确与前缀查找二分各组的第一个名称后解码一组，
+ *          地址查找二分地址表，均只触及少量页；子串查找需顺序解码全部还原名称。
+ *          索引由 build 显式保存在可执行文件旁，或由 open_for 自动保存在缓存目录中
+ */
+class SymbolIndex {
+public:
+    SymbolIndex() = default;
+    ~SymbolIndex();
+    SymbolIndex(const SymbolIndex &) = delete;
+    SymbolIndex &operator=(const SymbolIndex &) = delete;
+
+    // 可执行文件旁的索引文件路径，只由 build 显式生成
+    static std::string path_for(const std::string &elf_path) { return elf_path + symbol_index_suffix; }
+
+    /**
+     * @brief 缓存目录中的索引文件路径，文件名为 ELF 绝对路径中的 '/' 替换为 '%'
+     * @details 缓存目录依次取 REMOTEDEBUG_CACHE_DIR、$XDG_CACHE_HOME/remotedebug、$HOME/.cache/remotedebug
+     * @return 没有可用的缓存目录时返回空字符串
+     */
+    static std::string cache_path_for(const std::string &elf_path);
+
+    /**
+     * @brief 读取 ELF 文件生成索引文件，先写入临时文件再改名，不会留下不完整的索引
+     * @return 成功返回0，失败返回-1
+     */
+    static int build(const std::string &elf_path, const std::string &index_path);
+
+    /**
+     * @brief 打开索引文件
+     * @param[in] expected 源文件当前的大小与修改时间，与索引记录的不同时打开失败
+     * @details 索引文件来自缓存目录，不可信：打开时检查各表范围、每个组偏移与地址表序号，
+     *          解码名称时检查 varint 不越过表尾
+     * @return 成功返回0，文件不存在、格式错误或已过期返回-1
+     */
+    int open(const std::string &index_path, const IndexStamp &expected);
+
+    /**
+     * @brief 打开 ELF 文件的索引：依次使用文件旁与缓存目录中未过期的索引，都没有时生成并写入缓存目录，
+     *        缓存目录不可用时只在内存中生成。不会在 ELF 文件所在目录写入
+     * @return 成功返回0，ELF 文件无法读取返回-1
+     */
+    int open_for(const std::string &elf_path);
+
+    // 使用内存中的索引内容，用于测试或无法写入索引文件时
+    int assign(std::vector<uint8_t> image);
+
+    size_t size() const;
+
+    // 第一个 PT_LOAD 段按页对齐的虚拟地址，与 ElfSymbols::load_address 相同
+    uint64_t load_address() const;
+
+    // 序号对应的名称与还原名称（非 C++ 名称时与名称相同）
+    std::string name(size_t index) const;
+    std::string demangled(size_t index) const;
+
+    // 序号对应的符号，index 须小于 size()
+    ElfSymbol symbol(size_t index) const;
+
+    /**
+     * @brief 按名称精确查找
+     * @return 找到返回序号，否则返回 -1
+     */
+    ssize_t find(const std::string &name) const;
+
+    // 以 prefix 开头的名称，按名称顺序至多 limit 个
+    std::vector<size_t> find_prefix(const std::string &prefix, size_t limit) const;
+
+    // 还原名称（或非 C++ 名称）包含 text 的符号，按名称顺序至多 limit 个
+    std::vector<size_t> find_fuzzy(const std::string &text, size_t limit) const;
+
+    /**
+     * @brief 查找链接地址所在的函数或数据符号
+     * @param[out] offset 地址相对符号起始的偏移
+     * @return 找到返回序号，地址不在任何符号范围内返回 -1
+     */
+    ssize_t find_address(uint64_t address, uint64_t &offset) const;
+
+    // 源文件的大小与修改时间，文件不存在时为 0
+    static IndexStamp stamp_of(const std::string &path);
+
+private:
+    struct Header;
+    friend std::vector<uint8_t> encode_symbol_index(std::vector<IndexEntry> entries, uint64_t load_address,
+            const IndexStamp &stamp);
+
+    void close();
+    bool validate() const;
+    const Header *header() const { return reinterpret_cast<const Header *>(m_data); }
+    std::string decode(uint64_t table, uint64_t buckets, size_t index) const;
+    size_t lower_bound(const std::string &key) const;
+
+    const uint8_t       *m_data{ nullptr };
+    size_t               m_size{ 0 };
+    bool                 m_mapped{ false };
+    std::vector<uint8_t> m_memory;
+};
+
+/**
+ * @brief 按名称模糊选择补丁目标，只用于调用者显式要求模糊匹配时
+ * @details 依次尝试：精确匹配；唯一的前缀匹配；还原名称包含 query 的唯一匹配，多个时还原名称去掉参数列表后
+ *          与 query 相同的唯一一个。如 "rd::Service::handle" 选中 _ZN2rd7Service6handleEi
+ * @param[out] name 选中的符号名
+ * @param[out] candidates 无法唯一确定时的候选（还原名称），至多 limit 个
+ * @return 选中返回0，没有匹配或有多个匹配返回-1
+ */
+int select_symbol(const SymbolIndex &index, const std::string &query, std::string &name,
+        std::vector<std::string> &candidates, size_t limit = 10);
+
+/**
+ * @brief 将目标进程中的运行地址解析为符号，各模块的索引在首次使用时打开
+ */
+class ProcessSymbolizer {
+public:
+    explicit ProcessSymbolizer(pid_t pid);
+
+    /**
+     * @brief 地址所在的符号与偏移，如 "rd::Service::handle(int)+0x14"
+     * @return 地址不在已知模块的符号内时返回空字符串
+     */
+    std::string describe(uintptr_t address);
+
+    // 在文本中每个 0x 开头的地址后附加 "(<符号>+<偏移>)"，无法解析的地址保持不变
+    std::string annotate(const std::string &text);
+
+private:
+    struct Module {
+        std::string                  path;
+        uintptr_t                    base{ 0 };
+        uintptr_t                    end{ 0 };
+        std::unique_ptr<SymbolIndex> index; // 首次使用时打开，打开失败时为空
+        bool                         opened{ false };
+    };
+
+    std::vector<Module> m_modules;
+};
+
+}; // namespace RemoteDebug
@@ -0,0 +1,226 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "text_image.h"
+
+#include "hash.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <elf.h>
+#include <fcntl.h>
+#include <iostream>
+#include <link.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RemoteDebug {
+
+namespace {
+
+constexpr uint64_t page_mask = ~static_cast<uint64_t>(0xFFF);
+constexpr size_t   read_chunk_size = 256 * text_block_size; // 每次从目标进程读取 1MB
+
+} // namespace
+
+int TextImage::load(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Failed to open " << path << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ElfW(Ehdr))) {
+        close(fd);
+        std::cerr << path << " is not an ELF file" << std::endl;
+        return -1;
+    }
+    size_t image_size = static_cast<size_t>(st.st_size);
+    void *mapped = mmap(nullptr, image_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Failed to map " << path << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    const auto *image = static_cast<const uint8_t *>(mapped);
+    const auto *ehdr = reinterpret_cast<const ElfW(Ehdr) *>(image);
+    int ret = -1;
+    if (memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 || ehdr->e_ident[EI_CLASS] != ELFCLASS64) {
+        std::cerr << path << " is not a 64-bit ELF file" << std::endl;
+    } else if (ehdr->e_phoff + ehdr->e_phnum * sizeof(ElfW(Phdr)) > image_size) {
+        std::cerr << path << " has truncated headers" << std::endl;
+    } else {
+        m_segments.clear();
+        bool have_load = false;
+        const auto *phdrs = reinterpret_cast<const ElfW(Phdr) *>(image + ehdr->e_phoff);
+        for (size_t i = 0; i < ehdr->e_phnum; ++i) {
+            const ElfW(Phdr) &phdr = phdrs[i];
+            if (phdr.p_type != PT_LOAD) {
+                continue;
+            }
+            uint64_t address = (phdr.p_vaddr - phdr.p_offset) & page_mask;
+            if (!have_load || address < m_load_address) {
+                m_load_address = address;
+                have_load = true;
+            }
+            if (!(phdr.p_flags & PF_X) || phdr.p_filesz == 0 || phdr.p_offset + phdr.p_filesz > image_size) {
+                continue;
+            }
+
+            TextSegment segment;
+            segment.vaddr = phdr.p_vaddr;
+            segment.offset = phdr.p_offset;
+            segment.size = phdr.p_filesz;
+            for (uint64_t done = 0; done < segment.size; done += text_block_size) {
+                const auto length = static_cast<size_t>(std::min<uint64_t>(text_block_size, segment.size - done));
+                segment.block_crcs.push_back(crc32c(image + segment.offset + done, length));
+            }
+            m_segments.push_back(std::move(segment));
+        }
+        m_path = path;
+        m_inode = st.st_ino;
+        ret = 0;
+    }
+
+    munmap(mapped, image_size);
+    return ret;
+}
+
+int TextImage::read(uint64_t offset, void *buffer, size_t size) const
+{
+    int fd = open(m_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st{};
+    bool ok = fstat(fd, &st) == 0 && st.st_ino == m_inode &&
+              pread(fd, buffer, size, static_cast<off_t>(offset)) == static_cast<ssize_t>(size);
+    close(fd);
+    return ok ? 0 : -1;
+}
+
+void append_diffs(const uint8_t *live, const uint8_t *expected, size_t size, uintptr_t address,
+        const std::string &module, uint64_t offset, const std::vector<TextExpectation> &sites,
+        std::vector<TextDiff> &diffs)
+{
+    for (size_t i = 0; i < size;) {
+        if (live[i] == expected[i]) {
+            ++i;
+            continue;
+        }
+        size_t j = i + 1;
+        while (j < size && live[j] != expected[j]) {
+            ++j;
+        }
+
+        const uintptr_t begin = address + i;
+        const uintptr_t end = address + j;
+        std::string label = "unexpected";
+        for (const auto &site : sites) {
+            if (site.address < end && site.address + site.bytes.size() > begin) {
+                label = site.label;
+                break;
+            }
+        }
+        if (!diffs.empty() && diffs.back().end == begin && diffs.back().label == label &&
+            diffs.back().module == module) {
+            diffs.back().end = end;
+        } else {
+            diffs.push_back({ begin, end, module, offset + i, label });
+        }
+        i = j;
+    }
+}
+
+int verify_module_text(const TextImage &image, const std::string &module, uintptr_t bias,
+        const std::vector<TextExpectation> &expected, const MemoryReader &read, TextVerifyReport &report)
+{
+    std::vector<uint8_t> live(read_chunk_size);
+    std::vector<uint8_t> wanted(text_block_size);
+    ++report.modules;
+    for (const TextSegment &segment : image.segments()) {
+        ++report.segments;
+        const uintptr_t start = bias + segment.vaddr;
+        auto site = expected.begin();
+        for (uint64_t done = 0; done < segment.size; done += read_chunk_size) {
+            const auto size = static_cast<size_t>(std::min<uint64_t>(read_chunk_size, segment.size - done));
+            if (read(start + done, live.data(), size) != 0) {
+                report.skipped.push_back(module);
+                return -1;
+            }
+            report.bytes += size;
+
+            for (size_t block = 0; block < size; block += text_block_size) {
+                const uint64_t position = done + block;
+                const size_t length = std::min(text_block_size, size - block);
+                const uintptr_t address = start + position;
+                const uint8_t *data = live.data() + block;
+
+                // 含期望补丁的块：文件内容叠加期望字节后计算校验值
+                while (site != expected.end() && site->address + site->bytes.size() <= address) {
+                    ++site;
+                }
+                const bool overlaid = site != expected.end() && site->address < address + length;
+                uint32_t want = segment.block_crcs[position / text_block_size];
+                if (overlaid) {
+                    if (image.read(segment.offset + position, wanted.data(), length) != 0) {
+                        report.skipped.push_back(module);
+                        return -1;
+                    }
+                    for (auto it = site; it != expected.end() && it->address < address + length; ++it) {
+                        for (size_t i = 0; i < it->bytes.size(); ++i) {
+                            if (it->address + i >= address && it->address + i < address + length) {
+                                wanted[it->address + i - address] = it->bytes[i];
+                            }
+                        }
+                    }
+                    want = crc32c(wanted.data(), length);
+                }
+                if (crc32c(data, length) == want) {
+                    continue;
+                }
+
+                if (!overlaid && image.read(segment.offset + position, wanted.data(), length) != 0) {
+                    report.skipped.push_back(module);
+                    return -1;
+                }
+                append_diffs(data, wanted.data(), length, address, module, segment.vaddr + position, expected,
+                             report.diffs);
+            }
+        }
+    }
+    return 0;
+}
+
+std::string format_diff(const TextDiff &diff)
+{
+    std::ostringstream oss;
+    const size_t slash = diff.module.rfind('/');
+    oss << "0x" << std::hex << diff.begin << "-0x" << diff.end << ":"
+        << (slash == std::string::npos ? diff.module : diff.module.substr(slash + 1)) << "+0x" << diff.offset << ":"
+        << diff.label;
+    return oss.str();
+}
+
+std::string format_verify_report(const TextVerifyReport &report, size_t limit)
+{
+    std::string text = "diffs=" + std::to_string(report.diffs.size()) + " modules=" + std::to_string(report.modules) +
+                       " segments=" + std::to_string(report.segments) + " bytes=" + std::to_string(report.bytes) +
+                       " patches=" + std::to_string(report.patch_sites);
+    if (!report.skipped.empty()) {
+        text += " skipped=" + std::to_string(report.skipped.size());
+    }
+    for (size_t i = 0; i < report.diffs.size() && i < limit; ++i) {
+        text += " " + format_diff(report.diffs[i]);
+    }
+    if (limit > 0 && report.diffs.size() > limit) {
+        text += " +" + std::to_string(report.diffs.size() - limit) + " more";
+    }
+    return text;
+}
+
+}; // namespace RemoteDebug
@@ -0,0 +1,114 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 代码段完整性校验：按块比对目标进程中可执行段的 CRC32C 与磁盘上 ELF 文件及补丁清单期望的内容
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace RemoteDebug {
+
+constexpr size_t text_block_size = 4096; // 每个校验块的字节数
+
+// ELF 文件中的一个可执行 PT_LOAD 段
+struct TextSegment {
+    uint64_t              vaddr{ 0 };
+    uint64_t              offset{ 0 };
+    uint64_t              size{ 0 };   // p_filesz
+    std::vector<uint32_t> block_crcs;  // 每 text_block_size 字节一个，最后一块可能不足
+};
+
+/**
+ * @brief 单个 ELF 文件可执行段的分块校验值
+ * @details 校验值在加载时计算一次，由 SymbolCache 按路径和 inode 缓存；
+ *          需要逐字节比对时按原路径重新读取文件，inode 已变化则读取失败
+ */
+class TextImage {
+public:
+    /**
+     * @brief 读取 ELF 文件并计算各可执行段的分块校验值
+     * @return 成功返回0，失败返回-1
+     */
+    int load(const std::string &path);
+
+    /**
+     * @brief 从文件读取一段字节，用于定位与期望内容不同的位置
+     * @return 成功返回0，文件不可读或已被替换返回-1
+     */
+    int read(uint64_t offset, void *buffer, size_t size) const;
+
+    // 第一个 PT_LOAD 段按页对齐的虚拟地址，与 ElfSymbols::load_address 相同
+    uint64_t load_address() const { return m_load_address; }
+
+    const std::vector<TextSegment> &segments() const { return m_segments; }
+
+private:
+    std::string              m_path;
+    uint64_t                 m_inode{ 0 };
+    uint64_t                 m_load_address{ 0 };
+    std::vector<TextSegment> m_segments;
+};
+
+// 补丁清单中一处期望的代码，如改写后的函数入口
+struct TextExpectation {
+    uintptr_t            address{ 0 };
+    std::vector<uint8_t> bytes;
+    std::string          label;        // 出现差异时的说明，如 "patch:rd_target_value"
+};
+
+// 与期望内容不同的一段地址
+struct TextDiff {
+    uintptr_t   begin{ 0 };
+    uintptr_t   end{ 0 };
+    std::string module;              // 模块路径，跳转岛为 "[island]"
+    uint64_t    offset{ 0 };         // 相对模块加载偏移的链接地址
+    std::string label;               // 期望的补丁说明，补丁清单之外的改动为 "unexpected"
+};
+
+struct TextVerifyReport {
+    size_t                   modules{ 0 };
+    size_t                   segments{ 0 };
+    size_t                   patch_sites{ 0 };
+    uint64_t                 bytes{ 0 };
+    std::vector<TextDiff>    diffs;
+    std::vector<std::string> skipped;  // 无法读取文件或内存的模块
+};
+
+// 读取目标进程内存，成功返回0
+using MemoryReader = std::function<int(uintptr_t address, void *buffer, size_t size)>;
+
+/**
+ * @brief 校验一个模块的全部可执行段
+ * @details 按块计算内存的 CRC32C，与文件的分块校验值比对；含期望补丁的块由文件内容叠加期望字节后计算。
+ *          只有校验值不同的块才读取文件逐字节比对，得到精确的差异区间。不暂停目标进程，
+ *          其他线程同时改写代码时结果可能包含中间状态
+ * @param[in] bias 模块加载偏移
+ * @param[in] expected 本模块中的期望补丁，按地址排序
+ * @return 成功返回0，读取内存或文件失败返回-1（已发现的差异保留在 report 中）
+ */
+int verify_module_text(const TextImage &image, const std::string &module, uintptr_t bias,
+        const std::vector<TextExpectation> &expected, const MemoryReader &read, TextVerifyReport &report);
+
+/**
+ * @brief 逐字节比对 live 与 expected，将不同的区间追加到 diffs，与上一个区间相接时合并
+ */
+void append_diffs(const uint8_t *live, const uint8_t *expected, size_t size, uintptr_t address,
+        const std::string &module, uint64_t offset, const std::vector<TextExpectation> &sites,
+        std::vector<TextDiff> &diffs);
+
+/**
+ * @brief 差异区间的单行格式：<begin>-<end>:<模块文件名>+<offset>:<label>
+ */
+std::string format_diff(const TextDiff &diff);
+
+/**
+ * @brief 校验结果的单行摘要 "diffs= modules= segments= bytes= patches= [skipped=]"
+ * @details 随后列出至多 limit 个差异区间，limit 为 0 时只输出摘要
+ */
+std::string format_verify_report(const TextVerifyReport &report, size_t limit);
+
+}; // namespace RemoteDebug
@@ -1,7 +1,360 @@
+#include <chrono>
+#include <climits>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
 
-int main()
+#include <unistd.h>
+
+#include "inject/command_ring.h"
+#include "inject/patch_agent.h"
+#include "inject/probe_ring.h"
+#include "inject/symbol_index.h"
+#include "transmit/compress.h"
+#include "transmit/delta.h"
+
+using namespace RemoteDebug;
+
+namespace {
+
+struct SubCommand {
+    const char *name;
+    const char *usage;
+    int (*handler)(int argc, char *argv[]); // argv[0] 为子命令名
+};
+
+// 设备侧：输出已有文件的块签名，供主机计算增量
+int cmd_delta_signature(int argc, char *argv[])
 {
-    std::cout << "test \n";
+    if (argc != 3) {
+        return -1;
+    }
+
+    FileSignature signature;
+    if (compute_signature(argv[1], static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)), signature) != 0) {
+        return 1;
+    }
+    std::cout << encode_signature(signature);
     return 0;
-}
\ No newline at end of file
+}
+
+// 设备侧：将主机上传的增量原地应用到已有文件
+int cmd_delta_patch(int argc, char *argv[])
+{
+    if (argc != 3) {
+        return -1;
+    }
+
+    int ret = apply_delta_inplace(argv[1], argv[2]);
+    std::remove(argv[2]);
+    return ret == 0 ? 0 : 1;
+}
+
+// 设备侧：从标准输入读取主机发送的压缩流，解压写入文件
+int cmd_decompress(int argc, char *argv[])
+{
+    if (argc != 2) {
+        return -1;
+    }
+    return decompress_to_file(STDIN_FILENO, argv[1]) == 0 ? 0 : 1;
+}
+
+/**
+ * @brief 按目标进程可执行文件的符号索引模糊选择补丁目标（--match），可以使用还原后的 C++ 名称或名称前缀
+ * @details 不指定 --match 时目标名原样发送，不做任何替换。索引在内存或缓存目录中生成，不写入可执行文件所在目录
+ * @return 唯一匹配时替换为符号名并返回0；没有匹配或有多个匹配时在标准错误输出候选并返回-1
+ */
+int resolve_target(pid_t pid, std::string &target)
+{
+    char resolved[PATH_MAX];
+    SymbolIndex index;
+    if (!realpath(("/proc/" + std::to_string(pid) + "/exe").c_str(), resolved) || index.open_for(resolved) != 0) {
+        std::cerr << "Failed to index the executable of process " << pid << std::endl;
+        return -1;
+    }
+    std::string name;
+    std::vector<std::string> candidates;
+    if (select_symbol(index, target, name, candidates) == 0) {
+        std::cerr << target << " -> " << name << std::endl;
+        target = name;
+        return 0;
+    }
+    if (candidates.empty()) {
+        std::cerr << "No symbol in " << resolved << " matches " << target << std::endl;
+        return -1;
+    }
+    std::cerr << target << " matches several symbols in " << resolved << ":" << std::endl;
+    for (const auto &candidate : candidates) {
+        std::cerr << "  " << candidate << std::endl;
+    }
+    return -1;
+}
+
+// 在回复中的地址后附加目标进程内的符号
+std::string annotate_reply(pid_t pid, const std::string &reply)
+{
+    if (reply.compare(0, 2, "OK") == 0) {
+        return reply;
+    }
+    ProcessSymbolizer symbolizer(pid);
+    return symbolizer.annotate(reply);
+}
+
+PatchAgent *g_agent = nullptr;
+
+void stop_agent(int)
+{
+    if (g_agent) {
+        g_agent->stop();
+    }
+}
+
+// 设备侧：常驻补丁代理，缓存符号索引与跳转岛，通过 Unix socket 接收命令
+int cmd_agent(int argc, char *argv[])
+{
+    if (argc > 2) {
+        return -1;
+    }
+
+    PatchAgent agent(argc == 2 ? argv[1] : default_agent_socket);
+    g_agent = &agent;
+    struct sigaction action{};
+    action.sa_handler = stop_agent;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    int ret = agent.run();
+    g_agent = nullptr;
+    return ret == 0 ? 0 : 1;
+}
+
+// 向常驻补丁代理发送一条命令并输出回复
+int cmd_agent_cmd(int argc, char *argv[])
+{
+    int first = 1;
+    std::string socket_path = default_agent_socket;
+    if (argc > 2 && std::strcmp(argv[1], "--socket") == 0) {
+        socket_path = argv[2];
+        first = 3;
+    }
+    const bool match = first < argc && std::strcmp(argv[first], "--match") == 0;
+    first += match ? 1 : 0;
+    if (first >= argc) {
+        return -1;
+    }
+
+    const std::string command = argv[first];
+    const pid_t pid = first + 1 < argc ? static_cast<pid_t>(std::strtol(argv[first + 1], nullptr, 10)) : 0;
+    std::string request = command;
+    for (int i = first + 1; i < argc; ++i) {
+        // 代理要求补丁库为绝对路径
+        char resolved[PATH_MAX];
+        bool library = command == "load" && i == first + 2;
+        std::string arg = library && realpath(argv[i], resolved) ? resolved : argv[i];
+        if (match && command == "apply" && i == first + 2 && resolve_target(pid, arg) != 0) {
+            return 1;
+        }
+        request += " " + arg;
+    }
+
+    std::string reply;
+    if (agent_request(socket_path, request, reply) != 0) {
+        return 1;
+    }
+    std::cout << (pid > 0 ? annotate_reply(pid, reply) : reply) << std::endl;
+    return reply.compare(0, 2, "OK") == 0 ? 0 : 1;
+}
+
+// 通过共享内存命令环向进程内代理（libremotedebug_agent.so）发送命令，不使用 ptrace
+int cmd_inproc(int argc, char *argv[])
+{
+    const bool match = argc > 1 && std::strcmp(argv[1], "--match") == 0;
+    if (match) {
+        --argc;
+        ++argv;
+    }
+    if (argc < 3) {
+        return -1;
+    }
+
+    const pid_t pid = static_cast<pid_t>(std::strtol(argv[1], nullptr, 10));
+    const std::string command = argv[2];
+    std::string request = command;
+    for (int i = 3; i < argc; ++i) {
+        // 补丁库在目标进程内按路径加载，转换为绝对路径
+        char resolved[PATH_MAX];
+        bool library = (command == "load" || command == "package") && i == 3;
+        std::string arg = library && realpath(argv[i], resolved) ? resolved : argv[i];
+        if (match && ((command == "apply" && i == 3) || command == "probe") && resolve_target(pid, arg) != 0) {
+            return 1;
+        }
+        request += " " + arg;
+    }
+
+    std::string reply;
+    if (ring_request(pid, request, reply) != 0) {
+        return 1;
+    }
+    std::cout << annotate_reply(pid, reply) << std::endl;
+    return reply.compare(0, 2, "OK") == 0 ? 0 : 1;
+}
+
+// 读取进程内代理探针写入的调用记录，不暂停目标进程，结束后输出各函数的调用次数与耗时分布
+int cmd_probe_drain(int argc, char *argv[])
+{
+    if (argc != 2 && argc != 3) {
+        return -1;
+    }
+
+    ProbeDrain drain;
+    if (drain.open(static_cast<pid_t>(std::strtol(argv[1], nullptr, 10))) != 0) {
+        return 1;
+    }
+    const long seconds = argc == 3 ? std::strtol(argv[2], nullptr, 10) : 1;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    do {
+        drain.drain();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    } while (std::chrono::steady_clock::now() < deadline);
+    drain.drain();
+    std::cout << drain.report();
+    return 0;
+}
+
+// 不经代理、不暂停目标进程，校验代码段与磁盘上的 ELF 文件一致；补丁改写的入口同样报告为差异
+int cmd_verify(int argc, char *argv[])
+{
+    if (argc != 2) {
+        return -1;
+    }
+
+    const pid_t pid = static_cast<pid_t>(std::strtol(argv[1], nullptr, 10));
+    SymbolCache cache;
+    ProcessPatcher patcher(pid, cache);
+    TextVerifyReport report;
+    const auto start = std::chrono::steady_clock::now();
+    if (patcher.verify(report) != 0) {
+        return 1;
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << format_verify_report(report, 0) << " "
+              << std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() << "us" << std::endl;
+    ProcessSymbolizer symbolizer(pid);
+    for (const auto &diff : report.diffs) {
+        const std::string symbol = symbolizer.describe(diff.begin);
+        std::cout << format_diff(diff) << (symbol.empty() ? "" : " " + symbol) << std::endl;
+    }
+    for (const auto &module : report.skipped) {
+        std::cout << "skipped " << module << std::endl;
+    }
+    return report.diffs.empty() && report.skipped.empty() ? 0 : 1;
+}
+
+void print_symbol(const SymbolIndex &index, size_t i)
+{
+    const ElfSymbol symbol = index.symbol(i);
+    std::cout << "0x" << std::hex << symbol.value << std::dec << " " << symbol.size << " " << index.name(i);
+    const std::string demangled = index.demangled(i);
+    if (demangled != index.name(i)) {
+        std::cout << " " << demangled;
+    }
+    std::cout << std::endl;
+}
+
+// 生成或查询可执行文件旁的符号索引；地址为 ELF 中的链接地址
+int cmd_symbols(int argc, char *argv[])
+{
+    if (argc < 3) {
+        return -1;
+    }
+    const std::string mode = argv[2];
+    const std::string query = argc > 3 ? argv[3] : "";
+    if (mode == "index") {
+        return SymbolIndex::build(argv[1], SymbolIndex::path_for(argv[1])) == 0 ? 0 : 1;
+    }
+    if (argc != 4) {
+        return -1;
+    }
+
+    SymbolIndex index;
+    if (index.open_for(argv[1]) != 0) {
+        return 1;
+    }
+    constexpr size_t limit = 50;
+    std::vector<size_t> found;
+    if (mode == "find") {
+        const ssize_t i = index.find(query);
+        if (i >= 0) {
+            found.push_back(static_cast<size_t>(i));
+        }
+    } else if (mode == "prefix") {
+        found = index.find_prefix(query, limit);
+    } else if (mode == "fuzzy") {
+        found = index.find_fuzzy(query, limit);
+    } else if (mode == "addr") {
+        uint64_t offset = 0;
+        const ssize_t i = index.find_address(std::strtoull(query.c_str(), nullptr, 16), offset);
+        if (i < 0) {
+            return 1;
+        }
+        std::cout << index.demangled(static_cast<size_t>(i)) << "+0x" << std::hex << offset << std::endl;
+        return 0;
+    } else {
+        return -1;
+    }
+    for (size_t i : found) {
+        print_symbol(index, i);
+    }
+    return found.empty() ? 1 : 0;
+}
+
+const SubCommand sub_commands[] = {
+    { "delta-signature", "delta-signature <file> <block_size>", cmd_delta_signature },
+    { "delta-patch", "delta-patch <file> <delta_file>", cmd_delta_patch },
+    { "decompress", "decompress <file>  (compressed stream on stdin)", cmd_decompress },
+    { "agent", "agent [socket]  (resident patch agent)", cmd_agent },
+    { "agent-cmd", "agent-cmd [--socket <socket>] [--match] <request...>", cmd_agent_cmd },
+    { "inproc", "inproc [--match] <pid> <request...>  (process preloading libremotedebug_agent.so)", cmd_inproc },
+    { "probe-drain", "probe-drain <pid> [seconds]  (call latency recorded by inproc probes)", cmd_probe_drain },
+    { "verify", "verify <pid>  (text segments against the ELF files on disk)", cmd_verify },
+    { "symbols", "symbols <binary> index|find|prefix|fuzzy|addr [<query>]  (symbol index next to the binary)",
+      cmd_symbols },
+};
+
+void usage(const char *program)
+{
+    std::cout << "Usage:\n";
+    for (const auto &command : sub_commands) {
+        std::cout << "  " << program << " " << command.usage << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2) {
+        usage(argv[0]);
+        return 0;
+    }
+
+    const std::string name = argv[1];
+    for (const auto &command : sub_commands) {
+        if (name == command.name) {
+            int ret = command.handler(argc - 1, argv + 1);
+            if (ret < 0) {
+                std::cerr << "Usage: " << argv[0] << " " << command.usage << std::endl;
+                return 2;
+            }
+            return ret;
+        }
+    }
+
+    std::cerr << "Unknown command: " << name << std::endl;
+    usage(argv[0]);
+    return 2;
+}
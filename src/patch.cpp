@@ -1,359 +1,789 @@
-#include <cstdint>
+#include "patch.h"
+#include "patch_arch.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
 #include <cstring>
+#include <elf.h>
+#include <initializer_list>
+#include <iostream>
+#include <link.h>
 #include <sys/mman.h>
 #include <unistd.h>
-#include <dlfcn.h>
-#include <iostream>
-#include <vector>
-#include <cassert>
-
-// x86-64 架构的指令集
-#ifdef __x86_64__
-constexpr uint8_t JMP_OPCODE = 0xE9;
-constexpr uint8_t NOP_OPCODE = 0x90;
-constexpr size_t SHORT_JMP_SIZE = 5;
-constexpr size_t LONG_JMP_SIZE = 14;
-
-#elif defined(__aarch64__)
-// ARM64 架构实现
-constexpr uint32_t BR_OPCODE = 0xD61F0000;
-constexpr size_t BR_SIZE = 4;
-constexpr size_t NOP_SIZE = 4;
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
 #endif
 
-// 跳转岛结构
-struct JumpIsland {
-    void* allocated_memory = nullptr;
-    size_t size = 0;
-    uintptr_t original_function = 0;
-    uintptr_t patch_function = 0;
-    std::vector<uint8_t> original_prologue;
-};
+namespace RemoteDebug {
 
-class FunctionPatcher {
-public:
-    FunctionPatcher() = default;
-    ~FunctionPatcher() {
-        // 清理所有跳转岛
-        for (auto& island : islands) {
-            uninstall_patch(island);
+namespace {
+
+// 编译时选择的体系结构后端
+using Arch = arch::Native;
+
+// 跳转岛与原始函数的最大距离：不超过入口跳转的范围，且最多 ±256MB
+constexpr uintptr_t NEAR_RANGE = std::min<uintptr_t>(Arch::entry_range, 0x10000000);
+constexpr uintptr_t NEAR_STEP = 0x100000;     // 每次向外扩展 1MB 查找空闲地址
+
+// 以下为 x86-64 探针桩的指令解码与编码，仅在 Arch::supports_probes 时使用
+constexpr size_t PROBE_PROLOGUE_CAPACITY = 32;   // 搬移的入口指令最多占用的字节数
+constexpr uint32_t PROBE_FRAME_SIZE = 136;        // 保存 xmm0-xmm7 并使调用回调时栈按 16 字节对齐
+constexpr uint32_t PROBE_SAVED_GPR_SIZE = 64;     // 入口桩压栈的 8 个通用寄存器
+
+/**
+ * @brief 解码一条 x86-64 指令的长度
+ * @details 只覆盖函数入口常见的指令（压栈、mov/lea/算术、SSE 读写、endbr64、条件与无条件相对跳转等），
+ *          调用、返回、间接跳转、VEX 编码等无法或不应搬移的指令返回 0
+ * @param[out] rip_offset RIP 相对寻址的 32 位位移在指令中的偏移，没有时为 0
+ * @param[out] branch_size 相对跳转的位移字节数（1 或 4，位于指令末尾），不是跳转时为 0
+ */
+size_t x86_instruction_length(const uint8_t* code, size_t* rip_offset, size_t* branch_size) {
+    const uint8_t* p = code;
+    bool operand16 = false;
+    bool rex_w = false;
+    *rip_offset = 0;
+    *branch_size = 0;
+
+    for (;; ++p) {
+        if (*p == 0x66) {
+            operand16 = true;
+        } else if (*p != 0x67 && *p != 0xF0 && *p != 0xF2 && *p != 0xF3 && *p != 0x2E && *p != 0x3E &&
+                   *p != 0x26 && *p != 0x36 && *p != 0x64 && *p != 0x65) {
+            break;
         }
     }
+    if ((*p & 0xF0) == 0x40) {
+        rex_w = (*p & 0x08) != 0;
+        ++p;
+    }
 
-    // 安装函数补丁
-    bool install_patch(void* original_func, void* patch_func) {
-        JumpIsland island;
-        island.original_function = reinterpret_cast<uintptr_t>(original_func);
-        island.patch_function = reinterpret_cast<uintptr_t>(patch_func);
+    const uint8_t op = *p++;
+    const size_t imm_z = operand16 ? 2 : 4;
+    bool modrm = false;
+    size_t imm = 0;
+    if (op == 0x0F) {
+        const uint8_t op2 = *p++;
+        if (op2 >= 0x80 && op2 <= 0x8F) {
+            *branch_size = 4;
+        } else if (op2 == 0x38) {
+            ++p;
+            modrm = true;
+        } else if (op2 == 0x3A) {
+            ++p;
+            modrm = true;
+            imm = 1;
+        } else if ((op2 >= 0x70 && op2 <= 0x73) || op2 == 0xBA || op2 == 0xC2 || op2 == 0xC4 || op2 == 0xC5 ||
+                   op2 == 0xC6) {
+            modrm = true;
+            imm = 1;
+        } else if ((op2 >= 0x10 && op2 <= 0x18) || op2 == 0x1E || op2 == 0x1F || (op2 >= 0x28 && op2 <= 0x2F) ||
+                   (op2 >= 0x40 && op2 <= 0x6F) || (op2 >= 0x74 && op2 <= 0x7F) || (op2 >= 0x90 && op2 <= 0x9F) ||
+                   op2 == 0xA3 || op2 == 0xAB || op2 == 0xAF || op2 == 0xB3 || op2 == 0xB6 || op2 == 0xB7 ||
+                   (op2 >= 0xBB && op2 <= 0xBF) || (op2 >= 0xD0 && op2 <= 0xFE)) {
+            modrm = true;
+        } else {
+            return 0;
+        }
+    } else if ((op >= 0x70 && op <= 0x7F) || op == 0xEB) {
+        *branch_size = 1;
+    } else if (op == 0xE9) {
+        *branch_size = 4;
+    } else if (op < 0x40 && (op & 7) < 4) {
+        modrm = true;
+    } else if (op < 0x40 && (op & 7) == 4) {
+        imm = 1;
+    } else if (op < 0x40 && (op & 7) == 5) {
+        imm = imm_z;
+    } else if ((op >= 0x50 && op <= 0x5F) || (op >= 0x90 && op <= 0x99)) {
+        // push/pop/xchg/cdq，没有操作数字节
+    } else if (op == 0x63 || (op >= 0x84 && op <= 0x8B) || op == 0x8D || op == 0x8F || (op >= 0xD0 && op <= 0xD3) ||
+               op == 0xFE) {
+        modrm = true;
+    } else if (op == 0x6B || op == 0x80 || op == 0x83 || op == 0xC0 || op == 0xC1 || op == 0xC6) {
+        modrm = true;
+        imm = 1;
+    } else if (op == 0x69 || op == 0x81 || op == 0xC7) {
+        modrm = true;
+        imm = imm_z;
+    } else if (op == 0x6A || op == 0xA8 || (op >= 0xB0 && op <= 0xB7)) {
+        imm = 1;
+    } else if (op == 0x68 || op == 0xA9) {
+        imm = imm_z;
+    } else if (op >= 0xB8 && op <= 0xBF) {
+        imm = rex_w ? 8 : imm_z;
+    } else if (op == 0xF6 || op == 0xF7) {
+        modrm = true;
+        if (((*p >> 3) & 7) < 2) {
+            imm = op == 0xF6 ? 1 : imm_z;
+        }
+    } else if (op == 0xFF) {
+        // 只允许 inc/dec/push，间接调用与跳转不搬移
+        const uint8_t reg = (*p >> 3) & 7;
+        if (reg != 0 && reg != 1 && reg != 6) {
+            return 0;
+        }
+        modrm = true;
+    } else {
+        return 0;
+    }
 
-        // 保存原始函数入口代码
-        if (!save_original_prologue(island)) {
-            std::cerr << "保存原始函数入口失败" << std::endl;
-            return false;
+    if (modrm) {
+        const uint8_t mod = *p >> 6;
+        const uint8_t rm = *p & 7;
+        ++p;
+        if (mod != 3) {
+            if (rm == 4) {
+                if (mod == 0 && (*p & 7) == 5) {
+                    p += 4;
+                }
+                ++p;
+            } else if (mod == 0 && rm == 5) {
+                *rip_offset = static_cast<size_t>(p - code);
+                p += 4;
+            }
+            p += mod == 1 ? 1 : mod == 2 ? 4 : 0;
         }
+    }
+    p += imm + *branch_size;
+    const size_t length = static_cast<size_t>(p - code);
+    return length <= 15 ? length : 0;
+}
 
-        // 创建跳转岛
-        if (!create_jump_island(island)) {
-            std::cerr << "创建跳转岛失败" << std::endl;
-            return false;
+/**
+ * @brief 将覆盖 min_size 字节的入口指令逐条搬移到 buffer
+ * @details RIP 相对位移按新地址重新计算；相对跳转统一改写为 32 位位移的 jmp/jcc，
+ *          跳转目标落在被入口跳转覆盖的字节中时无法搬移
+ * @param[in] destination buffer 最终所在的地址
+ * @param[out] written 写入 buffer 的字节数
+ * @return 搬移的原始字节数，遇到无法搬移的指令或位移越界返回 0
+ */
+size_t relocate_prologue(uintptr_t source, uintptr_t destination, size_t min_size, uint8_t* buffer, size_t* written) {
+    size_t copied = 0;
+    size_t out = 0;
+    auto fits = [](int64_t value) { return value >= INT32_MIN && value <= INT32_MAX; };
+    while (copied < min_size) {
+        const uintptr_t address = source + copied;
+        const uint8_t* instruction = reinterpret_cast<const uint8_t*>(address);
+        const uintptr_t here = destination + out;
+        size_t rip_offset = 0;
+        size_t branch_size = 0;
+        const size_t length = x86_instruction_length(instruction, &rip_offset, &branch_size);
+        if (length == 0 || out + length + 4 > PROBE_PROLOGUE_CAPACITY) {
+            return 0;
         }
 
-        // 修改原始函数入口
-        if (!patch_original_function(island)) {
-            std::cerr << "修改原始函数入口失败" << std::endl;
-            uninstall_patch(island);
-            return false;
+        if (branch_size) {
+            int32_t displacement = static_cast<int8_t>(instruction[length - 1]);
+            if (branch_size == 4) {
+                memcpy(&displacement, instruction + length - 4, sizeof(displacement));
+            }
+            const uintptr_t target = address + length + static_cast<uintptr_t>(static_cast<int64_t>(displacement));
+            if (target >= source && target < source + min_size) {
+                return 0;
+            }
+            const uint8_t opcode = instruction[length - 1 - branch_size];
+            size_t size = 5;
+            if (opcode == 0xEB || opcode == 0xE9) {
+                buffer[out] = 0xE9;
+            } else {
+                buffer[out] = 0x0F;
+                buffer[out + 1] = static_cast<uint8_t>(0x80 | (opcode & 0x0F));
+                size = 6;
+            }
+            const int64_t moved = static_cast<int64_t>(target) - static_cast<int64_t>(here + size);
+            if (!fits(moved)) {
+                return 0;
+            }
+            displacement = static_cast<int32_t>(moved);
+            memcpy(buffer + out + size - 4, &displacement, sizeof(displacement));
+            out += size;
+        } else {
+            memcpy(buffer + out, instruction, length);
+            if (rip_offset) {
+                int32_t displacement;
+                memcpy(&displacement, instruction + rip_offset, sizeof(displacement));
+                const int64_t moved = displacement + (static_cast<int64_t>(address) - static_cast<int64_t>(here));
+                if (!fits(moved)) {
+                    return 0;
+                }
+                displacement = static_cast<int32_t>(moved);
+                memcpy(buffer + out + rip_offset, &displacement, sizeof(displacement));
+            }
+            out += length;
         }
+        copied += length;
+    }
+    *written = out;
+    return copied;
+}
 
-        islands.push_back(island);
-        return true;
+// 按字节拼接机器码
+class CodeBuffer {
+public:
+    void emit(std::initializer_list<uint8_t> bytes) { code.insert(code.end(), bytes); }
+
+    template <typename T>
+    void emit_value(T value) {
+        uint8_t raw[sizeof(T)];
+        memcpy(raw, &value, sizeof(T));
+        code.insert(code.end(), raw, raw + sizeof(T));
     }
 
-    // 卸载函数补丁
-    bool uninstall_patch(JumpIsland& island) {
-        if (!restore_original_prologue(island)) {
-            std::cerr << "恢复原始函数入口失败" << std::endl;
-            return false;
+    // movdqu [rsp + disp8], xmmN 或 movdqu xmmN, [rsp + disp8]
+    void emit_xmm(bool store, uint8_t reg, uint8_t displacement) {
+        emit({ 0xF3, 0x0F, static_cast<uint8_t>(store ? 0x7F : 0x6F), static_cast<uint8_t>(0x44 | reg << 3), 0x24,
+               displacement });
+    }
+
+    std::vector<uint8_t> code;
+};
+
+struct GotSearch {
+    const char* symbol;
+    uintptr_t skip_address;      // 补丁函数地址，所在模块不改写
+    std::vector<GotSlot> slots;
+};
+
+// 在一个模块的 .rela.plt 与 .rela.dyn 中查找引用目标符号的 GOT 表项
+int find_got_slots(dl_phdr_info* info, size_t, void* data) {
+    auto* search = static_cast<GotSearch*>(data);
+    const ElfW(Dyn)* dynamic = nullptr;
+    uintptr_t relro_begin = 0;
+    uintptr_t relro_end = 0;
+    for (ElfW(Half) i = 0; i < info->dlpi_phnum; ++i) {
+        const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+        uintptr_t begin = info->dlpi_addr + phdr.p_vaddr;
+        if (phdr.p_type == PT_DYNAMIC) {
+            dynamic = reinterpret_cast<const ElfW(Dyn)*>(begin);
+        } else if (phdr.p_type == PT_GNU_RELRO) {
+            relro_begin = begin;
+            relro_end = begin + phdr.p_memsz;
+        } else if (phdr.p_type == PT_LOAD && search->skip_address >= begin &&
+                   search->skip_address < begin + phdr.p_memsz) {
+            return 0;
         }
+    }
+    if (!dynamic) {
+        return 0;
+    }
 
-        // 释放跳转岛内存
-        if (island.allocated_memory) {
-            munmap(island.allocated_memory, island.size);
-            island.allocated_memory = nullptr;
+    // ld.so 已将动态段中的地址重定位，vDSO 等未重定位的按偏移处理
+    auto pointer = [info](ElfW(Addr) value) {
+        return value < info->dlpi_addr ? value + info->dlpi_addr : value;
+    };
+    const ElfW(Sym)* symtab = nullptr;
+    const char* strtab = nullptr;
+    const ElfW(Rela)* tables[2] = {};
+    size_t sizes[2] = {};
+    for (const ElfW(Dyn)* entry = dynamic; entry->d_tag != DT_NULL; ++entry) {
+        switch (entry->d_tag) {
+        case DT_SYMTAB: symtab = reinterpret_cast<const ElfW(Sym)*>(pointer(entry->d_un.d_ptr)); break;
+        case DT_STRTAB: strtab = reinterpret_cast<const char*>(pointer(entry->d_un.d_ptr)); break;
+        case DT_JMPREL: tables[0] = reinterpret_cast<const ElfW(Rela)*>(pointer(entry->d_un.d_ptr)); break;
+        case DT_PLTRELSZ: sizes[0] = entry->d_un.d_val; break;
+        case DT_RELA: tables[1] = reinterpret_cast<const ElfW(Rela)*>(pointer(entry->d_un.d_ptr)); break;
+        case DT_RELASZ: sizes[1] = entry->d_un.d_val; break;
+        default: break;
         }
+    }
+    if (!symtab || !strtab) {
+        return 0;
+    }
 
-        return true;
+    for (int t = 0; t < 2; ++t) {
+        for (size_t i = 0; tables[t] && i < sizes[t] / sizeof(ElfW(Rela)); ++i) {
+            const ElfW(Rela)& rela = tables[t][i];
+            uint32_t type = static_cast<uint32_t>(ELF64_R_TYPE(rela.r_info));
+            uint32_t index = static_cast<uint32_t>(ELF64_R_SYM(rela.r_info));
+            if ((type != Arch::reloc_jump_slot && type != Arch::reloc_glob_dat) || index == 0 ||
+                strcmp(strtab + symtab[index].st_name, search->symbol) != 0) {
+                continue;
+            }
+            GotSlot slot;
+            slot.address = info->dlpi_addr + rela.r_offset;
+            slot.original = __atomic_load_n(reinterpret_cast<uintptr_t*>(slot.address), __ATOMIC_ACQUIRE);
+            slot.relro = slot.address >= relro_begin && slot.address < relro_end;
+            search->slots.push_back(slot);
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+FunctionPatcher::~FunctionPatcher() {
+    // 清理所有跳转岛
+    for (auto& island : islands) {
+        uninstall_patch(island);
+    }
+    while (!redirects.empty()) {
+        uninstall_got_patch(redirects.back().symbol);
+    }
+    uninstall_probes();
+}
+
+// 安装函数补丁
+bool FunctionPatcher::install_patch(void* original_func, void* patch_func) {
+    JumpIsland island;
+    island.original_function = reinterpret_cast<uintptr_t>(original_func);
+    island.patch_function = reinterpret_cast<uintptr_t>(patch_func);
+    if (entry_rewritten(island.original_function)) {
+        std::cerr << "函数入口已被补丁或探测" << std::endl;
+        return false;
     }
 
-private:
     // 保存原始函数入口代码
-    bool save_original_prologue(JumpIsland& island) {
-        #ifdef __x86_64__
-        // 保存足够的指令以覆盖短跳转
-        island.original_prologue.resize(SHORT_JMP_SIZE);
-        memcpy(island.original_prologue.data(), 
-               reinterpret_cast<void*>(island.original_function), 
-               SHORT_JMP_SIZE);
-        return true;
-        
-        #elif defined(__aarch64__)
-        // ARM64 需要保存4字节指令
-        island.original_prologue.resize(BR_SIZE);
-        memcpy(island.original_prologue.data(), 
-               reinterpret_cast<void*>(island.original_function), 
-               BR_SIZE);
-        return true;
-        
-        #else
-        std::cerr << "不支持的架构" << std::endl;
+    if (!save_original_prologue(island)) {
+        std::cerr << "保存原始函数入口失败" << std::endl;
         return false;
-        #endif
     }
 
     // 创建跳转岛
-    bool create_jump_island(JumpIsland& island) {
-        #ifdef __x86_64__
-        // 计算所需空间: 短跳转 + 长跳转 + 原始入口代码
-        island.size = SHORT_JMP_SIZE + LONG_JMP_SIZE + island.original_prologue.size();
-        
-        // 分配可执行内存 (靠近原始函数地址)
-        island.allocated_memory = allocate_near(island.original_function, island.size);
-        if (!island.allocated_memory) return false;
-        
-        uint8_t* island_ptr = static_cast<uint8_t*>(island.allocated_memory);
-        
-        // 1. 跳转到补丁函数 (长跳转)
-        assemble_long_jump(island_ptr, island.patch_function);
-        island_ptr += LONG_JMP_SIZE;
-        
-        // 2. 原始入口代码 (将被短跳转覆盖的部分)
-        memcpy(island_ptr, island.original_prologue.data(), island.original_prologue.size());
-        island_ptr += island.original_prologue.size();
-        
-        // 3. 跳回原始函数 (在原始入口代码之后)
-        uintptr_t return_address = island.original_function + island.original_prologue.size();
-        assemble_short_jump(island_ptr, return_address);
-        
-        return true;
-        
-        #elif defined(__aarch64__)
-        // ARM64 实现
-        island.size = BR_SIZE + island.original_prologue.size();
-        island.allocated_memory = allocate_near(island.original_function, island.size);
-        if (!island.allocated_memory) return false;
-        
-        uint32_t* island_ptr = static_cast<uint32_t*>(island.allocated_memory);
-        
-        // 跳转到补丁函数
-        assemble_arm64_jump(island_ptr, island.patch_function);
-        island_ptr++;
-        
-        // 原始入口代码
-        memcpy(island_ptr, island.original_prologue.data(), island.original_prologue.size());
-        
-        return true;
-        
-        #else
+    if (!create_jump_island(island)) {
+        std::cerr << "创建跳转岛失败" << std::endl;
         return false;
-        #endif
     }
 
     // 修改原始函数入口
-    bool patch_original_function(JumpIsland& island) {
-        #ifdef __x86_64__
-        // 设置内存可写
-        if (!set_memory_protection(reinterpret_cast<void*>(island.original_function), 
-                                  SHORT_JMP_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC)) {
+    if (!patch_original_function(island)) {
+        std::cerr << "修改原始函数入口失败" << std::endl;
+        // 入口未被改写（如无法原子写入而拒绝）时不再写回原始指令，直接释放跳转岛
+        if (memcmp(reinterpret_cast<const void*>(island.original_function), island.original_prologue.data(),
+                   island.original_prologue.size()) == 0) {
+            island.original_prologue.clear();
+        }
+        uninstall_patch(island);
+        return false;
+    }
+
+    islands.push_back(island);
+    return true;
+}
+
+// 卸载函数补丁
+bool FunctionPatcher::uninstall_patch(JumpIsland& island) {
+    if (!restore_original_prologue(island)) {
+        std::cerr << "恢复原始函数入口失败" << std::endl;
+        return false;
+    }
+
+    // 释放跳转岛内存
+    if (island.allocated_memory) {
+        TraceSpan span("island_free", "inprocess");
+        munmap(island.allocated_memory, island.size);
+        island.allocated_memory = nullptr;
+    }
+
+    return true;
+}
+
+bool FunctionPatcher::uninstall_patch(void* original_func) {
+    auto it = std::find_if(islands.begin(), islands.end(), [original_func](const JumpIsland& island) {
+        return island.original_function == reinterpret_cast<uintptr_t>(original_func);
+    });
+    if (it == islands.end() || !uninstall_patch(*it)) {
+        return false;
+    }
+    islands.erase(it);
+    return true;
+}
+
+bool FunctionPatcher::retire_patch(void* original_func) {
+    auto it = std::find_if(islands.begin(), islands.end(), [original_func](const JumpIsland& island) {
+        return island.original_function == reinterpret_cast<uintptr_t>(original_func);
+    });
+    if (it == islands.end() || !restore_original_prologue(*it)) {
+        return false;
+    }
+    retired_islands.push_back(*it);
+    islands.erase(it);
+    return true;
+}
+
+std::vector<JumpIsland> FunctionPatcher::retired() const {
+    std::vector<JumpIsland> result = retired_islands;
+    for (const auto& site : retired_probes) {
+        result.push_back(site.island);
+    }
+    return result;
+}
+
+size_t FunctionPatcher::reclaim(const std::function<bool(const JumpIsland&)>& in_use) {
+    TraceSpan span("island_free", "inprocess");
+    size_t freed = 0;
+    auto release = [&](JumpIsland& island) {
+        if (in_use(island)) {
             return false;
         }
-        
-        // 写入短跳转到跳转岛
-        uint8_t* func_ptr = reinterpret_cast<uint8_t*>(island.original_function);
-        assemble_short_jump(func_ptr, reinterpret_cast<uintptr_t>(island.allocated_memory));
-        
-        // 用NOP填充剩余空间 (如果有)
-        for (size_t i = SHORT_JMP_SIZE; i < island.original_prologue.size(); ++i) {
-            func_ptr[i] = NOP_OPCODE;
+        munmap(island.allocated_memory, island.size);
+        ++freed;
+        return true;
+    };
+    retired_islands.erase(std::remove_if(retired_islands.begin(), retired_islands.end(), release),
+                          retired_islands.end());
+    retired_probes.erase(std::remove_if(retired_probes.begin(), retired_probes.end(),
+                                        [&](ProbeSite& site) { return release(site.island); }),
+                         retired_probes.end());
+    return freed;
+}
+
+// GOT 重定向
+bool FunctionPatcher::install_got_patch(const std::string& symbol, void* patch_func) {
+    if constexpr (!Arch::supported) {
+        std::cerr << "不支持的架构" << std::endl;
+        return false;
+    }
+    TraceSpan span("got_rewrite", "inprocess");
+    uintptr_t value = reinterpret_cast<uintptr_t>(patch_func);
+    auto it = std::find_if(redirects.begin(), redirects.end(),
+                           [&symbol](const GotRedirect& redirect) { return redirect.symbol == symbol; });
+    if (it != redirects.end()) {
+        for (const auto& slot : it->slots) {
+            if (!write_got_slot(slot, value)) {
+                return false;
+            }
         }
-        
-        // 刷新指令缓存
-        flush_instruction_cache(reinterpret_cast<void*>(island.original_function), 
-                                island.original_prologue.size());
+        it->patch_function = value;
         return true;
-        
-        #elif defined(__aarch64__)
-        if (!set_memory_protection(reinterpret_cast<void*>(island.original_function), 
-                                  BR_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC)) {
+    }
+
+    GotSearch search{ symbol.c_str(), value, {} };
+    dl_iterate_phdr(find_got_slots, &search);
+    if (search.slots.empty()) {
+        std::cerr << "没有模块通过 GOT 引用 " << symbol << std::endl;
+        return false;
+    }
+
+    GotRedirect redirect;
+    redirect.symbol = symbol;
+    redirect.patch_function = value;
+    for (const auto& slot : search.slots) {
+        if (!write_got_slot(slot, value)) {
+            for (const auto& written : redirect.slots) {
+                write_got_slot(written, written.original);
+            }
             return false;
         }
-        
-        uint32_t* func_ptr = reinterpret_cast<uint32_t*>(island.original_function);
-        assemble_arm64_jump(func_ptr, reinterpret_cast<uintptr_t>(island.allocated_memory));
-        
-        flush_instruction_cache(reinterpret_cast<void*>(island.original_function), BR_SIZE);
-        return true;
-        
-        #else
+        redirect.slots.push_back(slot);
+    }
+    redirects.push_back(std::move(redirect));
+    return true;
+}
+
+bool FunctionPatcher::uninstall_got_patch(const std::string& symbol) {
+    auto it = std::find_if(redirects.begin(), redirects.end(),
+                           [&symbol](const GotRedirect& redirect) { return redirect.symbol == symbol; });
+    if (it == redirects.end()) {
+        return false;
+    }
+    TraceSpan span("got_rewrite", "inprocess");
+    bool restored = true;
+    for (const auto& slot : it->slots) {
+        restored = write_got_slot(slot, slot.original) && restored;
+    }
+    redirects.erase(it);
+    return restored;
+}
+
+bool FunctionPatcher::write_got_slot(const GotSlot& slot, uintptr_t value) {
+    void* address = reinterpret_cast<void*>(slot.address);
+    if (slot.relro && !set_memory_protection(address, sizeof(uintptr_t), PROT_READ | PROT_WRITE)) {
+        return false;
+    }
+    // GOT 表项按 8 字节对齐，其他线程读到的要么是旧地址，要么是新地址
+    __atomic_store_n(reinterpret_cast<uintptr_t*>(slot.address), value, __ATOMIC_SEQ_CST);
+    return !slot.relro || set_memory_protection(address, sizeof(uintptr_t), PROT_READ);
+}
+
+// 安装入口/出口探针
+bool FunctionPatcher::install_probe(void* function, uint32_t id, const ProbeHooks& hooks) {
+    if constexpr (!Arch::supports_probes) {
+        std::cerr << "探针仅支持 x86-64" << std::endl;
+        return false;
+    }
+    const uintptr_t address = reinterpret_cast<uintptr_t>(function);
+    if (entry_rewritten(address)) {
+        std::cerr << "函数入口已被补丁或探测" << std::endl;
+        return false;
+    }
+    if (!hooks.enter || !hooks.exit || !create_exit_stub(hooks)) {
         return false;
-        #endif
     }
 
-    // 恢复原始函数入口
-    bool restore_original_prologue(JumpIsland& island) {
-        #ifdef __x86_64__
-        if (!set_memory_protection(reinterpret_cast<void*>(island.original_function), 
-                                  island.original_prologue.size(), 
-                                  PROT_READ | PROT_WRITE | PROT_EXEC)) {
+    // 同一函数、同一编号的跳转岛内容相同，直接复用
+    ProbeSite site;
+    auto retired = std::find_if(retired_probes.begin(), retired_probes.end(), [&](const ProbeSite& candidate) {
+        return candidate.island.original_function == address && candidate.id == id &&
+               candidate.island.patch_function == reinterpret_cast<uintptr_t>(hooks.enter);
+    });
+    if (retired != retired_probes.end()) {
+        site = *retired;
+        retired_probes.erase(retired);
+    } else {
+        site.id = id;
+        site.island.original_function = address;
+        if (!save_original_prologue(site.island) || !create_probe_island(site, hooks)) {
             return false;
         }
-        
-        memcpy(reinterpret_cast<void*>(island.original_function), 
-               island.original_prologue.data(), 
-               island.original_prologue.size());
-        
-        flush_instruction_cache(reinterpret_cast<void*>(island.original_function), 
-                                island.original_prologue.size());
-        return true;
-        
-        #elif defined(__aarch64__)
-        if (!set_memory_protection(reinterpret_cast<void*>(island.original_function), 
-                                  BR_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC)) {
+    }
+
+    if (!patch_original_function(site.island)) {
+        std::cerr << "修改原始函数入口失败" << std::endl;
+        retired_probes.push_back(site);
+        return false;
+    }
+    probes.push_back(site);
+    return true;
+}
+
+bool FunctionPatcher::uninstall_probes() {
+    bool restored = true;
+    for (auto& site : probes) {
+        restored = restore_original_prologue(site.island) && restored;
+        retired_probes.push_back(site);
+    }
+    probes.clear();
+    return restored;
+}
+
+bool FunctionPatcher::entry_rewritten(uintptr_t function) const {
+    return std::any_of(islands.begin(), islands.end(),
+                       [function](const JumpIsland& island) { return island.original_function == function; }) ||
+           std::any_of(probes.begin(), probes.end(),
+                       [function](const ProbeSite& site) { return site.island.original_function == function; });
+}
+
+// 生成探针跳转岛，x86-64 编码
+bool FunctionPatcher::create_probe_island(ProbeSite& site, const ProbeHooks& hooks) {
+    using X86 = arch::X86_64;
+    TraceSpan span("memory_write", "inprocess");
+    CodeBuffer buffer;
+    // 保存整数参数寄存器、rax（变参函数的向量寄存器个数）与 r10（静态链）
+    buffer.emit({ 0x57, 0x56, 0x52, 0x51, 0x41, 0x50, 0x41, 0x51, 0x50, 0x41, 0x52 });
+    // sub rsp, PROBE_FRAME_SIZE：入口时 rsp ≡ 8 (mod 16)，加上 64 字节寄存器后调用回调时对齐
+    buffer.emit({ 0x48, 0x81, 0xEC });
+    buffer.emit_value(PROBE_FRAME_SIZE);
+    for (uint8_t reg = 0; reg < 8; ++reg) {
+        buffer.emit_xmm(true, reg, static_cast<uint8_t>(reg * 16));
+    }
+    buffer.emit({ 0xBF });                          // mov edi, id
+    buffer.emit_value(site.id);
+    buffer.emit({ 0x48, 0x8D, 0xB4, 0x24 });        // lea rsi, [rsp + 返回地址的位置]
+    buffer.emit_value(PROBE_FRAME_SIZE + PROBE_SAVED_GPR_SIZE);
+    buffer.emit({ 0x48, 0xBA });                    // movabs rdx, exit_stub
+    buffer.emit_value(static_cast<uint64_t>(exit_stub));
+    buffer.emit({ 0x48, 0xB8 });                    // movabs rax, enter; call rax
+    buffer.emit_value(reinterpret_cast<uint64_t>(hooks.enter));
+    buffer.emit({ 0xFF, 0xD0 });
+    for (uint8_t reg = 0; reg < 8; ++reg) {
+        buffer.emit_xmm(false, reg, static_cast<uint8_t>(reg * 16));
+    }
+    buffer.emit({ 0x48, 0x81, 0xC4 });              // add rsp, PROBE_FRAME_SIZE
+    buffer.emit_value(PROBE_FRAME_SIZE);
+    buffer.emit({ 0x41, 0x5A, 0x58, 0x41, 0x59, 0x41, 0x58, 0x59, 0x5A, 0x5E, 0x5F });
+
+    JumpIsland& island = site.island;
+    island.patch_function = reinterpret_cast<uintptr_t>(hooks.enter);
+    island.size = buffer.code.size() + PROBE_PROLOGUE_CAPACITY + X86::entry_jump_size;
+    island.allocated_memory = allocate_near(island.original_function, island.size);
+    if (!island.allocated_memory) {
+        return false;
+    }
+
+    // 搬移被入口跳转覆盖的指令，再跳回其后的第一条指令
+    uint8_t* island_ptr = static_cast<uint8_t*>(island.allocated_memory);
+    memcpy(island_ptr, buffer.code.data(), buffer.code.size());
+    island_ptr += buffer.code.size();
+    size_t written = 0;
+    size_t relocated = relocate_prologue(island.original_function, reinterpret_cast<uintptr_t>(island_ptr),
+                                         X86::entry_jump_size, island_ptr, &written);
+    if (relocated == 0) {
+        std::cerr << "函数入口指令无法搬移" << std::endl;
+        munmap(island.allocated_memory, island.size);
+        island.allocated_memory = nullptr;
+        return false;
+    }
+    island_ptr += written;
+    const auto back = X86::entry_jump(reinterpret_cast<uintptr_t>(island_ptr), island.original_function + relocated);
+    memcpy(island_ptr, back.bytes, back.size);
+
+    flush_instruction_cache(island.allocated_memory, island.size);
+    return set_memory_protection(island.allocated_memory, island.size, PROT_READ | PROT_EXEC);
+}
+
+// 生成共享的出口桩：保存返回值寄存器，调用出口回调取回原返回地址并跳转过去，x86-64 编码
+bool FunctionPatcher::create_exit_stub(const ProbeHooks& hooks) {
+    if (exit_stub) {
+        if (exit_hook != hooks.exit) {
+            std::cerr << "出口回调与已有探针不一致" << std::endl;
             return false;
         }
-        
-        memcpy(reinterpret_cast<void*>(island.original_function), 
-               island.original_prologue.data(), 
-               BR_SIZE);
-        
-        flush_instruction_cache(reinterpret_cast<void*>(island.original_function), BR_SIZE);
         return true;
-        
-        #else
+    }
+
+    CodeBuffer buffer;
+    buffer.emit({ 0x50, 0x52 });                    // push rax; push rdx
+    buffer.emit({ 0x48, 0x83, 0xEC, 0x20 });        // sub rsp, 32：返回后 rsp ≡ 0 (mod 16)，调用回调时仍对齐
+    buffer.emit_xmm(true, 0, 0);
+    buffer.emit_xmm(true, 1, 16);
+    buffer.emit({ 0x48, 0xB8 });                    // movabs rax, exit; call rax
+    buffer.emit_value(reinterpret_cast<uint64_t>(hooks.exit));
+    buffer.emit({ 0xFF, 0xD0 });
+    buffer.emit({ 0x49, 0x89, 0xC3 });              // mov r11, rax
+    buffer.emit_xmm(false, 0, 0);
+    buffer.emit_xmm(false, 1, 16);
+    buffer.emit({ 0x48, 0x83, 0xC4, 0x20 });        // add rsp, 32
+    buffer.emit({ 0x5A, 0x58 });                    // pop rdx; pop rax
+    buffer.emit({ 0x41, 0xFF, 0xE3 });              // jmp r11
+
+    void* memory = mmap(nullptr, buffer.code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        std::cerr << "分配出口桩失败: " << strerror(errno) << std::endl;
+        return false;
+    }
+    memcpy(memory, buffer.code.data(), buffer.code.size());
+    flush_instruction_cache(memory, buffer.code.size());
+    if (!set_memory_protection(memory, buffer.code.size(), PROT_READ | PROT_EXEC)) {
+        munmap(memory, buffer.code.size());
+        return false;
+    }
+    exit_stub = reinterpret_cast<uintptr_t>(memory);
+    exit_hook = hooks.exit;
+    return true;
+}
+
+// 保存原始函数入口代码
+bool FunctionPatcher::save_original_prologue(JumpIsland& island) {
+    if constexpr (!Arch::supported) {
+        std::cerr << "不支持的架构" << std::endl;
         return false;
-        #endif
     }
+    // 保存将被入口跳转覆盖的字节
+    island.original_prologue.resize(Arch::entry_jump_size);
+    memcpy(island.original_prologue.data(),
+           reinterpret_cast<void*>(island.original_function),
+           Arch::entry_jump_size);
+    return true;
+}
+
+// 创建跳转岛：只有一段跳到补丁函数的远跳转
+bool FunctionPatcher::create_jump_island(JumpIsland& island) {
+    TraceSpan span("memory_write", "inprocess");
+    island.size = Arch::far_jump_size;
+
+    // 分配可执行内存 (靠近原始函数地址)
+    island.allocated_memory = allocate_near(island.original_function, island.size);
+    if (!island.allocated_memory) return false;
+
+    const uintptr_t island_address = reinterpret_cast<uintptr_t>(island.allocated_memory);
+    const auto jump = Arch::far_jump(island_address, island.patch_function);
+    memcpy(island.allocated_memory, jump.bytes, jump.size);
+
+    // 填充完成后去掉写权限
+    flush_instruction_cache(island.allocated_memory, island.size);
+    return set_memory_protection(island.allocated_memory, island.size, PROT_READ | PROT_EXEC);
+}
+
+// 修改原始函数入口
+bool FunctionPatcher::patch_original_function(JumpIsland& island) {
+    // 写入入口跳转到跳转岛
+    const uintptr_t island_address = reinterpret_cast<uintptr_t>(island.allocated_memory);
+    if (!Arch::entry_reachable(island.original_function, island_address)) {
+        std::cerr << "跳转岛超出入口跳转范围" << std::endl;
+        return false;
+    }
+    const auto jump = Arch::entry_jump(island.original_function, island_address);
+    return write_code(island.original_function, jump.bytes, jump.size);
+}
+
+// 恢复原始函数入口
+bool FunctionPatcher::restore_original_prologue(JumpIsland& island) {
+    if (island.original_prologue.empty()) {
+        return true;
+    }
+    return write_code(island.original_function, island.original_prologue.data(), island.original_prologue.size());
+}
 
-    // 分配靠近指定地址的内存
-    void* allocate_near(uintptr_t target_address, size_t size) {
-        // 尝试在目标地址附近分配内存
-        const size_t allocation_size = sysconf(_SC_PAGESIZE);
-        const uintptr_t start = target_address - 0x10000000; // ±256MB
-        const uintptr_t end = target_address + 0x10000000;
-        
-        for (uintptr_t addr = start; addr < end; addr += allocation_size) {
+// 分配靠近指定地址的内存
+void* FunctionPatcher::allocate_near(uintptr_t target_address, size_t size) {
+    TraceSpan span("island_alloc", "inprocess");
+    // 由近及远尝试目标地址两侧的空闲区间，MAP_FIXED_NOREPLACE 不会覆盖已有映射
+    const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const uintptr_t base = target_address & ~(page_size - 1);
+
+    for (uintptr_t offset = NEAR_STEP; offset <= NEAR_RANGE; offset += NEAR_STEP) {
+        for (uintptr_t addr : { base > offset ? base - offset : 0, base + offset }) {
+            if (addr < page_size) {
+                continue;
+            }
             void* result = mmap(reinterpret_cast<void*>(addr), size,
-                                PROT_READ | PROT_WRITE | PROT_EXEC,
-                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
-            
-            if (result != MAP_FAILED) {
+                                PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+            if (result == MAP_FAILED) {
+                continue;
+            }
+            // 旧内核不支持 MAP_FIXED_NOREPLACE 时地址仅作为提示
+            if (result == reinterpret_cast<void*>(addr)) {
                 return result;
             }
+            munmap(result, size);
         }
-        
-        // 回退到常规分配
-        return mmap(nullptr, size, PROT_READ | PROT_WRITE | PROT_EXEC,
-                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    }
-
-    // 设置内存保护
-    bool set_memory_protection(void* address, size_t size, int protection) {
-        long page_size = sysconf(_SC_PAGESIZE);
-        uintptr_t start = reinterpret_cast<uintptr_t>(address);
-        uintptr_t end = start + size;
-        uintptr_t page_start = start & ~(page_size - 1);
-        
-        if (mprotect(reinterpret_cast<void*>(page_start), 
-                     end - page_start, protection) == -1) {
-            std::cerr << "mprotect 失败: " << strerror(errno) << std::endl;
-            return false;
-        }
-        return true;
     }
 
-    // 刷新指令缓存
-    void flush_instruction_cache(void* address, size_t size) {
-        #ifdef __linux__
-        __builtin___clear_cache(reinterpret_cast<char*>(address), 
-                               reinterpret_cast<char*>(address) + size);
-        #elif defined(__APPLE__)
-        sys_icache_invalidate(address, size);
-        #endif
-    }
-
-    // x86-64 汇编辅助函数
-    #ifdef __x86_64__
-    void assemble_short_jump(uint8_t* buffer, uintptr_t target) {
-        uintptr_t source = reinterpret_cast<uintptr_t>(buffer);
-        int32_t offset = static_cast<int32_t>(target - (source + SHORT_JMP_SIZE));
-        
-        buffer[0] = JMP_OPCODE;
-        *reinterpret_cast<int32_t*>(buffer + 1) = offset;
-    }
-
-    void assemble_long_jump(uint8_t* buffer, uintptr_t target) {
-        // movabs rax, target
-        buffer[0] = 0x48; // REX.W prefix
-        buffer[1] = 0xB8; // MOV RAX, imm64
-        *reinterpret_cast<uint64_t*>(buffer + 2) = target;
-        
-        // jmp rax
-        buffer[10] = 0xFF;
-        buffer[11] = 0xE0;
-    }
-    #endif
-
-    // ARM64 汇编辅助函数
-    #ifdef __aarch64__
-    void assemble_arm64_jump(uint32_t* buffer, uintptr_t target) {
-        uintptr_t source = reinterpret_cast<uintptr_t>(buffer);
-        int64_t offset = target - source;
-        
-        if (llabs(offset) < (1 << 26)) {
-            // 使用 B 指令 (26位有符号偏移)
-            uint32_t imm26 = (offset >> 2) & 0x3FFFFFF;
-            *buffer = 0x14000000 | imm26;
-        } else {
-            // 使用绝对地址加载
-            uint32_t high = (target >> 32) & 0xFFFF;
-            uint32_t low = target & 0xFFFF;
-            
-            // MOVZ X17, #high, LSL #48
-            *buffer++ = 0xD2800000 | (17 << 5) | ((high >> 12) & 0xFFFF);
-            
-            // MOVK X17, #low, LSL #32
-            *buffer++ = 0xF2A00000 | (17 << 5) | (low & 0xFFFF);
-            
-            // BR X17
-            *buffer = BR_OPCODE | (17 << 5);
-        }
+    std::cerr << "目标地址附近没有可用的内存" << std::endl;
+    return nullptr;
+}
+
+// 设置内存保护
+bool FunctionPatcher::set_memory_protection(void* address, size_t size, int protection) {
+    uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t start = reinterpret_cast<uintptr_t>(address);
+    uintptr_t end = start + size;
+    uintptr_t page_start = start & ~(page_size - 1);
+
+    if (mprotect(reinterpret_cast<void*>(page_start),
+                 end - page_start, protection) == -1) {
+        std::cerr << "mprotect 失败: " << strerror(errno) << std::endl;
+        return false;
     }
-    #endif
+    return true;
+}
 
-private:
-    std::vector<JumpIsland> islands;
-};
+// 将指令写入正在执行的代码
+bool FunctionPatcher::write_code(uintptr_t address, const uint8_t* code, size_t size) {
+    TraceSpan span("prologue_rewrite", "inprocess");
+    void* target = reinterpret_cast<void*>(address);
+    if (!set_memory_protection(target, size, PROT_READ | PROT_WRITE | PROT_EXEC)) {
+        return false;
+    }
 
-// 使用示例
-void original_function() {
-    std::cout << "原始函数被调用" << std::endl;
+    // 指令位于同一个 8 字节对齐窗口内时整体原子写入，其余字节保持原值；
+    // 跨越 8 字节边界时用 16 字节 CAS，仍无法原子写入时拒绝，其他线程可能正在执行这段代码
+    uintptr_t window = address & ~static_cast<uintptr_t>(sizeof(uint64_t) - 1);
+    uintptr_t window16 = address & ~static_cast<uintptr_t>(15);
+    if (address + size <= window + sizeof(uint64_t)) {
+        uint64_t value;
+        memcpy(&value, reinterpret_cast<void*>(window), sizeof(value));
+        memcpy(reinterpret_cast<uint8_t*>(&value) + (address - window), code, size);
+        __atomic_store_n(reinterpret_cast<uint64_t*>(window), value, __ATOMIC_SEQ_CST);
+    } else if (Arch::supports_store16 && address + size <= window16 + 16) {
+        Arch::atomic_store16(reinterpret_cast<void*>(window16), code, address - window16, size);
+    } else {
+        std::cerr << "函数入口跨越 16 字节边界，无法原子写入" << std::endl;
+        set_memory_protection(target, size, PROT_READ | PROT_EXEC);
+        return false;
+    }
+
+    flush_instruction_cache(target, size);
+    return set_memory_protection(target, size, PROT_READ | PROT_EXEC);
 }
 
-void patched_function() {
-    std::cout << "补丁函数被调用" << std::endl;
+// 刷新指令缓存
+void FunctionPatcher::flush_instruction_cache(void* address, size_t size) {
+    Arch::flush_icache(address, size);
 }
 
-int main() {
-    FunctionPatcher patcher;
-    
-    std::cout << "安装补丁前:" << std::endl;
-    original_function();
-    
-    // 安装补丁
-    if (patcher.install_patch(reinterpret_cast<void*>(&original_function),
-                             reinterpret_cast<void*>(&patched_function))) {
-        std::cout << "\n安装补丁后:" << std::endl;
-        original_function(); // 实际调用 patched_function
-    }
-    
-    return 0;
-}
\ No newline at end of file
+}; // namespace RemoteDebug
@@ -0,0 +1,176 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 进程内函数补丁：将目标函数入口改写为跳转，经跳转岛跳到补丁函数或入口/出口探针
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace RemoteDebug {
+
+// 跳转岛结构
+struct JumpIsland {
+    void* allocated_memory = nullptr;
+    size_t size = 0;
+    uintptr_t original_function = 0;
+    uintptr_t patch_function = 0;
+    std::vector<uint8_t> original_prologue;
+};
+
+// 引用目标符号的 GOT 表项
+struct GotSlot {
+    uintptr_t address = 0;
+    uintptr_t original = 0;
+    bool relro = false;          // 位于 PT_GNU_RELRO 区间，加载完成后只读
+};
+
+// GOT 重定向记录
+struct GotRedirect {
+    std::string symbol;
+    uintptr_t patch_function = 0;
+    std::vector<GotSlot> slots;
+};
+
+/**
+ * @brief 函数探针回调，由跳转岛中的桩代码调用，调用前后保存全部参数与返回值寄存器
+ * @details enter 在函数入口调用，return_slot 指向栈上的返回地址，改写为 exit_stub 后函数返回时进入出口桩；
+ *          出口桩调用 exit，跳转到其返回的原返回地址。两者都不应调用可能被探测的函数
+ */
+struct ProbeHooks {
+    void (*enter)(uint32_t id, uintptr_t* return_slot, uintptr_t exit_stub) = nullptr;
+    uintptr_t (*exit)() = nullptr;
+};
+
+// 已安装的探针
+struct ProbeSite {
+    uint32_t id = 0;
+    JumpIsland island;
+};
+
+/**
+ * @brief 进程内函数补丁
+ * @details 入口跳转通过一次对齐的原子写入完成，其他线程无需暂停，
+ *          执行到入口时看到的要么是原始指令，要么是完整的跳转指令。
+ *          非线程安全，应由同一个线程调用
+ */
+class FunctionPatcher {
+public:
+    FunctionPatcher() = default;
+    ~FunctionPatcher();
+    FunctionPatcher(const FunctionPatcher&) = delete;
+    FunctionPatcher& operator=(const FunctionPatcher&) = delete;
+
+    // 安装函数补丁
+    bool install_patch(void* original_func, void* patch_func);
+
+    // 卸载函数补丁
+    bool uninstall_patch(JumpIsland& island);
+
+    // 按原始函数地址卸载补丁并立即释放跳转岛，调用者需确认没有线程在跳转岛中执行
+    bool uninstall_patch(void* original_func);
+
+    /**
+     * @brief 按原始函数地址卸载补丁，跳转岛暂不释放
+     * @details 恢复入口后新的调用不再进入跳转岛，但其他线程可能刚执行到跳转岛或仍在补丁函数中，
+     *          跳转岛移入待回收列表，由调用者确认没有线程引用后调用 reclaim 释放
+     */
+    bool retire_patch(void* original_func);
+
+    // 待回收的跳转岛，包括已卸载的补丁与探针
+    std::vector<JumpIsland> retired() const;
+
+    /**
+     * @brief 释放 in_use 返回 false 的待回收跳转岛
+     * @return 释放的跳转岛数
+     */
+    size_t reclaim(const std::function<bool(const JumpIsland&)>& in_use);
+
+    // 已安装的补丁
+    const std::vector<JumpIsland>& installed() const { return islands; }
+
+    /**
+     * @brief GOT 重定向：将各模块中引用 symbol 的 GOT 表项改为 patch_func
+     * @details 每个表项一次对齐的 8 字节原子写入，不修改代码也不需要跳转岛。
+     *          只影响跨模块经 PLT/GOT 的调用，模块内直接调用与之后加载的模块不受影响；
+     *          补丁函数所在的模块不改写，其中按名字调用的仍是原函数。已重定向时改为新的补丁函数
+     * @return 至少改写一个表项返回 true
+     */
+    bool install_got_patch(const std::string& symbol, void* patch_func);
+
+    // 恢复 GOT 表项原值
+    bool uninstall_got_patch(const std::string& symbol);
+
+    // 已重定向的符号
+    const std::vector<GotRedirect>& redirected() const { return redirects; }
+
+    /**
+     * @brief 安装入口/出口探针：入口跳到跳转岛中的桩代码，调用 hooks.enter 后执行搬移的入口指令再跳回原函数
+     * @details 仅支持 x86-64。入口处被覆盖的指令逐条解码搬移，RIP 相对寻址的位移会重新计算；
+     *          入口指令中含相对跳转、调用或返回时拒绝安装。出口经改写返回地址实现，
+     *          探测函数抛出的异常无法穿过出口桩，longjmp 跳出探测函数会使回调中的返回地址栈错位
+     * @param[in] id 传给回调的函数编号
+     * @return 函数已被补丁或探测、入口指令无法搬移时返回 false
+     */
+    bool install_probe(void* function, uint32_t id, const ProbeHooks& hooks);
+
+    /**
+     * @brief 恢复全部探测函数的入口
+     * @details 跳转岛移入待回收列表，出口桩不释放：其他线程可能仍在其中执行，或尚未从探测函数返回；
+     *          回收之前再次探测同一函数时复用原有跳转岛
+     */
+    bool uninstall_probes();
+
+    // 已安装的探针
+    const std::vector<ProbeSite>& probed() const { return probes; }
+
+private:
+    // 保存原始函数入口代码
+    bool save_original_prologue(JumpIsland& island);
+
+    // 创建跳转岛
+    bool create_jump_island(JumpIsland& island);
+
+    // 修改原始函数入口
+    bool patch_original_function(JumpIsland& island);
+
+    // 恢复原始函数入口
+    bool restore_original_prologue(JumpIsland& island);
+
+    // 分配靠近指定地址的内存
+    void* allocate_near(uintptr_t target_address, size_t size);
+
+    // 设置内存保护
+    bool set_memory_protection(void* address, size_t size, int protection);
+
+    // 将指令写入正在执行的代码，写入期间其他线程可能执行到这里
+    bool write_code(uintptr_t address, const uint8_t* code, size_t size);
+
+    // 原子写入一个 GOT 表项，位于 RELRO 区间时临时加写权限
+    bool write_got_slot(const GotSlot& slot, uintptr_t value);
+
+    // 入口已被补丁或探测
+    bool entry_rewritten(uintptr_t function) const;
+
+    // 生成探针跳转岛：保存寄存器、调用入口回调、恢复寄存器、搬移的入口指令、跳回原函数
+    bool create_probe_island(ProbeSite& site, const ProbeHooks& hooks);
+
+    // 生成共享的出口桩，首次安装探针时创建
+    bool create_exit_stub(const ProbeHooks& hooks);
+
+    // 刷新指令缓存
+    void flush_instruction_cache(void* address, size_t size);
+
+private:
+    std::vector<JumpIsland> islands;
+    std::vector<GotRedirect> redirects;
+    std::vector<ProbeSite> probes;
+    std::vector<JumpIsland> retired_islands; // 已卸载、等待回收的补丁跳转岛
+    std::vector<ProbeSite> retired_probes;  // 已卸载但仍保留的探针跳转岛
+    uintptr_t exit_stub = 0;
+    uintptr_t (*exit_hook)() = nullptr;
+};
+
+}; // namespace RemoteDebug
@@ -0,0 +1,365 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 函数补丁的体系结构后端：跳转指令编码、可达范围、重定位类型与指令缓存维护，编译时按目标体系结构选择。
+// 编码函数均为 constexpr，与宿主体系结构无关，文件末尾的 static_assert 在任何宿主上编译时校验
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <elf.h>
+
+namespace RemoteDebug {
+namespace arch {
+
+// 定长缓冲中的机器码，size 为实际长度，按小端写入
+template <size_t N>
+struct Code {
+    uint8_t bytes[N]{};
+    size_t  size{ 0 };
+
+    constexpr void append(uint8_t byte) { bytes[size++] = byte; }
+
+    constexpr void append32(uint32_t word)
+    {
+        for (size_t i = 0; i < 4; ++i) {
+            append(static_cast<uint8_t>(word >> (8 * i)));
+        }
+    }
+
+    constexpr void append64(uint64_t value)
+    {
+        append32(static_cast<uint32_t>(value));
+        append32(static_cast<uint32_t>(value >> 32));
+    }
+
+    // 第 index 个 32 位字
+    constexpr uint32_t word(size_t index) const
+    {
+        uint32_t value = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            value |= static_cast<uint32_t>(bytes[index * 4 + i]) << (8 * i);
+        }
+        return value;
+    }
+};
+
+constexpr int64_t signed_distance(uintptr_t from, uintptr_t to)
+{
+    return static_cast<int64_t>(to - from);
+}
+
+/**
+ * @brief x86-64 后端
+ * @details 入口改写为 5 字节的 jmp rel32；跳转岛中用 RIP 相对的间接跳转，不占用寄存器。
+ *          x86 的指令缓存与数据写入保持一致，改写后无需维护
+ */
+struct X86_64 {
+    static constexpr bool     supported = true;
+    static constexpr bool     supports_probes = true;
+    static constexpr size_t   entry_jump_size = 5;
+    static constexpr uint64_t entry_range = 0x7FFF0000;       // 入口跳转到跳转岛的最大距离
+    static constexpr size_t   far_jump_size = 14;
+    static constexpr size_t   literal_jump_size = 16;
+    static constexpr size_t   literal_target_offset = 8;      // 目标地址 8 字节对齐，可单独原子改写
+    static constexpr uint32_t reloc_jump_slot = R_X86_64_JUMP_SLOT;
+    static constexpr uint32_t reloc_glob_dat = R_X86_64_GLOB_DAT;
+
+    static constexpr bool entry_reachable(uintptr_t source, uintptr_t target)
+    {
+        const int64_t offset = signed_distance(source + entry_jump_size, target);
+        return offset >= INT32_MIN && offset <= INT32_MAX;
+    }
+
+    // jmp rel32
+    static constexpr Code<entry_jump_size> entry_jump(uintptr_t source, uintptr_t target)
+    {
+        Code<entry_jump_size> code;
+        code.append(0xE9);
+        code.append32(static_cast<uint32_t>(target - (source + entry_jump_size)));
+        return code;
+    }
+
+    // jmp qword ptr [rip + 0]; .quad target
+    static constexpr Code<far_jump_size> far_jump(uintptr_t, uintptr_t target)
+    {
+        Code<far_jump_size> code;
+        code.append(0xFF);
+        code.append(0x25);
+        code.append32(0);
+        code.append64(target);
+        return code;
+    }
+
+    // jmp qword ptr [rip + 2]; int3; int3; .quad target
+    static constexpr Code<literal_jump_size> literal_jump(uintptr_t target)
+    {
+        Code<literal_jump_size> code;
+        code.append(0xFF);
+        code.append(0x25);
+        code.append32(2);
+        code.append(0xCC);
+        code.append(0xCC);
+        code.append64(target);
+        return code;
+    }
+
+    static void flush_icache(void *, size_t) {}
+
+    /**
+     * @brief 用 lock cmpxchg16b 原子改写 16 字节对齐窗口中的 [offset, offset + size)，其余字节保持原值，
+     *        用于跨越 8 字节边界但位于同一 16 字节窗口内的入口
+     */
+    static constexpr bool supports_store16 = true;
+    static void atomic_store16(void *window, const uint8_t *code, size_t offset, size_t size)
+    {
+#ifdef __x86_64__
+        struct alignas(16) Window {
+            uint64_t words[2];
+        };
+        auto *words = static_cast<uint64_t *>(window);
+        uint64_t low = __atomic_load_n(&words[0], __ATOMIC_RELAXED);
+        uint64_t high = __atomic_load_n(&words[1], __ATOMIC_RELAXED);
+        bool stored = false;
+        while (!stored) {
+            uint64_t desired[2] = { low, high };
+            __builtin_memcpy(reinterpret_cast<uint8_t *>(desired) + offset, code, size);
+            // 失败时 rdx:rax 为窗口当前的值，按其重新合并
+            asm volatile("lock cmpxchg16b %1"
+                         : "=@ccz"(stored), "+m"(*static_cast<Window *>(window)), "+a"(low), "+d"(high)
+                         : "b"(desired[0]), "c"(desired[1])
+                         : "memory");
+        }
+#else
+        (void)window;
+        (void)code;
+        (void)offset;
+        (void)size;
+#endif
+    }
+};
+
+/**
+ * @brief AArch64 后端
+ * @details 入口改写为一条 B（±128MB）；跳转岛在 ±4GB 内用 ADRP+ADD+BR，超出时用 MOVZ/MOVK 装入完整的
+ *          64 位地址再 BR。跳转序列使用 x16/x17（IP0/IP1），过程调用约定允许在函数入口破坏。
+ *          改写后按 CTR_EL0 报告的缓存行清理数据缓存、无效指令缓存
+ */
+struct AArch64 {
+    static constexpr bool     supported = true;
+    static constexpr bool     supports_probes = false;
+    static constexpr size_t   entry_jump_size = 4;
+    static constexpr int64_t  branch_limit = int64_t{ 1 } << 27;  // B 的 imm26 按 4 字节缩放
+    static constexpr uint64_t entry_range = 0x7FF0000;            // 留出一个跳转岛区间的余量
+    static constexpr size_t   far_jump_size = 20;
+    static constexpr size_t   literal_jump_size = 16;
+    static constexpr size_t   literal_target_offset = 8;
+    static constexpr uint32_t reloc_jump_slot = R_AARCH64_JUMP_SLOT;
+    static constexpr uint32_t reloc_glob_dat = R_AARCH64_GLOB_DAT;
+    static constexpr uint32_t ip0 = 16;
+    static constexpr uint32_t ip1 = 17;
+
+    static constexpr bool branch_reachable(uintptr_t source, uintptr_t target)
+    {
+        const int64_t offset = signed_distance(source, target);
+        return (offset & 3) == 0 && offset >= -branch_limit && offset < branch_limit;
+    }
+
+    static constexpr bool entry_reachable(uintptr_t source, uintptr_t target)
+    {
+        return branch_reachable(source, target);
+    }
+
+    static constexpr bool adrp_reachable(uintptr_t pc, uintptr_t target)
+    {
+        const int64_t pages = static_cast<int64_t>(target >> 12) - static_cast<int64_t>(pc >> 12);
+        return pages >= -(int64_t{ 1 } << 20) && pages < (int64_t{ 1 } << 20);
+    }
+
+    // B label
+    static constexpr uint32_t b(uintptr_t source, uintptr_t target)
+    {
+        return 0x14000000u | (static_cast<uint32_t>(signed_distance(source, target) >> 2) & 0x03FFFFFFu);
+    }
+
+    // BR Xn
+    static constexpr uint32_t br(uint32_t rn) { return 0xD61F0000u | rn << 5; }
+
+    // ADRP Xd, label：immlo 位于 [30:29]，immhi 位于 [23:5]
+    static constexpr uint32_t adrp(uint32_t rd, uintptr_t pc, uintptr_t target)
+    {
+        const auto pages = static_cast<uint64_t>(static_cast<int64_t>(target >> 12) - static_cast<int64_t>(pc >> 12));
+        return 0x90000000u | static_cast<uint32_t>(pages & 0x3) << 29 |
+               static_cast<uint32_t>((pages >> 2) & 0x7FFFF) << 5 | rd;
+    }
+
+    // ADD Xd, Xn, #imm12
+    static constexpr uint32_t add_imm(uint32_t rd, uint32_t rn, uint32_t imm12)
+    {
+        return 0x91000000u | (imm12 & 0xFFFu) << 10 | rn << 5 | rd;
+    }
+
+    // MOVZ Xd, #imm16, LSL #shift
+    static constexpr uint32_t movz(uint32_t rd, uint32_t imm16, uint32_t shift)
+    {
+        return 0xD2800000u | (shift / 16) << 21 | (imm16 & 0xFFFFu) << 5 | rd;
+    }
+
+    // MOVK Xd, #imm16, LSL #shift
+    static constexpr uint32_t movk(uint32_t rd, uint32_t imm16, uint32_t shift)
+    {
+        return 0xF2800000u | (shift / 16) << 21 | (imm16 & 0xFFFFu) << 5 | rd;
+    }
+
+    // LDR Xt, label
+    static constexpr uint32_t ldr_literal(uint32_t rt, int32_t offset)
+    {
+        return 0x58000000u | (static_cast<uint32_t>(offset >> 2) & 0x7FFFFu) << 5 | rt;
+    }
+
+    static constexpr Code<entry_jump_size> entry_jump(uintptr_t source, uintptr_t target)
+    {
+        Code<entry_jump_size> code;
+        code.append32(b(source, target));
+        return code;
+    }
+
+    // pc 为跳转序列第一条指令的地址
+    static constexpr Code<far_jump_size> far_jump(uintptr_t pc, uintptr_t target)
+    {
+        Code<far_jump_size> code;
+        if (adrp_reachable(pc, target)) {
+            code.append32(adrp(ip1, pc, target));
+            code.append32(add_imm(ip1, ip1, static_cast<uint32_t>(target & 0xFFF)));
+        } else {
+            code.append32(movz(ip1, static_cast<uint32_t>(target), 0));
+            code.append32(movk(ip1, static_cast<uint32_t>(target >> 16), 16));
+            code.append32(movk(ip1, static_cast<uint32_t>(target >> 32), 32));
+            code.append32(movk(ip1, static_cast<uint32_t>(target >> 48), 48));
+        }
+        code.append32(br(ip1));
+        return code;
+    }
+
+    // ldr x16, #8; br x16; .quad target
+    static constexpr Code<literal_jump_size> literal_jump(uintptr_t target)
+    {
+        Code<literal_jump_size> code;
+        code.append32(ldr_literal(ip0, static_cast<int32_t>(literal_target_offset)));
+        code.append32(br(ip0));
+        code.append64(target);
+        return code;
+    }
+
+    static void flush_icache(void *address, size_t size)
+    {
+#ifdef __aarch64__
+        uint64_t ctr;
+        asm volatile("mrs %0, ctr_el0" : "=r"(ctr));
+        const uintptr_t start = reinterpret_cast<uintptr_t>(address);
+        const uintptr_t end = start + size;
+        // CTR_EL0.IDC/DIC 置位时硬件已保证一致，对应的维护可以省略
+        if (!((ctr >> 28) & 1)) {
+            const uintptr_t line = uintptr_t{ 4 } << ((ctr >> 16) & 0xF);
+            for (uintptr_t p = start & ~(line - 1); p < end; p += line) {
+                asm volatile("dc cvau, %0" : : "r"(p) : "memory");
+            }
+        }
+        asm volatile("dsb ish" : : : "memory");
+        if (!((ctr >> 29) & 1)) {
+            const uintptr_t line = uintptr_t{ 4 } << (ctr & 0xF);
+            for (uintptr_t p = start & ~(line - 1); p < end; p += line) {
+                asm volatile("ic ivau, %0" : : "r"(p) : "memory");
+            }
+            asm volatile("dsb ish" : : : "memory");
+        }
+        asm volatile("isb" : : : "memory");
+#else
+        __builtin___clear_cache(static_cast<char *>(address), static_cast<char *>(address) + size);
+#endif
+    }
+
+    // 入口为 4 字节对齐的单条指令，不会跨越 8 字节窗口
+    static constexpr bool supports_store16 = false;
+    static void atomic_store16(void *, const uint8_t *, size_t, size_t) {}
+};
+
+/**
+ * @brief 不支持的体系结构：各操作在运行时报错
+ */
+struct Unsupported {
+    static constexpr bool     supported = false;
+    static constexpr bool     supports_probes = false;
+    static constexpr size_t   entry_jump_size = 1;
+    static constexpr uint64_t entry_range = 0;
+    static constexpr size_t   far_jump_size = 1;
+    static constexpr size_t   literal_jump_size = 16;
+    static constexpr size_t   literal_target_offset = 8;
+    static constexpr uint32_t reloc_jump_slot = 0;
+    static constexpr uint32_t reloc_glob_dat = 0;
+
+    static constexpr bool entry_reachable(uintptr_t, uintptr_t) { return false; }
+    static constexpr Code<entry_jump_size> entry_jump(uintptr_t, uintptr_t) { return {}; }
+    static constexpr Code<far_jump_size> far_jump(uintptr_t, uintptr_t) { return {}; }
+    static constexpr Code<literal_jump_size> literal_jump(uintptr_t) { return {}; }
+    static void flush_icache(void *, size_t) {}
+    static constexpr bool supports_store16 = false;
+    static void atomic_store16(void *, const uint8_t *, size_t, size_t) {}
+};
+
+#if defined(__x86_64__)
+using Native = X86_64;
+#elif defined(__aarch64__)
+using Native = AArch64;
+#else
+using Native = Unsupported;
+#endif
+
+// 与手工汇编结果比对的编码校验
+static_assert(X86_64::entry_jump(0x1000, 0x2000).word(0) == 0x000FFBE9 && X86_64::entry_jump(0x1000, 0x2000).bytes[4] == 0,
+              "jmp rel32 forward");
+static_assert(X86_64::entry_jump(0x2000, 0x1000).word(0) == 0xFFEFFBE9 &&
+                      X86_64::entry_jump(0x2000, 0x1000).bytes[4] == 0xFF,
+              "jmp rel32 backward");
+static_assert(X86_64::far_jump(0, 0x1122334455667788).word(0) == 0x000025FF &&
+                      X86_64::far_jump(0, 0x1122334455667788).bytes[6] == 0x88 &&
+                      X86_64::far_jump(0, 0x1122334455667788).bytes[13] == 0x11,
+              "jmp [rip]; .quad");
+static_assert(X86_64::literal_jump(0).word(0) == 0x000225FF && X86_64::literal_jump(0).word(1) == 0xCCCC0000,
+              "jmp [rip + 2]; int3; int3");
+static_assert(X86_64::entry_reachable(0x7FFFFFFB, 0) && !X86_64::entry_reachable(0x7FFFFFFC, 0) &&
+                      !X86_64::entry_reachable(0, 0x90000000),
+              "rel32 range");
+
+static_assert(AArch64::b(0x1000, 0x1000) == 0x14000000u, "b .");
+static_assert(AArch64::b(0x1000, 0x1008) == 0x14000002u, "b #+8");
+static_assert(AArch64::b(0x1000, 0x0FFC) == 0x17FFFFFFu, "b #-4");
+static_assert(AArch64::b(0x8000000, 0x8000000 + 0x7FFFFFC) == 0x15FFFFFFu, "b to the farthest forward target");
+static_assert(AArch64::b(0x8000000, 0) == 0x16000000u, "b to the farthest backward target");
+static_assert(AArch64::branch_reachable(0x8000000, 0) && !AArch64::branch_reachable(0, 0x8000000) &&
+                      !AArch64::branch_reachable(0, 2),
+              "b range and alignment");
+static_assert(AArch64::br(16) == 0xD61F0200u && AArch64::br(17) == 0xD61F0220u, "br x16 / br x17");
+static_assert(AArch64::adrp(16, 0x1000, 0x1FFF) == 0x90000010u, "adrp x16, same page");
+static_assert(AArch64::adrp(0, 0x400000, 0x411000) == 0xB0000080u, "adrp x0, +0x11000");
+static_assert(AArch64::adrp(17, 0x401000, 0x400000) == 0xF0FFFFF1u, "adrp x17, -0x1000");
+static_assert(AArch64::add_imm(16, 16, 0x10) == 0x91004210u, "add x16, x16, #0x10");
+static_assert(AArch64::movz(17, 0x1234, 0) == 0xD2824691u, "movz x17, #0x1234");
+static_assert(AArch64::movk(17, 0xABCD, 16) == 0xF2B579B1u, "movk x17, #0xabcd, lsl #16");
+static_assert(AArch64::movk(17, 0xFFFF, 48) == 0xF2FFFFF1u, "movk x17, #0xffff, lsl #48");
+static_assert(AArch64::ldr_literal(16, 8) == 0x58000050u, "ldr x16, #8");
+static_assert(AArch64::far_jump(0x400000, 0x411234).size == 12 &&
+                      AArch64::far_jump(0x400000, 0x411234).word(0) == 0xB0000091u &&
+                      AArch64::far_jump(0x400000, 0x411234).word(1) == 0x9108D231u &&
+                      AArch64::far_jump(0x400000, 0x411234).word(2) == 0xD61F0220u,
+              "adrp + add + br within 4GB");
+static_assert(AArch64::far_jump(0x7F0000000000, 0x123456789ABC).size == 20 &&
+                      AArch64::far_jump(0x7F0000000000, 0x123456789ABC).word(0) == AArch64::movz(17, 0x9ABC, 0) &&
+                      AArch64::far_jump(0x7F0000000000, 0x123456789ABC).word(1) == AArch64::movk(17, 0x5678, 16) &&
+                      AArch64::far_jump(0x7F0000000000, 0x123456789ABC).word(2) == AArch64::movk(17, 0x1234, 32) &&
+                      AArch64::far_jump(0x7F0000000000, 0x123456789ABC).word(3) == AArch64::movk(17, 0, 48),
+              "movz/movk keep all 64 address bits");
+static_assert(AArch64::literal_jump(0).word(0) == 0x58000050u && AArch64::literal_jump(0).word(1) == 0xD61F0200u,
+              "ldr x16, #8; br x16");
+
+} // namespace arch
+}; // namespace RemoteDebug
@@ -0,0 +1,295 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace RemoteDebug {
+
+namespace {
+
+constexpr const char *stopped_phase = "stopped"; // 目标线程暂停区间，与 RemoteProcess 中一致
+
+uint32_t current_tid()
+{
+    thread_local uint32_t tid = static_cast<uint32_t>(syscall(SYS_gettid));
+    return tid;
+}
+
+std::string microseconds(uint64_t ns)
+{
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%llu.%03llu", static_cast<unsigned long long>(ns / 1000),
+                  static_cast<unsigned long long>(ns % 1000));
+    return buffer;
+}
+
+// 阶段名来自代码，请求名来自客户端，写出前转义
+std::string json_escape(const std::string &text)
+{
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// 请求名来自客户端，只有两种代理认识的命令以静态字符串记录，其余均记为 "invalid"，不随请求分配内存
+const char *request_name(const std::string &command)
+{
+    static constexpr const char *known[] = { "apply", "attach", "detach", "get", "load", "package",
+                                             "ping", "probe", "reclaim", "redirect", "revert", "set",
+                                             "shutdown", "status", "unload", "unprobe", "verify" };
+    for (const char *name : known) {
+        if (command == name) {
+            return name;
+        }
+    }
+    return "invalid";
+}
+
+} // namespace
+
+PhaseTracer &PhaseTracer::instance()
+{
+    static PhaseTracer tracer;
+    return tracer;
+}
+
+uint64_t PhaseTracer::now_ns()
+{
+    return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+                    .count());
+}
+
+void PhaseTracer::record(const TraceEvent &event)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_events.size() < max_events) {
+        m_events.push_back(event);
+    }
+}
+
+void PhaseTracer::record(const char *name, const char *category, uint64_t start_ns, int64_t target)
+{
+    uint64_t now = now_ns();
+    record({ name, category, start_ns, now - start_ns, current_tid(), target });
+}
+
+size_t PhaseTracer::mark()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_events.size();
+}
+
+void PhaseTracer::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_events.clear();
+}
+
+std::string PhaseTracer::summary(const std::string &label, size_t begin)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (begin >= m_events.size()) {
+        return "trace " + label + ": no events";
+    }
+
+    uint64_t first = UINT64_MAX;
+    uint64_t last = 0;
+    uint64_t stopped = 0;
+    std::vector<const TraceEvent *> nested;
+    for (size_t i = begin; i < m_events.size(); ++i) {
+        const TraceEvent &event = m_events[i];
+        first = std::min(first, event.start_ns);
+        last = std::max(last, event.start_ns + event.duration_ns);
+        if (strcmp(event.name, stopped_phase) == 0) {
+            stopped += event.duration_ns;
+        } else {
+            nested.push_back(&event);
+        }
+    }
+
+    // 同一线程上的时间段按开始时间排序后构成嵌套关系，父阶段扣除子阶段的耗时
+    std::sort(nested.begin(), nested.end(), [](const TraceEvent *a, const TraceEvent *b) {
+        if (a->tid != b->tid) {
+            return a->tid < b->tid;
+        }
+        return a->start_ns != b->start_ns ? a->start_ns < b->start_ns : a->duration_ns > b->duration_ns;
+    });
+    std::vector<int64_t> self(nested.size());
+    std::vector<size_t> stack;
+    for (size_t i = 0; i < nested.size(); ++i) {
+        const TraceEvent &event = *nested[i];
+        while (!stack.empty() && (nested[stack.back()]->tid != event.tid ||
+                                  nested[stack.back()]->start_ns + nested[stack.back()]->duration_ns <= event.start_ns)) {
+            stack.pop_back();
+        }
+        self[i] = static_cast<int64_t>(event.duration_ns);
+        if (!stack.empty()) {
+            self[stack.back()] -= static_cast<int64_t>(event.duration_ns);
+        }
+        stack.push_back(i);
+    }
+
+    // 请求本身不计入阶段，阶段按首次出现的时间排列
+    std::map<std::string, std::pair<uint64_t, int64_t>> phases; // 名称 -> (首次出现时间, 自身耗时)
+    for (size_t i = 0; i < nested.size(); ++i) {
+        if (strcmp(nested[i]->category, "request") == 0) {
+            continue;
+        }
+        auto result = phases.emplace(nested[i]->name, std::make_pair(nested[i]->start_ns, 0));
+        auto &phase = result.first->second;
+        phase.first = std::min(phase.first, nested[i]->start_ns);
+        phase.second += std::max<int64_t>(self[i], 0);
+    }
+    std::vector<std::pair<uint64_t, std::string>> sorted;
+    for (const auto &phase : phases) {
+        sorted.emplace_back(phase.second.first, phase.first);
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    std::ostringstream oss;
+    oss << "trace " << label << ": total=" << (last - first) / 1000 << "us stopped=" << stopped / 1000 << "us";
+    for (const auto &entry : sorted) {
+        oss << " " << entry.second << "=" << phases[entry.second].second / 1000 << "us";
+    }
+    return oss.str();
+}
+
+void PhaseTracer::write_json(std::ostream &os)
+{
+    std::vector<TraceEvent> events;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        events = m_events;
+    }
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << getpid()
+       << ",\"args\":{\"name\":\"RemoteDebug\"}}";
+    for (const auto &event : events) {
+        os << ",\n{\"name\":\"" << json_escape(event.name) << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"ts\":"
+           << microseconds(event.start_ns) << ",\"dur\":" << microseconds(event.duration_ns) << ",\"pid\":" << getpid()
+           << ",\"tid\":" << event.tid;
+        if (event.target) {
+            os << ",\"args\":{\"target_pid\":" << event.target << "}";
+        }
+        os << "}";
+    }
+    os << "\n]}\n";
+}
+
+int PhaseTracer::write_json(const std::string &path)
+{
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::trunc);
+        if (!file) {
+            std::cerr << "Failed to write trace " << temp << std::endl;
+            return -1;
+        }
+        write_json(file);
+        if (!file) {
+            return -1;
+        }
+    }
+    // 整体替换，查看时不会读到写了一半的文件
+    return std::rename(temp.c_str(), path.c_str()) == 0 ? 0 : -1;
+}
+
+void TraceSpan::end()
+{
+    if (m_start == 0) {
+        return;
+    }
+    PhaseTracer::instance().record(m_name, m_category, m_start, m_target);
+    m_start = 0;
+}
+
+TraceSession::TraceSession()
+{
+    const char *path = std::getenv("REMOTEDEBUG_TRACE");
+    if (path && *path) {
+        m_output = path;
+        PhaseTracer::instance().enable(true);
+    }
+}
+
+TraceSession::~TraceSession()
+{
+    if (PhaseTracer::instance().enabled() && !m_output.empty()) {
+        PhaseTracer::instance().write_json(m_output);
+    }
+}
+
+std::string TraceSession::control(std::istream &args)
+{
+    PhaseTracer &tracer = PhaseTracer::instance();
+    std::string action;
+    args >> action;
+    if (action.empty()) {
+        return m_last_summary.empty() ? "ERR no traced request" : "OK " + m_last_summary;
+    }
+    if (action == "on") {
+        std::string path;
+        args >> path;
+        m_output = path;
+        tracer.enable(true);
+        return "OK tracing" + (path.empty() ? std::string() : " to " + path);
+    }
+    if (action == "dump") {
+        std::string path;
+        args >> path;
+        if (path.empty()) {
+            path = m_output;
+        }
+        if (path.empty()) {
+            return "ERR no trace file";
+        }
+        return tracer.write_json(path) == 0 ? "OK " + path : "ERR failed to write trace";
+    }
+    if (action == "off") {
+        tracer.enable(false);
+        int ret = m_output.empty() ? 0 : tracer.write_json(m_output);
+        tracer.clear();
+        m_output.clear();
+        return ret == 0 ? "OK" : "ERR failed to write trace";
+    }
+    return "ERR invalid trace request";
+}
+
+std::string TraceSession::run(const std::string &command, const std::function<std::string()> &handler)
+{
+    PhaseTracer &tracer = PhaseTracer::instance();
+    if (!tracer.enabled()) {
+        return handler();
+    }
+
+    const char *name = request_name(command);
+    size_t begin = tracer.mark();
+    std::string reply;
+    {
+        TraceSpan span(name, "request");
+        reply = handler();
+    }
+    m_last_summary = tracer.summary(name, begin);
+    return reply;
+}
+
+}; // namespace RemoteDebug
@@ -0,0 +1,140 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 注入各阶段耗时追踪：记录时间段并导出为 Chrome trace-event JSON（Perfetto 可直接打开）
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace RemoteDebug {
+
+struct TraceEvent {
+    const char *name;        // 阶段名，需为静态字符串，记录时不分配内存
+    const char *category;    // ptrace、patcher、inprocess、request，需为静态字符串
+    uint64_t    start_ns;
+    uint64_t    duration_ns;
+    uint32_t    tid;
+    int64_t     target;      // 目标进程 pid，没有时为 0
+};
+
+/**
+ * @brief 进程级追踪器
+ * @details 未启用时时间段只检查一次原子标志，不读时钟也不加锁。
+ *          事件数达到上限后丢弃新事件，避免常驻进程无限增长
+ */
+class PhaseTracer {
+public:
+    static constexpr size_t max_events = 1 << 20;
+
+    static PhaseTracer &instance();
+
+    void enable(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+    bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    void record(const TraceEvent &event);
+
+    /**
+     * @brief 记录当前线程上从 start_ns 到现在的时间段，用于无法用作用域表示的区间
+     */
+    void record(const char *name, const char *category, uint64_t start_ns, int64_t target = 0);
+
+    /**
+     * @brief 当前事件数，作为 summary 的起点
+     */
+    size_t mark();
+
+    /**
+     * @brief 汇总 begin 之后的事件：同名阶段的自身耗时（扣除嵌套的子阶段）相加，
+     *        并给出目标线程被暂停的总时间
+     * @param[in] label 行首标签，如 "apply"
+     * @return 一行文本，如 "trace apply: total=120us stopped=40us attach=12us ..."
+     */
+    std::string summary(const std::string &label, size_t begin);
+
+    /**
+     * @brief 将全部事件写成 trace-event JSON 文件（覆盖写）
+     * @details 只在持锁期间复制事件，格式化与写文件不阻塞记录
+     * @return 成功返回0，失败返回-1
+     */
+    int write_json(const std::string &path);
+    void write_json(std::ostream &os);
+
+    void clear();
+
+    static uint64_t now_ns();
+
+private:
+    std::atomic<bool>       m_enabled{ false };
+    std::mutex              m_mutex;
+    std::vector<TraceEvent> m_events;
+};
+
+/**
+ * @brief 作用域时间段，析构时记录
+ */
+class TraceSpan {
+public:
+    TraceSpan(const char *name, const char *category, int64_t target = 0)
+        : m_name(name), m_category(category), m_target(target),
+          m_start(PhaseTracer::instance().enabled() ? PhaseTracer::now_ns() : 0) {}
+    ~TraceSpan() { end(); }
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    // 提前结束时间段
+    void end();
+
+private:
+    const char *m_name;
+    const char *m_category;
+    int64_t     m_target;
+    uint64_t    m_start;
+};
+
+/**
+ * @brief 补丁代理的追踪控制，常驻代理与进程内代理共用
+ * @details 设置 REMOTEDEBUG_TRACE=<file> 时启动即开启追踪。追踪开启后每个请求记录为一个
+ *          request 时间段，结束后生成一行汇总。JSON 文件只在 trace dump、trace off 和代理退出时写出，
+ *          请求路径上不写文件
+ */
+class TraceSession {
+public:
+    TraceSession();
+    ~TraceSession();
+    TraceSession(const TraceSession &) = delete;
+    TraceSession &operator=(const TraceSession &) = delete;
+
+    /**
+     * @brief 处理控制请求：
+     *          trace                  返回上一个请求的汇总
+     *          trace on [<file>]      开启追踪，<file> 为之后写出 JSON 的位置
+     *          trace dump [<file>]    将已记录的事件写出 JSON，缺省写到开启时指定的文件
+     *          trace off              写出 JSON 并关闭追踪，已记录的事件被清空
+     * @param[in] args 请求中 trace 之后的部分
+     * @return 回复（不含换行）
+     */
+    std::string control(std::istream &args);
+
+    /**
+     * @brief 执行一个请求，追踪开启时记录并汇总
+     * @param[in] command 请求命令，作为时间段名称，未知命令记为 "invalid"
+     * @param[in] handler 实际处理请求的函数
+     * @return handler 的回复
+     */
+    std::string run(const std::string &command, const std::function<std::string()> &handler);
+
+    const std::string &last_summary() const { return m_last_summary; }
+
+private:
+    std::string m_output;
+    std::string m_last_summary;
+};
+
+}; // namespace RemoteDebug
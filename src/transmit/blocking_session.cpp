@@ -0,0 +1,177 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "blocking_session.h"
+#include "net_util.h"
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace RemoteDebug {
+
+namespace {
+
+/**
+ * @brief 进程内共享的有界线程池，线程按需创建，最多 blocking_session_workers 个
+ * @details 进程退出时等待正在执行的传输结束，传输自身的 IO 超时保证等待有界
+ */
+class WorkerPool {
+public:
+    static WorkerPool &instance()
+    {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_cv.notify_all();
+        for (auto &thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    void submit(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push_back(std::move(job));
+            if (m_idle < m_jobs.size() && m_threads.size() < blocking_session_workers) {
+                m_threads.emplace_back(&WorkerPool::work, this);
+            }
+        }
+        m_cv.notify_one();
+    }
+
+private:
+    WorkerPool() = default;
+
+    void work()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            ++m_idle;
+            m_cv.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+            --m_idle;
+            if (m_jobs.empty()) {
+                return;
+            }
+            std::function<void()> job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            lock.unlock();
+            job();
+            lock.lock();
+        }
+    }
+
+    std::mutex                        m_mutex;
+    std::condition_variable           m_cv;
+    std::deque<std::function<void()>> m_jobs;
+    std::vector<std::thread>          m_threads;
+    size_t                            m_idle{ 0 };
+    bool                              m_stopping{ false };
+};
+
+} // namespace
+
+struct BlockingSession::Job {
+    explicit Job(const Device_info &device_info) : device(device_info) {}
+    ~Job()
+    {
+        if (event_fd >= 0) {
+            ::close(event_fd);
+        }
+    }
+
+    const Device_info               device;
+    std::unique_ptr<RemoteTransmit> transmit;
+    int                             event_fd{ -1 };
+    uint64_t                        file_size{ 0 };
+    int                             result{ -1 };      // finished 为 true 后有效
+    std::atomic<bool>               finished{ false };
+};
+
+BlockingSession::BlockingSession(const Device_info &device_info, TransmitFactory factory)
+    : m_device(device_info), m_factory(std::move(factory))
+{
+}
+
+BlockingSession::~BlockingSession() = default;
+
+SESSION_STATE BlockingSession::start(EventRegistry &registry)
+{
+    m_error.clear();
+    m_bytes_sent = 0;
+
+    // 上一次尝试超时后传输仍在运行（或已结束但结果未取走）时，本次尝试等待并采用它的结果
+    if (!m_job) {
+        auto job = std::make_shared<Job>(m_device);
+        job->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        job->transmit = m_factory();
+        if (job->event_fd < 0 || !job->transmit) {
+            m_error = job->event_fd < 0 ? std::string("eventfd failed: ") + strerror(errno) : "no transmit backend";
+            return SESSION_STATE::FAILED;
+        }
+        struct stat st {};
+        if (stat(m_device.file_name.c_str(), &st) == 0) {
+            job->file_size = static_cast<uint64_t>(st.st_size);
+        }
+        m_job = job;
+        WorkerPool::instance().submit([job] {
+            SigpipeGuard sigpipe_guard;
+            job->result = job->transmit->transmit(job->device);
+            job->transmit.reset();
+            job->finished = true;
+            const uint64_t one = 1;
+            if (write(job->event_fd, &one, sizeof(one)) != sizeof(one)) {
+                std::cerr << "Failed to signal transmit completion: " << strerror(errno) << std::endl;
+            }
+        });
+    }
+
+    if (registry.watch(m_job->event_fd, EPOLLIN) != 0) {
+        m_error = "failed to watch transmit completion";
+        return SESSION_STATE::FAILED;
+    }
+    return SESSION_STATE::RUNNING;
+}
+
+SESSION_STATE BlockingSession::on_event(EventRegistry &registry, int fd, uint32_t)
+{
+    uint64_t count = 0;
+    if (!m_job || fd != m_job->event_fd || read(fd, &count, sizeof(count)) < 0 || !m_job->finished) {
+        return SESSION_STATE::RUNNING;
+    }
+    std::shared_ptr<Job> job = std::move(m_job);
+    registry.unwatch(job->event_fd);
+    if (job->result != 0) {
+        m_error = "transmit failed";
+        return SESSION_STATE::FAILED;
+    }
+    m_bytes_sent = job->file_size;
+    return SESSION_STATE::DONE;
+}
+
+void BlockingSession::close(EventRegistry &registry)
+{
+    // 传输未结束时保留 m_job，下一次尝试继续等待
+    if (m_job) {
+        registry.unwatch(m_job->event_fd);
+    }
+}
+
+}; // namespace RemoteDebug
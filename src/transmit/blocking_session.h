@@ -0,0 +1,54 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 在工作线程中运行同步传输的会话，供 TransmitScheduler 调度尚无非阻塞实现的传输方式
+
+#pragma once
+
+#include "transmit_scheduler.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace RemoteDebug {
+
+constexpr size_t blocking_session_workers = 8; // 全部 BlockingSession 共享的工作线程数
+
+/**
+ * @brief 同步传输会话：RemoteTransmit::transmit 在共享的有界线程池中执行
+ * @details 用于 SSH、Telnet 等只有阻塞实现的传输方式。传输结束后工作线程写 eventfd，
+ *          事件循环据此完成本次尝试，报告与 FtpAsyncSession 经同一个 TransmitReport 输出；
+ *          同步接口不提供阶段耗时，建连与握手耗时记为0。
+ *          尝试超时后阻塞的传输无法中断，下一次尝试等待并采用仍在运行的传输的结果，
+ *          不会对同一设备同时发起两次上传
+ */
+class BlockingSession : public AsyncSession {
+public:
+    using TransmitFactory = std::function<std::unique_ptr<RemoteTransmit>()>;
+
+    /**
+     * @param[in] device_info 设备信息，工作线程使用其副本
+     * @param[in] factory 每次尝试创建一个新的传输对象
+     */
+    BlockingSession(const Device_info &device_info, TransmitFactory factory);
+    ~BlockingSession() override;
+
+    SESSION_STATE start(EventRegistry &registry) override;
+    SESSION_STATE on_event(EventRegistry &registry, int fd, uint32_t events) override;
+    void close(EventRegistry &registry) override;
+
+    const std::string &error() const override { return m_error; }
+    uint64_t bytes_sent() const override { return m_bytes_sent; }
+    std::chrono::microseconds connect_latency() const override { return std::chrono::microseconds(0); }
+    std::chrono::microseconds handshake_latency() const override { return std::chrono::microseconds(0); }
+
+private:
+    struct Job;
+
+    const Device_info &  m_device;
+    TransmitFactory      m_factory;
+    std::shared_ptr<Job> m_job;             // 结果被取走前保留，工作线程同样持有
+    std::string          m_error;
+    uint64_t             m_bytes_sent{ 0 };
+};
+
+}; // namespace RemoteDebug
@@ -0,0 +1,450 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "compress.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+#include <vector>
+
+#ifdef REMOTEDEBUG_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef REMOTEDEBUG_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace RemoteDebug {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t output_buffer_size = 128 * 1024;
+
+#ifdef REMOTEDEBUG_HAVE_ZSTD
+constexpr int zstd_min_level = 1;
+constexpr int zstd_max_level = 19;
+constexpr int zstd_initial_level = 3;
+
+class ZstdCompressor : public StreamCompressor {
+public:
+    ZstdCompressor(ChunkSink sink, bool adaptive)
+        : StreamCompressor(std::move(sink), AdaptiveLevel(zstd_min_level, zstd_max_level, zstd_initial_level), adaptive),
+          m_cctx(ZSTD_createCCtx()), m_buffer(ZSTD_CStreamOutSize())
+    {
+        ZSTD_CCtx_setParameter(m_cctx, ZSTD_c_compressionLevel, zstd_initial_level);
+    }
+
+    ~ZstdCompressor() override { ZSTD_freeCCtx(m_cctx); }
+
+protected:
+    int compress(const void *data, size_t size, bool end_segment) override
+    {
+        ZSTD_inBuffer input{ data, size, 0 };
+        return drive(input, end_segment ? ZSTD_e_flush : ZSTD_e_continue);
+    }
+
+    int end_stream() override
+    {
+        ZSTD_inBuffer input{ nullptr, 0, 0 };
+        return drive(input, ZSTD_e_end);
+    }
+
+    // 单线程模式下级别只能在帧边界修改：先结束当前帧，后续数据以新级别开始新帧
+    int set_level(int level) override
+    {
+        if (end_stream() != 0) {
+            return -1;
+        }
+        return ZSTD_isError(ZSTD_CCtx_setParameter(m_cctx, ZSTD_c_compressionLevel, level)) ? -1 : 0;
+    }
+
+private:
+    int drive(ZSTD_inBuffer &input, ZSTD_EndDirective mode)
+    {
+        size_t remaining;
+        do {
+            ZSTD_outBuffer output{ m_buffer.data(), m_buffer.size(), 0 };
+            remaining = ZSTD_compressStream2(m_cctx, &output, &input, mode);
+            if (ZSTD_isError(remaining)) {
+                std::cerr << "zstd compress failed: " << ZSTD_getErrorName(remaining) << std::endl;
+                return -1;
+            }
+            if (output.pos > 0 && emit(m_buffer.data(), output.pos) != 0) {
+                return -1;
+            }
+        } while (mode == ZSTD_e_continue ? input.pos < input.size : remaining != 0);
+        return 0;
+    }
+
+    ZSTD_CCtx           *m_cctx;
+    std::vector<uint8_t> m_buffer;
+};
+#endif
+
+#ifdef REMOTEDEBUG_HAVE_ZLIB
+constexpr int zlib_min_level = 1;
+constexpr int zlib_max_level = 9;
+constexpr int zlib_initial_level = 3;
+
+class ZlibCompressor : public StreamCompressor {
+public:
+    ZlibCompressor(ChunkSink sink, bool adaptive)
+        : StreamCompressor(std::move(sink), AdaptiveLevel(zlib_min_level, zlib_max_level, zlib_initial_level), adaptive),
+          m_buffer(output_buffer_size)
+    {
+        deflateInit(&m_stream, zlib_initial_level);
+    }
+
+    ~ZlibCompressor() override { deflateEnd(&m_stream); }
+
+protected:
+    int compress(const void *data, size_t size, bool end_segment) override
+    {
+        m_stream.next_in = static_cast<Bytef *>(const_cast<void *>(data));
+        m_stream.avail_in = static_cast<uInt>(size);
+        return drive(end_segment ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+    }
+
+    int end_stream() override
+    {
+        m_stream.next_in = nullptr;
+        m_stream.avail_in = 0;
+        return drive(Z_FINISH);
+    }
+
+    // deflateParams 可在流中途修改级别，分段结束时已 SYNC_FLUSH，无待输出数据
+    int set_level(int level) override
+    {
+        int ret;
+        do {
+            m_stream.next_out = m_buffer.data();
+            m_stream.avail_out = static_cast<uInt>(m_buffer.size());
+            ret = deflateParams(&m_stream, level, Z_DEFAULT_STRATEGY);
+            if (emit_output() != 0) {
+                return -1;
+            }
+        } while (ret == Z_BUF_ERROR && m_stream.avail_out == 0);
+        return ret == Z_OK || ret == Z_BUF_ERROR ? 0 : -1;
+    }
+
+private:
+    int drive(int flush)
+    {
+        int ret;
+        do {
+            m_stream.next_out = m_buffer.data();
+            m_stream.avail_out = static_cast<uInt>(m_buffer.size());
+            ret = deflate(&m_stream, flush);
+            if (ret == Z_STREAM_ERROR) {
+                std::cerr << "zlib deflate failed" << std::endl;
+                return -1;
+            }
+            if (emit_output() != 0) {
+                return -1;
+            }
+        } while (m_stream.avail_in > 0 || m_stream.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+        return 0;
+    }
+
+    int emit_output()
+    {
+        size_t produced = m_buffer.size() - m_stream.avail_out;
+        return produced > 0 ? emit(m_buffer.data(), produced) : 0;
+    }
+
+    z_stream             m_stream{};
+    std::vector<uint8_t> m_buffer;
+};
+#endif
+
+bool is_zstd_header(const uint8_t *data)
+{
+    return data[0] == 0x28 && data[1] == 0xB5 && data[2] == 0x2F && data[3] == 0xFD;
+}
+
+bool is_zlib_header(const uint8_t *data)
+{
+    return (data[0] == 0x1F && data[1] == 0x8B) || ((data[0] & 0x0F) == 8 && ((data[0] << 8) | data[1]) % 31 == 0);
+}
+
+} // namespace
+
+int AdaptiveLevel::update(std::chrono::nanoseconds compress_time, std::chrono::nanoseconds sink_time)
+{
+    if (sink_time > compress_time * 2 && m_level < m_max) {
+        ++m_level; // 链路是瓶颈，用 CPU 换压缩率
+    } else if (compress_time > sink_time && m_level > m_min) {
+        --m_level; // CPU 是瓶颈，降低级别
+    }
+    return m_level;
+}
+
+std::unique_ptr<StreamCompressor> StreamCompressor::create(COMPRESS_TYPE type, ChunkSink sink, bool adaptive)
+{
+    switch (type) {
+#ifdef REMOTEDEBUG_HAVE_ZSTD
+        case COMPRESS_TYPE::ZSTD:
+            return std::unique_ptr<StreamCompressor>(new ZstdCompressor(std::move(sink), adaptive));
+#endif
+#ifdef REMOTEDEBUG_HAVE_ZLIB
+        case COMPRESS_TYPE::ZLIB:
+            return std::unique_ptr<StreamCompressor>(new ZlibCompressor(std::move(sink), adaptive));
+#endif
+        default:
+            (void)sink;
+            (void)adaptive;
+            return nullptr;
+    }
+}
+
+COMPRESS_TYPE StreamCompressor::preferred_type()
+{
+#if defined(REMOTEDEBUG_HAVE_ZSTD)
+    return COMPRESS_TYPE::ZSTD;
+#elif defined(REMOTEDEBUG_HAVE_ZLIB)
+    return COMPRESS_TYPE::ZLIB;
+#else
+    return COMPRESS_TYPE::NONE;
+#endif
+}
+
+int StreamCompressor::write(const void *data, size_t size)
+{
+    const uint8_t *ptr = static_cast<const uint8_t *>(data);
+    while (size > 0) {
+        if (m_segment_bytes == 0) {
+            m_segment_start = Clock::now();
+        }
+        size_t chunk = std::min(size, segment_size - m_segment_bytes);
+        m_segment_bytes += chunk;
+        bool end_segment = m_segment_bytes == segment_size ||
+                           (m_segment_bytes >= min_segment_size && Clock::now() - m_segment_start >= segment_interval);
+
+        // 压缩耗时需扣除其中等待通道写入的时间
+        auto start = Clock::now();
+        auto sink_before = m_sink_time;
+        if (compress(ptr, chunk, end_segment) != 0) {
+            return -1;
+        }
+        m_compress_time += (Clock::now() - start) - (m_sink_time - sink_before);
+        ptr += chunk;
+        size -= chunk;
+        m_input_bytes += chunk;
+
+        if (end_segment) {
+            int old_level = m_adaptive.level();
+            if (m_enable_adaptive && m_adaptive.update(m_compress_time, m_sink_time) != old_level &&
+                set_level(m_adaptive.level()) != 0) {
+                return -1;
+            }
+            m_segment_bytes = 0;
+            m_compress_time = std::chrono::nanoseconds(0);
+            m_sink_time = std::chrono::nanoseconds(0);
+        }
+    }
+    return 0;
+}
+
+int StreamCompressor::finish()
+{
+    return end_stream();
+}
+
+int StreamCompressor::emit(const void *data, size_t size)
+{
+    auto start = Clock::now();
+    int ret = m_sink(data, size);
+    m_sink_time += Clock::now() - start;
+    m_output_bytes += size;
+    return ret;
+}
+
+struct StreamDecompressor::Impl {
+    explicit Impl(ChunkSink output) : sink(std::move(output)), buffer(output_buffer_size) {}
+
+    ~Impl()
+    {
+#ifdef REMOTEDEBUG_HAVE_ZSTD
+        if (dctx) {
+            ZSTD_freeDCtx(dctx);
+        }
+#endif
+#ifdef REMOTEDEBUG_HAVE_ZLIB
+        if (type == COMPRESS_TYPE::ZLIB) {
+            inflateEnd(&stream);
+        }
+#endif
+    }
+
+    // 根据前 4 字节识别压缩算法
+    int detect()
+    {
+        if (is_zstd_header(header.data())) {
+#ifdef REMOTEDEBUG_HAVE_ZSTD
+            dctx = ZSTD_createDCtx();
+            type = COMPRESS_TYPE::ZSTD;
+            return 0;
+#endif
+        } else if (is_zlib_header(header.data())) {
+#ifdef REMOTEDEBUG_HAVE_ZLIB
+            inflateInit2(&stream, 15 + 32); // 自动识别 zlib / gzip 头
+            type = COMPRESS_TYPE::ZLIB;
+            return 0;
+#endif
+        }
+        std::cerr << "Unsupported compressed stream" << std::endl;
+        return -1;
+    }
+
+    int feed(const uint8_t *data, size_t size)
+    {
+#ifdef REMOTEDEBUG_HAVE_ZSTD
+        if (type == COMPRESS_TYPE::ZSTD) {
+            ZSTD_inBuffer input{ data, size, 0 };
+            while (input.pos < input.size) {
+                ZSTD_outBuffer output{ buffer.data(), buffer.size(), 0 };
+                frame_remaining = ZSTD_decompressStream(dctx, &output, &input);
+                if (ZSTD_isError(frame_remaining)) {
+                    std::cerr << "zstd decompress failed: " << ZSTD_getErrorName(frame_remaining) << std::endl;
+                    return -1;
+                }
+                if (output.pos > 0 && sink(buffer.data(), output.pos) != 0) {
+                    return -1;
+                }
+            }
+            return 0;
+        }
+#endif
+#ifdef REMOTEDEBUG_HAVE_ZLIB
+        if (type == COMPRESS_TYPE::ZLIB) {
+            stream.next_in = const_cast<Bytef *>(data);
+            stream.avail_in = static_cast<uInt>(size);
+            while (!stream_end && (stream.avail_in > 0)) {
+                stream.next_out = buffer.data();
+                stream.avail_out = static_cast<uInt>(buffer.size());
+                int ret = inflate(&stream, Z_NO_FLUSH);
+                if (ret != Z_OK && ret != Z_STREAM_END) {
+                    std::cerr << "zlib inflate failed: " << ret << std::endl;
+                    return -1;
+                }
+                stream_end = ret == Z_STREAM_END;
+                size_t produced = buffer.size() - stream.avail_out;
+                if (produced > 0 && sink(buffer.data(), produced) != 0) {
+                    return -1;
+                }
+            }
+            return 0;
+        }
+#endif
+        (void)data;
+        (void)size;
+        return -1;
+    }
+
+    bool complete() const
+    {
+        switch (type) {
+            case COMPRESS_TYPE::ZSTD:
+                return frame_remaining == 0;
+            case COMPRESS_TYPE::ZLIB:
+                return stream_end;
+            default:
+                return false;
+        }
+    }
+
+    ChunkSink            sink;
+    std::vector<uint8_t> buffer;
+    std::vector<uint8_t> header;
+    COMPRESS_TYPE        type{ COMPRESS_TYPE::NONE };
+    size_t               frame_remaining{ 1 };
+    bool                 stream_end{ false };
+#ifdef REMOTEDEBUG_HAVE_ZSTD
+    ZSTD_DCtx *dctx{ nullptr };
+#endif
+#ifdef REMOTEDEBUG_HAVE_ZLIB
+    z_stream stream{};
+#endif
+};
+
+StreamDecompressor::StreamDecompressor(ChunkSink sink) : m_impl(new Impl(std::move(sink))) {}
+
+StreamDecompressor::~StreamDecompressor() = default;
+
+int StreamDecompressor::write(const void *data, size_t size)
+{
+    const uint8_t *ptr = static_cast<const uint8_t *>(data);
+    if (m_impl->type == COMPRESS_TYPE::NONE) {
+        // 攒够 4 字节头部后识别算法，再将已缓存的数据送入解压
+        size_t take = std::min<size_t>(4 - m_impl->header.size(), size);
+        m_impl->header.insert(m_impl->header.end(), ptr, ptr + take);
+        ptr += take;
+        size -= take;
+        if (m_impl->header.size() < 4) {
+            return 0;
+        }
+        if (m_impl->detect() != 0 || m_impl->feed(m_impl->header.data(), m_impl->header.size()) != 0) {
+            return -1;
+        }
+    }
+    return size > 0 ? m_impl->feed(ptr, size) : 0;
+}
+
+int StreamDecompressor::finish()
+{
+    if (!m_impl->complete()) {
+        std::cerr << "Compressed stream truncated" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+int decompress_to_file(int input_fd, const std::string &path)
+{
+    const std::string part_path = path + ".part";
+    int fd = open(part_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0755);
+    if (fd < 0) {
+        std::cerr << "Failed to create " << part_path << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    StreamDecompressor decompressor([fd](const void *data, size_t size) {
+        return write(fd, data, size) == static_cast<ssize_t>(size) ? 0 : -1;
+    });
+
+    int ret = 0;
+    std::vector<uint8_t> buffer(output_buffer_size);
+    while (true) {
+        ssize_t n = read(input_fd, buffer.data(), buffer.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            ret = n < 0 ? -1 : decompressor.finish();
+            break;
+        }
+        if (decompressor.write(buffer.data(), static_cast<size_t>(n)) != 0) {
+            ret = -1;
+            break;
+        }
+    }
+
+    if (ret == 0 && fsync(fd) != 0) {
+        ret = -1;
+    }
+    close(fd);
+    if (ret != 0 || std::rename(part_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to decompress into " << path << std::endl;
+        std::remove(part_path.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+}; // namespace RemoteDebug
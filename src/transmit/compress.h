@@ -0,0 +1,137 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 传输流水线中的流式压缩：文件读取 -> 压缩 -> 通道写入，设备侧由解压 sink 还原
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace RemoteDebug {
+
+enum class COMPRESS_TYPE {
+    ZSTD,
+    ZLIB,
+    NONE
+};
+
+// 压缩数据输出回调，返回0表示成功
+using ChunkSink = std::function<int(const void *data, size_t size)>;
+
+/**
+ * @brief 根据链路带宽与压缩 CPU 耗时自适应调整压缩级别
+ * @details 每个分段结束后比较“等待通道写入”与“压缩计算”的耗时：
+ *          链路是瓶颈（写入耗时明显更长）时提高级别换取压缩率，
+ *          CPU 是瓶颈时降低级别，避免局域网传输被压缩拖慢
+ */
+class AdaptiveLevel {
+public:
+    AdaptiveLevel(int min_level, int max_level, int initial_level)
+        : m_min(min_level), m_max(max_level), m_level(initial_level) {}
+
+    /**
+     * @brief 提交一个分段的耗时统计
+     * @return 返回下一分段使用的压缩级别
+     */
+    int update(std::chrono::nanoseconds compress_time, std::chrono::nanoseconds sink_time);
+
+    int level() const { return m_level; }
+
+private:
+    int m_min;
+    int m_max;
+    int m_level;
+};
+
+/**
+ * @brief 流式压缩器，按分段统计耗时并调整级别
+ */
+class StreamCompressor {
+public:
+    // 每 256KB 原始数据评估一次压缩级别；链路很慢时分段耗时过长，
+    // 超过 segment_interval 且已有 min_segment_size 数据时提前结束分段，小文件同样能调整级别
+    static constexpr size_t                    segment_size = 256 * 1024;
+    static constexpr size_t                    min_segment_size = 64 * 1024;
+    static constexpr std::chrono::milliseconds segment_interval{ 100 };
+
+    /**
+     * @brief 创建压缩器
+     * @param[in] type 压缩算法，编译时未启用的算法返回 nullptr
+     * @param[in] sink 压缩数据输出
+     * @param[in] adaptive 是否自适应调整级别
+     */
+    static std::unique_ptr<StreamCompressor> create(COMPRESS_TYPE type, ChunkSink sink, bool adaptive = true);
+
+    /**
+     * @brief 编译时启用的首选压缩算法，均未启用时返回 NONE
+     */
+    static COMPRESS_TYPE preferred_type();
+
+    virtual ~StreamCompressor() = default;
+
+    /**
+     * @brief 压缩一段数据并输出
+     * @return 成功返回0，失败返回-1
+     */
+    int write(const void *data, size_t size);
+
+    /**
+     * @brief 结束压缩流，输出剩余数据
+     */
+    int finish();
+
+    int level() const { return m_adaptive.level(); }
+    uint64_t input_bytes() const { return m_input_bytes; }
+    uint64_t output_bytes() const { return m_output_bytes; }
+
+protected:
+    StreamCompressor(ChunkSink sink, AdaptiveLevel adaptive, bool enable_adaptive)
+        : m_sink(std::move(sink)), m_adaptive(adaptive), m_enable_adaptive(enable_adaptive) {}
+
+    virtual int compress(const void *data, size_t size, bool end_segment) = 0;
+    virtual int end_stream() = 0;
+    virtual int set_level(int level) = 0;
+
+    // 供具体算法输出压缩数据，同时统计通道写入耗时
+    int emit(const void *data, size_t size);
+
+private:
+    ChunkSink                             m_sink;
+    AdaptiveLevel                         m_adaptive;
+    bool                                  m_enable_adaptive;
+    size_t                                m_segment_bytes{ 0 };
+    std::chrono::steady_clock::time_point m_segment_start;
+    std::chrono::nanoseconds              m_compress_time{ 0 };
+    std::chrono::nanoseconds              m_sink_time{ 0 };
+    uint64_t                              m_input_bytes{ 0 };
+    uint64_t                              m_output_bytes{ 0 };
+};
+
+/**
+ * @brief 流式解压器：根据流头部自动识别 zstd / zlib
+ */
+class StreamDecompressor {
+public:
+    explicit StreamDecompressor(ChunkSink sink);
+    ~StreamDecompressor();
+    StreamDecompressor(const StreamDecompressor &) = delete;
+    StreamDecompressor &operator=(const StreamDecompressor &) = delete;
+
+    int write(const void *data, size_t size);
+    int finish();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+/**
+ * @brief 设备侧：从 fd 读取压缩流，解压写入文件（先写 .part 再重命名）
+ * @return 成功返回0，失败返回-1
+ */
+int decompress_to_file(int input_fd, const std::string &path);
+
+}; // namespace RemoteDebug
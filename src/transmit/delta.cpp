@@ -0,0 +1,632 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "delta.h"
+#include "hash.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RemoteDebug {
+
+namespace {
+
+constexpr char     delta_magic[4] = { 'R', 'D', 'D', 'L' };
+constexpr uint32_t delta_version = 1;
+constexpr uint8_t  op_end = 0;
+constexpr uint8_t  op_copy = 1;    // u64 源偏移, u64 目标偏移, u64 长度
+constexpr uint8_t  op_literal = 2; // u64 目标偏移, u32 长度, 数据
+constexpr size_t   copy_buffer_size = 256 * 1024;
+
+// rsync 滚动校验和：a = Σx, b = Σ(len - i)·x，各取低 16 位
+class RollingChecksum {
+public:
+    void reset(const uint8_t *data, uint32_t size)
+    {
+        m_a = 0;
+        m_b = 0;
+        m_size = size;
+        for (uint32_t i = 0; i < size; ++i) {
+            m_a += data[i];
+            m_b += (size - i) * data[i];
+        }
+    }
+
+    void roll(uint8_t out, uint8_t in)
+    {
+        m_a += in - out;
+        m_b += m_a - m_size * out;
+    }
+
+    uint32_t digest() const { return (m_a & 0xFFFF) | (m_b << 16); }
+
+private:
+    uint32_t m_a{ 0 };
+    uint32_t m_b{ 0 };
+    uint32_t m_size{ 0 };
+};
+
+uint32_t weak_checksum(const uint8_t *data, uint32_t size)
+{
+    RollingChecksum rolling;
+    rolling.reset(data, size);
+    return rolling.digest();
+}
+
+// 只读映射整个文件，空文件返回 nullptr 且 size 为0
+class MappedFile {
+public:
+    bool open(const std::string &path)
+    {
+        m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (m_fd < 0) {
+            return false;
+        }
+        struct stat st{};
+        if (fstat(m_fd, &st) != 0) {
+            return false;
+        }
+        m_size = static_cast<size_t>(st.st_size);
+        if (m_size == 0) {
+            return true;
+        }
+        void *addr = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+        if (addr == MAP_FAILED) {
+            return false;
+        }
+        m_data = static_cast<const uint8_t *>(addr);
+        return true;
+    }
+
+    ~MappedFile()
+    {
+        if (m_data) {
+            munmap(const_cast<uint8_t *>(m_data), m_size);
+        }
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+    }
+
+    const uint8_t *data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    int            m_fd{ -1 };
+    const uint8_t *m_data{ nullptr };
+    size_t         m_size{ 0 };
+};
+
+void put_u32(std::string &out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+void put_u64(std::string &out, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+uint64_t get_le(const uint8_t *ptr, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i) {
+        value = (value << 8) | ptr[i];
+    }
+    return value;
+}
+
+// 增量指令写出器：块引用与字面数据均携带显式的目标偏移
+class DeltaWriter {
+public:
+    explicit DeltaWriter(FILE *file) : m_file(file) {}
+
+    void raw(const std::string &bytes) { m_buffer += bytes; }
+
+    void copy(uint64_t src, uint64_t dst, uint64_t len)
+    {
+        m_buffer.push_back(static_cast<char>(op_copy));
+        put_u64(m_buffer, src);
+        put_u64(m_buffer, dst);
+        put_u64(m_buffer, len);
+        if (m_buffer.size() >= copy_buffer_size) {
+            flush_buffer();
+        }
+    }
+
+    void literal(uint64_t dst, const uint8_t *data, uint64_t len)
+    {
+        while (len > 0) {
+            uint32_t chunk = static_cast<uint32_t>(std::min<uint64_t>(len, copy_buffer_size));
+            m_buffer.push_back(static_cast<char>(op_literal));
+            put_u64(m_buffer, dst);
+            put_u32(m_buffer, chunk);
+            m_buffer.append(reinterpret_cast<const char *>(data), chunk);
+            flush_buffer();
+            data += chunk;
+            dst += chunk;
+            len -= chunk;
+        }
+    }
+
+    bool finish()
+    {
+        m_buffer.push_back(static_cast<char>(op_end));
+        flush_buffer();
+        return !m_failed;
+    }
+
+private:
+    void flush_buffer()
+    {
+        if (!m_buffer.empty() && fwrite(m_buffer.data(), 1, m_buffer.size(), m_file) != m_buffer.size()) {
+            m_failed = true;
+        }
+        m_buffer.clear();
+    }
+
+    FILE       *m_file;
+    std::string m_buffer;
+    bool        m_failed{ false };
+};
+
+// 按弱校验和排序的块索引，配合位图快速排除不可能命中的位置
+class BlockIndex {
+public:
+    explicit BlockIndex(const FileSignature &signature) : m_signature(signature), m_filter(filter_bits / 64, 0)
+    {
+        m_entries.reserve(signature.blocks.size());
+        for (uint32_t i = 0; i < signature.blocks.size(); ++i) {
+            m_entries.push_back({ signature.blocks[i].weak, i });
+            uint32_t bit = filter_hash(signature.blocks[i].weak);
+            m_filter[bit / 64] |= 1ULL << (bit % 64);
+        }
+        std::sort(m_entries.begin(), m_entries.end(), [](const Entry &lhs, const Entry &rhs) {
+            return lhs.weak != rhs.weak ? lhs.weak < rhs.weak : lhs.block < rhs.block;
+        });
+    }
+
+    /**
+     * @brief 查找与当前位置内容相同的块
+     * @param[in] preferred 优先选择的块号（延续上一段连续引用）
+     * @return 返回块号，未命中返回 UINT32_MAX
+     */
+    uint32_t find(uint32_t weak, const uint8_t *data, uint64_t position, uint32_t preferred) const
+    {
+        uint32_t bit = filter_hash(weak);
+        if (!(m_filter[bit / 64] & (1ULL << (bit % 64)))) {
+            return UINT32_MAX;
+        }
+
+        auto it = std::lower_bound(m_entries.begin(), m_entries.end(), weak,
+                                   [](const Entry &entry, uint32_t value) { return entry.weak < value; });
+        uint32_t found = UINT32_MAX;
+        uint64_t strong = 0;
+        bool strong_ready = false;
+        for (; it != m_entries.end() && it->weak == weak; ++it) {
+            if (!strong_ready) {
+                strong = xxh64(data, m_signature.block_size);
+                strong_ready = true;
+            }
+            if (m_signature.blocks[it->block].strong != strong) {
+                continue;
+            }
+            // 同一偏移的块设备侧无需任何写入，其次延续上一段引用以便合并
+            if (static_cast<uint64_t>(it->block) * m_signature.block_size == position) {
+                return it->block;
+            }
+            if (found == UINT32_MAX || it->block == preferred) {
+                found = it->block;
+            }
+        }
+        return found;
+    }
+
+private:
+    static constexpr uint32_t filter_bits = 1 << 20;
+
+    struct Entry {
+        uint32_t weak;
+        uint32_t block;
+    };
+
+    static uint32_t filter_hash(uint32_t weak) { return (weak * 2654435761U) >> 12; }
+
+    const FileSignature  &m_signature;
+    std::vector<uint64_t> m_filter;
+    std::vector<Entry>    m_entries;
+};
+
+struct CopyCommand {
+    uint64_t src;
+    uint64_t dst;
+    uint64_t len;
+};
+
+struct LiteralRange {
+    uint64_t dst;
+    uint64_t len;
+};
+
+/**
+ * @brief 为原地重建安排块引用的执行顺序
+ * @details 若引用 i 的源区间与引用 j 的目标区间重叠，则 i 必须先于 j 执行（读在写之前）。
+ *          按该依赖做拓扑排序，遇到环时把环上最短的引用转为字面数据（字面数据在全部引用之后写入）
+ * @param[in,out] copies 输入全部引用，输出按执行顺序排列的引用
+ * @param[out] literals 追加由引用转换而来的字面区间
+ */
+void schedule_inplace(std::vector<CopyCommand> &copies, std::vector<LiteralRange> &literals)
+{
+    const size_t count = copies.size();
+    std::vector<size_t> by_dst(count);
+    for (size_t i = 0; i < count; ++i) {
+        by_dst[i] = i;
+    }
+    std::sort(by_dst.begin(), by_dst.end(), [&](size_t l, size_t r) { return copies[l].dst < copies[r].dst; });
+
+    // 目标区间互不重叠，按目标偏移二分即可找到与源区间重叠的引用
+    std::vector<std::vector<size_t>> successors(count);
+    std::vector<size_t> indegree(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t src_end = copies[i].src + copies[i].len;
+        auto it = std::lower_bound(by_dst.begin(), by_dst.end(), copies[i].src,
+                                   [&](size_t j, uint64_t src) { return copies[j].dst + copies[j].len <= src; });
+        for (; it != by_dst.end() && copies[*it].dst < src_end; ++it) {
+            if (*it != i) {
+                successors[i].push_back(*it);
+                ++indegree[*it];
+            }
+        }
+    }
+
+    std::vector<size_t> ready;
+    for (size_t i = 0; i < count; ++i) {
+        if (indegree[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+
+    std::vector<bool> done(count, false);
+    std::vector<CopyCommand> ordered;
+    ordered.reserve(count);
+    auto release = [&](size_t node) {
+        done[node] = true;
+        for (size_t next : successors[node]) {
+            if (!done[next] && --indegree[next] == 0) {
+                ready.push_back(next);
+            }
+        }
+    };
+
+    size_t remaining = count;
+    while (remaining > 0) {
+        if (ready.empty()) {
+            // 存在环：转换剩余节点中最短的引用
+            size_t victim = count;
+            for (size_t i = 0; i < count; ++i) {
+                if (!done[i] && (victim == count || copies[i].len < copies[victim].len)) {
+                    victim = i;
+                }
+            }
+            // 转换后的节点不再读取源区间，其目标区间随字面数据最后写入
+            literals.push_back({ copies[victim].dst, copies[victim].len });
+            release(victim);
+            --remaining;
+            continue;
+        }
+
+        size_t node = ready.back();
+        ready.pop_back();
+        if (done[node]) {
+            continue;
+        }
+        ordered.push_back(copies[node]);
+        release(node);
+        --remaining;
+    }
+    copies.swap(ordered);
+}
+
+// 同一文件内复制，源与目标重叠且源在前时从尾部向前复制
+bool copy_range(int fd, uint64_t src, uint64_t dst, uint64_t len, std::vector<uint8_t> &buffer)
+{
+    const bool backward = src < dst && dst < src + len;
+    for (uint64_t done = 0; done < len;) {
+        uint64_t chunk = std::min<uint64_t>(len - done, buffer.size());
+        uint64_t offset = backward ? len - done - chunk : done;
+        if (pread(fd, buffer.data(), chunk, static_cast<off_t>(src + offset)) != static_cast<ssize_t>(chunk) ||
+            pwrite(fd, buffer.data(), chunk, static_cast<off_t>(dst + offset)) != static_cast<ssize_t>(chunk)) {
+            return false;
+        }
+        done += chunk;
+    }
+    return true;
+}
+
+// 解析固定长度的十六进制字段，含非十六进制字符时失败而不是抛出异常
+template <typename T>
+bool parse_hex(const char *text, size_t length, T &value)
+{
+    const auto result = std::from_chars(text, text + length, value, 16);
+    return result.ec == std::errc() && result.ptr == text + length;
+}
+
+} // namespace
+
+uint32_t choose_block_size(uint64_t file_size)
+{
+    uint64_t block = static_cast<uint64_t>(std::sqrt(static_cast<double>(file_size)));
+    block = (block + 7) & ~7ULL;
+    return static_cast<uint32_t>(std::clamp<uint64_t>(block, delta_min_block_size, delta_max_block_size));
+}
+
+int compute_signature(const std::string &path, uint32_t block_size, FileSignature &signature)
+{
+    if (block_size == 0) {
+        std::cerr << "Invalid delta block size" << std::endl;
+        return -1;
+    }
+
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Failed to open " << path << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    signature.block_size = block_size;
+    signature.file_size = file.size();
+    signature.blocks.clear();
+    for (size_t offset = 0; offset + block_size <= file.size(); offset += block_size) {
+        const uint8_t *block = file.data() + offset;
+        signature.blocks.push_back({ weak_checksum(block, block_size), xxh64(block, block_size) });
+    }
+    return 0;
+}
+
+std::string encode_signature(const FileSignature &signature)
+{
+    // 首行：RDSIG <版本> <块大小> <文件大小> <块数>，随后每块 8+16 个十六进制字符
+    std::string text = "RDSIG 1 " + std::to_string(signature.block_size) + " " +
+        std::to_string(signature.file_size) + " " + std::to_string(signature.blocks.size()) + "\n";
+    text.reserve(text.size() + signature.blocks.size() * 24 + 1);
+
+    char buffer[32];
+    for (const auto &block : signature.blocks) {
+        std::snprintf(buffer, sizeof(buffer), "%08x%016llx", block.weak,
+                      static_cast<unsigned long long>(block.strong));
+        text += buffer;
+    }
+    text += "\n";
+    return text;
+}
+
+int decode_signature(const std::string &text, FileSignature &signature)
+{
+    // 远端命令输出中可能混有登录提示等前导内容，签名从 RDSIG 开始
+    size_t start = text.find("RDSIG ");
+    unsigned version = 0;
+    unsigned long long file_size = 0;
+    unsigned long count = 0;
+    int header_len = 0;
+    if (start == std::string::npos ||
+        std::sscanf(text.c_str() + start, "RDSIG %u %u %llu %lu\n%n", &version, &signature.block_size, &file_size,
+                    &count, &header_len) != 4 || version != 1 || signature.block_size == 0 || header_len == 0) {
+        std::cerr << "Malformed delta signature" << std::endl;
+        return -1;
+    }
+
+    // 块数来自设备输出，先与剩余长度比较再分配，避免乘法溢出
+    size_t pos = start + static_cast<size_t>(header_len);
+    if (count > (text.size() - pos) / 24) {
+        std::cerr << "Truncated delta signature" << std::endl;
+        return -1;
+    }
+
+    std::vector<BlockSignature> blocks(count);
+    for (auto &block : blocks) {
+        uint32_t weak = 0;
+        uint64_t strong = 0;
+        const char *field = text.data() + pos;
+        if (!parse_hex(field, 8, weak) || !parse_hex(field + 8, 16, strong)) {
+            std::cerr << "Malformed delta signature block at offset " << pos << std::endl;
+            return -1;
+        }
+        block.weak = weak;
+        block.strong = strong;
+        pos += 24;
+    }
+    signature.file_size = file_size;
+    signature.blocks = std::move(blocks);
+    return 0;
+}
+
+int compute_delta(const FileSignature &signature, const std::string &target_path,
+        const std::string &delta_path, DeltaStats *stats)
+{
+    MappedFile target;
+    if (!target.open(target_path)) {
+        std::cerr << "Failed to open " << target_path << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    const uint8_t *data = target.data();
+    const size_t size = target.size();
+    const uint32_t block_size = signature.block_size;
+
+    // 1. 滚动匹配，收集块引用与字面区间（同偏移的引用无需发送）
+    DeltaStats local_stats;
+    std::vector<CopyCommand> copies;
+    std::vector<LiteralRange> literals;
+    auto add_literal = [&](uint64_t begin, uint64_t end) {
+        if (end > begin) {
+            literals.push_back({ begin, end - begin });
+        }
+    };
+
+    BlockIndex index(signature);
+    RollingChecksum rolling;
+    size_t literal_start = 0;
+    size_t pos = 0;
+    uint32_t preferred = UINT32_MAX;
+    if (!signature.blocks.empty() && size >= block_size) {
+        rolling.reset(data, block_size);
+        while (pos + block_size <= size) {
+            uint32_t block = index.find(rolling.digest(), data + pos, pos, preferred);
+            if (block != UINT32_MAX) {
+                add_literal(literal_start, pos);
+                const uint64_t src = static_cast<uint64_t>(block) * block_size;
+                if (src != pos) {
+                    CopyCommand *last = copies.empty() ? nullptr : &copies.back();
+                    if (last && last->src + last->len == src && last->dst + last->len == pos) {
+                        last->len += block_size;
+                    } else {
+                        copies.push_back({ src, pos, block_size });
+                    }
+                }
+                local_stats.copied_bytes += block_size;
+                preferred = block + 1;
+                pos += block_size;
+                literal_start = pos;
+                if (pos + block_size <= size) {
+                    rolling.reset(data + pos, block_size);
+                }
+                continue;
+            }
+            if (pos + block_size < size) {
+                rolling.roll(data[pos], data[pos + block_size]);
+            }
+            ++pos;
+        }
+    }
+    add_literal(literal_start, size);
+
+    // 2. 安排原地重建顺序，环上的引用转为字面数据
+    schedule_inplace(copies, literals);
+
+    // 3. 写出：头部、块引用（按执行顺序）、字面数据
+    FILE *out = std::fopen(delta_path.c_str(), "wb");
+    if (!out) {
+        std::cerr << "Failed to create " << delta_path << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    DeltaWriter writer(out);
+    std::string header(delta_magic, sizeof(delta_magic));
+    put_u32(header, delta_version);
+    put_u64(header, size);
+    put_u64(header, xxh64(data, size));
+    writer.raw(header);
+
+    for (const auto &copy : copies) {
+        writer.copy(copy.src, copy.dst, copy.len);
+    }
+    for (const auto &literal : literals) {
+        writer.literal(literal.dst, data + literal.dst, literal.len);
+        local_stats.literal_bytes += literal.len;
+    }
+    local_stats.copied_bytes = size - local_stats.literal_bytes;
+
+    bool ok = writer.finish();
+    local_stats.delta_size = static_cast<uint64_t>(std::ftell(out));
+    ok = std::fclose(out) == 0 && ok;
+    if (!ok) {
+        std::cerr << "Failed to write " << delta_path << std::endl;
+        return -1;
+    }
+    if (stats) {
+        *stats = local_stats;
+    }
+    return 0;
+}
+
+int apply_delta_inplace(const std::string &basis_path, const std::string &delta_path)
+{
+    constexpr size_t header_size = 24;
+    MappedFile delta;
+    if (!delta.open(delta_path) || delta.size() < header_size || memcmp(delta.data(), delta_magic, 4) != 0 ||
+        get_le(delta.data() + 4, 4) != delta_version) {
+        std::cerr << "Invalid delta file " << delta_path << std::endl;
+        return -1;
+    }
+
+    const uint8_t *ptr = delta.data() + header_size;
+    const uint8_t *end = delta.data() + delta.size();
+    const uint64_t target_size = get_le(delta.data() + 8, 8);
+    const uint64_t target_hash = get_le(delta.data() + 16, 8);
+
+    int fd = open(basis_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0755);
+    if (fd < 0) {
+        std::cerr << "Failed to open " << basis_path << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0) {
+        std::cerr << "Failed to stat " << basis_path << ": " << strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+    const uint64_t basis_size = static_cast<uint64_t>(st.st_size);
+
+    std::vector<uint8_t> buffer(copy_buffer_size);
+    int ret = -1;
+    while (ptr < end) {
+        uint8_t op = *ptr++;
+        if (op == op_end) {
+            ret = 0;
+            break;
+        }
+        if (op == op_copy && ptr + 24 <= end) {
+            uint64_t src = get_le(ptr, 8);
+            uint64_t dst = get_le(ptr + 8, 8);
+            uint64_t len = get_le(ptr + 16, 8);
+            ptr += 24;
+            if (src + len > basis_size || dst + len > target_size) {
+                std::cerr << "Delta references data outside of " << basis_path << std::endl;
+                break;
+            }
+            if (!copy_range(fd, src, dst, len, buffer)) {
+                break;
+            }
+        } else if (op == op_literal && ptr + 12 <= end) {
+            uint64_t dst = get_le(ptr, 8);
+            uint64_t len = get_le(ptr + 8, 4);
+            ptr += 12;
+            if (ptr + len > end || dst + len > target_size ||
+                pwrite(fd, ptr, len, static_cast<off_t>(dst)) != static_cast<ssize_t>(len)) {
+                break;
+            }
+            ptr += len;
+        } else {
+            break;
+        }
+    }
+
+    if (ret != 0 || ftruncate(fd, static_cast<off_t>(target_size)) != 0) {
+        std::cerr << "Failed to apply delta " << delta_path << " to " << basis_path << std::endl;
+        close(fd);
+        return -1;
+    }
+    fsync(fd);
+    close(fd);
+
+    MappedFile result;
+    if (!result.open(basis_path) || xxh64(result.data(), result.size()) != target_hash) {
+        std::cerr << "Checksum mismatch after applying delta to " << basis_path << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+}; // namespace RemoteDebug
@@ -0,0 +1,67 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// rsync 风格的增量编码：设备侧计算已有文件的块签名，主机侧只发送字面数据与块引用
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace RemoteDebug {
+
+constexpr uint32_t delta_min_block_size = 512;
+constexpr uint32_t delta_max_block_size = 64 * 1024;
+
+struct BlockSignature {
+    uint32_t weak{ 0 };   // 滚动校验和
+    uint64_t strong{ 0 }; // 块内容 xxh64
+};
+
+struct FileSignature {
+    uint32_t                    block_size{ 0 };
+    uint64_t                    file_size{ 0 };
+    std::vector<BlockSignature> blocks; // 仅包含完整块，尾部不足一块的数据不参与匹配
+};
+
+struct DeltaStats {
+    uint64_t literal_bytes{ 0 }; // 需要发送的字面数据
+    uint64_t copied_bytes{ 0 };  // 通过块引用复用的数据
+    uint64_t delta_size{ 0 };    // 增量文件大小
+};
+
+/**
+ * @brief 根据文件大小选择块大小（约为 sqrt(size)，按 8 字节对齐）
+ */
+uint32_t choose_block_size(uint64_t file_size);
+
+/**
+ * @brief 计算文件块签名
+ * @return 成功返回0，失败返回-1
+ */
+int compute_signature(const std::string &path, uint32_t block_size, FileSignature &signature);
+
+/**
+ * @brief 签名与文本互相转换，便于通过远端命令的标准输出回传
+ */
+std::string encode_signature(const FileSignature &signature);
+int decode_signature(const std::string &text, FileSignature &signature);
+
+/**
+ * @brief 根据远端签名生成目标文件的增量
+ * @details 块引用按读写依赖排序后输出，设备侧无需额外空间即可原地重建
+ * @param[in] signature 远端已有文件的签名
+ * @param[in] target_path 本地新文件
+ * @param[in] delta_path 生成的增量文件
+ * @param[out] stats 统计信息，可为空
+ * @return 成功返回0，失败返回-1
+ */
+int compute_delta(const FileSignature &signature, const std::string &target_path,
+        const std::string &delta_path, DeltaStats *stats = nullptr);
+
+/**
+ * @brief 将增量原地应用到已有文件，完成后校验整体哈希
+ * @return 成功返回0，失败返回-1（校验失败时文件内容不可用，需要完整重传）
+ */
+int apply_delta_inplace(const std::string &basis_path, const std::string &delta_path);
+
+}; // namespace RemoteDebug
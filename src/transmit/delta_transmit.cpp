@@ -0,0 +1,96 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "delta_transmit.h"
+#include "net_util.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RemoteDebug {
+
+int DeltaTransmit::transmit(const Device_info &device_info)
+{
+    struct stat st{};
+    if (stat(device_info.file_name.c_str(), &st) != 0) {
+        std::cerr << "Failed to stat " << device_info.file_name << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    m_stats = DeltaStats{};
+    if (transmit_delta(device_info, static_cast<uint64_t>(st.st_size)) == 0) {
+        return 0;
+    }
+    return transmit_full(device_info);
+}
+
+int DeltaTransmit::transmit_delta(const Device_info &device_info, uint64_t file_size)
+{
+    const uint32_t block_size = choose_block_size(file_size);
+    std::string output;
+    int ret = m_backend.execute(device_info, m_remote_tool + " delta-signature " +
+        shell_quote(device_info.remote_path) + " " + std::to_string(block_size), output);
+    if (ret != 0) {
+        return -1; // 远端无副本或不支持执行命令
+    }
+
+    FileSignature signature;
+    if (decode_signature(output, signature) != 0 || signature.blocks.empty()) {
+        return -1;
+    }
+
+    char delta_path[] = "/tmp/remote_debug_delta_XXXXXX";
+    int fd = mkstemp(delta_path);
+    if (fd < 0) {
+        std::cerr << "Failed to create delta file: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    close(fd);
+
+    DeltaStats stats;
+    ret = compute_delta(signature, device_info.file_name, delta_path, &stats);
+    if (ret == 0 && stats.delta_size >= file_size) {
+        ret = -1; // 增量不比原文件小，直接完整传输
+    }
+
+    const std::string remote_delta = device_info.remote_path + ".delta";
+    if (ret == 0) {
+        Device_info delta_device{ device_info.trans_type, device_info.ip, device_info.port, delta_path,
+                                  device_info.m_username, device_info.m_password, remote_delta };
+        ret = m_backend.transmit(delta_device);
+    }
+    std::remove(delta_path);
+
+    if (ret == 0) {
+        ret = m_backend.execute(device_info, m_remote_tool + " delta-patch " + shell_quote(device_info.remote_path) +
+            " " + shell_quote(remote_delta), output);
+        if (ret != 0) {
+            std::cerr << "Remote delta apply failed (" << ret << "): " << output << std::endl;
+        }
+    }
+
+    if (ret == 0) {
+        m_stats = stats;
+        std::cout << "Delta transmit " << device_info.file_name << ": literal " << stats.literal_bytes
+                  << " bytes, reused " << stats.copied_bytes << " bytes, sent " << stats.delta_size
+                  << " bytes" << std::endl;
+    }
+    return ret;
+}
+
+int DeltaTransmit::transmit_full(const Device_info &device_info)
+{
+    int ret = m_backend.transmit(device_info);
+    if (ret == 0) {
+        struct stat st{};
+        stat(device_info.file_name.c_str(), &st);
+        m_stats.literal_bytes = static_cast<uint64_t>(st.st_size);
+        m_stats.delta_size = static_cast<uint64_t>(st.st_size);
+    }
+    return ret;
+}
+
+}; // namespace RemoteDebug
@@ -0,0 +1,47 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 增量传输：仅发送与设备上已有副本的差异，设备侧由热补丁工具原地重建文件
+
+#pragma once
+
+#include "transmit.h"
+#include "delta.h"
+
+#include <string>
+
+namespace RemoteDebug {
+
+/**
+ * @brief 包装任意支持 execute() 的传输方式，提供增量传输
+ * @details 1. 远端执行 "<tool> delta-signature <file> <block>" 获取已有副本的块签名
+ *          2. 本地生成增量，经原传输方式上传到 "<file>.delta"
+ *          3. 远端执行 "<tool> delta-patch <file> <file>.delta" 原地重建并校验
+ *          远端无副本、增量无收益或任一步骤失败时回退为完整传输
+ */
+class DeltaTransmit : public RemoteTransmit {
+public:
+    explicit DeltaTransmit(RemoteTransmit &backend, std::string remote_tool = remote_tool_path)
+        : m_backend(backend), m_remote_tool(std::move(remote_tool)) {}
+
+    int transmit(const Device_info &device_info) override;
+
+    int execute(const Device_info &device_info, const std::string &command, std::string &output) override
+    {
+        return m_backend.execute(device_info, command, output);
+    }
+
+    /**
+     * @brief 最近一次传输的统计，完整传输时 copied_bytes 为0
+     */
+    const DeltaStats &last_stats() const { return m_stats; }
+
+private:
+    int transmit_delta(const Device_info &device_info, uint64_t file_size);
+    int transmit_full(const Device_info &device_info);
+
+private:
+    RemoteTransmit &m_backend;
+    std::string     m_remote_tool;
+    DeltaStats      m_stats;
+};
+
+}; // namespace RemoteDebug
@@ -0,0 +1,365 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "ftp_async_session.h"
+#include "ftp_transmit.h"
+#include "net_util.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RemoteDebug {
+
+namespace {
+
+constexpr size_t sendfile_chunk = 1 << 20;
+
+std::chrono::microseconds elapsed_since(SteadyClock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now() - start);
+}
+
+} // namespace
+
+FtpAsyncSession::~FtpAsyncSession()
+{
+    for (int fd : { m_control_fd, m_data_fd, m_file_fd }) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+}
+
+SESSION_STATE FtpAsyncSession::start(EventRegistry &registry)
+{
+    close_all(registry);
+    m_step = STEP::CONNECTING;
+    m_recv_buffer.clear();
+    m_send_buffer.clear();
+    m_error.clear();
+    m_bytes_sent = 0;
+    m_offset = 0;
+    m_connect_latency = std::chrono::microseconds(0);
+    m_handshake_latency = std::chrono::microseconds(0);
+    m_start = SteadyClock::now();
+
+    if (m_device.port > UINT16_MAX) {
+        return fail("invalid ftp port " + std::to_string(m_device.port));
+    }
+
+    m_file_fd = open(m_device.file_name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_file_fd < 0) {
+        return fail("failed to open local file " + m_device.file_name + ": " + strerror(errno));
+    }
+    struct stat file_stat{};
+    if (fstat(m_file_fd, &file_stat) != 0) {
+        return fail("failed to stat local file " + m_device.file_name + ": " + strerror(errno));
+    }
+    m_file_size = file_stat.st_size;
+    m_part_path = ftp_part_path(m_device.remote_path, file_stat);
+
+    m_control_fd = tcp_connect_nonblocking(m_device.ip, static_cast<uint16_t>(m_device.port));
+    if (m_control_fd < 0 || registry.watch(m_control_fd, EPOLLOUT) != 0) {
+        return fail("failed to start control connection");
+    }
+    return SESSION_STATE::RUNNING;
+}
+
+SESSION_STATE FtpAsyncSession::on_event(EventRegistry &registry, int fd, uint32_t events)
+{
+    if (fd == m_control_fd) {
+        return on_control(registry, events);
+    }
+    if (fd == m_data_fd) {
+        return on_data(registry, events);
+    }
+    return SESSION_STATE::RUNNING;
+}
+
+void FtpAsyncSession::close(EventRegistry &registry)
+{
+    close_all(registry);
+}
+
+void FtpAsyncSession::close_all(EventRegistry &registry)
+{
+    close_fd(registry, m_data_fd);
+    close_fd(registry, m_control_fd);
+    if (m_file_fd >= 0) {
+        ::close(m_file_fd);
+        m_file_fd = -1;
+    }
+}
+
+SESSION_STATE FtpAsyncSession::on_control(EventRegistry &registry, uint32_t events)
+{
+    if (m_step == STEP::CONNECTING) {
+        int err = connect_result(m_control_fd);
+        if (err != 0) {
+            return fail(std::string("connect failed: ") + strerror(err));
+        }
+        m_connect_latency = elapsed_since(m_start);
+        m_step = STEP::GREETING;
+        return registry.watch(m_control_fd, EPOLLIN) == 0 ? SESSION_STATE::RUNNING : fail("epoll_ctl failed");
+    }
+
+    if (events & EPOLLOUT) {
+        SESSION_STATE state = flush_control(registry);
+        if (state != SESSION_STATE::RUNNING) {
+            return state;
+        }
+    }
+
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+        char buffer[1024];
+        while (true) {
+            ssize_t n = recv(m_control_fd, buffer, sizeof(buffer), 0);
+            if (n > 0) {
+                m_recv_buffer.append(buffer, static_cast<size_t>(n));
+                continue;
+            }
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            return fail(std::string("control connection closed: ") + (n == 0 ? "eof" : strerror(errno)));
+        }
+
+        std::string reply;
+        int code;
+        while ((code = take_reply(reply)) != 0) {
+            SESSION_STATE state = on_reply(registry, code, reply);
+            if (state != SESSION_STATE::RUNNING) {
+                return state;
+            }
+        }
+    }
+    return SESSION_STATE::RUNNING;
+}
+
+SESSION_STATE FtpAsyncSession::on_data(EventRegistry &registry, uint32_t events)
+{
+    if (m_step == STEP::DATA_CONNECTING) {
+        int err = connect_result(m_data_fd);
+        if (err != 0) {
+            return fail(std::string("data connection failed: ") + strerror(err));
+        }
+        // 连接建立后暂停监听，收到 STOR 的 150 应答后再开始发送
+        registry.unwatch(m_data_fd);
+
+        // REST 必须紧邻 STOR 发送
+        if (m_offset > 0) {
+            return send_command(registry, "REST " + std::to_string(m_offset), STEP::REST);
+        }
+        return send_store(registry);
+    }
+
+    if (m_step != STEP::SENDING) {
+        return SESSION_STATE::RUNNING;
+    }
+    if ((events & EPOLLERR) && !(events & EPOLLOUT)) {
+        return fail("data connection error at offset " + std::to_string(m_offset));
+    }
+
+    // 非阻塞发送直到 socket 缓冲区写满，剩余部分等待下一次 EPOLLOUT
+    while (m_offset < m_file_size) {
+        size_t count = static_cast<size_t>(m_file_size - m_offset);
+        ssize_t sent = sendfile(m_data_fd, m_file_fd, &m_offset, count < sendfile_chunk ? count : sendfile_chunk);
+        if (sent > 0) {
+            m_bytes_sent += static_cast<uint64_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return SESSION_STATE::RUNNING;
+        }
+        return fail("sendfile failed at offset " + std::to_string(m_offset) + ": " +
+                    (sent == 0 ? "unexpected eof" : strerror(errno)));
+    }
+
+    // 关闭数据连接通知服务端传输结束，随后等待 226 Transfer complete
+    shutdown(m_data_fd, SHUT_WR);
+    close_fd(registry, m_data_fd);
+    m_step = STEP::COMPLETE;
+    return SESSION_STATE::RUNNING;
+}
+
+SESSION_STATE FtpAsyncSession::on_reply(EventRegistry &registry, int code, const std::string &reply)
+{
+    if (code < 100) {
+        return fail("malformed ftp reply: " + reply);
+    }
+
+    // 除 STOR 外的 1xx 预备应答无需处理，继续等待最终应答
+    if (code < 200 && m_step != STEP::STOR) {
+        return SESSION_STATE::RUNNING;
+    }
+
+    switch (m_step) {
+    case STEP::GREETING:
+        if (code != 220) {
+            return fail("unexpected ftp greeting: " + reply);
+        }
+        return send_command(registry, "USER " + m_device.m_username, STEP::USER);
+    case STEP::USER:
+        if (code == 331) {
+            return send_command(registry, "PASS " + m_device.m_password, STEP::PASS);
+        }
+        [[fallthrough]];
+    case STEP::PASS:
+        if (code != 230) {
+            return fail("ftp login failed: " + reply);
+        }
+        return send_command(registry, "TYPE I", STEP::TYPE);
+    case STEP::TYPE:
+        if (code != 200) {
+            return fail("ftp server refused binary mode: " + reply);
+        }
+        m_handshake_latency = elapsed_since(m_start) - m_connect_latency;
+        return send_command(registry, "SIZE " + m_part_path, STEP::SIZE);
+    case STEP::SIZE:
+        // 断点续传：临时文件名绑定本地文件，只续传同一份文件遗留的前缀，且远端不能比本地文件更大
+        m_offset = code == 213 && reply.size() > 4 ? static_cast<off_t>(std::strtoll(reply.c_str() + 4, nullptr, 10)) : 0;
+        if (m_offset > m_file_size) {
+            m_offset = 0;
+        }
+        return send_command(registry, "PASV", STEP::PASV);
+    case STEP::PASV: {
+        // 227 Entering Passive Mode (h1,h2,h3,h4,p1,p2)，地址统一使用控制连接的对端地址
+        unsigned h[4] = {};
+        unsigned p[2] = {};
+        size_t pos = reply.find('(');
+        if (code != 227 || pos == std::string::npos ||
+            std::sscanf(reply.c_str() + pos, "(%u,%u,%u,%u,%u,%u)", &h[0], &h[1], &h[2], &h[3], &p[0], &p[1]) != 6) {
+            return fail("ftp passive mode failed: " + reply);
+        }
+        m_data_fd = tcp_connect_nonblocking(m_device.ip, static_cast<uint16_t>((p[0] << 8) | p[1]));
+        if (m_data_fd < 0 || registry.watch(m_data_fd, EPOLLOUT) != 0) {
+            return fail("failed to start data connection");
+        }
+        m_step = STEP::DATA_CONNECTING;
+        return SESSION_STATE::RUNNING;
+    }
+    case STEP::REST:
+        if (code != 350) {
+            m_offset = 0;
+        }
+        return send_store(registry);
+    case STEP::STOR:
+        if (code != 125 && code != 150) {
+            return fail("ftp STOR " + m_part_path + " failed: " + reply);
+        }
+        m_step = STEP::SENDING;
+        return registry.watch(m_data_fd, EPOLLOUT) == 0 ? SESSION_STATE::RUNNING : fail("epoll_ctl failed");
+    case STEP::COMPLETE:
+        if (code != 226 && code != 250) {
+            return fail("ftp upload incomplete: " + reply);
+        }
+        return send_command(registry, "RNFR " + m_part_path, STEP::RNFR);
+    case STEP::RNFR:
+        if (code != 350) {
+            return fail("ftp RNFR " + m_part_path + " failed: " + reply);
+        }
+        return send_command(registry, "RNTO " + m_device.remote_path, STEP::RNTO);
+    case STEP::RNTO:
+        if (code != 250) {
+            return fail("ftp RNTO " + m_device.remote_path + " failed: " + reply);
+        }
+        // QUIT 的应答无需等待
+        send(m_control_fd, "QUIT\r\n", 6, MSG_NOSIGNAL);
+        return SESSION_STATE::DONE;
+    default:
+        return fail("unexpected ftp reply: " + reply);
+    }
+}
+
+int FtpAsyncSession::take_reply(std::string &reply)
+{
+    size_t end = m_recv_buffer.find("\r\n");
+    if (end == std::string::npos) {
+        return 0;
+    }
+    if (end < 3) {
+        reply = m_recv_buffer.substr(0, end);
+        m_recv_buffer.erase(0, end + 2);
+        return -1;
+    }
+
+    // 多行应答以 "xyz-" 开始，以 "xyz " 结束
+    if (m_recv_buffer[3] == '-') {
+        const std::string terminator = "\r\n" + m_recv_buffer.substr(0, 3) + " ";
+        size_t last = m_recv_buffer.find(terminator);
+        if (last == std::string::npos) {
+            return 0;
+        }
+        end = m_recv_buffer.find("\r\n", last + terminator.size());
+        if (end == std::string::npos) {
+            return 0;
+        }
+    }
+
+    reply = m_recv_buffer.substr(0, end);
+    m_recv_buffer.erase(0, end + 2);
+    return std::atoi(reply.substr(0, 3).c_str());
+}
+
+SESSION_STATE FtpAsyncSession::send_command(EventRegistry &registry, const std::string &cmd, STEP next)
+{
+    m_step = next;
+    m_send_buffer += cmd + "\r\n";
+    return flush_control(registry);
+}
+
+SESSION_STATE FtpAsyncSession::flush_control(EventRegistry &registry)
+{
+    while (!m_send_buffer.empty()) {
+        ssize_t n = send(m_control_fd, m_send_buffer.data(), m_send_buffer.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            m_send_buffer.erase(0, static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        return fail(std::string("failed to send ftp command: ") + strerror(errno));
+    }
+
+    uint32_t events = EPOLLIN | (m_send_buffer.empty() ? 0u : static_cast<uint32_t>(EPOLLOUT));
+    return registry.watch(m_control_fd, events) == 0 ? SESSION_STATE::RUNNING : fail("epoll_ctl failed");
+}
+
+SESSION_STATE FtpAsyncSession::send_store(EventRegistry &registry)
+{
+    return send_command(registry, "STOR " + m_part_path, STEP::STOR);
+}
+
+SESSION_STATE FtpAsyncSession::fail(const std::string &error)
+{
+    m_error = error;
+    return SESSION_STATE::FAILED;
+}
+
+void FtpAsyncSession::close_fd(EventRegistry &registry, int &fd)
+{
+    if (fd >= 0) {
+        registry.unwatch(fd);
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+}; // namespace RemoteDebug
@@ -0,0 +1,86 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// FTP 上传的非阻塞状态机版本，供 TransmitScheduler 在单个事件循环中并发驱动
+
+#pragma once
+
+#include "transmit_scheduler.h"
+
+#include <sys/types.h>
+#include <string>
+
+namespace RemoteDebug {
+
+/**
+ * @brief 非阻塞 FTP 上传会话
+ * @details 协议流程与 FtpTransmit 一致（ftp_part_path 临时文件 + SIZE/REST 续传 + RNFR/RNTO），
+ *          控制连接与数据连接均为非阻塞 fd，由事件循环在可读/可写时推进
+ */
+class FtpAsyncSession : public AsyncSession {
+public:
+    explicit FtpAsyncSession(const Device_info &device_info) : m_device(device_info) {}
+    ~FtpAsyncSession() override;
+
+    SESSION_STATE start(EventRegistry &registry) override;
+    SESSION_STATE on_event(EventRegistry &registry, int fd, uint32_t events) override;
+    void close(EventRegistry &registry) override;
+
+    const std::string &error() const override { return m_error; }
+    uint64_t bytes_sent() const override { return m_bytes_sent; }
+    std::chrono::microseconds connect_latency() const override { return m_connect_latency; }
+    std::chrono::microseconds handshake_latency() const override { return m_handshake_latency; }
+
+private:
+    enum class STEP {
+        CONNECTING,
+        GREETING,
+        USER,
+        PASS,
+        TYPE,
+        SIZE,
+        PASV,
+        DATA_CONNECTING,
+        REST,
+        STOR,
+        SENDING,
+        COMPLETE,
+        RNFR,
+        RNTO
+    };
+
+    SESSION_STATE on_control(EventRegistry &registry, uint32_t events);
+    SESSION_STATE on_data(EventRegistry &registry, uint32_t events);
+    SESSION_STATE on_reply(EventRegistry &registry, int code, const std::string &reply);
+
+    /**
+     * @brief 从接收缓存中取出一条完整应答
+     * @return 返回应答码，应答尚不完整时返回0，格式错误返回-1
+     */
+    int take_reply(std::string &reply);
+
+    SESSION_STATE send_command(EventRegistry &registry, const std::string &cmd, STEP next);
+    SESSION_STATE flush_control(EventRegistry &registry);
+    SESSION_STATE send_store(EventRegistry &registry);
+    SESSION_STATE fail(const std::string &error);
+
+    void close_all(EventRegistry &registry);
+    void close_fd(EventRegistry &registry, int &fd);
+
+private:
+    const Device_info &       m_device;
+    STEP                      m_step{ STEP::CONNECTING };
+    int                       m_control_fd{ -1 };
+    int                       m_data_fd{ -1 };
+    int                       m_file_fd{ -1 };
+    off_t                     m_file_size{ 0 };
+    off_t                     m_offset{ 0 };        // 本次上传起始偏移（续传位置），发送时递增
+    std::string               m_part_path;
+    std::string               m_recv_buffer;
+    std::string               m_send_buffer;        // 控制连接未发送完的命令
+    std::string               m_error;
+    uint64_t                  m_bytes_sent{ 0 };
+    SteadyClock::time_point   m_start;
+    std::chrono::microseconds m_connect_latency{ 0 };
+    std::chrono::microseconds m_handshake_latency{ 0 };
+};
+
+}; // namespace RemoteDebug
@@ -0,0 +1,276 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "ftp_transmit.h"
+#include "net_util.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RemoteDebug {
+
+namespace {
+
+constexpr size_t sendfile_chunk = 1 << 20; // 单次 sendfile 最大字节数
+
+} // namespace
+
+std::string ftp_part_path(const std::string &remote_path, const struct stat &local)
+{
+    char stamp[48];
+    std::snprintf(stamp, sizeof(stamp), ".%llx-%llx.part", static_cast<unsigned long long>(local.st_size),
+                  static_cast<unsigned long long>(local.st_mtim.tv_sec) * 1000000000ull +
+                          static_cast<unsigned long long>(local.st_mtim.tv_nsec));
+    return remote_path + stamp;
+}
+
+FtpTransmit::~FtpTransmit()
+{
+    close_control();
+}
+
+int FtpTransmit::transmit(const Device_info &device_info)
+{
+    if (connect(device_info) != 0) {
+        return -1;
+    }
+
+    int ret = login(device_info);
+    if (ret == 0) {
+        ret = send_file(device_info);
+    }
+
+    command("QUIT");
+    close_control();
+    return ret;
+}
+
+int FtpTransmit::connect(const Device_info &device_info)
+{
+    close_control();
+    if (device_info.port > UINT16_MAX) {
+        std::cerr << "Invalid ftp port: " << device_info.port << std::endl;
+        return -1;
+    }
+
+    m_ip = device_info.ip;
+    m_socket_fd = tcp_connect(device_info.ip, static_cast<uint16_t>(device_info.port));
+    if (m_socket_fd < 0) {
+        return -1;
+    }
+
+    // 220 Service ready
+    if (read_reply() != 220) {
+        std::cerr << "Unexpected ftp greeting from " << ip_to_string(m_ip) << std::endl;
+        close_control();
+        return -1;
+    }
+    return 0;
+}
+
+int FtpTransmit::login(const Device_info &device_info)
+{
+    int code = command("USER " + device_info.m_username);
+    if (code == 331) {
+        code = command("PASS " + device_info.m_password);
+    }
+    if (code != 230) {
+        std::cerr << "Ftp login failed, reply code: " << code << std::endl;
+        return -1;
+    }
+
+    if (command("TYPE I") != 200) {
+        std::cerr << "Ftp server refused binary mode" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+int FtpTransmit::send_file(const Device_info &device_info)
+{
+    int file_fd = open(device_info.file_name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file_fd < 0) {
+        std::cerr << "Failed to open local file " << device_info.file_name << ": "
+                  << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    struct stat file_stat{};
+    if (fstat(file_fd, &file_stat) != 0) {
+        std::cerr << "Failed to stat local file " << device_info.file_name << ": " << strerror(errno) << std::endl;
+        close(file_fd);
+        return -1;
+    }
+    const off_t file_size = file_stat.st_size;
+    const std::string part_path = ftp_part_path(device_info.remote_path, file_stat);
+
+    // 断点续传：临时文件名绑定本地文件，只续传同一份文件遗留的前缀，且远端不能比本地文件更大
+    off_t offset = m_resume ? remote_size(part_path) : 0;
+    if (offset > file_size) {
+        offset = 0;
+    }
+
+    int data_fd = open_data_connection();
+    if (data_fd < 0) {
+        close(file_fd);
+        return -1;
+    }
+
+    // REST 必须紧邻 STOR 发送
+    if (offset > 0 && command("REST " + std::to_string(offset)) != 350) {
+        offset = 0;
+    }
+
+    // 125/150: 数据连接已就绪，开始传输
+    int code = command("STOR " + part_path);
+    if (code != 125 && code != 150) {
+        std::cerr << "Ftp STOR " << part_path << " failed, reply code: " << code << std::endl;
+        close(data_fd);
+        close(file_fd);
+        return -1;
+    }
+
+    int ret = 0;
+    SigpipeGuard sigpipe_guard;
+    while (offset < file_size) {
+        size_t count = static_cast<size_t>(file_size - offset);
+        ssize_t sent = sendfile(data_fd, file_fd, &offset, count < sendfile_chunk ? count : sendfile_chunk);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            std::cerr << "Ftp sendfile failed at offset " << offset << ": " << strerror(errno) << std::endl;
+            ret = -1;
+            break;
+        }
+    }
+    close(file_fd);
+
+    // 关闭数据连接通知服务端传输结束，随后读取 226 Transfer complete
+    shutdown(data_fd, SHUT_WR);
+    close(data_fd);
+    code = read_reply();
+    if (ret != 0 || (code != 226 && code != 250)) {
+        std::cerr << "Ftp upload of " << device_info.file_name << " incomplete, reply code: " << code << std::endl;
+        return -1;
+    }
+
+    if (command("RNFR " + part_path) != 350 || command("RNTO " + device_info.remote_path) != 250) {
+        std::cerr << "Ftp rename " << part_path << " -> " << device_info.remote_path << " failed" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+int FtpTransmit::command(const std::string &cmd, std::string *reply)
+{
+    if (m_socket_fd < 0) {
+        return -1;
+    }
+
+    std::string line = cmd + "\r\n";
+    if (send_all(m_socket_fd, line.data(), line.size()) != 0) {
+        std::cerr << "Failed to send ftp command: " << strerror(errno) << std::endl;
+        return -1;
+    }
+    return read_reply(reply);
+}
+
+int FtpTransmit::read_reply(std::string *reply)
+{
+    std::string line;
+    if (read_line(line) != 0 || line.size() < 3) {
+        return -1;
+    }
+
+    int code = std::atoi(line.substr(0, 3).c_str());
+    std::string text = line;
+
+    // 多行应答以 "xyz-" 开始，以 "xyz " 结束
+    if (line.size() > 3 && line[3] == '-') {
+        const std::string terminator = line.substr(0, 3) + " ";
+        do {
+            if (read_line(line) != 0) {
+                return -1;
+            }
+            text += "\n" + line;
+        } while (line.compare(0, 4, terminator) != 0);
+    }
+
+    if (reply) {
+        *reply = text;
+    }
+    return code;
+}
+
+int FtpTransmit::read_line(std::string &line)
+{
+    while (true) {
+        size_t pos = m_recv_buffer.find("\r\n");
+        if (pos != std::string::npos) {
+            line = m_recv_buffer.substr(0, pos);
+            m_recv_buffer.erase(0, pos + 2);
+            return 0;
+        }
+
+        char buffer[1024];
+        ssize_t n = recv(m_socket_fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            std::cerr << "Ftp control connection closed: " << (n == 0 ? "eof" : strerror(errno)) << std::endl;
+            return -1;
+        }
+        m_recv_buffer.append(buffer, static_cast<size_t>(n));
+    }
+}
+
+int FtpTransmit::open_data_connection()
+{
+    std::string reply;
+    if (command("PASV", &reply) != 227) {
+        std::cerr << "Ftp server refused passive mode: " << reply << std::endl;
+        return -1;
+    }
+
+    // 227 Entering Passive Mode (h1,h2,h3,h4,p1,p2)
+    unsigned h[4] = {};
+    unsigned p[2] = {};
+    size_t pos = reply.find('(');
+    if (pos == std::string::npos ||
+        std::sscanf(reply.c_str() + pos, "(%u,%u,%u,%u,%u,%u)", &h[0], &h[1], &h[2], &h[3], &p[0], &p[1]) != 6) {
+        std::cerr << "Malformed ftp PASV reply: " << reply << std::endl;
+        return -1;
+    }
+
+    // 忽略应答中的地址，统一使用控制连接的对端地址（NAT 后的设备常返回内网地址）
+    return tcp_connect(m_ip, static_cast<uint16_t>((p[0] << 8) | p[1]));
+}
+
+off_t FtpTransmit::remote_size(const std::string &path)
+{
+    std::string reply;
+    if (command("SIZE " + path, &reply) != 213 || reply.size() <= 4) {
+        return 0;
+    }
+    return static_cast<off_t>(std::strtoll(reply.c_str() + 4, nullptr, 10));
+}
+
+void FtpTransmit::close_control()
+{
+    if (m_socket_fd >= 0) {
+        close(m_socket_fd);
+        m_socket_fd = -1;
+    }
+    m_recv_buffer.clear();
+}
+
+}; // namespace RemoteDebug
@@ -5,15 +5,72 @@
 
 #include "transmit.h"
 
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <string>
+
+namespace RemoteDebug {
+
+/**
+ * @brief 上传使用的临时文件路径 "<remote_path>.<大小>-<修改时间>.part"（十六进制）
+ * @details 文件名绑定本地文件的大小与修改时间（纳秒），只有同一份本地文件的上传才会续传遗留的临时文件，
+ *          其他版本中断后遗留的前缀不会与新文件拼接。FtpTransmit 与 FtpAsyncSession 共用，可互相续传
+ */
+std::string ftp_part_path(const std::string &remote_path, const struct stat &local);
+
+/**
+ * @brief FTP 传输：被动模式 + 二进制类型，数据连接由 sendfile(2) 直接从本地文件发送
+ * @details 先上传到 ftp_part_path 给出的临时文件，完成后 RNFR/RNTO 重命名为目标文件；
+ *          上次中断遗留的同一本地文件的临时文件会通过 SIZE + REST 断点续传
+ */
 class FtpTransmit : public RemoteTransmit {
 public:
-    FtpTransmit(const Device_info &device_info) : m_device_info(device_info) {}
-    int transmit() override;
+    FtpTransmit() = default;
+    ~FtpTransmit() override;
+
+    int transmit(const Device_info &device_info) override;
+
+    /**
+     * @brief 设置是否启用断点续传（默认启用）
+     */
+    void set_resume(bool resume) { m_resume = resume; }
 
 private:
-    int connect();
-    int send_file();
+    int connect(const Device_info &device_info);
+    int login(const Device_info &device_info);
+    int send_file(const Device_info &device_info);
+
+    /**
+     * @brief 发送一条控制命令并读取应答
+     * @return 返回应答码，失败返回-1
+     */
+    int command(const std::string &cmd, std::string *reply = nullptr);
+
+    /**
+     * @brief 读取一条完整应答（支持多行应答 "xyz-...\r\n ... xyz ...\r\n"）
+     * @return 返回应答码，失败返回-1
+     */
+    int read_reply(std::string *reply = nullptr);
+    int read_line(std::string &line);
+
+    /**
+     * @brief 进入被动模式并建立数据连接
+     * @return 返回数据连接 fd，失败返回-1
+     */
+    int open_data_connection();
+
+    /**
+     * @brief 查询远端文件大小，文件不存在时返回0
+     */
+    off_t remote_size(const std::string &path);
+
+    void close_control();
 
 private:
-    int m_socket_fd{ -1 };
+    int         m_socket_fd{ -1 };
+    uint32_t    m_ip{ 0 };           // 数据连接使用控制连接的对端地址（主机字节序）
+    bool        m_resume{ true };
+    std::string m_recv_buffer;       // 控制连接接收缓存
 };
+
+}; // namespace RemoteDebug
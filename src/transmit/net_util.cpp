@@ -0,0 +1,180 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "net_util.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace RemoteDebug {
+
+namespace {
+
+void set_io_timeout(int fd, int timeout_ms)
+{
+    timeval tv{};
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+} // namespace
+
+int tcp_connect(uint32_t ip, uint16_t port, int timeout_ms)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "Failed to create socket: " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(ip);
+
+    // 非阻塞 connect + poll 实现连接超时，连接建立后恢复阻塞模式
+    int flags = fcntl(fd, F_GETFL);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    int ret = ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+    if (ret != 0 && errno == EINPROGRESS) {
+        pollfd pfd{ fd, POLLOUT, 0 };
+        ret = poll(&pfd, 1, timeout_ms);
+        if (ret == 1) {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            errno = err;
+            ret = err == 0 ? 0 : -1;
+        } else {
+            errno = ret == 0 ? ETIMEDOUT : errno;
+            ret = -1;
+        }
+    }
+    if (ret != 0) {
+        std::cerr << "Failed to connect to " << ip_to_string(ip) << ":" << port << ": "
+                  << strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, flags);
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    set_io_timeout(fd, timeout_ms);
+    return fd;
+}
+
+int tcp_connect_nonblocking(uint32_t ip, uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        std::cerr << "Failed to create socket: " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(ip);
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 && errno != EINPROGRESS) {
+        std::cerr << "Failed to connect to " << ip_to_string(ip) << ":" << port << ": "
+                  << strerror(errno) << std::endl;
+        close(fd);
+        return -1;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+int connect_result(int fd)
+{
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0) {
+        return errno;
+    }
+    return err;
+}
+
+int send_all(int fd, const void *data, size_t size)
+{
+    const char *ptr = static_cast<const char *>(data);
+    while (size > 0) {
+        ssize_t n = send(fd, ptr, size, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        ptr += n;
+        size -= static_cast<size_t>(n);
+    }
+    return 0;
+}
+
+std::string ip_to_string(uint32_t ip)
+{
+    in_addr addr{};
+    addr.s_addr = htonl(ip);
+    char buf[INET_ADDRSTRLEN] = {};
+    inet_ntop(AF_INET, &addr, buf, sizeof(buf));
+    return buf;
+}
+
+std::string shell_quote(const std::string &arg)
+{
+    std::string quoted = "'";
+    for (char c : arg) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "'";
+}
+
+SigpipeGuard::SigpipeGuard()
+{
+    sigset_t pending;
+    sigpending(&pending);
+    m_was_pending = sigismember(&pending, SIGPIPE) == 1;
+
+    sigset_t block;
+    sigemptyset(&block);
+    sigaddset(&block, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &block, &m_old_mask);
+}
+
+SigpipeGuard::~SigpipeGuard()
+{
+    if (!m_was_pending) {
+        sigset_t pending;
+        sigpending(&pending);
+        if (sigismember(&pending, SIGPIPE) == 1) {
+            sigset_t pipe_set;
+            sigemptyset(&pipe_set);
+            sigaddset(&pipe_set, SIGPIPE);
+            timespec zero{};
+            while (sigtimedwait(&pipe_set, nullptr, &zero) < 0 && errno == EINTR) {
+            }
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &m_old_mask, nullptr);
+}
+
+}; // namespace RemoteDebug
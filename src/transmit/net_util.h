@@ -0,0 +1,70 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 传输模块公用的 socket 及远端命令工具函数
+
+#pragma once
+
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace RemoteDebug {
+
+constexpr int default_io_timeout_ms = 30000; // 默认读写超时时间
+
+/**
+ * @brief 建立 TCP 连接
+ * @param[in] ip 对端地址（主机字节序）
+ * @param[in] port 对端端口
+ * @param[in] timeout_ms 连接及后续读写超时时间
+ * @return 返回阻塞模式的 socket fd，失败返回-1
+ */
+int tcp_connect(uint32_t ip, uint16_t port, int timeout_ms = default_io_timeout_ms);
+
+/**
+ * @brief 发起非阻塞 TCP 连接，不等待连接完成
+ * @details fd 可写后需通过 connect_result 检查连接是否成功
+ * @return 返回非阻塞模式的 socket fd，失败返回-1
+ */
+int tcp_connect_nonblocking(uint32_t ip, uint16_t port);
+
+/**
+ * @brief 获取非阻塞连接的结果
+ * @return 连接成功返回0，否则返回对应的 errno
+ */
+int connect_result(int fd);
+
+/**
+ * @brief 发送全部数据，自动处理部分写与 EINTR
+ * @return 成功返回0，失败返回-1
+ */
+int send_all(int fd, const void *data, size_t size);
+
+/**
+ * @brief 点分十进制地址，用于日志输出
+ */
+std::string ip_to_string(uint32_t ip);
+
+/**
+ * @brief 转义为单引号包裹的 shell 参数，用于拼接远端命令
+ */
+std::string shell_quote(const std::string &arg);
+
+/**
+ * @brief 作用域内屏蔽当前线程的 SIGPIPE
+ * @details sendfile 无法像 send 一样使用 MSG_NOSIGNAL，对端关闭连接时会产生 SIGPIPE，
+ *          析构时丢弃作用域内产生的 SIGPIPE 并恢复原信号掩码
+ */
+class SigpipeGuard {
+public:
+    SigpipeGuard();
+    ~SigpipeGuard();
+    SigpipeGuard(const SigpipeGuard &) = delete;
+    SigpipeGuard &operator=(const SigpipeGuard &) = delete;
+
+private:
+    sigset_t m_old_mask;
+    bool     m_was_pending{ false };
+};
+
+}; // namespace RemoteDebug
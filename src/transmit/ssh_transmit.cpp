@@ -1,8 +1,17 @@
+#include "ssh_transmit.h"
+#include "net_util.h"
+
 #include <libssh2.h>
 #include <iostream>
-#include <fstream>
+#include <cstdio>
 #include <cstring>
 #include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RemoteDebug {
+
+namespace {
 
 // Utility to handle errors
 void checkLibssh2Result(int result, const std::string& errorMessage) {
@@ -11,75 +20,191 @@ void checkLibssh2Result(int result, const std::string& errorMessage) {
     }
 }
 
-void sendFileAndExecuteCommand(const std::string& hostname,
-                               int port,
-                               const std::string& username,
-                               const std::string& password,
-                               const std::string& localFilePath,
-                               const std::string& remoteFilePath,
-                               const std::string& command) {
-    // Initialize libssh2
-    libssh2_init(0);
+void initLibssh2() {
+    static const int result = libssh2_init(0);
+    checkLibssh2Result(result, "Failed to initialize libssh2");
+}
 
-    // Establish a socket connection
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) {
-        throw std::runtime_error("Failed to create socket");
+} // namespace
+
+SshTransmit::~SshTransmit() {
+    disconnect();
+}
+
+int SshTransmit::transmit(const Device_info& device_info) {
+    try {
+        connect(device_info);
+        send_file(device_info);
+    } catch (const std::exception& e) {
+        std::cerr << "Ssh transmit error: " << e.what() << std::endl;
+        disconnect();
+        return -1;
+    }
+    return 0;
+}
+
+int SshTransmit::execute(const Device_info& device_info, const std::string& command, std::string& output) {
+    try {
+        connect(device_info);
+        return run_command(command, output);
+    } catch (const std::exception& e) {
+        std::cerr << "Ssh execute error: " << e.what() << std::endl;
+        disconnect();
+        return -1;
     }
+}
 
-    struct sockaddr_in sin;
-    sin.sin_family = AF_INET;
-    sin.sin_port = htons(port);
-    inet_pton(AF_INET, hostname.c_str(), &sin.sin_addr);
+void SshTransmit::connect(const Device_info& device_info) {
+    // Reuse the session when talking to the same device
+    if (m_session && m_ip == device_info.ip && m_port == device_info.port && m_username == device_info.m_username) {
+        return;
+    }
+    disconnect();
+    initLibssh2();
 
-    if (connect(sock, (struct sockaddr*)&sin, sizeof(sin)) != 0) {
-        close(sock);
+    // Establish a socket connection
+    m_socket_fd = tcp_connect(device_info.ip, static_cast<uint16_t>(device_info.port));
+    if (m_socket_fd < 0) {
         throw std::runtime_error("Failed to connect to host");
     }
 
     // Establish an SSH session
-    LIBSSH2_SESSION* session = libssh2_session_init();
-    if (!session) {
-        close(sock);
+    m_session = libssh2_session_init();
+    if (!m_session) {
         throw std::runtime_error("Failed to initialize SSH session");
     }
+    libssh2_session_set_blocking(m_session, 1);
 
-    checkLibssh2Result(libssh2_session_handshake(session, sock), "SSH handshake failed");
+    checkLibssh2Result(libssh2_session_handshake(m_session, m_socket_fd), "SSH handshake failed");
 
     // Authenticate with username and password
-    checkLibssh2Result(libssh2_userauth_password(session, username.c_str(), password.c_str()),
+    checkLibssh2Result(libssh2_userauth_password(m_session, device_info.m_username.c_str(),
+                                                 device_info.m_password.c_str()),
                        "Authentication failed");
 
+    m_ip = device_info.ip;
+    m_port = device_info.port;
+    m_username = device_info.m_username;
+}
+
+void SshTransmit::disconnect() {
+    if (m_session) {
+        libssh2_session_disconnect(m_session, "Normal Shutdown");
+        libssh2_session_free(m_session);
+        m_session = nullptr;
+    }
+    if (m_socket_fd >= 0) {
+        close(m_socket_fd);
+        m_socket_fd = -1;
+    }
+}
+
+void SshTransmit::send_file(const Device_info& device_info) {
+    if (m_compress_type != COMPRESS_TYPE::NONE) {
+        send_compressed(device_info);
+        return;
+    }
+
     // SCP to send the file
     struct stat fileinfo;
-    if (stat(localFilePath.c_str(), &fileinfo) != 0) {
+    if (stat(device_info.file_name.c_str(), &fileinfo) != 0) {
         throw std::runtime_error("Failed to get local file info");
     }
 
-    FILE* localFile = fopen(localFilePath.c_str(), "rb");
+    FILE* localFile = fopen(device_info.file_name.c_str(), "rb");
     if (!localFile) {
         throw std::runtime_error("Failed to open local file");
     }
 
-    LIBSSH2_CHANNEL* channel = libssh2_scp_send(session, remoteFilePath.c_str(), fileinfo.st_mode & 0777, fileinfo.st_size);
+    LIBSSH2_CHANNEL* channel = libssh2_scp_send64(m_session, device_info.remote_path.c_str(),
+                                                  fileinfo.st_mode & 0777, fileinfo.st_size, 0, 0);
     if (!channel) {
         fclose(localFile);
         throw std::runtime_error("SCP send failed");
     }
 
-    char buffer[1024];
+    char buffer[32 * 1024];
     size_t n;
-    while ((n = fread(buffer, 1, sizeof(buffer), localFile)) > 0) {
-        libssh2_channel_write(channel, buffer, n);
+    bool ok = true;
+    while (ok && (n = fread(buffer, 1, sizeof(buffer), localFile)) > 0) {
+        for (size_t written = 0; written < n;) {
+            ssize_t rc = libssh2_channel_write(channel, buffer + written, n - written);
+            if (rc < 0) {
+                ok = false;
+                break;
+            }
+            written += static_cast<size_t>(rc);
+        }
+    }
+
+    fclose(localFile);
+    libssh2_channel_send_eof(channel);
+    libssh2_channel_wait_eof(channel);
+    libssh2_channel_close(channel);
+    libssh2_channel_free(channel);
+    if (!ok) {
+        throw std::runtime_error("SCP write failed");
+    }
+}
+
+void SshTransmit::send_compressed(const Device_info& device_info) {
+    FILE* localFile = fopen(device_info.file_name.c_str(), "rb");
+    if (!localFile) {
+        throw std::runtime_error("Failed to open local file");
+    }
+
+    // The device decompresses from stdin straight into the remote file
+    LIBSSH2_CHANNEL* channel = libssh2_channel_open_session(m_session);
+    if (!channel) {
+        fclose(localFile);
+        throw std::runtime_error("Failed to open channel for compressed transfer");
+    }
+    std::string command = m_remote_tool + " decompress " + shell_quote(device_info.remote_path);
+    if (libssh2_channel_exec(channel, command.c_str()) != 0) {
+        fclose(localFile);
+        libssh2_channel_free(channel);
+        throw std::runtime_error("Failed to start remote decompressor");
     }
 
+    auto compressor = StreamCompressor::create(m_compress_type, [channel](const void* data, size_t size) {
+        const char* ptr = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t rc = libssh2_channel_write(channel, ptr, size);
+            if (rc < 0) {
+                return -1;
+            }
+            ptr += rc;
+            size -= static_cast<size_t>(rc);
+        }
+        return 0;
+    });
+
+    bool ok = compressor != nullptr;
+    char buffer[64 * 1024];
+    size_t n;
+    while (ok && (n = fread(buffer, 1, sizeof(buffer), localFile)) > 0) {
+        ok = compressor->write(buffer, n) == 0;
+    }
+    ok = ok && compressor->finish() == 0;
     fclose(localFile);
+
     libssh2_channel_send_eof(channel);
+    libssh2_channel_wait_eof(channel);
     libssh2_channel_close(channel);
+    libssh2_channel_wait_closed(channel);
+    int exit_status = libssh2_channel_get_exit_status(channel);
     libssh2_channel_free(channel);
+    if (!ok || exit_status != 0) {
+        throw std::runtime_error("Compressed transfer failed (remote exit status " + std::to_string(exit_status) + ")");
+    }
+
+    std::cout << "Compressed " << compressor->input_bytes() << " -> " << compressor->output_bytes()
+              << " bytes, final level " << compressor->level() << std::endl;
+}
 
+int SshTransmit::run_command(const std::string& command, std::string& output) {
     // Execute the command
-    channel = libssh2_channel_open_session(session);
+    LIBSSH2_CHANNEL* channel = libssh2_channel_open_session(m_session);
     if (!channel) {
         throw std::runtime_error("Failed to open channel for command execution");
     }
@@ -87,30 +212,18 @@ void sendFileAndExecuteCommand(const std::string& hostname,
     checkLibssh2Result(libssh2_channel_exec(channel, command.c_str()), "Command execution failed");
 
     // Read the command output
+    output.clear();
+    char buffer[4096];
+    ssize_t n;
     while ((n = libssh2_channel_read(channel, buffer, sizeof(buffer))) > 0) {
-        std::cout.write(buffer, n);
+        output.append(buffer, static_cast<size_t>(n));
     }
 
     libssh2_channel_close(channel);
+    libssh2_channel_wait_closed(channel);
+    int exit_status = libssh2_channel_get_exit_status(channel);
     libssh2_channel_free(channel);
-
-    // Cleanup
-    libssh2_session_disconnect(session, "Normal Shutdown");
-    libssh2_session_free(session);
-    close(sock);
-    libssh2_exit();
+    return exit_status;
 }
 
-int main() {
-    try {
-        sendFileAndExecuteCommand("192.168.1.10", 22, "username", "password",
-                                  "/path/to/local/file.txt",
-                                  "/path/to/remote/file.txt",
-                                  "ls -l /path/to/remote/");
-    } catch (const std::exception& e) {
-        std::cerr << "Error: " << e.what() << std::endl;
-        return 1;
-    }
-
-    return 0;
-}
\ No newline at end of file
+}; // namespace RemoteDebug
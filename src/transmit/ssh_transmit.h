@@ -0,0 +1,54 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 使用 ssh 连接设备：scp 上传文件，exec 通道执行远端命令
+
+#pragma once
+
+#include "transmit.h"
+#include "compress.h"
+
+#include <string>
+
+typedef struct _LIBSSH2_SESSION LIBSSH2_SESSION;
+
+namespace RemoteDebug {
+
+/**
+ * @brief SSH 传输，同一设备的多次调用复用已建立的会话
+ */
+class SshTransmit : public RemoteTransmit {
+public:
+    SshTransmit() = default;
+    ~SshTransmit() override;
+
+    int transmit(const Device_info &device_info) override;
+    int execute(const Device_info &device_info, const std::string &command, std::string &output) override;
+
+    /**
+     * @brief 启用流式压缩：数据经压缩后写入 "<tool> decompress <file>" 的标准输入，由设备侧解压
+     * @param[in] type 压缩算法，NONE 表示关闭
+     * @param[in] remote_tool 远端热补丁工具路径
+     */
+    void set_compression(COMPRESS_TYPE type, std::string remote_tool = remote_tool_path)
+    {
+        m_compress_type = type;
+        m_remote_tool = std::move(remote_tool);
+    }
+
+private:
+    void connect(const Device_info &device_info);
+    void disconnect();
+    void send_file(const Device_info &device_info);
+    void send_compressed(const Device_info &device_info);
+    int run_command(const std::string &command, std::string &output);
+
+private:
+    int              m_socket_fd{ -1 };
+    LIBSSH2_SESSION *m_session{ nullptr };
+    uint32_t         m_ip{ 0 };
+    uint32_t         m_port{ 0 };
+    std::string      m_username;
+    COMPRESS_TYPE    m_compress_type{ COMPRESS_TYPE::NONE };
+    std::string      m_remote_tool{ remote_tool_path };
+};
+
+}; // namespace RemoteDebug
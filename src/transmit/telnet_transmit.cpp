@@ -0,0 +1,513 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "telnet_transmit.h"
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace RemoteDebug {
+
+namespace {
+
+// telnet 命令（RFC 854）
+constexpr uint8_t telnet_se = 240;
+constexpr uint8_t telnet_sb = 250;
+constexpr uint8_t telnet_will = 251;
+constexpr uint8_t telnet_wont = 252;
+constexpr uint8_t telnet_do = 253;
+constexpr uint8_t telnet_dont = 254;
+constexpr uint8_t telnet_iac = 255;
+
+// 仅接受服务端回显与抑制 GA，其余选项一律拒绝，保持 NVT 文本模式
+constexpr uint8_t option_echo = 1;
+constexpr uint8_t option_sga = 3;
+
+constexpr int login_sync_attempts = 3;
+constexpr int login_sync_timeout_ms = 3000;
+
+constexpr std::array<uint32_t, 256> make_cksum_table()
+{
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i << 24;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80000000u) ? (crc << 1) ^ 0x04C11DB7u : crc << 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<uint32_t, 256> cksum_table = make_cksum_table();
+
+uint32_t cksum_update(uint32_t crc, const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        crc = (crc << 8) ^ cksum_table[(crc >> 24) ^ data[i]];
+    }
+    return crc;
+}
+
+// POSIX cksum 在数据之后追加长度（低字节在前，去掉高位的 0）
+uint32_t cksum_final(uint32_t crc, uint64_t length)
+{
+    for (; length; length >>= 8) {
+        crc = (crc << 8) ^ cksum_table[(crc >> 24) ^ (length & 0xFF)];
+    }
+    return ~crc;
+}
+
+std::string base64_encode(const uint8_t *data, size_t size)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((size + 2) / 3 * 4);
+    size_t i = 0;
+    for (; i + 3 <= size; i += 3) {
+        uint32_t v = (uint32_t{ data[i] } << 16) | (uint32_t{ data[i + 1] } << 8) | data[i + 2];
+        out += alphabet[v >> 18];
+        out += alphabet[(v >> 12) & 63];
+        out += alphabet[(v >> 6) & 63];
+        out += alphabet[v & 63];
+    }
+    if (i < size) {
+        uint32_t v = uint32_t{ data[i] } << 16;
+        if (i + 1 < size) {
+            v |= uint32_t{ data[i + 1] } << 8;
+        }
+        out += alphabet[v >> 18];
+        out += alphabet[(v >> 12) & 63];
+        out += i + 1 < size ? alphabet[(v >> 6) & 63] : '=';
+        out += '=';
+    }
+    return out;
+}
+
+} // namespace
+
+uint32_t TelnetTransmit::posix_cksum(const void *data, size_t size)
+{
+    return cksum_final(cksum_update(0, static_cast<const uint8_t *>(data), size), size);
+}
+
+TelnetTransmit::~TelnetTransmit()
+{
+    disconnect();
+}
+
+int TelnetTransmit::transmit(const Device_info &device_info)
+{
+    if (connect(device_info) != 0) {
+        return -1;
+    }
+    if (send_file(device_info) != 0) {
+        // 失败时终端可能仍停留在解码循环中，下次重新登录
+        disconnect();
+        return -1;
+    }
+    return 0;
+}
+
+int TelnetTransmit::execute(const Device_info &device_info, const std::string &command, std::string &output)
+{
+    if (connect(device_info) != 0) {
+        return -1;
+    }
+
+    // 标记由引号拼接，终端回显的命令行本身不会匹配
+    std::string text;
+    std::string status;
+    if (send_line("echo RD\"BEGIN\"; { " + command + "; } < /dev/null; echo RD\"EXIT\" $?") != 0 ||
+        wait_for({ "RDBEGIN" }) != 0 || read_rest_of_line(status) != 0 ||
+        wait_for({ "RDEXIT " }, &text) != 0 || read_rest_of_line(status) != 0) {
+        std::cerr << "Telnet execute failed: " << command << std::endl;
+        disconnect();
+        return -1;
+    }
+
+    // 终端输出的换行为 CR LF
+    output.clear();
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '\r' || i + 1 >= text.size() || text[i + 1] != '\n') {
+            output += text[i];
+        }
+    }
+    return std::atoi(status.c_str());
+}
+
+int TelnetTransmit::connect(const Device_info &device_info)
+{
+    // 同一设备复用已登录的会话
+    if (m_socket_fd >= 0 && m_ip == device_info.ip && m_port == device_info.port &&
+        m_username == device_info.m_username) {
+        return 0;
+    }
+    disconnect();
+
+    if (device_info.port > UINT16_MAX) {
+        std::cerr << "Invalid telnet port: " << device_info.port << std::endl;
+        return -1;
+    }
+    m_socket_fd = tcp_connect(device_info.ip, static_cast<uint16_t>(device_info.port));
+    if (m_socket_fd < 0) {
+        return -1;
+    }
+    m_ip = device_info.ip;
+    m_port = device_info.port;
+    m_username = device_info.m_username;
+
+    if (login(device_info) != 0) {
+        std::cerr << "Telnet login to " << ip_to_string(m_ip) << ":" << m_port << " failed" << std::endl;
+        disconnect();
+        return -1;
+    }
+    return 0;
+}
+
+int TelnetTransmit::login(const Device_info &device_info)
+{
+    // 未配置用户名的设备直接进入 shell
+    if (!device_info.m_username.empty()) {
+        if (wait_for({ "ogin:" }) != 0 || send_line(device_info.m_username) != 0) {
+            return -1;
+        }
+        if (!device_info.m_password.empty() &&
+            (wait_for({ "assword:" }) != 0 || send_line(device_info.m_password) != 0)) {
+            return -1;
+        }
+    }
+
+    // 关闭回显后等待同步标记；部分 login 程序在校验密码后会清空输入缓冲，未收到时重发
+    for (int attempt = 0; attempt < login_sync_attempts; ++attempt) {
+        if (send_line("stty -echo 2>/dev/null; echo RD\"READY\"") != 0) {
+            return -1;
+        }
+        int index = wait_for({ "RDREADY", "ncorrect", "denied" }, nullptr, login_sync_timeout_ms);
+        if (index == 0) {
+            m_text.clear();
+            return 0;
+        }
+        if (index > 0 || m_socket_fd < 0) {
+            return -1;
+        }
+    }
+    return -1;
+}
+
+int TelnetTransmit::send_file(const Device_info &device_info)
+{
+    int file_fd = open(device_info.file_name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file_fd < 0) {
+        std::cerr << "Failed to open local file " << device_info.file_name << ": " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    // 压缩流先完整写入设备侧临时文件，校验通过后再解压，解压失败不会留下不完整的目标文件
+    std::string output;
+    bool compressed = false;
+    if (m_compress_type != COMPRESS_TYPE::NONE) {
+        compressed = execute(device_info, "test -x " + shell_quote(m_remote_tool), output) == 0;
+        if (!compressed) {
+            std::cerr << "Telnet device has no " << m_remote_tool << ", sending uncompressed" << std::endl;
+        }
+    }
+    const std::string part_path = shell_quote(device_info.remote_path + (compressed ? ".z.part" : ".part"));
+    if (execute(device_info, "command -v base64 >/dev/null && : > " + part_path, output) != 0) {
+        std::cerr << "Telnet device lacks base64 or cannot create " << part_path << std::endl;
+        close(file_fd);
+        return -1;
+    }
+
+    // 设备侧解码循环：每个窗口先读行数，再由 head 一次读入整窗交给 base64 -d，
+    // 解码失败时仍用 cat 读完本窗口，避免后续数据被 shell 当作命令执行
+    if (send_line("rd_p=" + part_path + "; while IFS= read -r rd_n && [ \"$rd_n\" -gt 0 ] 2>/dev/null; do "
+                  "head -n \"$rd_n\" | { base64 -d >> \"$rd_p\" 2>/dev/null || cat > /dev/null; }; "
+                  "echo RD\"ACK\"; done; echo RD\"END\" $(cksum < \"$rd_p\")") != 0) {
+        close(file_fd);
+        return -1;
+    }
+
+    uint32_t crc = 0;
+    uint64_t length = 0;
+    size_t windows_sent = 0;
+    size_t windows_acked = 0;
+    const size_t window_bytes = chunk_size * m_chunks_per_window;
+
+    // 发送一个窗口（只有最后一个窗口可以不满），未确认的窗口达到上限时等待最早的确认
+    auto send_window = [&](const uint8_t *data, size_t size) {
+        crc = cksum_update(crc, data, size);
+        length += size;
+
+        // 整个窗口拼成一次发送
+        const size_t lines = (size + chunk_size - 1) / chunk_size;
+        std::string window = std::to_string(lines) + "\r\n";
+        for (size_t offset = 0; offset < size; offset += chunk_size) {
+            window += base64_encode(data + offset, std::min(chunk_size, size - offset));
+            window += "\r\n";
+        }
+        if (send_all(m_socket_fd, window.data(), window.size()) != 0) {
+            std::cerr << "Telnet send failed: " << strerror(errno) << std::endl;
+            return -1;
+        }
+        ++windows_sent;
+
+        while (windows_sent - windows_acked >= m_windows_in_flight) {
+            if (wait_for({ "RDACK" }) != 0) {
+                std::cerr << "Telnet upload stalled after " << windows_acked << " windows" << std::endl;
+                return -1;
+            }
+            ++windows_acked;
+        }
+        return 0;
+    };
+
+    // 压缩输出攒满整窗再发送，等待确认的时间计入通道写入耗时，链路慢时压缩级别随之升高
+    std::string staged;
+    std::unique_ptr<StreamCompressor> compressor;
+    if (compressed) {
+        compressor = StreamCompressor::create(m_compress_type, [&](const void *data, size_t size) {
+            staged.append(static_cast<const char *>(data), size);
+            size_t sent = 0;
+            int ret = 0;
+            for (; ret == 0 && staged.size() - sent >= window_bytes; sent += window_bytes) {
+                ret = send_window(reinterpret_cast<const uint8_t *>(staged.data()) + sent, window_bytes);
+            }
+            staged.erase(0, sent);
+            return ret;
+        });
+        if (!compressor) {
+            std::cerr << "Compression type is not available in this build" << std::endl;
+            close(file_fd);
+            return -1;
+        }
+    }
+
+    std::vector<uint8_t> buffer(window_bytes);
+    int ret = 0;
+    while (ret == 0) {
+        // 读满整个窗口，只有文件末尾的分块长度不是 3 的倍数
+        size_t size = 0;
+        while (size < buffer.size()) {
+            ssize_t n = read(file_fd, buffer.data() + size, buffer.size() - size);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0) {
+                std::cerr << "Failed to read " << device_info.file_name << ": " << strerror(errno) << std::endl;
+                ret = -1;
+            }
+            if (n <= 0) {
+                break;
+            }
+            size += static_cast<size_t>(n);
+        }
+        if (ret != 0 || size == 0) {
+            break;
+        }
+        ret = compressor ? compressor->write(buffer.data(), size) : send_window(buffer.data(), size);
+    }
+    close(file_fd);
+    if (compressor && ret == 0) {
+        ret = compressor->finish();
+        if (ret == 0 && !staged.empty()) {
+            ret = send_window(reinterpret_cast<const uint8_t *>(staged.data()), staged.size());
+        }
+    }
+    if (ret != 0) {
+        return -1;
+    }
+
+    std::string summary;
+    if (send_line("0") != 0 || wait_for({ "RDEND " }) != 0 || read_rest_of_line(summary) != 0) {
+        std::cerr << "Telnet upload did not finish" << std::endl;
+        return -1;
+    }
+
+    // cksum 输出 "<crc> <length>"
+    const std::string expected = std::to_string(cksum_final(crc, length)) + " " + std::to_string(length);
+    if (summary != expected) {
+        std::cerr << "Telnet upload checksum mismatch: device \"" << summary << "\", local \"" << expected << "\""
+                  << std::endl;
+        return -1;
+    }
+
+    const std::string remote_path = shell_quote(device_info.remote_path);
+    if (compressed) {
+        std::cout << "Compressed " << compressor->input_bytes() << " -> " << compressor->output_bytes()
+                  << " bytes, final level " << compressor->level() << std::endl;
+        const std::string command = shell_quote(m_remote_tool) + " decompress " + remote_path + " < " + part_path +
+                                    "; rd_s=$?; rm -f " + part_path + "; [ \"$rd_s\" -eq 0 ]";
+        if (execute(device_info, command, output) != 0) {
+            std::cerr << "Telnet decompress into " << device_info.remote_path << " failed: " << output << std::endl;
+            return -1;
+        }
+        return 0;
+    }
+    if (execute(device_info, "mv -f " + part_path + " " + remote_path, output) != 0) {
+        std::cerr << "Telnet rename to " << device_info.remote_path << " failed: " << output << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+void TelnetTransmit::disconnect()
+{
+    if (m_socket_fd >= 0) {
+        close(m_socket_fd);
+        m_socket_fd = -1;
+    }
+    m_text.clear();
+    m_pending.clear();
+    m_answered.reset();
+}
+
+int TelnetTransmit::send_line(const std::string &line)
+{
+    std::string data;
+    data.reserve(line.size() + 2);
+    for (char c : line) {
+        data += c;
+        if (static_cast<uint8_t>(c) == telnet_iac) {
+            data += c;
+        }
+    }
+    data += "\r\n";
+    return send_all(m_socket_fd, data.data(), data.size());
+}
+
+int TelnetTransmit::wait_for(const std::vector<std::string> &markers, std::string *before, int timeout_ms)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    size_t searched = 0;
+    while (true) {
+        // 返回最早出现的标记；只在新数据附近重新查找
+        size_t best_pos = std::string::npos;
+        int best = -1;
+        for (size_t i = 0; i < markers.size(); ++i) {
+            size_t from = searched >= markers[i].size() ? searched - markers[i].size() + 1 : 0;
+            size_t pos = m_text.find(markers[i], from);
+            if (pos < best_pos) {
+                best_pos = pos;
+                best = static_cast<int>(i);
+            }
+        }
+        if (best >= 0) {
+            if (before) {
+                *before = m_text.substr(0, best_pos);
+            }
+            m_text.erase(0, best_pos + markers[static_cast<size_t>(best)].size());
+            return best;
+        }
+        searched = m_text.size();
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0 || receive(static_cast<int>(remaining.count())) != 0) {
+            return -1;
+        }
+    }
+}
+
+int TelnetTransmit::read_rest_of_line(std::string &line)
+{
+    std::string text;
+    if (wait_for({ "\n" }, &text) != 0) {
+        return -1;
+    }
+    while (!text.empty() && (text.back() == '\r' || text.back() == '\0')) {
+        text.pop_back();
+    }
+    line = text;
+    return 0;
+}
+
+int TelnetTransmit::receive(int timeout_ms)
+{
+    pollfd pfd{ m_socket_fd, POLLIN, 0 };
+    int ret;
+    while ((ret = poll(&pfd, 1, timeout_ms)) < 0 && errno == EINTR) {
+    }
+    if (ret <= 0) {
+        return -1;
+    }
+
+    uint8_t buffer[16 * 1024];
+    ssize_t n = recv(m_socket_fd, buffer, sizeof(buffer), 0);
+    if (n <= 0) {
+        std::cerr << "Telnet connection closed: " << (n == 0 ? "eof" : strerror(errno)) << std::endl;
+        disconnect();
+        return -1;
+    }
+
+    m_pending.insert(m_pending.end(), buffer, buffer + n);
+    size_t i = 0;
+    while (i < m_pending.size()) {
+        uint8_t c = m_pending[i];
+        if (c != telnet_iac) {
+            if (c != '\0') {
+                m_text += static_cast<char>(c);
+            }
+            ++i;
+            continue;
+        }
+
+        // IAC 序列不完整时留到下次接收
+        if (i + 1 >= m_pending.size()) {
+            break;
+        }
+        uint8_t command = m_pending[i + 1];
+        if (command == telnet_iac) {
+            m_text += static_cast<char>(telnet_iac);
+            i += 2;
+        } else if (command >= telnet_will && command <= telnet_dont) {
+            if (i + 2 >= m_pending.size()) {
+                break;
+            }
+            handle_option(command, m_pending[i + 2]);
+            i += 3;
+        } else if (command == telnet_sb) {
+            // 子协商 IAC SB ... IAC SE，不支持任何子协商，直接跳过
+            size_t end = i + 2;
+            while (end + 1 < m_pending.size() && !(m_pending[end] == telnet_iac && m_pending[end + 1] == telnet_se)) {
+                ++end;
+            }
+            if (end + 1 >= m_pending.size()) {
+                break;
+            }
+            i = end + 2;
+        } else {
+            i += 2;
+        }
+    }
+    m_pending.erase(m_pending.begin(), m_pending.begin() + static_cast<std::ptrdiff_t>(i));
+    return 0;
+}
+
+void TelnetTransmit::handle_option(uint8_t command, uint8_t option)
+{
+    // DONT/WONT 表示对端保持默认（关闭）状态，无需回复
+    if (command != telnet_do && command != telnet_will) {
+        return;
+    }
+    const size_t index = (command == telnet_will ? 256u : 0u) + option;
+    if (m_answered.test(index)) {
+        return;
+    }
+    m_answered.set(index);
+
+    uint8_t reply = telnet_wont;
+    if (command == telnet_will) {
+        reply = option == option_echo || option == option_sga ? telnet_do : telnet_dont;
+    }
+    const uint8_t data[3] = { telnet_iac, reply, option };
+    send_all(m_socket_fd, data, sizeof(data));
+}
+
+}; // namespace RemoteDebug
@@ -0,0 +1,111 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 使用 telnet 连接设备：登录 shell 后将文件编码为 base64 分块，流式写入设备侧解码器
+
+#pragma once
+
+#include "transmit.h"
+#include "compress.h"
+#include "net_util.h"
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace RemoteDebug {
+
+/**
+ * @brief Telnet 传输，适用于没有 SSH/FTP 服务的设备
+ * @details 登录后关闭终端回显，在设备上启动解码循环：
+ *          主机按窗口发送 "<行数>" + 若干 base64 行，设备用 head -n 读取整个窗口交给 base64 -d，
+ *          每个窗口解码完成后回复一次确认。主机最多保持若干个窗口未确认，
+ *          不必逐行等待往返；全部发送后比较设备侧 cksum 与本地计算的 CRC 和长度，
+ *          一致后再把 .part 文件重命名为目标文件。
+ *          启用压缩且设备上有热补丁工具时，传输的是压缩流，设备侧校验后由
+ *          "<tool> decompress" 还原为目标文件
+ */
+class TelnetTransmit : public RemoteTransmit {
+public:
+    static constexpr size_t chunk_size = 2046; // 单行原始字节数，3 的倍数保证只有最后一行有填充，编码后远小于终端行长限制
+
+    TelnetTransmit() = default;
+    ~TelnetTransmit() override;
+
+    int transmit(const Device_info &device_info) override;
+    int execute(const Device_info &device_info, const std::string &command, std::string &output) override;
+
+    /**
+     * @brief 设置发送窗口
+     * @param[in] chunks_per_window 每个窗口包含的分块数
+     * @param[in] windows_in_flight 允许同时未确认的窗口数
+     */
+    void set_window(size_t chunks_per_window, size_t windows_in_flight)
+    {
+        m_chunks_per_window = chunks_per_window ? chunks_per_window : 1;
+        m_windows_in_flight = windows_in_flight ? windows_in_flight : 1;
+    }
+
+    /**
+     * @brief 启用流式压缩，设备上没有 remote_tool 时退回不压缩的上传
+     * @param[in] type 压缩算法，NONE 表示关闭
+     * @param[in] remote_tool 远端热补丁工具路径
+     */
+    void set_compression(COMPRESS_TYPE type, std::string remote_tool = remote_tool_path)
+    {
+        m_compress_type = type;
+        m_remote_tool = std::move(remote_tool);
+    }
+
+    /**
+     * @brief 计算与 POSIX cksum 命令一致的 CRC（包含长度）
+     */
+    static uint32_t posix_cksum(const void *data, size_t size);
+
+private:
+    int connect(const Device_info &device_info);
+    int login(const Device_info &device_info);
+    int send_file(const Device_info &device_info);
+    void disconnect();
+
+    /**
+     * @brief 发送一行 shell 输入（自动转义 IAC 并追加 CR LF）
+     */
+    int send_line(const std::string &line);
+
+    /**
+     * @brief 读取直到出现任意一个标记
+     * @param[in] markers 候选标记
+     * @param[out] before 标记之前的文本，可为空
+     * @param[in] timeout_ms 等待超时时间
+     * @return 返回匹配的标记下标，超时或连接断开返回-1
+     */
+    int wait_for(const std::vector<std::string> &markers, std::string *before = nullptr,
+                 int timeout_ms = default_io_timeout_ms);
+
+    /**
+     * @brief 读取标记所在行的剩余部分（去掉行尾 CR LF）
+     */
+    int read_rest_of_line(std::string &line);
+
+    /**
+     * @brief 接收数据并处理 telnet 选项协商，正文追加到 m_text
+     * @return 成功返回0，超时或连接断开返回-1
+     */
+    int receive(int timeout_ms);
+    void handle_option(uint8_t command, uint8_t option);
+
+private:
+    int                  m_socket_fd{ -1 };
+    uint32_t             m_ip{ 0 };
+    uint32_t             m_port{ 0 };
+    std::string          m_username;
+    std::string          m_text;                  // 已接收的终端输出（已去除 telnet 命令）
+    std::vector<uint8_t> m_pending;               // 未接收完整的 IAC 序列
+    std::bitset<512>     m_answered;              // 已回复过的 DO/WILL 选项，避免协商循环
+    size_t               m_chunks_per_window{ 16 };
+    size_t               m_windows_in_flight{ 2 };
+    COMPRESS_TYPE        m_compress_type{ COMPRESS_TYPE::NONE };
+    std::string          m_remote_tool{ remote_tool_path };
+};
+
+}; // namespace RemoteDebug
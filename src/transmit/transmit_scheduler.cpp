@@ -0,0 +1,360 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+
+#include "transmit_scheduler.h"
+#include "blocking_session.h"
+#include "ftp_async_session.h"
+#include "net_util.h"
+#include "telnet_transmit.h"
+#ifdef REMOTEDEBUG_HAVE_LIBSSH2
+#include "ssh_transmit.h"
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace RemoteDebug {
+
+namespace {
+
+constexpr int max_events = 256;
+constexpr int max_wait_ms = 1000;
+
+/**
+ * @brief epoll 事件循环，记录每个 fd 所属的设备
+ * @details epoll_event 中同时保存 fd 与注册序号，会话关闭 fd 后同一批事件中
+ *          编号被复用的新 fd 不会收到旧 fd 的残留事件
+ */
+class EventLoop : public EventRegistry {
+public:
+    EventLoop() : m_epoll_fd(epoll_create1(EPOLL_CLOEXEC)) {}
+    ~EventLoop() override
+    {
+        if (m_epoll_fd >= 0) {
+            close(m_epoll_fd);
+        }
+    }
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    bool valid() const { return m_epoll_fd >= 0; }
+
+    // 当前正在回调的设备，新注册的 fd 归属于它
+    void set_owner(size_t owner) { m_owner = owner; }
+
+    int watch(int fd, uint32_t events) override
+    {
+        auto it = m_fds.find(fd);
+        int op = it == m_fds.end() ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+        uint32_t token = it == m_fds.end() ? ++m_next_token : it->second.token;
+
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = (static_cast<uint64_t>(token) << 32) | static_cast<uint32_t>(fd);
+        if (epoll_ctl(m_epoll_fd, op, fd, &event) != 0) {
+            std::cerr << "epoll_ctl failed on fd " << fd << ": " << strerror(errno) << std::endl;
+            return -1;
+        }
+        if (it == m_fds.end()) {
+            m_fds[fd] = { m_owner, token };
+        }
+        return 0;
+    }
+
+    void unwatch(int fd) override
+    {
+        if (m_fds.erase(fd) != 0) {
+            epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        }
+    }
+
+    int wait(epoll_event *events, int timeout_ms)
+    {
+        int n = epoll_wait(m_epoll_fd, events, max_events, timeout_ms);
+        return n < 0 && errno == EINTR ? 0 : n;
+    }
+
+    /**
+     * @brief 查找事件所属设备，过期事件返回 false
+     */
+    bool lookup(const epoll_event &event, int &fd, size_t &owner) const
+    {
+        fd = static_cast<int>(event.data.u64 & 0xFFFFFFFF);
+        auto it = m_fds.find(fd);
+        if (it == m_fds.end() || it->second.token != static_cast<uint32_t>(event.data.u64 >> 32)) {
+            return false;
+        }
+        owner = it->second.owner;
+        return true;
+    }
+
+private:
+    struct Registration {
+        size_t   owner;
+        uint32_t token;
+    };
+
+    int                                   m_epoll_fd;
+    size_t                                m_owner{ 0 };
+    uint32_t                              m_next_token{ 0 };
+    std::unordered_map<int, Registration> m_fds;
+};
+
+struct DeviceTask {
+    std::unique_ptr<AsyncSession> session;
+    TransmitReport                report;
+    uint32_t                      subnet{ 0 };
+    bool                          active{ false };
+    SteadyClock::time_point       first_start;
+    SteadyClock::time_point       next_start;   // 重试时间
+    SteadyClock::time_point       deadline;     // 当前尝试的超时时间
+};
+
+int milliseconds_until(SteadyClock::time_point now, SteadyClock::time_point when)
+{
+    if (when <= now) {
+        return 0;
+    }
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(when - now).count() + 1;
+    return static_cast<int>(std::min<long long>(ms, max_wait_ms));
+}
+
+double to_ms(std::chrono::microseconds us)
+{
+    return static_cast<double>(us.count()) / 1000.0;
+}
+
+} // namespace
+
+TransmitScheduler::TransmitScheduler(TransmitPolicy policy, SessionFactory factory)
+    : m_policy(policy), m_factory(std::move(factory))
+{
+    m_policy.max_concurrency = std::max<size_t>(m_policy.max_concurrency, 1);
+    m_policy.max_per_subnet = std::max<size_t>(m_policy.max_per_subnet, 1);
+    m_policy.max_attempts = std::max(m_policy.max_attempts, 1);
+    m_policy.subnet_prefix = std::min<uint32_t>(m_policy.subnet_prefix, 32);
+}
+
+std::unique_ptr<AsyncSession> TransmitScheduler::default_session_factory(const Device_info &device_info)
+{
+    switch (device_info.trans_type) {
+        case TRANSMIT_TYPE::FTP:
+            return std::make_unique<FtpAsyncSession>(device_info);
+        case TRANSMIT_TYPE::TELNET:
+            // 设备上已有热补丁工具时压缩上传，否则自动退回不压缩
+            return std::make_unique<BlockingSession>(device_info, [] {
+                auto telnet = std::make_unique<TelnetTransmit>();
+                telnet->set_compression(StreamCompressor::preferred_type());
+                return telnet;
+            });
+#ifdef REMOTEDEBUG_HAVE_LIBSSH2
+        case TRANSMIT_TYPE::SSH:
+            return std::make_unique<BlockingSession>(device_info, [] { return std::make_unique<SshTransmit>(); });
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+std::vector<TransmitReport> TransmitScheduler::run(const std::vector<Device_info> &devices)
+{
+    std::vector<DeviceTask> tasks(devices.size());
+    std::vector<TransmitReport> reports(devices.size());
+
+    EventLoop loop;
+    if (!loop.valid()) {
+        std::cerr << "Failed to create epoll instance: " << strerror(errno) << std::endl;
+        for (auto &report : reports) {
+            report.error = "epoll unavailable";
+        }
+        return reports;
+    }
+
+    // 多个数据连接同时 sendfile，统一屏蔽 SIGPIPE 由返回值处理断连
+    SigpipeGuard sigpipe_guard;
+    std::minstd_rand jitter_rng(static_cast<uint32_t>(SteadyClock::now().time_since_epoch().count()));
+
+    const auto start_time = SteadyClock::now();
+    std::vector<size_t> waiting;
+    for (size_t i = 0; i < devices.size(); ++i) {
+        const Device_info &device = devices[i];
+        DeviceTask &task = tasks[i];
+        task.report.device = ip_to_string(device.ip) + ":" + std::to_string(device.port) + " " + device.remote_path;
+        task.subnet = m_policy.subnet_prefix == 0 ? 0 : device.ip >> (32 - m_policy.subnet_prefix);
+        task.first_start = start_time;
+        task.next_start = start_time;
+        task.session = m_factory(device);
+        if (!task.session) {
+            task.report.error = "unsupported transmit type";
+            std::cerr << "Transmit to " << task.report.device << " failed: " << task.report.error << std::endl;
+            if (m_progress) {
+                m_progress(i, task.report);
+            }
+            continue;
+        }
+        waiting.push_back(i);
+    }
+
+    size_t active_count = 0;
+    std::unordered_map<uint32_t, size_t> subnet_active;
+
+    // 结束一次尝试：成功或放弃则完成，否则按指数退避（带 ±25% 抖动）重新排队
+    auto finish_attempt = [&](size_t index, SESSION_STATE state, const std::string &error) {
+        DeviceTask &task = tasks[index];
+        loop.set_owner(index);
+        task.session->close(loop);
+        task.active = false;
+        --active_count;
+        --subnet_active[task.subnet];
+
+        const auto now = SteadyClock::now();
+        TransmitReport &report = task.report;
+        report.status = state == SESSION_STATE::DONE ? 0 : -1;
+        report.bytes_sent = task.session->bytes_sent();
+        report.connect_latency = task.session->connect_latency();
+        report.handshake_latency = task.session->handshake_latency();
+        report.total_time = std::chrono::duration_cast<std::chrono::microseconds>(now - task.first_start);
+        report.error = state == SESSION_STATE::DONE ? "" : error;
+
+        if (state != SESSION_STATE::DONE) {
+            std::cerr << "Transmit to " << report.device << " failed (attempt " << report.attempts << "/"
+                      << m_policy.max_attempts << "): " << error << std::endl;
+            if (report.attempts < m_policy.max_attempts) {
+                std::chrono::milliseconds backoff = m_policy.initial_backoff * (1 << std::min(report.attempts - 1, 20));
+                backoff = std::min(backoff, m_policy.max_backoff);
+                std::uniform_real_distribution<double> jitter(0.75, 1.25);
+                task.next_start = now + std::chrono::duration_cast<std::chrono::milliseconds>(backoff * jitter(jitter_rng));
+                waiting.push_back(index);
+            }
+        }
+        if (m_progress) {
+            m_progress(index, report);
+        }
+    };
+
+    epoll_event events[max_events];
+    while (active_count > 0 || !waiting.empty()) {
+        // 1. 在并发上限内启动到期的设备，按入队顺序放行，子网已满的设备留在队列中
+        auto now = SteadyClock::now();
+        for (size_t pos = 0; pos < waiting.size() && active_count < m_policy.max_concurrency;) {
+            size_t index = waiting[pos];
+            DeviceTask &task = tasks[index];
+            if (task.next_start > now || subnet_active[task.subnet] >= m_policy.max_per_subnet) {
+                ++pos;
+                continue;
+            }
+            waiting.erase(waiting.begin() + static_cast<std::ptrdiff_t>(pos));
+
+            ++task.report.attempts;
+            ++active_count;
+            ++subnet_active[task.subnet];
+            task.active = true;
+            task.deadline = now + m_policy.session_timeout;
+            loop.set_owner(index);
+            if (task.session->start(loop) != SESSION_STATE::RUNNING) {
+                finish_attempt(index, SESSION_STATE::FAILED, task.session->error());
+            }
+        }
+
+        // 2. 等待事件，超时时间取最近的会话超时或重试时间
+        int timeout_ms = max_wait_ms;
+        for (const auto &task : tasks) {
+            if (task.active) {
+                timeout_ms = std::min(timeout_ms, milliseconds_until(now, task.deadline));
+            }
+        }
+        if (active_count < m_policy.max_concurrency) {
+            for (size_t index : waiting) {
+                timeout_ms = std::min(timeout_ms, milliseconds_until(now, tasks[index].next_start));
+            }
+        }
+        if (active_count == 0 && waiting.empty()) {
+            break;
+        }
+
+        int n = loop.wait(events, timeout_ms);
+        if (n < 0) {
+            std::cerr << "epoll_wait failed: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        // 3. 分发事件
+        for (int i = 0; i < n; ++i) {
+            int fd;
+            size_t index;
+            if (!loop.lookup(events[i], fd, index) || !tasks[index].active) {
+                continue;
+            }
+            loop.set_owner(index);
+            SESSION_STATE state = tasks[index].session->on_event(loop, fd, events[i].events);
+            if (state != SESSION_STATE::RUNNING) {
+                finish_attempt(index, state, tasks[index].session->error());
+            }
+        }
+
+        // 4. 处理超时
+        now = SteadyClock::now();
+        for (size_t index = 0; index < tasks.size(); ++index) {
+            if (tasks[index].active && now >= tasks[index].deadline) {
+                finish_attempt(index, SESSION_STATE::FAILED, "timed out");
+            }
+        }
+    }
+
+    // epoll 异常退出时，未完成的设备按失败处理
+    for (size_t index = 0; index < tasks.size(); ++index) {
+        if (tasks[index].active) {
+            loop.set_owner(index);
+            tasks[index].session->close(loop);
+            tasks[index].report.error = "aborted";
+        }
+        reports[index] = std::move(tasks[index].report);
+    }
+    return reports;
+}
+
+void TransmitScheduler::print_report(std::ostream &os, const std::vector<TransmitReport> &reports)
+{
+    std::vector<double> totals;
+    size_t succeeded = 0;
+    uint64_t bytes = 0;
+    const std::ios::fmtflags flags = os.flags();
+    const std::streamsize precision = os.precision();
+
+    os << std::left << std::setw(40) << "device" << std::right << std::setw(8) << "status" << std::setw(10)
+       << "attempts" << std::setw(12) << "bytes" << std::setw(12) << "connect_ms" << std::setw(14) << "handshake_ms"
+       << std::setw(12) << "total_ms" << "  error" << std::endl;
+    os << std::fixed << std::setprecision(2);
+    for (const auto &report : reports) {
+        os << std::left << std::setw(40) << report.device << std::right << std::setw(8)
+           << (report.status == 0 ? "ok" : "failed") << std::setw(10) << report.attempts << std::setw(12)
+           << report.bytes_sent << std::setw(12) << to_ms(report.connect_latency) << std::setw(14)
+           << to_ms(report.handshake_latency) << std::setw(12) << to_ms(report.total_time) << "  " << report.error
+           << std::endl;
+        if (report.status == 0) {
+            ++succeeded;
+            bytes += report.bytes_sent;
+            totals.push_back(to_ms(report.total_time));
+        }
+    }
+
+    os << succeeded << "/" << reports.size() << " devices succeeded, " << bytes << " bytes sent";
+    if (!totals.empty()) {
+        std::sort(totals.begin(), totals.end());
+        auto percentile = [&](double p) {
+            return totals[std::min(totals.size() - 1, static_cast<size_t>(p * static_cast<double>(totals.size())))];
+        };
+        os << ", total_ms p50 " << percentile(0.5) << " p90 " << percentile(0.9) << " max " << totals.back();
+    }
+    os << std::endl;
+    os.flags(flags);
+    os.precision(precision);
+}
+
+}; // namespace RemoteDebug
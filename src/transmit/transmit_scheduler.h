@@ -0,0 +1,127 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 异步批量传输：单个 epoll 事件循环驱动多个设备的非阻塞会话
+
+#pragma once
+
+#include "transmit.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace RemoteDebug {
+
+using SteadyClock = std::chrono::steady_clock;
+
+struct TransmitPolicy {
+    size_t                    max_concurrency{ 64 };      // 全局同时进行的会话数
+    size_t                    max_per_subnet{ 8 };        // 同一子网同时进行的会话数
+    uint32_t                  subnet_prefix{ 24 };        // 子网前缀长度
+    int                       max_attempts{ 3 };          // 每个设备最多尝试次数
+    std::chrono::milliseconds initial_backoff{ 500 };     // 首次重试等待，之后翻倍
+    std::chrono::milliseconds max_backoff{ 10000 };
+    std::chrono::milliseconds session_timeout{ 60000 };   // 单次尝试的总超时
+};
+
+struct TransmitReport {
+    std::string               device;                     // ip:port -> remote_path
+    int                       status{ -1 };               // 0 成功，-1 失败
+    int                       attempts{ 0 };
+    uint64_t                  bytes_sent{ 0 };            // 最后一次尝试发送的字节数
+    std::chrono::microseconds connect_latency{ 0 };       // TCP 建连耗时
+    std::chrono::microseconds handshake_latency{ 0 };     // 建连到登录完成
+    std::chrono::microseconds total_time{ 0 };            // 首次开始到最终完成（含重试等待）
+    std::string               error;
+};
+
+enum class SESSION_STATE {
+    RUNNING,
+    DONE,
+    FAILED
+};
+
+/**
+ * @brief 事件循环提供给会话的 fd 注册接口
+ */
+class EventRegistry {
+public:
+    virtual ~EventRegistry() = default;
+    virtual int watch(int fd, uint32_t events) = 0;  // 新增或修改监听事件（EPOLLIN/EPOLLOUT）
+    virtual void unwatch(int fd) = 0;
+};
+
+/**
+ * @brief 非阻塞会话：由调度器在 fd 就绪时回调推进状态机
+ */
+class AsyncSession {
+public:
+    virtual ~AsyncSession() = default;
+
+    /**
+     * @brief 开始一次尝试（发起非阻塞连接并注册 fd）
+     */
+    virtual SESSION_STATE start(EventRegistry &registry) = 0;
+
+    /**
+     * @brief fd 就绪回调
+     */
+    virtual SESSION_STATE on_event(EventRegistry &registry, int fd, uint32_t events) = 0;
+
+    /**
+     * @brief 结束当前尝试，关闭并注销所有 fd（成功、失败、超时后都会调用）
+     */
+    virtual void close(EventRegistry &registry) = 0;
+
+    virtual const std::string &error() const = 0;
+    virtual uint64_t bytes_sent() const = 0;
+    virtual std::chrono::microseconds connect_latency() const = 0;
+    virtual std::chrono::microseconds handshake_latency() const = 0;
+};
+
+using SessionFactory = std::function<std::unique_ptr<AsyncSession>(const Device_info &)>;
+
+/**
+ * @brief 批量传输调度器
+ * @details 所有会话共享一个 epoll 事件循环；按全局与子网并发上限放行，
+ *          失败后按指数退避重试，完成后输出每个设备的耗时报告
+ */
+class TransmitScheduler {
+public:
+    explicit TransmitScheduler(TransmitPolicy policy = {}, SessionFactory factory = default_session_factory);
+
+    /**
+     * @brief 默认会话工厂：FTP 使用非阻塞 FtpAsyncSession，Telnet 与 SSH 使用 BlockingSession
+     *        在工作线程中运行同步实现（Telnet 在设备有热补丁工具时压缩上传），未编译的传输方式返回 nullptr
+     */
+    static std::unique_ptr<AsyncSession> default_session_factory(const Device_info &device_info);
+
+    /**
+     * @brief 设置进度回调，设备完成、失败或进入重试时调用
+     */
+    void set_progress_callback(std::function<void(size_t index, const TransmitReport &)> callback)
+    {
+        m_progress = std::move(callback);
+    }
+
+    /**
+     * @brief 向全部设备传输文件，返回时所有设备均已完成或放弃
+     * @return 报告与 devices 一一对应
+     */
+    std::vector<TransmitReport> run(const std::vector<Device_info> &devices);
+
+    /**
+     * @brief 输出报告汇总：每设备状态、尝试次数、建连/握手/总耗时，以及整体耗时分位
+     */
+    static void print_report(std::ostream &os, const std::vector<TransmitReport> &reports);
+
+private:
+    TransmitPolicy                                             m_policy;
+    SessionFactory                                             m_factory;
+    std::function<void(size_t, const TransmitReport &)>        m_progress;
+};
+
+}; // namespace RemoteDebug
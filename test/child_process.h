@@ -0,0 +1,95 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 测试辅助：启动子进程并通过管道与其标准输入输出交互
+
+#pragma once
+
+#include <chrono>
+#include <fcntl.h>
+#include <poll.h>
+#include <string>
+#include <sys/types.h>
+#include <unistd.h>
+#include <vector>
+
+namespace RemoteDebug {
+namespace test {
+
+struct Child {
+    pid_t       pid{ -1 };
+    int         input{ -1 };  // 子进程标准输入
+    int         output{ -1 }; // 子进程标准输出
+    std::string buffer;
+};
+
+/**
+ * @brief 启动子进程
+ * @param[in] args 程序路径与参数
+ * @param[in] env 额外的环境变量（"NAME=value"）
+ */
+inline Child spawn(const std::vector<std::string> &args, const std::vector<std::string> &env = {})
+{
+    int in_pipe[2];
+    int out_pipe[2];
+    Child child;
+    if (pipe2(in_pipe, O_CLOEXEC) != 0 || pipe2(out_pipe, O_CLOEXEC) != 0) {
+        return child;
+    }
+    child.pid = fork();
+    if (child.pid == 0) {
+        dup2(in_pipe[0], STDIN_FILENO);
+        dup2(out_pipe[1], STDOUT_FILENO);
+        for (const auto &entry : env) {
+            putenv(const_cast<char *>(entry.c_str()));
+        }
+        std::vector<char *> argv;
+        for (const auto &arg : args) {
+            argv.push_back(const_cast<char *>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    close(in_pipe[0]);
+    close(out_pipe[1]);
+    child.input = in_pipe[1];
+    child.output = out_pipe[0];
+    return child;
+}
+
+/**
+ * @brief 读取子进程输出直至出现以 prefix 开头的行
+ * @param[out] line 匹配的行，可为空
+ * @return 超时或子进程关闭输出返回 false
+ */
+inline bool wait_line(Child &child, const std::string &prefix, std::string *line = nullptr,
+        std::chrono::milliseconds timeout = std::chrono::milliseconds(3000))
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+        size_t pos;
+        while ((pos = child.buffer.find('\n')) != std::string::npos) {
+            std::string current = child.buffer.substr(0, pos);
+            child.buffer.erase(0, pos + 1);
+            if (current.compare(0, prefix.size(), prefix) == 0) {
+                if (line) {
+                    *line = current;
+                }
+                return true;
+            }
+        }
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        pollfd pfd{ child.output, POLLIN, 0 };
+        if (left.count() <= 0 || poll(&pfd, 1, static_cast<int>(left.count())) <= 0) {
+            return false;
+        }
+        char buffer[512];
+        ssize_t n = read(child.output, buffer, sizeof(buffer));
+        if (n <= 0) {
+            return false;
+        }
+        child.buffer.append(buffer, static_cast<size_t>(n));
+    }
+}
+
+}; // namespace test
+}; // namespace RemoteDebug
@@ -0,0 +1,89 @@
+#include "inject/command_ring.h"
+#include "test_common.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace RemoteDebug;
+using test::expect;
+
+namespace {
+
+// 与进程内代理相同的处理循环，"slow" 请求处理 100ms
+void serve(CommandRing *ring, const std::atomic<bool> &stop)
+{
+    while (!stop) {
+        uint32_t doorbell = ring->doorbell.load(std::memory_order_acquire);
+        for (auto &slot : ring->slots) {
+            uint32_t expected = static_cast<uint32_t>(SLOT_STATE::READY);
+            if (!slot.state.compare_exchange_strong(expected, static_cast<uint32_t>(SLOT_STATE::PROCESSING))) {
+                continue;
+            }
+            const std::string request(slot.request, strnlen(slot.request, command_text_size));
+            if (request == "slow") {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            ring_complete(slot, "OK " + request);
+        }
+        ring_wait(ring->doorbell, doorbell, 10);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    const std::string name = command_ring_name(getpid());
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0 || ftruncate(fd, sizeof(CommandRing)) != 0) {
+        std::cerr << "Failed to create " << name << std::endl;
+        return 1;
+    }
+    void *mapped = mmap(nullptr, sizeof(CommandRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return 1;
+    }
+    auto *ring = static_cast<CommandRing *>(mapped);
+    ring->version = command_ring_version;
+    ring->pid = getpid();
+    ring->magic = command_ring_magic;
+    std::atomic<bool> stop{ false };
+    std::thread server(serve, ring, std::cref(stop));
+
+    // 1. 正常请求
+    std::string reply;
+    expect(ring_request(getpid(), "status", reply, 1000) == 0 && reply == "OK status", "request: " + reply);
+
+    // 2. 处理中超时的请求不会永久占用槽位：超时次数多于槽位数后仍可发送请求
+    size_t timed_out = 0;
+    for (size_t i = 0; i < command_ring_slots + 2; ++i) {
+        timed_out += ring_request(getpid(), "slow", reply, 30) != 0;
+        std::this_thread::sleep_for(std::chrono::milliseconds(80)); // 下一个请求到达时代理已空闲，会被取走处理
+    }
+    expect(timed_out == command_ring_slots + 2, "slow requests time out: " + std::to_string(timed_out));
+    expect(ring_request(getpid(), "after", reply, 1000) == 0 && reply == "OK after", "request after timeouts");
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    size_t free_slots = 0;
+    for (const auto &slot : ring->slots) {
+        free_slots += slot.state.load() == static_cast<uint32_t>(SLOT_STATE::FREE);
+    }
+    expect(free_slots == command_ring_slots, "abandoned slots are freed: " + std::to_string(free_slots));
+
+    stop = true;
+    ring->doorbell.fetch_add(1);
+    ring_wake(ring->doorbell);
+    server.join();
+    munmap(mapped, sizeof(CommandRing));
+    shm_unlink(name.c_str());
+
+    return test::report("command_ring_test");
+}
@@ -0,0 +1,155 @@
+#include "transmit/compress.h"
+#include "test_common.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <thread>
+
+using namespace RemoteDebug;
+using test::expect;
+using namespace std::chrono_literals;
+
+namespace {
+
+// 类似符号表/代码段的可压缩数据
+std::string sample_data(size_t size)
+{
+    std::mt19937 rng(1);
+    const char *words[] = { "_ZN11RemoteDebug", "transmit", "Device_info", "\x48\x89\xe5", "\x0f\x1f\x44", "patch" };
+    std::string data;
+    while (data.size() < size) {
+        data += words[rng() % 6];
+        data.push_back(static_cast<char>(rng() % 16));
+    }
+    data.resize(size);
+    return data;
+}
+
+std::string compress_all(COMPRESS_TYPE type, const std::string &input, bool adaptive, int *final_level = nullptr)
+{
+    std::string output;
+    auto compressor = StreamCompressor::create(type, [&](const void *data, size_t size) {
+        output.append(static_cast<const char *>(data), size);
+        return 0;
+    }, adaptive);
+
+    // 模拟文件读取：按不规则大小分块写入
+    for (size_t pos = 0; pos < input.size();) {
+        size_t chunk = std::min<size_t>(input.size() - pos, 1000 + pos % 70000);
+        expect(compressor->write(input.data() + pos, chunk) == 0, "compress write");
+        pos += chunk;
+    }
+    expect(compressor->finish() == 0, "compress finish");
+    expect(compressor->input_bytes() == input.size() && compressor->output_bytes() == output.size(),
+           "compress byte counters");
+    if (final_level) {
+        *final_level = compressor->level();
+    }
+    return output;
+}
+
+std::string decompress_all(const std::string &input, size_t feed_size)
+{
+    std::string output;
+    StreamDecompressor decompressor([&](const void *data, size_t size) {
+        output.append(static_cast<const char *>(data), size);
+        return 0;
+    });
+    for (size_t pos = 0; pos < input.size(); pos += feed_size) {
+        expect(decompressor.write(input.data() + pos, std::min(feed_size, input.size() - pos)) == 0, "decompress write");
+    }
+    expect(decompressor.finish() == 0, "decompress finish");
+    return output;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <RemoteDebug binary>" << std::endl;
+        return 2;
+    }
+
+    // 自适应级别：链路慢时升高，CPU 慢时降低，且不越界
+    AdaptiveLevel adaptive(1, 5, 3);
+    expect(adaptive.update(10ms, 100ms) == 4, "slow link raises level");
+    expect(adaptive.update(10ms, 100ms) == 5 && adaptive.update(10ms, 100ms) == 5, "level capped at max");
+    expect(adaptive.update(100ms, 10ms) == 4, "cpu bound lowers level");
+    expect(adaptive.update(10ms, 15ms) == 4, "balanced keeps level");
+    for (int i = 0; i < 10; ++i) {
+        adaptive.update(100ms, 1ms);
+    }
+    expect(adaptive.level() == 1, "level floored at min");
+
+    const COMPRESS_TYPE type = StreamCompressor::preferred_type();
+    if (type == COMPRESS_TYPE::NONE) {
+        std::cout << "compress_test skipped stream checks: no compression library" << std::endl;
+        return test::g_failures ? 1 : 0;
+    }
+
+    const std::string input = sample_data(5 * 1024 * 1024 + 333);
+
+    // 固定级别与自适应级别（内存 sink 几乎无耗时，级别应逐步降到最低）均可正确还原
+    std::string fixed = compress_all(type, input, false);
+    expect(fixed.size() * 3 < input.size(), "sample data compresses");
+    expect(decompress_all(fixed, 1).size() == input.size(), "byte-by-byte decompress length");
+    expect(decompress_all(fixed, 4096) == input, "fixed level round trip");
+
+    int level = 0;
+    std::string adaptive_output = compress_all(type, input, true, &level);
+    expect(decompress_all(adaptive_output, 65536) == input, "adaptive level round trip");
+    expect(level == 1, "fast sink drives level down to minimum");
+
+    expect(decompress_all(compress_all(type, "", false), 16).empty(), "empty stream round trip");
+
+    // 小于 1MB 的文件同样按分段调整级别：受限链路（约 2MB/s）级别升高，内存 sink 级别降低
+    {
+        const std::string small = sample_data(700 * 1024);
+        std::string output;
+        auto throttled = StreamCompressor::create(type, [&](const void *data, size_t size) {
+            output.append(static_cast<const char *>(data), size);
+            std::this_thread::sleep_for(std::chrono::microseconds(size / 2));
+            return 0;
+        });
+        const int initial = throttled->level();
+        for (size_t pos = 0; pos < small.size(); pos += 32 * 1024) {
+            expect(throttled->write(small.data() + pos, std::min<size_t>(32 * 1024, small.size() - pos)) == 0,
+                   "throttled write");
+        }
+        expect(throttled->finish() == 0, "throttled finish");
+        expect(throttled->level() > initial, "throttled sink raises level: " + std::to_string(throttled->level()));
+        expect(decompress_all(output, 65536) == small, "throttled round trip");
+
+        int fast_level = 0;
+        expect(decompress_all(compress_all(type, small, true, &fast_level), 65536) == small, "fast sink round trip");
+        expect(fast_level < initial, "fast sink lowers level: " + std::to_string(fast_level));
+    }
+
+    // 截断的压缩流必须报错
+    {
+        StreamDecompressor decompressor([](const void *, size_t) { return 0; });
+        decompressor.write(fixed.data(), fixed.size() / 2);
+        expect(decompressor.finish() != 0, "truncated stream detected");
+    }
+
+    // 设备侧解压命令：压缩流经标准输入写入目标文件
+    char dir_template[] = "/tmp/compress_test_XXXXXX";
+    std::string dir = mkdtemp(dir_template);
+    std::string remote = dir + "/remote_file";
+    FILE *pipe = popen((std::string(argv[1]) + " decompress " + remote).c_str(), "w");
+    fwrite(adaptive_output.data(), 1, adaptive_output.size(), pipe);
+    expect(pclose(pipe) == 0, "remote decompress exit status");
+    std::ifstream file(remote, std::ios::binary);
+    expect(std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()) == input,
+           "remote decompress content");
+    std::system(("rm -rf " + dir).c_str());
+
+    return test::report("compress_test");
+}
@@ -0,0 +1,144 @@
+#include "transmit/delta.h"
+#include "transmit/delta_transmit.h"
+#include "hash.h"
+#include "test_common.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace RemoteDebug;
+using test::expect;
+using test::read_file;
+
+namespace {
+
+void write_file(const std::string &path, const std::string &data)
+{
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << data;
+}
+
+std::string random_bytes(std::mt19937 &rng, size_t size)
+{
+    std::string data(size, '\0');
+    for (auto &c : data) {
+        c = static_cast<char>(rng());
+    }
+    return data;
+}
+
+// 本地模拟设备：“远端”路径即本地路径，远端命令通过 shell 执行
+class LocalTransmit : public RemoteTransmit {
+public:
+    int transmit(const Device_info &device_info) override
+    {
+        ++transmit_count;
+        sent_bytes += read_file(device_info.file_name).size();
+        write_file(device_info.remote_path, read_file(device_info.file_name));
+        return 0;
+    }
+
+    int execute(const Device_info &, const std::string &command, std::string &output) override
+    {
+        FILE *pipe = popen((command + " 2>/dev/null").c_str(), "r");
+        output.clear();
+        char buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+            output.append(buffer, n);
+        }
+        int status = pclose(pipe);
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+
+    int    transmit_count{ 0 };
+    size_t sent_bytes{ 0 };
+};
+
+// 签名 -> 增量 -> 原地重建，校验结果与目标一致
+void round_trip(const std::string &dir, const std::string &basis, const std::string &target, const std::string &name)
+{
+    const std::string basis_path = dir + "/basis";
+    const std::string target_path = dir + "/target";
+    const std::string delta_path = dir + "/delta";
+    write_file(basis_path, basis);
+    write_file(target_path, target);
+
+    FileSignature signature;
+    expect(compute_signature(basis_path, choose_block_size(target.size()), signature) == 0, name + ": signature");
+
+    FileSignature decoded;
+    expect(decode_signature("login banner\n" + encode_signature(signature), decoded) == 0 &&
+           decoded.blocks.size() == signature.blocks.size() && decoded.file_size == signature.file_size,
+           name + ": signature text round trip");
+
+    DeltaStats stats;
+    expect(compute_delta(decoded, target_path, delta_path, &stats) == 0, name + ": compute delta");
+    expect(apply_delta_inplace(basis_path, delta_path) == 0, name + ": apply delta");
+    expect(read_file(basis_path) == target, name + ": rebuilt content");
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <RemoteDebug binary>" << std::endl;
+        return 2;
+    }
+
+    expect(xxh64("", 0) == 0xEF46DB3751D8E999ULL, "xxh64 empty input");
+    expect(xxh64("a", 1) == 0xD24EC4F1A98C6E5BULL, "xxh64 single byte");
+
+    // 设备输出异常时签名解析失败而不是抛出异常
+    FileSignature malformed;
+    expect(decode_signature("RDSIG 1 4096 8192 2\n00000001000000000000000Zsh: command not found\n", malformed) != 0,
+           "non-hex block rejected");
+    expect(decode_signature("RDSIG 1 4096 8192 768614336404564651\n" + std::string(48, '0'), malformed) != 0,
+           "overflowing block count rejected");
+    expect(decode_signature("RDSIG 1 4096 8192 1\n0x000001000000000000000002\n", malformed) != 0,
+           "hex prefix rejected");
+    expect(decode_signature("RDSIG 1 4096 4096 1\n0000000a00000000000000ff\n", malformed) == 0 &&
+               malformed.blocks.size() == 1 && malformed.blocks[0].weak == 10 && malformed.blocks[0].strong == 255,
+           "well-formed block");
+
+    char dir_template[] = "/tmp/delta_test_XXXXXX";
+    std::string dir = mkdtemp(dir_template);
+    std::mt19937 rng(7);
+
+    const std::string basis = random_bytes(rng, 2 * 1024 * 1024 + 123);
+    std::string modified = basis;
+    modified.replace(1000, 16, "0123456789abcdef");        // 原位修改
+    modified.insert(500000, random_bytes(rng, 3000));       // 插入，后续数据整体后移
+    modified.erase(1200000, 70000);                         // 删除
+    modified += random_bytes(rng, 5000);                    // 追加
+
+    round_trip(dir, basis, modified, "mixed edits");
+    round_trip(dir, basis, basis, "identical");
+    round_trip(dir, basis, basis.substr(300000) + basis.substr(0, 300000), "rotated");
+    round_trip(dir, basis, random_bytes(rng, 4096), "unrelated");
+    round_trip(dir, basis, "", "empty target");
+
+    // 完整流程：首次完整传输，之后只发送增量
+    const std::string local = dir + "/patch.so";
+    const std::string remote = dir + "/remote_patch.so";
+    write_file(local, basis);
+
+    LocalTransmit backend;
+    DeltaTransmit delta(backend, argv[1]);
+    Device_info device{ TRANSMIT_TYPE::SSH, 0, 0, local, "", "", remote };
+    expect(delta.transmit(device) == 0 && read_file(remote) == basis, "initial full transmit");
+    expect(delta.last_stats().copied_bytes == 0, "initial transmit has nothing to reuse");
+
+    write_file(local, modified);
+    backend.sent_bytes = 0;
+    expect(delta.transmit(device) == 0 && read_file(remote) == modified, "delta transmit content");
+    expect(backend.sent_bytes * 10 < modified.size(), "delta transmit sends an order of magnitude less");
+    expect(read_file(remote + ".delta").empty(), "remote delta file removed");
+
+    std::system(("rm -rf " + dir).c_str());
+    return test::report("delta_test");
+}
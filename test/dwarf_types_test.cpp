@@ -0,0 +1,82 @@
+#include "inject/dwarf_types.h"
+#include "test_common.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace RemoteDebug;
+using test::expect;
+
+namespace rd_test {
+enum class Mode : uint16_t { IDLE, BUSY };
+struct Limits {
+    static short          floor;
+    static const unsigned ceiling;
+};
+short          Limits::floor = -3;
+const unsigned Limits::ceiling = 9;
+Mode           g_mode = Mode::BUSY;
+} // namespace rd_test
+
+typedef long long rd_counter_t;
+extern "C" {
+volatile rd_counter_t rd_counter = 7;
+bool                  rd_enabled = true;
+}
+
+namespace {
+
+volatile int rd_hidden = 3; // 匿名命名空间中的变量没有外部链接
+
+std::string round_trip(const VariableType &type, const std::string &text)
+{
+    std::vector<uint8_t> bytes;
+    std::string error;
+    if (encode_value(type, text, bytes, error) != 0) {
+        return "ERR " + error;
+    }
+    return bytes.size() == type.size ? format_value(type, bytes.data()) : "ERR size";
+}
+
+} // namespace
+
+int main()
+{
+    // 1. 从自身的调试信息中读取变量类型
+    DwarfTypes types;
+    expect(types.load("/proc/self/exe") == 0 && types.has_debug_info(), "load own debug info");
+    VariableType type;
+    expect(types.find("rd_counter", type) && type.kind == VALUE_KIND::SIGNED && type.size == 8 &&
+               type.name == "rd_counter_t" && !type.is_const,
+           "typedef keeps its name: " + type.name);
+    expect(types.find("rd_enabled", type) && type.kind == VALUE_KIND::BOOL && type.size == 1, "bool variable");
+    expect(types.find("rd_test::Limits::floor", type) && type.kind == VALUE_KIND::SIGNED && type.size == 2,
+           "static member by qualified name");
+    expect(types.find("rd_test::Limits::ceiling", type) && type.is_const, "const static member");
+    expect(types.find("rd_test::g_mode", type) && type.kind == VALUE_KIND::ENUM && type.size == 2,
+           "enum class with underlying type");
+    expect(!types.find("rd_hidden", type), "variables in anonymous namespaces are not linkable");
+    expect(!types.find("rd_missing", type), "unknown variable");
+    (void)rd_counter;
+    (void)rd_enabled;
+    (void)rd_test::g_mode;
+    (void)rd_hidden;
+
+    // 2. 按类型编码与格式化
+    VariableType s8{ "signed char", VALUE_KIND::SIGNED, 1, false };
+    expect(round_trip(s8, "-128") == "-128", "int8 lower bound");
+    expect(round_trip(s8, "128").rfind("ERR", 0) == 0, "int8 overflow");
+    VariableType u32{ "unsigned int", VALUE_KIND::UNSIGNED, 4, false };
+    expect(round_trip(u32, "0xffffffff") == "4294967295", "hex unsigned");
+    expect(round_trip(u32, "-1").rfind("ERR", 0) == 0, "negative unsigned");
+    expect(round_trip(u32, "12abc").rfind("ERR", 0) == 0, "trailing garbage");
+    VariableType f64{ "double", VALUE_KIND::FLOAT, 8, false };
+    expect(round_trip(f64, "0.125") == "0.125", "double");
+    VariableType flag{ "bool", VALUE_KIND::BOOL, 1, false };
+    expect(round_trip(flag, "false") == "false" && round_trip(flag, "2").rfind("ERR", 0) == 0, "bool");
+    VariableType aggregate{ "Limits", VALUE_KIND::AGGREGATE, 16, false };
+    expect(round_trip(aggregate, "1").rfind("ERR", 0) == 0, "aggregates cannot be set from text");
+
+    return test::report("dwarf_types_test");
+}
@@ -0,0 +1,68 @@
+#include "transmit/ftp_transmit.h"
+#include "stub_server.h"
+#include "test_common.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+
+using namespace RemoteDebug;
+using test::expect;
+using test::read_file;
+using test::write_random_file;
+
+int main()
+{
+    char root_template[] = "/tmp/ftp_stub_XXXXXX";
+    std::string root = mkdtemp(root_template);
+    std::string local_file = root + "/patch.so";
+    write_random_file(local_file, 3 * 1024 * 1024 + 17, 42);
+
+    test::FtpStubServer server(root + "/");
+    if (!server.start()) {
+        std::cerr << "Failed to start ftp stub server" << std::endl;
+        return 1;
+    }
+
+    Device_info device{ TRANSMIT_TYPE::FTP, test::loopback_ip, server.port(), local_file, "user", "pass",
+                        "/tmp/remote_debug_file" };
+    FtpTransmit ftp;
+
+    // 1. 完整上传
+    expect(ftp.transmit(device) == 0, "full upload returns 0");
+    expect(read_file(server.local_path(device.remote_path)) == read_file(local_file), "full upload content");
+
+    // 2. 上传中断后断点续传
+    std::remove(server.local_path(device.remote_path).c_str());
+    server.set_abort_after(1024 * 1024);
+    expect(ftp.transmit(device) != 0, "interrupted upload reports failure");
+    server.set_abort_after(0);
+    expect(ftp.transmit(device) == 0, "resumed upload returns 0");
+    expect(server.last_rest_offset() == 1024 * 1024, "resume starts at interrupted offset");
+    expect(read_file(server.local_path(device.remote_path)) == read_file(local_file), "resumed upload content");
+
+    // 3. 中断后本地文件换成另一个版本（大小相同），遗留的前缀不能与新文件拼接
+    std::remove(server.local_path(device.remote_path).c_str());
+    server.set_abort_after(1024 * 1024);
+    expect(ftp.transmit(device) != 0, "interrupted upload of the old build");
+    server.set_abort_after(0);
+    write_random_file(local_file, 3 * 1024 * 1024 + 17, 43);
+    const timespec times[2] = { { 0, UTIME_NOW }, { 1000, 0 } }; // 修改时间必然与上一版本不同
+    expect(utimensat(AT_FDCWD, local_file.c_str(), times, 0) == 0, "touch new build");
+    expect(ftp.transmit(device) == 0, "upload of the new build returns 0");
+    expect(read_file(server.local_path(device.remote_path)) == read_file(local_file), "new build is not spliced");
+
+    // 4. 同一文件遗留的前缀仍然续传
+    std::remove(server.local_path(device.remote_path).c_str());
+    server.set_abort_after(512 * 1024);
+    expect(ftp.transmit(device) != 0, "interrupted upload of the new build");
+    server.set_abort_after(0);
+    expect(ftp.transmit(device) == 0 && server.last_rest_offset() == 512 * 1024, "same build resumes");
+    expect(read_file(server.local_path(device.remote_path)) == read_file(local_file), "resumed new build content");
+
+    server.stop();
+    std::system(("rm -rf " + root).c_str());
+
+    return test::report("ftp_transmit_test");
+}
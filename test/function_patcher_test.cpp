@@ -0,0 +1,336 @@
+#include "inject/grace_period.h"
+#include "inject/probe_ring.h"
+#include "patch.h"
+#include "test_common.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace RemoteDebug;
+using test::expect;
+
+namespace {
+
+// 探针测试回调：单线程使用，保存被改写的返回地址
+int       g_enters = 0;
+int       g_exits = 0;
+uint32_t  g_last_id = 0;
+uintptr_t g_returns[64];
+int       g_depth = 0;
+
+void test_enter(uint32_t id, uintptr_t *return_slot, uintptr_t exit_stub)
+{
+    ++g_enters;
+    g_last_id = id;
+    g_returns[g_depth++] = *return_slot;
+    *return_slot = exit_stub;
+}
+
+uintptr_t test_exit()
+{
+    ++g_exits;
+    return g_returns[--g_depth];
+}
+
+} // namespace
+
+// 入口处只有 2 字节指令后跟 ret，无法容纳入口跳转
+asm(".text\n"
+    ".globl rd_short_function\n"
+    ".type rd_short_function, @function\n"
+    ".p2align 4\n"
+    "rd_short_function:\n"
+    "    xorl %eax, %eax\n"
+    "    ret\n"
+    ".size rd_short_function, .-rd_short_function\n");
+extern "C" int rd_short_function();
+
+// 入口位于 16 字节窗口的第 6 字节，入口跳转跨越 8 字节边界但在同一 16 字节窗口内，返回 5
+asm(".text\n"
+    ".p2align 4\n"
+    ".skip 6, 0x90\n"
+    ".globl rd_window_function\n"
+    ".type rd_window_function, @function\n"
+    "rd_window_function:\n"
+    "    movl $5, %eax\n"
+    "    ret\n"
+    ".size rd_window_function, .-rd_window_function\n");
+extern "C" int rd_window_function();
+
+// 入口位于 16 字节窗口的第 13 字节，入口跳转跨越 16 字节边界，无法原子写入，返回 6
+asm(".text\n"
+    ".p2align 4\n"
+    ".skip 13, 0x90\n"
+    ".globl rd_straddle_function\n"
+    ".type rd_straddle_function, @function\n"
+    "rd_straddle_function:\n"
+    "    movl $6, %eax\n"
+    "    ret\n"
+    ".size rd_straddle_function, .-rd_straddle_function\n");
+extern "C" int rd_straddle_function();
+
+// 入口处的条件跳转被搬移到跳转岛：n > 0 时返回 2n，否则返回 -1
+asm(".text\n"
+    ".globl rd_branch_function\n"
+    ".type rd_branch_function, @function\n"
+    ".p2align 4\n"
+    "rd_branch_function:\n"
+    "    cmpq $0, %rdi\n"
+    "    jle 1f\n"
+    "    leaq (%rdi,%rdi), %rax\n"
+    "    ret\n"
+    "1:  movq $-1, %rax\n"
+    "    ret\n"
+    ".size rd_branch_function, .-rd_branch_function\n");
+extern "C" long rd_branch_function(long n);
+
+// 自旋直到 rd_release 非 0 后返回 3，线程停留期间 PC 始终位于 [rd_spin_function, rd_spin_function_end)
+extern "C" {
+volatile int rd_release = 0;
+}
+asm(".text\n"
+    ".globl rd_spin_function\n"
+    ".type rd_spin_function, @function\n"
+    ".p2align 4\n"
+    "rd_spin_function:\n"
+    "1:  pause\n"
+    "    cmpl $0, rd_release(%rip)\n"
+    "    je 1b\n"
+    "    movl $3, %eax\n"
+    "    ret\n"
+    "rd_spin_function_end:\n"
+    ".size rd_spin_function, .-rd_spin_function\n");
+extern "C" int rd_spin_function();
+extern "C" const char rd_spin_function_end[];
+
+// 整数与浮点参数都经过寄存器传递，用于检查入口桩保存了全部参数寄存器
+extern "C" __attribute__((noinline, aligned(16))) double probed_arguments(int a, int b, int c, int d, int e, int f,
+                                                                          double x, double y)
+{
+    asm volatile("");
+    return a + b * 2 + c * 3 + d * 4 + e * 5 + f * 6 + x * y;
+}
+
+// 经函数指针递归，避免编译器把递归改写为循环
+extern long (*volatile g_recursive)(long);
+
+extern "C" __attribute__((noinline, aligned(16))) long probed_recursive(long n)
+{
+    return n < 2 ? n : g_recursive(n - 1) + g_recursive(n - 2);
+}
+
+extern "C" __attribute__((noinline, aligned(16))) int original_function()
+{
+    asm volatile("");
+    return 1;
+}
+
+extern "C" __attribute__((noinline)) int patched_function()
+{
+    asm volatile("");
+    return 2;
+}
+
+extern "C" int rd_got_value();
+extern "C" int rd_got_value_fixed();
+extern "C" int rd_got_value_internal();
+
+// 通过函数指针调用，避免编译器内联
+int (*volatile g_function)() = original_function;
+double (*volatile g_arguments)(int, int, int, int, int, int, double, double) = probed_arguments;
+long (*volatile g_recursive)(long) = probed_recursive;
+
+int main()
+{
+    FunctionPatcher patcher;
+    expect(g_function() == 1, "original before patch");
+
+    // 1. 安装与卸载
+    expect(patcher.install_patch(reinterpret_cast<void *>(&original_function),
+                                 reinterpret_cast<void *>(&patched_function)),
+           "install patch");
+    expect(g_function() == 2, "patched function runs");
+    expect(patcher.installed().size() == 1, "one island installed");
+    expect(patcher.uninstall_patch(reinterpret_cast<void *>(&original_function)), "uninstall patch");
+    expect(g_function() == 1, "original restored");
+    expect(!patcher.uninstall_patch(reinterpret_cast<void *>(&original_function)), "double uninstall fails");
+
+    // 2. 其他线程持续调用时反复改写入口，调用结果只能是两者之一
+    std::atomic<bool> running{ true };
+    std::atomic<long> calls{ 0 };
+    std::atomic<long> bad{ 0 };
+    std::thread caller([&] {
+        while (running) {
+            int value = g_function();
+            if (value != 1 && value != 2) {
+                ++bad;
+            }
+            ++calls;
+        }
+    });
+    for (int i = 0; i < 2000; ++i) {
+        patcher.install_patch(reinterpret_cast<void *>(&original_function), reinterpret_cast<void *>(&patched_function));
+        patcher.uninstall_patch(reinterpret_cast<void *>(&original_function));
+    }
+    running = false;
+    caller.join();
+    expect(bad == 0 && calls > 0, "concurrent callers see whole instructions");
+
+    // 3. 析构时恢复全部补丁
+    {
+        FunctionPatcher scoped;
+        scoped.install_patch(reinterpret_cast<void *>(&original_function), reinterpret_cast<void *>(&patched_function));
+        expect(g_function() == 2, "scoped patch active");
+    }
+    expect(g_function() == 1, "destructor restores original");
+
+    // 4. GOT 重定向：只改写本程序引用库函数的表项，不修改代码
+    FunctionPatcher got;
+    expect(rd_got_value() == 1, "library function before redirect");
+    expect(got.install_got_patch("rd_got_value", reinterpret_cast<void *>(&rd_got_value_fixed)), "install got patch");
+    expect(rd_got_value() == 2, "call through GOT is redirected");
+    expect(rd_got_value_internal() == 1, "module of the replacement is left alone");
+    expect(got.installed().empty() && got.redirected().size() == 1 && !got.redirected()[0].slots.empty(),
+           "no island for GOT redirect");
+    expect(got.redirected()[0].slots[0].relro, "-z now places the GOT entry in RELRO");
+    expect(got.install_got_patch("rd_got_value", reinterpret_cast<void *>(&patched_function)), "retarget got patch");
+    expect(rd_got_value() == 2 && got.redirected().size() == 1, "retarget keeps one redirect");
+    expect(got.uninstall_got_patch("rd_got_value"), "uninstall got patch");
+    expect(rd_got_value() == 1, "GOT entry restored");
+    expect(!got.uninstall_got_patch("rd_got_value"), "double got uninstall fails");
+    expect(!got.install_got_patch("rd_no_such_import", reinterpret_cast<void *>(&patched_function)),
+           "symbol without GOT entry");
+
+#ifdef __x86_64__
+    // 5. 入口/出口探针：参数与返回值不变，递归调用的每一层都有配对的出口
+    FunctionPatcher probes;
+    ProbeHooks hooks;
+    hooks.enter = test_enter;
+    hooks.exit = test_exit;
+    const double expected = g_arguments(1, 2, 3, 4, 5, 6, 1.5, 4.0);
+    expect(probes.install_probe(reinterpret_cast<void *>(&probed_arguments), 7, hooks), "install probe");
+    expect(g_arguments(1, 2, 3, 4, 5, 6, 1.5, 4.0) == expected, "probed function sees every argument");
+    expect(g_enters == 1 && g_exits == 1 && g_last_id == 7, "entry and exit hooks called");
+    expect(probes.install_probe(reinterpret_cast<void *>(&probed_recursive), 8, hooks), "probe recursive function");
+    g_enters = g_exits = 0;
+    expect(g_recursive(10) == 55, "recursive result");
+    expect(g_enters == 177 && g_exits == 177 && g_depth == 0, "every nested call returns through the exit stub");
+    expect(!probes.install_probe(reinterpret_cast<void *>(&probed_recursive), 9, hooks), "probe twice fails");
+    expect(!probes.install_patch(reinterpret_cast<void *>(&probed_recursive), reinterpret_cast<void *>(&patched_function)),
+           "patching a probed function fails");
+    expect(!probes.install_probe(reinterpret_cast<void *>(&rd_short_function), 10, hooks) && rd_short_function() == 0,
+           "entry shorter than a jump is refused");
+    expect(probes.install_probe(reinterpret_cast<void *>(&rd_branch_function), 11, hooks), "probe entry branch");
+    g_enters = g_exits = 0;
+    expect(rd_branch_function(21) == 42 && rd_branch_function(-3) == -1 && g_exits == 2,
+           "relocated branch keeps both paths");
+    expect(probes.probed().size() == 3, "three probes installed");
+
+    expect(probes.uninstall_probes() && probes.probed().empty(), "uninstall probes");
+    g_enters = g_exits = 0;
+    expect(g_recursive(10) == 55 && g_enters == 0, "entries restored");
+    expect(probes.install_probe(reinterpret_cast<void *>(&probed_recursive), 8, hooks) && g_recursive(5) == 5 &&
+               g_enters == 15 && g_exits == 15,
+           "reinstall reuses the island");
+    probes.uninstall_probes();
+    expect(probes.retired().size() == 3, "unprobed islands wait for reclaim");
+    expect(probes.reclaim([](const JumpIsland &) { return false; }) == 3 && probes.retired().empty(),
+           "reclaim frees probe islands");
+
+    // 6. 撤销补丁不释放跳转岛，线程仍在补丁函数中时扫描发现引用，返回后才回收
+    FunctionPatcher retiring;
+    expect(retiring.install_patch(reinterpret_cast<void *>(&original_function),
+                                  reinterpret_cast<void *>(&rd_spin_function)),
+           "patch with spinning replacement");
+    const auto island = reinterpret_cast<uintptr_t>(retiring.installed()[0].allocated_memory);
+    const std::vector<CodeRange> ranges{
+        { reinterpret_cast<uintptr_t>(&rd_spin_function), reinterpret_cast<uintptr_t>(rd_spin_function_end) },
+        { island, island + retiring.installed()[0].size },
+    };
+    std::atomic<int>  result{ 0 };
+    std::atomic<bool> finish{ false };
+    std::thread spinner([&] {
+        result = g_function();
+        while (!finish) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    std::vector<bool> referenced;
+    bool entered = false;
+    for (int i = 0; i < 100 && !entered; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        entered = scan_thread_references(ranges, referenced) == 0 && referenced[0];
+    }
+    expect(entered, "scan finds the thread spinning in the replacement");
+    expect(retiring.retire_patch(reinterpret_cast<void *>(&original_function)) && g_function() == 1,
+           "retire restores the entry at once");
+    expect(retiring.installed().empty() && retiring.retired().size() == 1, "island waits for reclaim");
+    expect(!retiring.retire_patch(reinterpret_cast<void *>(&original_function)), "double retire fails");
+    auto in_use = [&](const JumpIsland &) {
+        return scan_thread_references(ranges, referenced) != 0 || referenced[0] || referenced[1];
+    };
+    expect(retiring.reclaim(in_use) == 0 && retiring.retired().size() == 1, "referenced island is kept");
+
+    rd_release = 1;
+    while (result == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    expect(retiring.reclaim(in_use) == 1 && retiring.retired().empty() && result == 3,
+           "island freed after the thread returns");
+    finish = true;
+    spinner.join();
+
+    // 7. fork 出的子进程不写入父进程的探针线程环
+    ProbeRing *ring = probe_ring_create();
+    expect(ring != nullptr, "create probe ring");
+    if (ring) {
+        ring->enabled.store(1);
+        FunctionPatcher recorded;
+        expect(recorded.install_probe(reinterpret_cast<void *>(&probed_recursive), 0, probe_ring_hooks()) &&
+                   g_recursive(5) == 5,
+               "probe with the shared ring");
+        auto records = [ring] {
+            uint64_t total = 0;
+            for (const auto &thread : ring->threads) {
+                total += thread.head.load();
+            }
+            return total;
+        };
+        const uint64_t before = records();
+        expect(before == 30, "parent records enter and exit: " + std::to_string(before));
+        const pid_t child = fork();
+        if (child == 0) {
+            _exit(g_recursive(5) == 5 && g_recursive(10) == 55 ? 0 : 1);
+        }
+        int status = -1;
+        waitpid(child, &status, 0);
+        expect(WIFEXITED(status) && WEXITSTATUS(status) == 0, "probed function works in the child");
+        expect(records() == before, "child writes nothing to the ring");
+        expect(g_recursive(5) == 5 && records() == before + 30, "parent keeps recording");
+        recorded.uninstall_probes();
+        ring->enabled.store(0);
+        probe_ring_unlink();
+    }
+
+    // 8. 跨越 8 字节边界的入口用 16 字节 CAS 写入，跨越 16 字节边界的拒绝改写
+    FunctionPatcher windows;
+    expect(windows.install_patch(reinterpret_cast<void *>(&rd_window_function),
+                                 reinterpret_cast<void *>(&patched_function)) &&
+               rd_window_function() == 2,
+           "entry across an 8-byte boundary");
+    expect(windows.uninstall_patch(reinterpret_cast<void *>(&rd_window_function)) && rd_window_function() == 5,
+           "entry across an 8-byte boundary restored");
+    expect(!windows.install_patch(reinterpret_cast<void *>(&rd_straddle_function),
+                                  reinterpret_cast<void *>(&patched_function)) &&
+               rd_straddle_function() == 6 && windows.installed().empty(),
+           "entry across a 16-byte boundary is refused");
+#endif
+
+    return test::report("function_patcher_test");
+}
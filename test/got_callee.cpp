@@ -0,0 +1,16 @@
+// GOT 重定向测试使用的共享库：被测程序经 PLT 调用其中的函数
+extern "C" int rd_got_value()
+{
+    return 1;
+}
+
+extern "C" int rd_got_value_fixed()
+{
+    return 2;
+}
+
+// 库内按名字调用，经本库的 GOT；补丁函数所在的模块不会被改写
+extern "C" int rd_got_value_internal()
+{
+    return rd_got_value();
+}
@@ -0,0 +1,225 @@
+#include "inject/command_ring.h"
+#include "inject/probe_ring.h"
+#include "child_process.h"
+#include "test_common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace RemoteDebug;
+using test::expect;
+using namespace std::chrono_literals;
+using test::Child;
+using test::wait_line;
+
+namespace {
+
+bool starts_with(const std::string &text, const std::string &prefix)
+{
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::string request(pid_t pid, const std::string &line)
+{
+    std::string reply;
+    if (ring_request(pid, line, reply, 5000) != 0) {
+        return "<no reply>";
+    }
+    return reply;
+}
+
+// 目标进程是否被 ptrace
+bool traced(pid_t pid)
+{
+    std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (starts_with(line, "TracerPid:")) {
+            return std::strtol(line.c_str() + 10, nullptr, 10) != 0;
+        }
+    }
+    return false;
+}
+
+// 补丁库是否仍映射在目标进程中
+bool mapped(pid_t pid, const std::string &path)
+{
+    std::ifstream maps("/proc/" + std::to_string(pid) + "/maps");
+    std::string line;
+    while (std::getline(maps, line)) {
+        if (line.find(path) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc != 5) {
+        std::cerr << "Usage: " << argv[0] << " <agent library> <patch_target> <fix library> <library without table>"
+                  << std::endl;
+        return 2;
+    }
+    char agent_path[PATH_MAX];
+    char fix_path[PATH_MAX];
+    char plain_path[PATH_MAX];
+    if (!realpath(argv[1], agent_path) || !realpath(argv[3], fix_path) || !realpath(argv[4], plain_path)) {
+        std::cerr << "Libraries not found" << std::endl;
+        return 2;
+    }
+    const std::string fix_library = fix_path;
+
+    Child target = test::spawn({ argv[2], "serve" }, { std::string("LD_PRELOAD=") + agent_path });
+    expect(wait_line(target, "value 1"), "target starts with original value");
+    pid_t pid = target.pid;
+
+    // 1. 代理线程随库加载启动
+    expect(request(pid, "ping") == "OK pong", "agent answers ping");
+
+    // 2. 补丁包：加载并安装补丁表中的补丁
+    std::string reply = request(pid, "package " + fix_library);
+    expect(starts_with(reply, "OK applied=1"), "package: " + reply);
+    expect(wait_line(target, "value 2"), "target runs the packaged replacement");
+
+    // 3. 改写为另一个替换函数，再回退
+    reply = request(pid, "apply rd_target_value rd_target_value_other");
+    expect(starts_with(reply, "OK 0x"), "apply: " + reply);
+    expect(wait_line(target, "value 3"), "target runs the new replacement");
+    expect(starts_with(request(pid, "revert rd_target_value"), "OK"), "revert");
+    expect(wait_line(target, "value 1"), "target runs the original again");
+    expect(starts_with(request(pid, "revert rd_target_value"), "ERR"), "double revert fails");
+
+    // 4. 反复 apply/revert，全程不使用 ptrace
+    std::vector<long> apply_us;
+    for (int i = 0; i < 20; ++i) {
+        reply = request(pid, "apply rd_target_value rd_target_value_fixed");
+        expect(starts_with(reply, "OK"), "repeated apply: " + reply);
+        apply_us.push_back(std::strtol(reply.c_str() + reply.rfind(' ') + 1, nullptr, 10));
+        expect(starts_with(request(pid, "revert rd_target_value"), "OK"), "repeated revert");
+    }
+    std::sort(apply_us.begin(), apply_us.end());
+    std::cout << "in-process apply median " << apply_us[apply_us.size() / 2] << " us" << std::endl;
+    expect(!traced(pid), "target was never traced");
+    reply = request(pid, "status");
+    expect(reply.find(" libraries=1 patches=0") != std::string::npos, "status: " + reply);
+
+    // 5. 阶段追踪：进程内补丁没有暂停，汇总中只有分配跳转岛与改写入口等阶段
+    expect(starts_with(request(pid, "trace on"), "OK"), "trace on");
+    expect(starts_with(request(pid, "apply rd_target_value rd_target_value_fixed"), "OK"), "traced apply");
+    reply = request(pid, "trace");
+    for (const char *phase : { "trace apply:", "stopped=0us", "symbol_resolve=", "island_alloc=", "prologue_rewrite=" }) {
+        expect(reply.find(phase) != std::string::npos, std::string("apply summary has ") + phase + ": " + reply);
+    }
+    expect(starts_with(request(pid, "revert rd_target_value"), "OK"), "traced revert");
+    expect(request(pid, "trace off") == "OK", "trace off");
+
+    // 6. 入口/出口探针：各线程的调用记录写入共享内存环，不暂停目标进程即可读取
+    reply = request(pid, "probe rd_target_value");
+    expect(starts_with(reply, "OK probes=1 " + probe_ring_name(pid)), "probe: " + reply);
+    ProbeDrain drain;
+    expect(drain.open(pid) == 0, "open probe ring");
+    size_t records = 0;
+    for (int i = 0; i < 100 && records < 400; ++i) {
+        std::this_thread::sleep_for(10ms);
+        records += drain.drain();
+    }
+    const auto &stats = drain.stats();
+    expect(stats.size() == 1 && stats.begin()->second.name == "rd_target_value" && stats.begin()->second.calls >= 100,
+           "main and worker thread calls are paired: " + drain.report());
+    std::cout << drain.report();
+    expect(starts_with(request(pid, "apply rd_target_value rd_target_value_fixed"), "ERR"),
+           "probed function cannot be patched");
+    expect(starts_with(request(pid, "probe rd_target_value"), "ERR"), "probe twice");
+    reply = request(pid, "status");
+    expect(reply.find(" probes=1") != std::string::npos && reply.find("rd_target_value@probe") != std::string::npos,
+           "status lists probes: " + reply);
+    expect(starts_with(request(pid, "unprobe"), "OK removed=1"), "unprobe");
+    std::this_thread::sleep_for(20ms);
+    drain.drain();
+    std::this_thread::sleep_for(20ms);
+    expect(drain.drain() == 0, "no records after unprobe");
+    expect(starts_with(request(pid, "unprobe"), "ERR"), "unprobe without probes");
+    expect(!traced(pid), "probes never trace the target");
+
+    // 7. 错误请求
+    expect(starts_with(request(pid, std::string("package ") + plain_path), "ERR"), "library without patch table");
+    expect(starts_with(request(pid, "apply no_such_symbol rd_target_value_fixed"), "ERR"), "unknown symbol");
+    expect(starts_with(request(pid, "probe no_such_symbol"), "ERR"), "probe unknown symbol");
+    expect(starts_with(request(pid, "redirect rd_target_value rd_target_value_fixed"), "ERR"),
+           "redirect of a symbol without GOT entry");
+    expect(starts_with(request(pid, "bogus"), "ERR"), "unknown command");
+    expect(request(getpid(), "ping") == "<no reply>", "process without agent");
+
+    // 8. 卸载补丁库：立即恢复入口，线程离开库中的代码后才 dlclose，之后可重新加载
+    reply = request(pid, "apply rd_target_value rd_target_value_slow");
+    expect(starts_with(reply, "OK"), "apply slow replacement: " + reply);
+    expect(wait_line(target, "value 4"), "target runs the slow replacement");
+    // 输出 value 4 时两个线程刚返回，100ms 后都停留在下一次调用中
+    std::this_thread::sleep_for(100ms);
+    reply = request(pid, "unload " + fix_library);
+    expect(starts_with(reply, "OK reverted=1 "), "unload: " + reply);
+    reply = request(pid, "reclaim");
+    expect(starts_with(reply, "OK") && reply.find(" libraries=0 ") != std::string::npos &&
+                   reply.find(" pending=0 ") == std::string::npos,
+           "library kept while a thread sleeps in it: " + reply);
+    expect(mapped(pid, fix_library), "library still mapped during the grace period");
+    expect(wait_line(target, "value 1"), "original restored without waiting for the sleeping threads");
+    for (int i = 0; i < 50 && reply.find(" pending=0 ") == std::string::npos; ++i) {
+        std::this_thread::sleep_for(20ms);
+        reply = request(pid, "reclaim");
+    }
+    expect(reply.find(" pending=0 ") != std::string::npos, "grace period ends: " + reply);
+    expect(!mapped(pid, fix_library), "library closed after the grace period");
+    reply = request(pid, "status");
+    expect(reply.find(" patches=0") != std::string::npos && reply.find(" retired=0") != std::string::npos &&
+                   reply.find("@unloading") == std::string::npos,
+           "status after unload: " + reply);
+    expect(starts_with(request(pid, "unload " + fix_library), "ERR"), "unload twice");
+    expect(starts_with(request(pid, "package " + fix_library), "OK applied=1"), "reload after unload");
+    expect(wait_line(target, "value 2"), "reloaded replacement runs");
+
+    // 9. 线程屏蔽扫描信号时扫描失败：自动扫描逐次退避，连续失败后停止，显式 reclaim 恢复
+    expect(write(target.input, "block-scan\n", 11) == 11 && wait_line(target, "blocking scan"),
+           "start a thread that blocks the scan signal");
+    const auto blocked_since = std::chrono::steady_clock::now();
+    expect(starts_with(request(pid, "revert rd_target_value"), "OK"), "revert with a blocking thread");
+    expect(wait_line(target, "value 1"), "original restored with a blocking thread");
+    reply = request(pid, "status");
+    for (int i = 0; i < 50 && reply.find(" reclaim=paused") == std::string::npos; ++i) {
+        std::this_thread::sleep_for(100ms);
+        reply = request(pid, "status");
+    }
+    expect(reply.find(" retired=1 scan_failures=3 reclaim=paused") != std::string::npos,
+           "automatic reclaim paused after repeated failures: " + reply);
+    expect(std::chrono::steady_clock::now() - blocked_since >= 700ms, "failed scans back off");
+    std::this_thread::sleep_for(300ms);
+    expect(request(pid, "status").find(" scan_failures=3 reclaim=paused") != std::string::npos,
+           "no automatic scans while paused");
+    expect(request(pid, "reclaim") == "ERR thread scan failed", "explicit reclaim still scans");
+    reply = request(pid, "status");
+    expect(reply.find(" scan_failures=1") != std::string::npos && reply.find("reclaim=paused") == std::string::npos,
+           "explicit reclaim resumes automatic scans: " + reply);
+
+    // 10. 带补丁退出，退出时删除命令环与探针记录区
+    expect(starts_with(request(pid, "apply rd_target_value rd_target_value_fixed"), "OK"), "apply before exit");
+    close(target.input);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    expect(WIFEXITED(status) && WEXITSTATUS(status) == 0, "target exits cleanly");
+    expect(access(("/dev/shm" + command_ring_name(pid)).c_str(), F_OK) != 0, "command ring removed");
+    expect(access(("/dev/shm" + probe_ring_name(pid)).c_str(), F_OK) != 0, "probe ring removed");
+
+    return test::report("inprocess_agent_test");
+}
@@ -0,0 +1,276 @@
+#include "inject/patch_agent.h"
+#include "child_process.h"
+#include "test_common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <csignal>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace RemoteDebug;
+using test::expect;
+using test::read_file;
+using test::Child;
+using test::wait_line;
+using namespace std::chrono_literals;
+
+namespace {
+
+bool starts_with(const std::string &text, const std::string &prefix)
+{
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::string request(const std::string &socket_path, const std::string &line)
+{
+    std::string reply;
+    if (agent_request(socket_path, line, reply) != 0) {
+        return "<no reply>";
+    }
+    return reply;
+}
+
+// 从 "key=value" 形式的回复中取出数值
+long field(const std::string &reply, const std::string &key)
+{
+    size_t pos = reply.find(" " + key + "=");
+    return pos == std::string::npos ? -1 : std::strtol(reply.c_str() + pos + key.size() + 2, nullptr, 10);
+}
+
+// "OK 0x... <n>us" 中的耗时
+long reply_us(const std::string &reply)
+{
+    size_t end = reply.rfind("us");
+    size_t begin = reply.rfind(' ', end);
+    return end == std::string::npos || begin == std::string::npos
+                   ? -1
+                   : std::strtol(reply.c_str() + begin + 1, nullptr, 10);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc != 5) {
+        std::cerr << "Usage: " << argv[0] << " <RemoteDebug binary> <patch_target> <fix library> <extra library>"
+                  << std::endl;
+        return 2;
+    }
+    // 代理要求补丁库为绝对路径
+    char fix_path[PATH_MAX];
+    char extra_path[PATH_MAX];
+    if (!realpath(argv[3], fix_path) || !realpath(argv[4], extra_path)) {
+        std::cerr << "Libraries not found" << std::endl;
+        return 2;
+    }
+    const std::string fix_library = fix_path;
+    const std::string extra_library = extra_path;
+
+    char root_template[] = "/tmp/patch_agent_XXXXXX";
+    std::string root = mkdtemp(root_template);
+    std::string socket_path = root + "/agent.sock";
+
+    Child target = test::spawn({ argv[2], "serve" });
+    expect(wait_line(target, "value 1"), "target starts with original value");
+    std::string pid = std::to_string(target.pid);
+
+    Child agent = test::spawn({ argv[1], "agent", socket_path });
+    std::string reply;
+    for (int i = 0; i < 100 && agent_request(socket_path, "ping", reply, 1000) != 0; ++i) {
+        std::this_thread::sleep_for(20ms);
+    }
+    expect(reply == "OK pong", "agent answers ping");
+
+    // 1. 预热：建立全部模块的符号索引
+    reply = request(socket_path, "attach " + pid);
+    expect(starts_with(reply, "OK") && field(reply, "modules") > 0 && field(reply, "indexed") == field(reply, "modules"),
+           "attach indexes every module: " + reply);
+
+    // 2. 补丁库加载前找不到替换函数
+    reply = request(socket_path, "apply " + pid + " rd_target_value rd_target_value_fixed");
+    expect(starts_with(reply, "ERR") && reply.find("rd_target_value_fixed") != std::string::npos,
+           "apply before load fails: " + reply);
+
+    // 3. 加载补丁库并打补丁；目标线程持有加载器锁时远程 dlopen 等待其释放，而不是与之互相等待
+    expect(write(target.input, "hold-loader 1000\n", 17) == 17 && wait_line(target, "holding loader"),
+           "target thread holds the loader lock");
+    reply = request(socket_path, "load " + pid + " " + fix_library);
+    expect(starts_with(reply, "OK 0x"), "load patch library while the loader lock is held: " + reply);
+    expect(wait_line(target, "released loader"), "lock holder ran during the remote dlopen");
+    reply = request(socket_path, "apply " + pid + " rd_target_value rd_target_value_fixed");
+    expect(starts_with(reply, "OK 0x"), "apply: " + reply);
+    expect(wait_line(target, "value 2"), "target runs the replacement");
+
+    // 4. 重复打补丁只改写跳转岛
+    reply = request(socket_path, "apply " + pid + " rd_target_value rd_target_value_other");
+    expect(starts_with(reply, "OK"), "retarget: " + reply);
+    expect(wait_line(target, "value 3"), "target runs the retargeted replacement");
+
+    // 5. 回退
+    reply = request(socket_path, "revert " + pid + " rd_target_value");
+    expect(starts_with(reply, "OK"), "revert: " + reply);
+    expect(wait_line(target, "value 1"), "target runs the original again");
+    expect(starts_with(request(socket_path, "revert " + pid + " rd_target_value"), "ERR"), "double revert fails");
+
+    // 6. 热缓存下反复 apply/revert，跳转岛复用同一块内存
+    std::vector<long> apply_us;
+    for (int i = 0; i < 20; ++i) {
+        reply = request(socket_path, "apply " + pid + " rd_target_value rd_target_value_fixed");
+        expect(starts_with(reply, "OK"), "warm apply: " + reply);
+        apply_us.push_back(reply_us(reply));
+        expect(starts_with(request(socket_path, "revert " + pid + " rd_target_value"), "OK"), "warm revert");
+    }
+    std::sort(apply_us.begin(), apply_us.end());
+    std::cout << "warm apply median " << apply_us[apply_us.size() / 2] << " us, max " << apply_us.back() << " us"
+              << std::endl;
+    reply = request(socket_path, "status " + pid);
+    expect(field(reply, "patches") == 0 && field(reply, "arenas") == 1 && field(reply, "libraries") == 1,
+           "status after warm loop: " + reply);
+
+    // 7. 目标进程自行加载模块后代理通过轮询发现
+    long modules = field(reply, "modules");
+    expect(write(target.input, ("dlopen " + extra_library + "\n").c_str(), extra_library.size() + 8) > 0,
+           "send dlopen to target");
+    expect(wait_line(target, "loaded ok"), "target loads extra module");
+    std::this_thread::sleep_for(std::chrono::milliseconds(agent_watch_interval_ms * 3));
+    reply = request(socket_path, "status " + pid);
+    expect(field(reply, "modules") == modules + 1, "agent notices module load: " + reply);
+
+    // 8. 阶段追踪：汇总给出暂停时间与各阶段耗时，JSON 中每个阶段一个完整事件
+    std::string trace_path = root + "/trace.json";
+    expect(starts_with(request(socket_path, "trace"), "ERR"), "no trace before enabling");
+    expect(starts_with(request(socket_path, "trace on " + trace_path), "OK"), "trace on");
+    expect(starts_with(request(socket_path, "apply " + pid + " rd_target_value rd_target_value_fixed"), "OK"),
+           "traced apply");
+    reply = request(socket_path, "trace");
+    for (const char *phase : { "trace apply:", "stopped=", "symbol_resolve=", "attach=", "prologue_rewrite=", "detach=" }) {
+        expect(reply.find(phase) != std::string::npos, std::string("apply summary has ") + phase + ": " + reply);
+    }
+    expect(starts_with(request(socket_path, "revert " + pid + " rd_target_value"), "OK"), "traced revert");
+    expect(request(socket_path, "trace off") == "OK", "trace off writes the file");
+    std::string json = read_file(trace_path);
+    for (const char *event : { "\"traceEvents\"", "\"name\":\"apply\",\"cat\":\"request\",\"ph\":\"X\"",
+                               "\"name\":\"revert\"", "\"name\":\"stopped\"", "\"name\":\"memory_write\"" }) {
+        expect(json.find(event) != std::string::npos, std::string("trace file has ") + event);
+    }
+    expect(request(socket_path, "ping") == "OK pong" && access((trace_path + ".tmp").c_str(), F_OK) != 0,
+           "tracing stopped");
+
+    // 9. 数据补丁：按 DWARF 类型检查后成批写入，回退恢复第一次写入前的值
+    auto tuning = [&target](const std::string &expected) {
+        std::string line;
+        return write(target.input, "tuning\n", 7) == 7 && wait_line(target, "tuning", &line) && line == expected;
+    };
+    reply = request(socket_path, "get " + pid + " rd_queue_depth");
+    expect(reply == "OK 16 type=int size=4", "get C variable: " + reply);
+    reply = request(socket_path, "get " + pid + " rd::Tuning::backoff");
+    expect(reply == "OK 0.5 type=double size=8", "get static member via DWARF: " + reply);
+    reply = request(socket_path, "set " + pid + " rd_queue_depth=32 rd::Tuning::batch_size=0x80 rd::Tuning::backoff=0.25");
+    expect(starts_with(reply, "OK rd_queue_depth=16->32 rd::Tuning::batch_size=64->128 rd::Tuning::backoff=0.5->0.25"),
+           "set batch: " + reply);
+    expect(tuning("tuning depth=32 batch=128 backoff=0.25 limit=5"), "target sees the new values");
+    expect(starts_with(request(socket_path, "set " + pid + " rd_queue_depth=64"), "OK rd_queue_depth=32->64"),
+           "second set");
+    expect(starts_with(request(socket_path, "set " + pid + " rd_queue_depth=1 rd::Tuning::batch_size=-1"), "ERR"),
+           "out-of-range value rejects the whole batch");
+    expect(starts_with(request(socket_path, "set " + pid + " rd_const_limit=6"), "ERR"), "const variable refused");
+    expect(starts_with(request(socket_path, "set " + pid + " rd_target_value=1"), "ERR"), "function is not a variable");
+    expect(tuning("tuning depth=64 batch=128 backoff=0.25 limit=5"), "rejected batches write nothing");
+    reply = request(socket_path, "status " + pid);
+    expect(field(reply, "data") == 3, "status counts data patches: " + reply);
+    for (const char *variable : { "rd_queue_depth", "rd::Tuning::batch_size", "rd::Tuning::backoff" }) {
+        expect(starts_with(request(socket_path, "revert " + pid + " " + variable), "OK"),
+               std::string("revert ") + variable);
+    }
+    expect(tuning("tuning depth=16 batch=64 backoff=0.5 limit=5"), "revert restores the original values");
+
+    // 10. 代码段校验：不暂停目标进程读取，补丁入口与跳转岛按补丁清单比对
+    reply = request(socket_path, "verify " + pid);
+    expect(starts_with(reply, "OK diffs=0") && field(reply, "modules") > 0 && field(reply, "bytes") > 0 &&
+                   field(reply, "patches") == 0,
+           "unpatched text matches the ELF files: " + reply);
+    reply = request(socket_path, "apply " + pid + " rd_target_value rd_target_value_fixed");
+    const uintptr_t entry = std::strtoull(reply.c_str() + 3, nullptr, 16);
+    expect(starts_with(reply, "OK 0x") && wait_line(target, "value 2"), "apply before verify: " + reply);
+    expect(starts_with(request(socket_path, "revert " + pid + " rd_target_value"), "OK"), "revert to read the entry");
+    uint8_t original[16] = {};
+    int mem = open(("/proc/" + pid + "/mem").c_str(), O_RDWR | O_CLOEXEC);
+    expect(mem >= 0 && pread(mem, original, sizeof(original), static_cast<off_t>(entry)) == sizeof(original),
+           "read original entry");
+    expect(starts_with(request(socket_path, "apply " + pid + " rd_target_value rd_target_value_fixed"), "OK"),
+           "apply again");
+    reply = request(socket_path, "verify " + pid);
+    expect(starts_with(reply, "OK diffs=0") && field(reply, "patches") == 1, "patched text matches: " + reply);
+
+    // 绕过代理恢复入口：按补丁报告差异区间
+    kill(target.pid, SIGSTOP);
+    expect(pwrite(mem, original, sizeof(original), static_cast<off_t>(entry)) == sizeof(original), "overwrite entry");
+    kill(target.pid, SIGCONT);
+    reply = request(socket_path, "verify " + pid);
+    std::ostringstream range;
+    range << " 0x" << std::hex << entry << "-0x";
+    expect(field(reply, "diffs") == 1 && reply.find(range.str()) != std::string::npos &&
+                   reply.find(":patch:rd_target_value") != std::string::npos,
+           "entry mismatch reported: " + reply);
+    expect(starts_with(request(socket_path, "revert " + pid + " rd_target_value"), "OK"), "revert after mismatch");
+    expect(starts_with(request(socket_path, "verify " + pid), "OK diffs=0"), "reverted text matches");
+    if (mem >= 0) {
+        close(mem);
+    }
+
+    // 11. 错误请求
+    expect(starts_with(request(socket_path, "apply " + pid + " no_such_symbol rd_target_value_fixed"), "ERR"),
+           "unknown target symbol");
+    expect(starts_with(request(socket_path, "load " + pid + " relative.so"), "ERR"), "relative library path");
+    expect(starts_with(request(socket_path, "status 999999999"), "ERR"), "unknown pid");
+    expect(starts_with(request(socket_path, "bogus"), "ERR"), "unknown command");
+
+    // 12. 锁一直不释放时远程调用超时：请求失败，目标进程恢复运行，代理继续服务
+    Child stuck = test::spawn({ argv[2], "serve" });
+    expect(wait_line(stuck, "value 1"), "second target starts");
+    expect(write(stuck.input, "hold-loader 0\n", 14) == 14 && wait_line(stuck, "holding loader"),
+           "second target holds the loader lock");
+    auto load_start = std::chrono::steady_clock::now();
+    reply = request(socket_path, "load " + std::to_string(stuck.pid) + " " + extra_library);
+    auto load_ms =
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - load_start).count();
+    expect(starts_with(reply, "ERR") && load_ms >= remote_call_timeout_ms && load_ms < remote_call_timeout_ms + 3000,
+           "load times out: " + reply + " after " + std::to_string(load_ms) + " ms");
+    std::string line;
+    expect(write(stuck.input, "tuning\n", 7) == 7 && wait_line(stuck, "tuning", &line),
+           "second target keeps running after the timeout");
+    expect(request(socket_path, "ping") == "OK pong", "agent still serves after the timeout");
+    // 被放弃的 dlopen 留下的加载器锁无法恢复，直接结束该进程
+    kill(stuck.pid, SIGKILL);
+    waitpid(stuck.pid, nullptr, 0);
+    close(stuck.input);
+    close(stuck.output);
+
+    // 13. 目标进程退出后状态被丢弃
+    expect(starts_with(request(socket_path, "apply " + pid + " rd_target_value rd_target_value_fixed"), "OK"),
+           "apply before exit");
+    close(target.input);
+    int status = 0;
+    waitpid(target.pid, &status, 0);
+    expect(WIFEXITED(status) && WEXITSTATUS(status) == 0, "patched target exits cleanly");
+    std::this_thread::sleep_for(std::chrono::milliseconds(agent_watch_interval_ms * 3));
+    reply = request(socket_path, "status");
+    expect(field(reply, "processes") == 0, "agent drops exited process: " + reply);
+
+    expect(request(socket_path, "shutdown") == "OK bye", "shutdown");
+    waitpid(agent.pid, &status, 0);
+    expect(WIFEXITED(status) && WEXITSTATUS(status) == 0, "agent exits cleanly");
+    expect(access(socket_path.c_str(), F_OK) != 0, "agent removes its socket");
+
+    std::system(("rm -rf " + root).c_str());
+    return test::report("patch_agent_test");
+}
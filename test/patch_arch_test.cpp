@@ -0,0 +1,125 @@
+#include "patch_arch.h"
+#include "test_common.h"
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+
+using namespace RemoteDebug;
+using test::expect;
+
+namespace {
+
+int64_t sign_extend(uint64_t value, unsigned bits)
+{
+    const uint64_t sign = uint64_t{ 1 } << (bits - 1);
+    return static_cast<int64_t>((value ^ sign) - sign);
+}
+
+// 按 AArch64 语义执行远跳转序列，返回 BR 的目标；序列不合法时返回 0
+uintptr_t run_arm64_far_jump(const arch::Code<arch::AArch64::far_jump_size> &code, uintptr_t pc)
+{
+    uint64_t x17 = 0;
+    for (size_t i = 0; i * 4 < code.size; ++i) {
+        const uint32_t insn = code.word(i);
+        const uint32_t rd = insn & 0x1F;
+        if ((insn & 0x9F000000u) == 0x90000000u && rd == 17) {
+            const uint64_t imm = ((insn >> 5) & 0x7FFFF) << 2 | ((insn >> 29) & 0x3);
+            x17 = (pc & ~uint64_t{ 0xFFF }) + static_cast<uint64_t>(sign_extend(imm, 21) * 4096);
+        } else if ((insn & 0xFFC00000u) == 0x91000000u && rd == 17 && ((insn >> 5) & 0x1F) == 17) {
+            x17 += (insn >> 10) & 0xFFF;
+        } else if ((insn & 0xFF800000u) == 0xD2800000u && rd == 17) {
+            x17 = static_cast<uint64_t>((insn >> 5) & 0xFFFF) << (16 * ((insn >> 21) & 3));
+        } else if ((insn & 0xFF800000u) == 0xF2800000u && rd == 17) {
+            const unsigned shift = 16 * ((insn >> 21) & 3);
+            x17 = (x17 & ~(uint64_t{ 0xFFFF } << shift)) | static_cast<uint64_t>((insn >> 5) & 0xFFFF) << shift;
+        } else if (insn == arch::AArch64::br(17) && (i + 1) * 4 == code.size) {
+            return x17;
+        } else {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+uintptr_t arm64_branch_target(uint32_t insn, uintptr_t pc)
+{
+    return pc + static_cast<uintptr_t>(sign_extend(insn & 0x03FFFFFFu, 26) * 4);
+}
+
+uintptr_t x86_far_jump_target(const arch::Code<arch::X86_64::far_jump_size> &code)
+{
+    uint64_t target = 0;
+    memcpy(&target, code.bytes + 6, sizeof(target));
+    return code.bytes[0] == 0xFF && code.bytes[1] == 0x25 && code.word(0) >> 16 == 0 ? target : 0;
+}
+
+} // namespace
+
+int main()
+{
+    using A64 = arch::AArch64;
+    std::mt19937_64 random(20250601);
+
+    // 1. AArch64 远跳转：近处用 ADRP+ADD，远处用 MOVZ/MOVK，两种序列都保留完整的 64 位地址
+    size_t adrp_sequences = 0;
+    for (int i = 0; i < 20000; ++i) {
+        const uintptr_t pc = (random() & 0x0000FFFFFFFFFFFCull);
+        uintptr_t target = random() & 0x0000FFFFFFFFFFFFull;
+        if (i % 2) {
+            target = pc + static_cast<uintptr_t>(static_cast<int64_t>(random() % 0x1FFFFFFFEull) - 0xFFFFFFFFll);
+        }
+        const auto code = A64::far_jump(pc, target);
+        adrp_sequences += code.size == 12;
+        if (run_arm64_far_jump(code, pc) != target) {
+            expect(false, "far jump from " + std::to_string(pc) + " to " + std::to_string(target));
+            break;
+        }
+    }
+    expect(adrp_sequences > 5000, "adrp sequence used within 4GB");
+    // 旧实现丢失地址的 [47:16] 位
+    expect(run_arm64_far_jump(A64::far_jump(0x1000, 0x0000FFFF12345678), 0x1000) == 0x0000FFFF12345678,
+           "far jump keeps the middle bits");
+
+    // 2. AArch64 入口 B：范围边界与对齐
+    const uintptr_t entry = 0x40000000;
+    for (int64_t offset : { int64_t{ 0 }, int64_t{ 4 }, int64_t{ -4 }, (int64_t{ 1 } << 27) - 4, -(int64_t{ 1 } << 27) }) {
+        const uintptr_t target = entry + static_cast<uintptr_t>(offset);
+        expect(A64::entry_reachable(entry, target) &&
+                       arm64_branch_target(A64::entry_jump(entry, target).word(0), entry) == target,
+               "b within range: " + std::to_string(offset));
+    }
+    expect(!A64::entry_reachable(entry, entry + (uintptr_t{ 1 } << 27)), "b past forward range");
+    expect(!A64::entry_reachable(entry, entry - (uintptr_t{ 1 } << 27) - 4), "b past backward range");
+    expect(!A64::entry_reachable(entry, entry + 6), "b to unaligned target");
+    expect(A64::entry_range < uint64_t{ 1 } << 27, "island search stays within b range");
+
+    // 3. x86-64 入口跳转与远跳转
+    using X86 = arch::X86_64;
+    for (int i = 0; i < 1000; ++i) {
+        const uintptr_t source = random() & 0x00007FFFFFFFFFFFull;
+        const uintptr_t target = source + static_cast<uintptr_t>(static_cast<int64_t>(random() % 0xFFFE0000ull) - 0x7FFF0000ll);
+        const auto jump = X86::entry_jump(source, target);
+        int32_t rel = 0;
+        memcpy(&rel, jump.bytes + 1, sizeof(rel));
+        if (!X86::entry_reachable(source, target) || jump.bytes[0] != 0xE9 ||
+            source + 5 + static_cast<uintptr_t>(static_cast<int64_t>(rel)) != target) {
+            expect(false, "jmp rel32 from " + std::to_string(source) + " to " + std::to_string(target));
+            break;
+        }
+        expect(x86_far_jump_target(X86::far_jump(source, target)) == target, "jmp [rip] target");
+    }
+
+    // 4. 字面量跳转岛：目标地址位于对齐位置，可单独改写
+    for (uintptr_t target : { uintptr_t{ 0 }, uintptr_t{ 0x00007F0012345678 } }) {
+        uint64_t x86_target = 0;
+        uint64_t a64_target = 0;
+        memcpy(&x86_target, X86::literal_jump(target).bytes + X86::literal_target_offset, sizeof(x86_target));
+        memcpy(&a64_target, A64::literal_jump(target).bytes + A64::literal_target_offset, sizeof(a64_target));
+        expect(x86_target == target && a64_target == target, "literal jump target");
+    }
+    expect(arch::Native::supported, "native backend is supported on this host");
+
+    return test::report("patch_arch_test");
+}
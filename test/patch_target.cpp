@@ -0,0 +1,151 @@
+// 补丁代理测试的目标进程：主线程与工作线程循环调用 rd_target_value，返回值变化时输出到标准输出；
+// 从标准输入接收 "dlopen <path>" 命令以模拟运行中加载模块，"tuning" 命令输出数据补丁测试使用的变量，
+// "block-scan" 命令启动一个屏蔽进程内代理扫描信号的线程，"hold-loader <ms>" 命令启动一个在
+// dl_iterate_phdr 回调中停留 ms 毫秒的线程，期间持有 dlopen 需要的加载器锁（0 表示直至退出）
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <link.h>
+#include <poll.h>
+#include <pthread.h>
+#include <string>
+#include <sys/prctl.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// 按 16 字节对齐，入口跳转可以一次原子写入（-O0 时编译器不对齐函数）
+extern "C" __attribute__((noinline, aligned(16))) int rd_target_value()
+{
+    static volatile int value = 1;
+    return value;
+}
+
+// 数据补丁测试使用的调优参数
+extern "C" {
+volatile int rd_queue_depth = 16;
+}
+
+namespace rd {
+struct Tuning {
+    static volatile unsigned batch_size;
+    static volatile double   backoff;
+};
+volatile unsigned Tuning::batch_size = 64;
+volatile double   Tuning::backoff = 0.5;
+} // namespace rd
+
+extern const int rd_const_limit;
+const int        rd_const_limit = 5;
+
+// 通过函数指针调用，避免编译器内联或常量折叠
+int (*volatile g_function)() = rd_target_value;
+
+struct LoaderHold {
+    std::atomic<bool> *running;
+    long               ms;
+};
+
+// dl_iterate_phdr 在调用回调期间持有 dl_load_write_lock，dlopen 把新模块加入列表时需要该锁
+int hold_loader(dl_phdr_info *, size_t, void *data)
+{
+    auto *hold = static_cast<LoaderHold *>(data);
+    std::printf("holding loader\n");
+    std::fflush(stdout);
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(hold->ms);
+    while (*hold->running && (hold->ms == 0 || std::chrono::steady_clock::now() < until)) {
+        usleep(1000);
+    }
+    std::printf("released loader\n");
+    std::fflush(stdout);
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2 || std::strcmp(argv[1], "serve") != 0) {
+        std::fprintf(stderr, "Usage: %s serve\n", argv[0]);
+        return 2;
+    }
+
+    // 允许非父进程的补丁代理 ptrace（Yama ptrace_scope = 1）
+    prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY);
+
+    std::atomic<bool> running{ true };
+    std::thread worker([&running] {
+        while (running) {
+            g_function();
+            usleep(500);
+        }
+    });
+
+    std::printf("ready\n");
+    std::fflush(stdout);
+
+    int last = 0;
+    std::string input;
+    std::vector<std::thread> blockers;
+    while (true) {
+        int value = g_function();
+        if (value != last) {
+            std::printf("value %d\n", value);
+            std::fflush(stdout);
+            last = value;
+        }
+
+        pollfd pfd{ STDIN_FILENO, POLLIN, 0 };
+        if (poll(&pfd, 1, 1) <= 0) {
+            continue;
+        }
+        char buffer[512];
+        ssize_t n = read(STDIN_FILENO, buffer, sizeof(buffer));
+        if (n <= 0) {
+            break;
+        }
+        input.append(buffer, static_cast<size_t>(n));
+        size_t pos;
+        while ((pos = input.find('\n')) != std::string::npos) {
+            std::string line = input.substr(0, pos);
+            input.erase(0, pos + 1);
+            if (line.compare(0, 7, "dlopen ") == 0) {
+                void *handle = dlopen(line.c_str() + 7, RTLD_NOW);
+                std::printf("loaded %s\n", handle ? "ok" : dlerror());
+                std::fflush(stdout);
+            } else if (line == "block-scan") {
+                blockers.emplace_back([&running] {
+                    sigset_t set;
+                    sigemptyset(&set);
+                    sigaddset(&set, SIGRTMAX - 2);
+                    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+                    while (running) {
+                        usleep(1000);
+                    }
+                });
+                std::printf("blocking scan\n");
+                std::fflush(stdout);
+            } else if (line.compare(0, 12, "hold-loader ") == 0) {
+                long ms = std::strtol(line.c_str() + 12, nullptr, 10);
+                blockers.emplace_back([&running, ms] {
+                    LoaderHold hold{ &running, ms };
+                    dl_iterate_phdr(hold_loader, &hold);
+                });
+            } else if (line == "tuning") {
+                std::printf("tuning depth=%d batch=%u backoff=%g limit=%d\n", rd_queue_depth,
+                            static_cast<unsigned>(rd::Tuning::batch_size), static_cast<double>(rd::Tuning::backoff),
+                            rd_const_limit);
+                std::fflush(stdout);
+            }
+        }
+    }
+
+    running = false;
+    worker.join();
+    for (auto &blocker : blockers) {
+        blocker.join();
+    }
+    return 0;
+}
@@ -0,0 +1,27 @@
+// 补丁代理测试使用的补丁库：提供 rd_target_value 的替换函数
+#include "patch_package.h"
+
+#include <unistd.h>
+
+extern "C" int rd_target_value_fixed()
+{
+    return 2;
+}
+
+extern "C" int rd_target_value_other()
+{
+    return 3;
+}
+
+// 每次调用停留 200ms，用于检查卸载补丁库时等待线程离开库中的代码
+extern "C" int rd_target_value_slow()
+{
+    usleep(200 * 1000);
+    return 4;
+}
+
+// 作为补丁包加载时安装的补丁
+REMOTEDEBUG_PATCH_TABLE = {
+    { "rd_target_value", "rd_target_value_fixed" },
+    { nullptr, nullptr },
+};
@@ -0,0 +1,439 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 测试用的本地替身服务器：监听 127.0.0.1 的随机端口，模拟设备侧服务
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pty.h>
+#include <csignal>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace RemoteDebug {
+namespace test {
+
+constexpr uint32_t loopback_ip = 0x7F000001; // 127.0.0.1（主机字节序）
+
+inline int listen_loopback(uint16_t &port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(loopback_ip);
+    addr.sin_port = 0;
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len);
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+/**
+ * @brief 替身服务器基类：后台线程 accept，每个连接一个处理线程
+ */
+class StubServer {
+public:
+    StubServer() = default;
+    StubServer(const StubServer &) = delete;
+    StubServer &operator=(const StubServer &) = delete;
+    virtual ~StubServer() { stop(); }
+
+    bool start()
+    {
+        m_listen_fd = listen_loopback(m_port);
+        if (m_listen_fd < 0) {
+            return false;
+        }
+        m_accept_thread = std::thread([this] { accept_loop(); });
+        return true;
+    }
+
+    void stop()
+    {
+        if (m_listen_fd < 0) {
+            return;
+        }
+        m_stopping = true;
+        shutdown(m_listen_fd, SHUT_RDWR);
+        m_accept_thread.join();
+        close(m_listen_fd);
+        m_listen_fd = -1;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (int fd : m_client_fds) {
+            shutdown(fd, SHUT_RDWR);
+        }
+        for (auto &worker : m_workers) {
+            worker.join();
+        }
+        m_workers.clear();
+    }
+
+    uint16_t port() const { return m_port; }
+
+    // 已接受的连接数
+    size_t connections()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_client_fds.size();
+    }
+
+protected:
+    virtual void serve(int client_fd) = 0;
+
+    static bool send_text(int fd, const std::string &text)
+    {
+        return send(fd, text.data(), text.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(text.size());
+    }
+
+    std::atomic<bool> m_stopping{ false };
+
+private:
+    void accept_loop()
+    {
+        while (!m_stopping) {
+            int client_fd = accept4(m_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client_fd < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            // 与真实服务器一样及时发送小应答，避免 Nagle 与延迟确认叠加出 40ms 的停顿
+            int one = 1;
+            setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_client_fds.push_back(client_fd);
+            m_workers.emplace_back([this, client_fd] {
+                serve(client_fd);
+                shutdown(client_fd, SHUT_RDWR);
+            });
+        }
+    }
+
+    int                      m_listen_fd{ -1 };
+    uint16_t                 m_port{ 0 };
+    std::thread              m_accept_thread;
+    std::mutex               m_mutex;
+    std::vector<int>         m_client_fds;
+    std::vector<std::thread> m_workers;
+};
+
+/**
+ * @brief 最小 FTP 服务器：USER/PASS/TYPE/PASV/SIZE/REST/STOR/RNFR/RNTO/QUIT
+ * @details 远端路径只取文件名，保存到 root 目录下
+ */
+class FtpStubServer : public StubServer {
+public:
+    explicit FtpStubServer(std::string root) : m_root(std::move(root)) {}
+    ~FtpStubServer() override { stop(); }
+
+    std::string local_path(const std::string &remote) const
+    {
+        return m_root + "/" + remote.substr(remote.find_last_of('/') + 1);
+    }
+
+    // 数据连接收到指定字节数后主动断开，模拟传输中断（0 表示不断开）
+    void set_abort_after(size_t bytes) { m_abort_after = bytes; }
+
+    size_t last_rest_offset() const { return m_last_rest; }
+    size_t stor_count() const { return m_stor_count; }
+
+protected:
+    void serve(int fd) override
+    {
+        send_text(fd, "220 RemoteDebug stub ftp ready\r\n");
+
+        std::string buffer;
+        std::string rename_from;
+        int pasv_fd = -1;
+        size_t rest = 0;
+        while (!m_stopping) {
+            size_t pos;
+            while ((pos = buffer.find("\r\n")) == std::string::npos) {
+                char chunk[512];
+                ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) {
+                    if (pasv_fd >= 0) {
+                        close(pasv_fd);
+                    }
+                    return;
+                }
+                buffer.append(chunk, static_cast<size_t>(n));
+            }
+            std::string line = buffer.substr(0, pos);
+            buffer.erase(0, pos + 2);
+
+            std::string verb = line.substr(0, line.find(' '));
+            std::string arg = line.size() > verb.size() ? line.substr(verb.size() + 1) : "";
+            if (verb == "USER") {
+                send_text(fd, "331 password required\r\n");
+            } else if (verb == "PASS") {
+                send_text(fd, "230 logged in\r\n");
+            } else if (verb == "TYPE") {
+                send_text(fd, "200 type set\r\n");
+            } else if (verb == "PASV") {
+                uint16_t data_port = 0;
+                pasv_fd = listen_loopback(data_port);
+                send_text(fd, "227 Entering Passive Mode (127,0,0,1," + std::to_string(data_port >> 8) + "," +
+                                  std::to_string(data_port & 0xFF) + ")\r\n");
+            } else if (verb == "SIZE") {
+                struct stat st{};
+                if (stat(local_path(arg).c_str(), &st) == 0) {
+                    send_text(fd, "213 " + std::to_string(st.st_size) + "\r\n");
+                } else {
+                    send_text(fd, "550 no such file\r\n");
+                }
+            } else if (verb == "REST") {
+                rest = std::strtoull(arg.c_str(), nullptr, 10);
+                m_last_rest = rest;
+                send_text(fd, "350 restarting\r\n");
+            } else if (verb == "STOR") {
+                if (pasv_fd < 0) {
+                    send_text(fd, "425 use PASV first\r\n");
+                    continue;
+                }
+                send_text(fd, "150 opening data connection\r\n");
+                bool complete = receive_file(pasv_fd, local_path(arg), rest);
+                close(pasv_fd);
+                pasv_fd = -1;
+                rest = 0;
+                ++m_stor_count;
+                send_text(fd, complete ? "226 transfer complete\r\n" : "426 connection aborted\r\n");
+                if (!complete) {
+                    return;
+                }
+            } else if (verb == "RNFR") {
+                rename_from = local_path(arg);
+                send_text(fd, "350 ready for RNTO\r\n");
+            } else if (verb == "RNTO") {
+                bool ok = std::rename(rename_from.c_str(), local_path(arg).c_str()) == 0;
+                send_text(fd, ok ? "250 renamed\r\n" : "550 rename failed\r\n");
+            } else if (verb == "QUIT") {
+                send_text(fd, "221 bye\r\n");
+                break;
+            } else {
+                send_text(fd, "502 not implemented\r\n");
+            }
+        }
+        if (pasv_fd >= 0) {
+            close(pasv_fd);
+        }
+    }
+
+private:
+    bool receive_file(int pasv_fd, const std::string &path, size_t rest)
+    {
+        int data_fd = accept4(pasv_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (data_fd < 0) {
+            return false;
+        }
+
+        int file_fd = open(path.c_str(), O_WRONLY | O_CREAT | (rest ? 0 : O_TRUNC), 0644);
+        if (rest) {
+            ftruncate(file_fd, static_cast<off_t>(rest));
+            lseek(file_fd, static_cast<off_t>(rest), SEEK_SET);
+        }
+
+        bool complete = true;
+        size_t received = 0;
+        char chunk[64 * 1024];
+        ssize_t n;
+        while ((n = recv(data_fd, chunk, sizeof(chunk), 0)) > 0) {
+            size_t len = static_cast<size_t>(n);
+            if (m_abort_after && received + len >= m_abort_after) {
+                len = m_abort_after - received;
+                complete = false;
+            }
+            if (write(file_fd, chunk, len) != static_cast<ssize_t>(len)) {
+                complete = false;
+            }
+            received += len;
+            if (!complete) {
+                break;
+            }
+        }
+        close(file_fd);
+        close(data_fd);
+        return complete;
+    }
+
+    std::string         m_root;
+    std::atomic<size_t> m_abort_after{ 0 };
+    std::atomic<size_t> m_last_rest{ 0 };
+    std::atomic<size_t> m_stor_count{ 0 };
+};
+
+/**
+ * @brief 最小 telnet 服务器：协商选项、校验登录后在伪终端中启动 /bin/sh
+ * @details 与常见 telnetd 一致：输入中的 IAC 序列被剔除，CR LF / CR NUL 转换为 CR，
+ *          终端使用默认的规范模式（回显、ICRNL、ONLCR）
+ */
+class TelnetStubServer : public StubServer {
+public:
+    TelnetStubServer(std::string username, std::string password)
+        : m_username(std::move(username)), m_password(std::move(password)) {}
+    ~TelnetStubServer() override { stop(); }
+
+    size_t login_failures() const { return m_login_failures; }
+
+protected:
+    void serve(int fd) override
+    {
+        // 服务端常见的初始协商：要求终端类型，声明回显与抑制 GA
+        const unsigned char negotiation[] = { 255, 253, 24, 255, 251, 1, 255, 251, 3 };
+        send(fd, negotiation, sizeof(negotiation), MSG_NOSIGNAL);
+
+        std::string input;
+        bool logged_in = false;
+        for (int attempt = 0; attempt < 3 && !logged_in; ++attempt) {
+            std::string username;
+            std::string password;
+            if (!send_text(fd, "stub login: ") || !read_line(fd, input, username) ||
+                !send_text(fd, "Password: ") || !read_line(fd, input, password)) {
+                return;
+            }
+            logged_in = username == m_username && password == m_password;
+            if (!logged_in) {
+                ++m_login_failures;
+                send_text(fd, "\r\nLogin incorrect\r\n");
+            }
+        }
+        if (logged_in) {
+            run_shell(fd, input);
+        }
+    }
+
+private:
+    // 读取一行登录输入（登录阶段不回显，与 login 程序读取密码时一致）
+    static bool read_line(int fd, std::string &input, std::string &line)
+    {
+        size_t pos;
+        while ((pos = input.find_first_of("\r\n")) == std::string::npos) {
+            char chunk[256];
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                return false;
+            }
+            input += filter_input(chunk, static_cast<size_t>(n));
+        }
+        line = input.substr(0, pos);
+        input.erase(0, pos + 1);
+        return true;
+    }
+
+    // 剔除 IAC 命令，CR LF / CR NUL 转换为 CR；简化处理：序列不会跨越两次 recv
+    static std::string filter_input(const char *data, size_t size)
+    {
+        std::string out;
+        for (size_t i = 0; i < size; ++i) {
+            unsigned char c = static_cast<unsigned char>(data[i]);
+            if (c == 255 && i + 1 < size) {
+                unsigned char command = static_cast<unsigned char>(data[i + 1]);
+                if (command == 255) {
+                    out += data[i];
+                    ++i;
+                } else if (command >= 251 && command <= 254) {
+                    i += 2;
+                } else {
+                    ++i;
+                }
+            } else if (c == '\r' && i + 1 < size && (data[i + 1] == '\n' || data[i + 1] == '\0')) {
+                out += '\r';
+                ++i;
+            } else {
+                out += data[i];
+            }
+        }
+        return out;
+    }
+
+    void run_shell(int fd, const std::string &pending)
+    {
+        int master_fd = -1;
+        pid_t pid = forkpty(&master_fd, nullptr, nullptr, nullptr);
+        if (pid < 0) {
+            return;
+        }
+        if (pid == 0) {
+            // 多线程进程 fork 后只调用 async-signal-safe 函数
+            char *const argv[] = { const_cast<char *>("sh"), nullptr };
+            char *const envp[] = { const_cast<char *>("PS1=$ "), const_cast<char *>("PATH=/usr/bin:/bin"),
+                                   nullptr };
+            execve("/bin/sh", argv, envp);
+            _exit(127);
+        }
+
+        // 登录阶段多读到的输入转交给 shell
+        std::string input = pending;
+        bool ok = input.empty() || write(master_fd, input.data(), input.size()) == static_cast<ssize_t>(input.size());
+        while (ok && !m_stopping) {
+            pollfd fds[2] = { { fd, POLLIN, 0 }, { master_fd, POLLIN, 0 } };
+            if (poll(fds, 2, 200) < 0) {
+                break;
+            }
+            char chunk[16 * 1024];
+            if (fds[0].revents) {
+                ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) {
+                    break;
+                }
+                input = filter_input(chunk, static_cast<size_t>(n));
+                // 阻塞写入：终端缓冲区满时暂停读取 socket，由 TCP 向客户端施加背压
+                for (size_t off = 0; ok && off < input.size();) {
+                    ssize_t w = write(master_fd, input.data() + off, input.size() - off);
+                    ok = w > 0;
+                    off += ok ? static_cast<size_t>(w) : 0;
+                }
+            }
+            if (fds[1].revents) {
+                ssize_t n = read(master_fd, chunk, sizeof(chunk));
+                if (n <= 0) {
+                    break;
+                }
+                std::string output;
+                for (ssize_t i = 0; i < n; ++i) {
+                    output += chunk[i];
+                    if (static_cast<unsigned char>(chunk[i]) == 255) {
+                        output += chunk[i];
+                    }
+                }
+                ok = send_text(fd, output);
+            }
+        }
+
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        close(master_fd);
+    }
+
+    std::string         m_username;
+    std::string         m_password;
+    std::atomic<size_t> m_login_failures{ 0 };
+};
+
+}; // namespace test
+}; // namespace RemoteDebug
@@ -0,0 +1,242 @@
+#include "inject/symbol_index.h"
+#include "test_common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <elf.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace RemoteDebug;
+using test::expect;
+using test::read_file;
+
+namespace rd_index {
+struct Service {
+    int handle(int value);
+};
+__attribute__((noinline)) int Service::handle(int value)
+{
+    return value + 1;
+}
+__attribute__((noinline)) int compute(int value)
+{
+    return value * 2;
+}
+__attribute__((noinline)) double compute(double value)
+{
+    return value * 2;
+}
+} // namespace rd_index
+
+extern "C" __attribute__((noinline)) int rd_index_marker(int value)
+{
+    return value * 3 + 1;
+}
+
+namespace {
+
+int copy_file(const std::string &from, const std::string &to)
+{
+    std::ifstream in(from, std::ios::binary);
+    std::ofstream out(to, std::ios::binary);
+    out << in.rdbuf();
+    return in && out ? 0 : -1;
+}
+
+// 修改索引文件内容：在 offset 处写入 value
+template <typename T>
+void write_at(std::string &image, size_t offset, T value)
+{
+    memcpy(&image[offset], &value, sizeof(value));
+}
+
+template <typename T>
+T read_at(const std::string &image, size_t offset)
+{
+    T value{};
+    memcpy(&value, image.data() + offset, sizeof(value));
+    return value;
+}
+
+void write_image(const std::string &path, const std::string &image)
+{
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << image;
+}
+
+template <typename F>
+double measure_us(size_t rounds, F &&f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i) {
+        f(i);
+    }
+    const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(rounds);
+}
+
+} // namespace
+
+int main()
+{
+    char directory[] = "/tmp/rd_symbol_index_XXXXXX";
+    if (!mkdtemp(directory)) {
+        std::cerr << "mkdtemp failed" << std::endl;
+        return 1;
+    }
+    const std::string binary = std::string(directory) + "/target";
+    const std::string cache = std::string(directory) + "/cache";
+    expect(copy_file("/proc/self/exe", binary) == 0, "copy own executable");
+    setenv("REMOTEDEBUG_CACHE_DIR", cache.c_str(), 1);
+    const std::string cache_path = SymbolIndex::cache_path_for(binary);
+
+    // 1. 生成索引文件，全部符号与 ElfSymbols 一致；自动生成的索引只写入缓存目录
+    SymbolIndex index;
+    expect(index.open_for(binary) == 0, "open_for builds the index");
+    expect(access(SymbolIndex::path_for(binary).c_str(), F_OK) != 0, "nothing written next to the binary");
+    expect(cache_path.compare(0, cache.size() + 1, cache + "/") == 0 && access(cache_path.c_str(), R_OK) == 0,
+           "index saved in the cache directory: " + cache_path);
+    ElfSymbols symbols;
+    expect(symbols.load(binary) == 0, "load symbols");
+    expect(index.size() == symbols.size() && index.load_address() == symbols.load_address(),
+           "same symbols as ElfSymbols: " + std::to_string(index.size()) + " vs " + std::to_string(symbols.size()));
+    size_t mismatched = 0;
+    for (size_t i = 0; i < index.size(); ++i) {
+        const ElfSymbol *expected = symbols.find(index.name(i));
+        const ElfSymbol actual = index.symbol(i);
+        mismatched += !expected || expected->value != actual.value || expected->size != actual.size ||
+                      expected->bind != actual.bind || index.find(index.name(i)) != static_cast<ssize_t>(i);
+    }
+    expect(mismatched == 0, "every symbol round trips: " + std::to_string(mismatched) + " mismatched");
+
+    // 2. 精确、前缀、子串与地址查找
+    const ssize_t marker = index.find("rd_index_marker");
+    expect(marker >= 0 && index.symbol(static_cast<size_t>(marker)).type == STT_FUNC, "exact lookup");
+    expect(index.find("rd_index_marke") < 0 && index.find("rd_index_marker_") < 0, "exact lookup misses");
+    const std::vector<size_t> prefixed = index.find_prefix("_ZN8rd_index7compute", 10);
+    expect(prefixed.size() == 2, "prefix lookup finds both overloads");
+    const std::vector<size_t> fuzzy = index.find_fuzzy("rd_index::Service::handle", 10);
+    expect(fuzzy.size() == 1 && index.demangled(fuzzy[0]) == "rd_index::Service::handle(int)",
+           "substring of the demangled name");
+    if (marker >= 0) {
+        const ElfSymbol symbol = index.symbol(static_cast<size_t>(marker));
+        uint64_t offset = 0;
+        expect(index.find_address(symbol.value + 4, offset) == marker && offset == 4, "address inside a function");
+        expect(index.find_address(symbol.value + symbol.size, offset) != marker, "address past the function end");
+    }
+    ProcessSymbolizer symbolizer(getpid());
+    const auto address = reinterpret_cast<uintptr_t>(&rd_index_marker) + 4;
+    expect(symbolizer.describe(address) == "rd_index_marker+0x4", "runtime address: " + symbolizer.describe(address));
+    const std::string annotated = symbolizer.annotate("fault at 0x" + [address] {
+        char text[32];
+        snprintf(text, sizeof(text), "%lx", static_cast<unsigned long>(address));
+        return std::string(text);
+    }() + " and 0x1");
+    expect(annotated.find("(rd_index_marker+0x4) and 0x1") != std::string::npos, "annotate: " + annotated);
+
+    // 3. 选择补丁目标
+    std::string name;
+    std::vector<std::string> candidates;
+    expect(select_symbol(index, "rd_index_marker", name, candidates) == 0 && name == "rd_index_marker",
+           "select exact name");
+    expect(select_symbol(index, "rd_index::Service::handle", name, candidates) == 0 &&
+               name == "_ZN8rd_index7Service6handleEi",
+           "select by demangled name: " + name);
+    expect(select_symbol(index, "rd_index::compute", name, candidates) != 0 && candidates.size() == 2,
+           "overloads are ambiguous");
+    expect(select_symbol(index, "rd_index::compute(double)", name, candidates) == 0 &&
+               name == "_ZN8rd_index7computeEd",
+           "select one overload");
+    expect(select_symbol(index, "rd_no_such_symbol", name, candidates) != 0 && candidates.empty(), "no match");
+
+    // 4. 源文件变化后索引过期并重新生成
+    expect(index.open(cache_path, SymbolIndex::stamp_of(binary)) == 0, "fresh index opens");
+    const timespec times[2] = { { 0, UTIME_NOW }, { 1000, 0 } };
+    expect(utimensat(AT_FDCWD, binary.c_str(), times, 0) == 0, "touch binary");
+    expect(index.open(cache_path, SymbolIndex::stamp_of(binary)) != 0, "stale index rejected");
+    expect(index.open_for(binary) == 0 && index.find("rd_index_marker") == marker, "stale index rebuilt");
+
+    // 5. 损坏的缓存索引：越界的组偏移、地址序号与截断的文件打开失败，损坏的 varint 不越界读取，open_for 重新生成
+    const std::string good = read_file(cache_path);
+    const IndexStamp stamp = SymbolIndex::stamp_of(binary);
+    const auto names = read_at<uint64_t>(good, 40);     // Header::names
+    const auto buckets = read_at<uint64_t>(good, 48);   // Header::name_buckets
+    const auto addresses = read_at<uint64_t>(good, 80); // Header::addresses
+    std::string corrupt = good;
+    write_at<uint64_t>(corrupt, buckets, UINT64_MAX / 2);
+    write_image(cache_path, corrupt);
+    expect(index.open(cache_path, stamp) != 0, "bucket offset outside the table rejected");
+    corrupt = good;
+    write_at<uint32_t>(corrupt, addresses, UINT32_MAX);
+    write_image(cache_path, corrupt);
+    expect(index.open(cache_path, stamp) != 0, "address index out of range rejected");
+    write_image(cache_path, good.substr(0, good.size() / 2));
+    expect(index.open(cache_path, stamp) != 0, "truncated index rejected");
+    corrupt = good;
+    std::fill(corrupt.begin() + static_cast<long>(names), corrupt.begin() + static_cast<long>(buckets), '\xff');
+    write_image(cache_path, corrupt);
+    expect(index.open(cache_path, stamp) == 0 && index.find("rd_index_marker") < 0 &&
+                   index.find_prefix("rd_", 10).empty() && index.name(0).empty(),
+           "unterminated varints decode as missing names");
+    write_at<uint64_t>(corrupt, buckets, UINT64_MAX / 2);
+    write_image(cache_path, corrupt);
+    expect(index.open_for(binary) == 0 && index.find("rd_index_marker") == marker, "corrupt cache index rebuilt");
+
+    expect(SymbolIndex::build(binary, SymbolIndex::path_for(binary)) == 0 &&
+               index.open(SymbolIndex::path_for(binary), SymbolIndex::stamp_of(binary)) == 0,
+           "explicit build writes next to the binary");
+    unlink(SymbolIndex::path_for(binary).c_str());
+    unlink(cache_path.c_str());
+    rmdir(cache.c_str());
+    unlink(binary.c_str());
+    rmdir(directory);
+
+    // 6. 大符号表的查找耗时与索引大小
+    constexpr size_t count = 500000;
+    std::vector<IndexEntry> entries;
+    size_t raw_bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const std::string type = "Handler" + std::to_string(i / 100);
+        const std::string method = "process" + std::to_string(i % 100);
+        const std::string mangled = "_ZN3svc" + std::to_string(type.size()) + type + std::to_string(method.size()) +
+                                    method + "Ei";
+        raw_bytes += mangled.size() + 1 + sizeof(Elf64_Sym);
+        entries.push_back({ mangled, { 0x400000 + i * 32, 16, STT_FUNC, STB_GLOBAL } });
+    }
+    SymbolIndex large;
+    const auto build_start = std::chrono::steady_clock::now();
+    std::vector<uint8_t> image = encode_symbol_index(std::move(entries), 0x400000, {});
+    const std::chrono::duration<double, std::milli> build_ms = std::chrono::steady_clock::now() - build_start;
+    const size_t image_size = image.size();
+    expect(large.assign(std::move(image)) == 0 && large.size() == count, "large index");
+    size_t found = 0;
+    const double exact_us = measure_us(10000, [&](size_t i) {
+        const size_t n = i * 7919 % count;
+        found += large.find("_ZN3svc" + std::to_string(7 + std::to_string(n / 100).size()) + "Handler" +
+                            std::to_string(n / 100) + std::to_string(7 + std::to_string(n % 100).size()) + "process" +
+                            std::to_string(n % 100) + "Ei") >= 0;
+    });
+    expect(found == 10000, "large exact lookup");
+    found = 0;
+    const double address_us = measure_us(10000, [&](size_t i) {
+        uint64_t offset = 0;
+        found += large.find_address(0x400000 + (i * 7919 % count) * 32 + 8, offset) >= 0 && offset == 8;
+    });
+    expect(found == 10000, "large address lookup");
+    const double fuzzy_us =
+            measure_us(1, [&](size_t) { found = large.find_fuzzy("Handler4999::process9(", 10).size(); });
+    expect(found == 1, "large fuzzy lookup");
+    std::cout << count << " symbols: index " << image_size / 1024 << " KB (ELF symtab+strtab " << raw_bytes / 1024
+              << " KB), build " << static_cast<long>(build_ms.count()) << " ms, exact " << exact_us << " us, address "
+              << address_us << " us, fuzzy " << fuzzy_us / 1000 << " ms" << std::endl;
+    expect(image_size < raw_bytes, "index smaller than the symbol table");
+
+    return test::report("symbol_index_test");
+}
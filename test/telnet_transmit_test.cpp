@@ -0,0 +1,114 @@
+#include "transmit/telnet_transmit.h"
+#include "stub_server.h"
+#include "test_common.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+using namespace RemoteDebug;
+using test::expect;
+using test::read_file;
+using test::write_random_file;
+
+namespace {
+
+// 可压缩的文本内容
+void write_text_file(const std::string &path, size_t size)
+{
+    std::string data;
+    for (size_t line = 0; data.size() < size; ++line) {
+        data += "symbol_" + std::to_string(line % 977) + " = 0x" + std::to_string(line * 16) + ";\n";
+    }
+    data.resize(size);
+    std::ofstream(path, std::ios::binary) << data;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <RemoteDebug binary>" << std::endl;
+        return 2;
+    }
+
+    // 与 cksum(1) 输出一致
+    expect(TelnetTransmit::posix_cksum("123456789", 9) == 930766865u, "posix cksum of check string");
+    expect(TelnetTransmit::posix_cksum("", 0) == 4294967295u, "posix cksum of empty input");
+
+    char root_template[] = "/tmp/telnet_stub_XXXXXX";
+    std::string root = mkdtemp(root_template);
+    std::string local_file = root + "/patch.so";
+    write_random_file(local_file, 600 * 1024 + 7, 11);
+
+    test::TelnetStubServer server("user", "pass");
+    if (!server.start()) {
+        std::cerr << "Failed to start telnet stub server" << std::endl;
+        return 1;
+    }
+
+    Device_info device{ TRANSMIT_TYPE::TELNET, test::loopback_ip, server.port(), local_file, "user", "pass",
+                        root + "/remote_file" };
+    TelnetTransmit telnet;
+
+    // 1. 远端命令的输出与退出码
+    std::string output;
+    expect(telnet.execute(device, "echo hello; printf 'a\\377b\\n'; false", output) == 1, "execute exit status");
+    expect(output == "hello\na\377b\n", "execute output");
+
+    // 2. 窗口化上传，较小窗口以覆盖多次确认
+    telnet.set_window(4, 2);
+    auto start = std::chrono::steady_clock::now();
+    expect(telnet.transmit(device) == 0, "windowed upload returns 0");
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    expect(read_file(device.remote_path) == read_file(local_file), "windowed upload content");
+    expect(read_file(device.remote_path + ".part").empty(), "part file renamed");
+    std::cout << "telnet upload of 600 KB took " << elapsed.count() << " ms" << std::endl;
+
+    // 3. 复用会话上传较小的文件与空文件
+    write_random_file(local_file, 5000, 11);
+    telnet.set_window(16, 2);
+    expect(telnet.transmit(device) == 0, "reused session upload returns 0");
+    expect(read_file(device.remote_path) == read_file(local_file), "reused session content");
+    std::ofstream(local_file, std::ios::trunc).close();
+    expect(telnet.transmit(device) == 0 && read_file(device.remote_path).empty(), "empty file upload");
+
+    // 4. 压缩上传：压缩流写入临时文件，校验后由设备侧工具解压为目标文件
+    const COMPRESS_TYPE type = StreamCompressor::preferred_type();
+    if (type != COMPRESS_TYPE::NONE) {
+        write_text_file(local_file, 700 * 1024 + 5);
+        telnet.set_compression(type, argv[1]);
+        expect(telnet.transmit(device) == 0, "compressed upload returns 0");
+        expect(read_file(device.remote_path) == read_file(local_file), "compressed upload content");
+        expect(access((device.remote_path + ".z.part").c_str(), F_OK) != 0, "compressed part file removed");
+
+        // 设备侧解压失败时上传失败，目标文件保持不变
+        const std::string previous = read_file(device.remote_path);
+        write_text_file(local_file, 300 * 1024);
+        telnet.set_compression(type, "/bin/false");
+        expect(telnet.transmit(device) != 0, "failing decompressor fails the upload");
+        expect(read_file(device.remote_path) == previous, "failed decompress keeps the old file");
+
+        // 设备上没有工具时不压缩
+        telnet.set_compression(type, root + "/no_such_tool");
+        expect(telnet.transmit(device) == 0 && read_file(device.remote_path) == read_file(local_file),
+               "missing tool falls back to an uncompressed upload");
+        telnet.set_compression(COMPRESS_TYPE::NONE);
+    }
+
+    // 5. 错误密码登录失败
+    Device_info wrong{ TRANSMIT_TYPE::TELNET, test::loopback_ip, server.port(), local_file, "user", "wrong",
+                       root + "/never" };
+    TelnetTransmit other;
+    expect(other.transmit(wrong) != 0, "wrong password rejected");
+    expect(server.login_failures() >= 1, "stub saw failed login");
+
+    server.stop();
+    std::system(("rm -rf " + root).c_str());
+
+    return test::report("telnet_transmit_test");
+}
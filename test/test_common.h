@@ -0,0 +1,60 @@
+// Copyright (c) 2025 The RemoteDebug Authors. All rights reserved.
+// 测试辅助：断言计数、结果输出与文件读写，各测试程序共用
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+
+namespace RemoteDebug {
+namespace test {
+
+inline int g_failures = 0;
+
+/**
+ * @brief 检查条件，失败时输出原因并计数，测试继续执行
+ */
+inline void expect(bool condition, const std::string &message)
+{
+    if (!condition) {
+        std::cerr << "FAILED: " << message << std::endl;
+        ++g_failures;
+    }
+}
+
+/**
+ * @brief 输出 "<name> passed" 或 "<name> failed"
+ * @return main 的返回值，有失败时为1
+ */
+inline int report(const char *name)
+{
+    std::cout << name << (g_failures ? " failed" : " passed") << std::endl;
+    return g_failures ? 1 : 0;
+}
+
+inline std::string read_file(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+/**
+ * @brief 写入 size 字节的伪随机内容，相同 seed 生成相同内容
+ */
+inline void write_random_file(const std::string &path, size_t size, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::string data(size, '\0');
+    for (auto &c : data) {
+        c = static_cast<char>(rng());
+    }
+    std::ofstream(path, std::ios::binary) << data;
+}
+
+}; // namespace test
+}; // namespace RemoteDebug
@@ -0,0 +1,130 @@
+#include "hash.h"
+#include "inject/text_image.h"
+#include "test_common.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <link.h>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace RemoteDebug;
+using test::expect;
+
+namespace {
+
+uintptr_t own_bias()
+{
+    uintptr_t bias = 0;
+    dl_iterate_phdr(
+            [](dl_phdr_info *info, size_t, void *data) {
+                *static_cast<uintptr_t *>(data) = info->dlpi_addr;
+                return 1; // 第一个模块是可执行文件本身
+            },
+            &bias);
+    return bias;
+}
+
+// 读取自身内存，并在 [tamper, tamper + patch.size()) 处替换为 patch
+MemoryReader own_memory(uintptr_t tamper = 0, std::vector<uint8_t> patch = {})
+{
+    return [tamper, patch](uintptr_t address, void *buffer, size_t size) {
+        memcpy(buffer, reinterpret_cast<const void *>(address), size);
+        for (size_t i = 0; i < patch.size(); ++i) {
+            if (tamper + i >= address && tamper + i < address + size) {
+                static_cast<uint8_t *>(buffer)[tamper + i - address] = patch[i];
+            }
+        }
+        return 0;
+    };
+}
+
+} // namespace
+
+extern "C" __attribute__((noinline)) int rd_verify_target(int value)
+{
+    return value * 3 + 1;
+}
+
+int main()
+{
+    // 1. CRC32C：标准测试向量，硬件与查表实现一致，可分段计算
+    expect(crc32c("123456789", 9) == 0xE3069283u, "crc32c check value");
+    std::vector<uint8_t> zeros(32, 0);
+    expect(crc32c(zeros.data(), zeros.size()) == 0x8A9136AAu, "crc32c of 32 zero bytes");
+    std::mt19937 random(39);
+    std::vector<uint8_t> data(100 * 1024 * 1024);
+    for (auto &byte : data) {
+        byte = static_cast<uint8_t>(random());
+    }
+    for (size_t size : { 0, 1, 7, 8, 9, 63, 4096, 4099 }) {
+        const uint32_t software = ~detail::crc32c_software(~0u, data.data() + 3, size);
+        expect(crc32c(data.data() + 3, size) == software, "hardware matches table for " + std::to_string(size));
+        expect(crc32c(data.data() + 3 + size / 2, size - size / 2, crc32c(data.data() + 3, size / 2)) == software,
+               "chained crc32c for " + std::to_string(size));
+    }
+    const auto start = std::chrono::steady_clock::now();
+    uint32_t sink = 0;
+    for (size_t offset = 0; offset < data.size(); offset += text_block_size) {
+        sink ^= crc32c(data.data() + offset, text_block_size);
+    }
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << "crc32c 100MB in 4KB blocks: " << ms.count() << " ms (" << sink << ")" << std::endl;
+
+    // 2. 自身代码段与可执行文件一致
+    TextImage image;
+    expect(image.load("/proc/self/exe") == 0 && !image.segments().empty(), "load own text segments");
+    const uintptr_t bias = own_bias();
+    TextVerifyReport report;
+    expect(verify_module_text(image, "/proc/self/exe", bias, {}, own_memory(), report) == 0, "verify own text");
+    expect(report.diffs.empty() && report.modules == 1 && report.segments == image.segments().size() &&
+                   report.bytes > 0,
+           "own text matches: " + format_verify_report(report, 4));
+
+    // 3. 改动的字节给出精确区间，跨越块边界的区间合并为一个
+    const auto function = reinterpret_cast<uintptr_t>(&rd_verify_target);
+    const TextSegment &segment = image.segments().front();
+    const uintptr_t boundary = ((function - bias - segment.vaddr) / text_block_size + 1) * text_block_size +
+                               segment.vaddr + bias;
+    report = TextVerifyReport();
+    const std::vector<uint8_t> tampered{ 0xCC, 0xCC, 0xCC };
+    verify_module_text(image, "/proc/self/exe", bias, {}, own_memory(function, tampered), report);
+    verify_module_text(image, "/proc/self/exe", bias, {}, own_memory(boundary - 2, { 0xCC, 0xCC, 0xCC, 0xCC }),
+                       report);
+    bool found_function = false;
+    bool found_boundary = false;
+    for (const auto &diff : report.diffs) {
+        found_function |= diff.begin >= function && diff.end <= function + 3 && diff.label == "unexpected" &&
+                          diff.offset == diff.begin - bias;
+        found_boundary |= diff.begin >= boundary - 2 && diff.begin < boundary && diff.end > boundary &&
+                          diff.end <= boundary + 2;
+    }
+    expect(found_function, "tampered function entry reported: " + format_verify_report(report, 8));
+    expect(found_boundary, "range across a block boundary is merged: " + format_verify_report(report, 8));
+    expect(format_diff(report.diffs.front()).find(":exe+0x") != std::string::npos, "diff format");
+
+    // 4. 补丁清单：期望的跳转已写入时无差异，未写入时按补丁报告
+    const std::vector<uint8_t> jump{ 0xE9, 0x10, 0x20, 0x30, 0x00 };
+    const std::vector<TextExpectation> manifest{ { function, jump, "patch:rd_verify_target" } };
+    report = TextVerifyReport();
+    verify_module_text(image, "/proc/self/exe", bias, manifest, own_memory(function, jump), report);
+    expect(report.diffs.empty(), "expected patch matches: " + format_verify_report(report, 4));
+    report = TextVerifyReport();
+    verify_module_text(image, "/proc/self/exe", bias, manifest, own_memory(), report);
+    expect(report.diffs.size() == 1 && report.diffs[0].begin >= function && report.diffs[0].end <= function + 5 &&
+                   report.diffs[0].label == "patch:rd_verify_target",
+           "missing patch reported: " + format_verify_report(report, 4));
+
+    // 5. 读取失败的模块计入 skipped
+    report = TextVerifyReport();
+    expect(verify_module_text(image, "m", bias, {}, [](uintptr_t, void *, size_t) { return -1; }, report) != 0 &&
+                   report.skipped.size() == 1,
+           "unreadable module skipped");
+    expect(format_verify_report(report, 0).find("skipped=1") != std::string::npos, "report counts skipped modules");
+    (void)rd_verify_target(1);
+
+    return test::report("text_verify_test");
+}
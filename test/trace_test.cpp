@@ -0,0 +1,121 @@
+#include "trace.h"
+#include "test_common.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace RemoteDebug;
+using test::expect;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr uint64_t base_ns = 1000000000;
+
+TraceEvent event(const char *name, const char *category, uint64_t start_us, uint64_t end_us, uint32_t tid = 1)
+{
+    return { name, category, base_ns + start_us * 1000, (end_us - start_us) * 1000, tid, 42 };
+}
+
+} // namespace
+
+int main()
+{
+    PhaseTracer &tracer = PhaseTracer::instance();
+
+    // 1. 未启用时不记录
+    {
+        TraceSpan span("attach", "ptrace");
+    }
+    expect(tracer.mark() == 0, "disabled tracer records nothing");
+
+    // 2. 嵌套阶段按自身耗时汇总，暂停区间单独统计，其他线程的事件不参与嵌套
+    tracer.record(event("apply", "request", 0, 1000));
+    tracer.record(event("attach", "ptrace", 100, 200));
+    tracer.record(event("prologue_rewrite", "patcher", 300, 500));
+    tracer.record(event("memory_write", "ptrace", 350, 450));
+    tracer.record(event("detach", "ptrace", 800, 900));
+    tracer.record(event("stopped", "ptrace", 200, 900));
+    tracer.record(event("memory_write", "ptrace", 320, 340, 2));
+    std::string summary = tracer.summary("apply", 0);
+    expect(summary == "trace apply: total=1000us stopped=700us attach=100us prologue_rewrite=100us "
+                      "memory_write=120us detach=100us",
+           "nested summary: " + summary);
+
+    // 3. 从标记处开始汇总
+    size_t begin = tracer.mark();
+    tracer.record(event("revert", "request", 2000, 2300));
+    tracer.record(event("prologue_rewrite", "patcher", 2100, 2150));
+    summary = tracer.summary("revert", begin);
+    expect(summary == "trace revert: total=300us stopped=0us prologue_rewrite=50us", "summary from mark: " + summary);
+    expect(tracer.summary("idle", tracer.mark()) == "trace idle: no events", "empty summary");
+
+    // 4. trace-event JSON：微秒时间戳保留纳秒精度，名称转义
+    tracer.record({ "a\"b", "request", base_ns + 1, 1500, 3, 0 });
+    std::ostringstream json;
+    tracer.write_json(json);
+    const std::string text = json.str();
+    expect(text.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", 0) == 0, "json header");
+    expect(text.find("{\"name\":\"attach\",\"cat\":\"ptrace\",\"ph\":\"X\",\"ts\":1000100.000,\"dur\":100.000,\"pid\":" +
+                     std::to_string(getpid()) + ",\"tid\":1,\"args\":{\"target_pid\":42}}") != std::string::npos,
+           "complete event");
+    expect(text.find("\"name\":\"a\\\"b\",\"cat\":\"request\",\"ph\":\"X\",\"ts\":1000000.001,\"dur\":1.500") !=
+                   std::string::npos,
+           "escaped name and sub-microsecond timestamp");
+    expect(text.find("\"ph\":\"M\"") != std::string::npos, "process name metadata");
+    expect(text.compare(text.size() - 4, 4, "\n]}\n") == 0, "json footer");
+
+    // 5. 启用后时间段记录实际耗时
+    tracer.clear();
+    tracer.enable(true);
+    {
+        TraceSpan span("remote_alloc", "patcher");
+        std::this_thread::sleep_for(2ms);
+    }
+    summary = tracer.summary("load", 0);
+    expect(summary.find("remote_alloc=") != std::string::npos &&
+                   std::strtol(summary.c_str() + summary.find("remote_alloc=") + 13, nullptr, 10) >= 2000,
+           "span duration: " + summary);
+    tracer.enable(false);
+
+    // 6. 请求路径不写 JSON，trace dump 与 trace off 时写出；请求名在请求字符串释放后仍有效
+    tracer.clear();
+    unsetenv("REMOTEDEBUG_TRACE");
+    const std::string path = "/tmp/trace_test." + std::to_string(getpid()) + ".json";
+    std::remove(path.c_str());
+    {
+        TraceSession session;
+        std::istringstream on("on " + path);
+        expect(session.control(on) == "OK tracing to " + path, "trace on");
+        for (int i = 0; i < 3; ++i) {
+            std::string command = "apply";
+            expect(session.run(command, [] { return std::string("OK"); }) == "OK", "traced request");
+        }
+        std::string bogus = "no_such_command";
+        session.run(bogus, [] { return std::string("ERR invalid request"); });
+        expect(session.last_summary().rfind("trace invalid:", 0) == 0, "unknown command: " + session.last_summary());
+        expect(access(path.c_str(), F_OK) != 0, "no json written per request");
+        std::istringstream dump("dump");
+        expect(session.control(dump) == "OK " + path, "trace dump");
+        std::ifstream file(path);
+        std::stringstream content;
+        content << file.rdbuf();
+        expect(content.str().find("\"name\":\"apply\",\"cat\":\"request\"") != std::string::npos,
+               "dumped request events");
+        expect(content.str().find("no_such_command") == std::string::npos &&
+                       content.str().find("\"name\":\"invalid\"") != std::string::npos,
+               "unknown commands recorded as invalid");
+        std::remove(path.c_str());
+        std::istringstream off("off");
+        expect(session.control(off) == "OK" && access(path.c_str(), F_OK) == 0, "trace off writes json");
+    }
+    std::remove(path.c_str());
+
+    return test::report("trace_test");
+}
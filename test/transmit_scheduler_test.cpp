@@ -0,0 +1,218 @@
+#include "transmit/ftp_async_session.h"
+#include "transmit/transmit_scheduler.h"
+#include "stub_server.h"
+#include "test_common.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+
+using namespace RemoteDebug;
+using test::expect;
+using test::read_file;
+using test::write_random_file;
+using namespace std::chrono_literals;
+
+namespace {
+
+// 统计同时进行的会话数，检查调度器的并发限制
+size_t g_active = 0;
+size_t g_max_active = 0;
+
+class CountingSession : public FtpAsyncSession {
+public:
+    using FtpAsyncSession::FtpAsyncSession;
+
+    SESSION_STATE start(EventRegistry &registry) override
+    {
+        g_max_active = std::max(g_max_active, ++g_active);
+        return FtpAsyncSession::start(registry);
+    }
+
+    void close(EventRegistry &registry) override
+    {
+        --g_active;
+        FtpAsyncSession::close(registry);
+    }
+};
+
+std::unique_ptr<AsyncSession> counting_factory(const Device_info &device_info)
+{
+    return std::make_unique<CountingSession>(device_info);
+}
+
+uint16_t unused_port()
+{
+    uint16_t port = 0;
+    int fd = test::listen_loopback(port);
+    close(fd);
+    return port;
+}
+
+} // namespace
+
+int main()
+{
+    char root_template[] = "/tmp/scheduler_stub_XXXXXX";
+    std::string root = mkdtemp(root_template);
+    std::string local_file = root + "/patch.so";
+    write_random_file(local_file, 2 * 1024 * 1024 + 5, 7);
+    const std::string expected = read_file(local_file);
+
+    test::FtpStubServer server(root + "/");
+    if (!server.start()) {
+        std::cerr << "Failed to start ftp stub server" << std::endl;
+        return 1;
+    }
+
+    // 1. 多台设备（同一子网）并发上传，同时进行的会话数不超过子网上限
+    {
+        std::vector<Device_info> devices;
+        for (int i = 0; i < 8; ++i) {
+            devices.push_back({ TRANSMIT_TYPE::FTP, test::loopback_ip, server.port(), local_file, "user", "pass",
+                                "/tmp/remote_debug_file_" + std::to_string(i) });
+        }
+
+        TransmitPolicy policy;
+        policy.max_per_subnet = 3;
+        TransmitScheduler scheduler(policy, counting_factory);
+        size_t progress_calls = 0;
+        scheduler.set_progress_callback([&](size_t, const TransmitReport &) { ++progress_calls; });
+        auto reports = scheduler.run(devices);
+
+        expect(reports.size() == devices.size(), "one report per device");
+        for (size_t i = 0; i < reports.size(); ++i) {
+            expect(reports[i].status == 0 && reports[i].attempts == 1, "device " + std::to_string(i) + " succeeded");
+            expect(reports[i].bytes_sent == expected.size(), "device " + std::to_string(i) + " bytes sent");
+            expect(read_file(server.local_path(devices[i].remote_path)) == expected,
+                   "device " + std::to_string(i) + " content");
+        }
+        expect(g_max_active > 1 && g_max_active <= 3, "concurrency limited to subnet cap");
+        expect(progress_calls == devices.size(), "progress reported once per device");
+
+        std::ostringstream os;
+        TransmitScheduler::print_report(os, reports);
+        expect(os.str().find("8/8 devices succeeded") != std::string::npos, "report summary");
+    }
+
+    // 2. 无法连接的设备按退避间隔重试，达到次数上限后放弃
+    {
+        std::vector<Device_info> devices{
+            { TRANSMIT_TYPE::FTP, test::loopback_ip, unused_port(), local_file, "user", "pass", "/tmp/unreachable" },
+            { TRANSMIT_TYPE::NONE, test::loopback_ip, 22, local_file, "user", "pass", "/tmp/unsupported" },
+        };
+
+        TransmitPolicy policy;
+        policy.max_attempts = 3;
+        policy.initial_backoff = 40ms;
+        auto reports = TransmitScheduler(policy).run(devices);
+
+        expect(reports[0].status == -1 && reports[0].attempts == 3, "unreachable device retried then failed");
+        expect(reports[0].total_time >= 80ms, "retries wait for backoff");
+        expect(!reports[0].error.empty(), "failure reason recorded");
+        expect(reports[1].status == -1 && reports[1].attempts == 0, "unsupported type rejected without attempts");
+    }
+
+    // 3. 传输中断后重试，从中断位置续传
+    {
+        std::vector<Device_info> devices{
+            { TRANSMIT_TYPE::FTP, test::loopback_ip, server.port(), local_file, "user", "pass", "/tmp/resumed" },
+        };
+
+        TransmitPolicy policy;
+        policy.initial_backoff = 10ms;
+        TransmitScheduler scheduler(policy);
+        scheduler.set_progress_callback([&](size_t, const TransmitReport &report) {
+            if (report.status != 0) {
+                server.set_abort_after(0);
+            }
+        });
+        server.set_abort_after(512 * 1024);
+        auto reports = scheduler.run(devices);
+
+        expect(reports[0].status == 0 && reports[0].attempts == 2, "interrupted device succeeds on retry");
+        expect(server.last_rest_offset() == 512 * 1024, "retry resumes at interrupted offset");
+        expect(reports[0].bytes_sent == expected.size() - 512 * 1024, "retry sends only the remainder");
+        expect(read_file(server.local_path("/tmp/resumed")) == expected, "resumed content");
+    }
+
+    // 4. 中断后本地文件换成另一个版本，重新上传不续传旧版本遗留的前缀
+    {
+        std::vector<Device_info> devices{
+            { TRANSMIT_TYPE::FTP, test::loopback_ip, server.port(), local_file, "user", "pass", "/tmp/rebuilt" },
+        };
+
+        TransmitPolicy policy;
+        policy.max_attempts = 1;
+        server.set_abort_after(512 * 1024);
+        auto reports = TransmitScheduler(policy).run(devices);
+        expect(reports[0].status == -1, "interrupted upload of the old build");
+        server.set_abort_after(0);
+
+        write_random_file(local_file, 2 * 1024 * 1024 + 5, 8);
+        const timespec times[2] = { { 0, UTIME_NOW }, { 1000, 0 } };
+        expect(utimensat(AT_FDCWD, local_file.c_str(), times, 0) == 0, "touch new build");
+        reports = TransmitScheduler(policy).run(devices);
+        expect(reports[0].status == 0 && reports[0].bytes_sent == expected.size(), "new build uploaded from the start");
+        expect(read_file(server.local_path("/tmp/rebuilt")) == read_file(local_file), "new build is not spliced");
+    }
+
+    // 5. Telnet 设备在工作线程中运行同步实现，与 FTP 设备在同一次调度中完成并同样输出报告
+    test::TelnetStubServer telnet("user", "pass");
+    if (!telnet.start()) {
+        std::cerr << "Failed to start telnet stub server" << std::endl;
+        return 1;
+    }
+    std::string small_file = root + "/small.so";
+    write_random_file(small_file, 300 * 1024 + 3, 9);
+    {
+        std::vector<Device_info> devices{
+            { TRANSMIT_TYPE::FTP, test::loopback_ip, server.port(), local_file, "user", "pass", "/tmp/mixed" },
+            { TRANSMIT_TYPE::TELNET, test::loopback_ip, telnet.port(), small_file, "user", "pass", root + "/telnet" },
+            { TRANSMIT_TYPE::TELNET, test::loopback_ip, telnet.port(), small_file, "user", "wrong", root + "/never" },
+        };
+
+        TransmitPolicy policy;
+        policy.max_attempts = 2;
+        policy.initial_backoff = 10ms;
+        size_t progress_calls = 0;
+        TransmitScheduler scheduler(policy);
+        scheduler.set_progress_callback([&](size_t, const TransmitReport &) { ++progress_calls; });
+        auto reports = scheduler.run(devices);
+
+        expect(reports[0].status == 0 && read_file(server.local_path("/tmp/mixed")) == read_file(local_file),
+               "ftp device in a mixed batch");
+        expect(reports[1].status == 0 && reports[1].attempts == 1 && reports[1].bytes_sent == 300 * 1024 + 3,
+               "telnet device succeeded: " + reports[1].error);
+        expect(read_file(root + "/telnet") == read_file(small_file), "telnet device content");
+        expect(reports[2].status == -1 && reports[2].attempts == 2 && !reports[2].error.empty(),
+               "telnet login failure retried then reported");
+        expect(progress_calls == 4, "progress reported for telnet retries");
+    }
+
+    // 6. 尝试超时后同步传输无法中断，重试等待原传输完成而不是重新连接上传
+    {
+        std::vector<Device_info> devices{
+            { TRANSMIT_TYPE::TELNET, test::loopback_ip, telnet.port(), small_file, "user", "pass", root + "/slow" },
+        };
+
+        TransmitPolicy policy;
+        policy.max_attempts = 1000;
+        policy.session_timeout = 5ms;
+        policy.initial_backoff = 1ms;
+        policy.max_backoff = 1ms;
+        const size_t connections = telnet.connections();
+        auto reports = TransmitScheduler(policy).run(devices);
+        expect(reports[0].status == 0 && reports[0].attempts > 1, "timed-out telnet attempt completes on retry");
+        expect(telnet.connections() == connections + 1, "retries reuse the running upload");
+        expect(read_file(root + "/slow") == read_file(small_file), "timed-out telnet upload content");
+    }
+
+    telnet.stop();
+    server.stop();
+    std::system(("rm -rf " + root).c_str());
+
+    return test::report("transmit_scheduler_test");
+}